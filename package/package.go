@@ -42,8 +42,13 @@ func GetPackage() *denv.Package {
 	maintest.AddDependencies(cunittestpkg.GetMainLib())
 	maintest.AddDependency(testlib)
 
+	// benchmark application
+	benchmark := denv.SetupCppAppProject(mainpkg, name+"_benchmark")
+	benchmark.AddDependency(mainlib)
+
 	mainpkg.AddMainLib(mainlib)
 	mainpkg.AddTestLib(testlib)
 	mainpkg.AddUnittest(maintest)
+	mainpkg.AddMainApp(benchmark)
 	return mainpkg
 }
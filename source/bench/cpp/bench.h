@@ -0,0 +1,146 @@
+#ifndef __C_PATH_BENCH_H__
+#define __C_PATH_BENCH_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "ccore/c_allocator.h"
+
+namespace ncore
+{
+    namespace nbench
+    {
+        struct context_t;
+        typedef void (*bench_fn)(context_t& ctx);
+
+        u64 now_ns();
+        u64 minor_faults();
+        u64 major_faults();
+
+        // A benchmark registers itself at static-init time, bench_main runs them in registration order
+        struct registrar_t
+        {
+            registrar_t(const char* name, bench_fn fn);
+
+            const char*  m_name;
+            bench_fn     m_fn;
+            registrar_t* m_next;
+        };
+
+        struct result_t
+        {
+            const char* m_config;       // e.g. "thp+prefault", may be nullptr
+            u64         m_ops;          // number of operations measured
+            u64         m_ns;           // total wall time in nanoseconds
+            u64         m_minor_faults; // minor page faults during the measurement
+            u64         m_major_faults; // major page faults during the measurement
+            u64         m_bytes;        // memory in use at the end of the measurement (0 = not measured)
+            u64         m_paths;        // number of paths the memory is spread over (0 = no bytes/path)
+            f64         m_p50_ns;       // latency percentiles per operation (0 = not sampled)
+            f64         m_p90_ns;       //
+            f64         m_p99_ns;       //
+            f64         m_max_ns;       //
+        };
+
+        void init_result(result_t& result, const char* config, u64 ops);
+
+        // Latency percentiles, operations are timed in batches of c_batch_ops so that the
+        // clock itself does not dominate the measurement of very cheap operations.
+        struct sampler_t
+        {
+            static const u32 c_batch_ops = 32;
+
+            void init(alloc_t* allocator, u64 num_ops);
+            void exit(alloc_t* allocator);
+
+            inline void begin() { m_batch_start = now_ns(); }
+            inline void end(u64 op)
+            {
+                if (((op + 1) % c_batch_ops) == 0 && m_num_samples < m_max_samples)
+                {
+                    u64 const t                 = now_ns();
+                    m_samples[m_num_samples++] = (f32)(t - m_batch_start) / (f32)c_batch_ops;
+                    m_batch_start               = t;
+                }
+            }
+
+            void finalize(result_t& result); // sorts the samples, fills in the percentiles
+
+            f32* m_samples;
+            u32  m_num_samples;
+            u32  m_max_samples;
+            u64  m_batch_start;
+        };
+
+        struct context_t
+        {
+            alloc_t*    m_allocator;
+            const char* m_name;  // name of the running benchmark
+            u32         m_scale; // problem size multiplier, 1 = default
+
+            void report(result_t const& result);
+        };
+
+        // A flat list of '\0' terminated path strings
+        struct pathlist_t
+        {
+            char* m_text;     // all strings, back to back
+            u32*  m_offsets;  // offset of every string in m_text
+            u32   m_count;    //
+            u32   m_max;      //
+            u64   m_size;     // bytes used in m_text
+            u64   m_capacity; // bytes available in m_text
+
+            inline const char* at(u32 i) const { return m_text + m_offsets[i]; }
+        };
+
+        void init_pathlist(alloc_t* allocator, pathlist_t& list, u32 max_paths, u64 max_bytes);
+        void exit_pathlist(alloc_t* allocator, pathlist_t& list);
+        bool add_path(pathlist_t& list, const char* path);
+
+        // Synthetic shapes, every path is a directory path of the form "bench:/.../"
+        void generate_wide(pathlist_t& list, u32 count);                  // one folder with 'count' sub folders
+        void generate_deep(pathlist_t& list, u32 count, u32 depth);       // chains of 'depth' folders
+        void generate_source_tree(pathlist_t& list, u32 count, u32 seed); // realistic source tree, fan-out shrinks with depth
+
+        // A manifest is a text file with one path per line, paths without a device are put on device "m:"
+        bool load_manifest(const char* filename, pathlist_t& list);
+
+        // Set by bench_main from '--manifest <file>', nullptr when not given
+        extern const char* g_manifest;
+
+        // Set by bench_main from '--scan <dir>', the folder the scan benchmark enumerates, nullptr when not given
+        extern const char* g_scan_root;
+
+        // Scoped measurement helper
+        struct measure_t
+        {
+            inline measure_t() { start(); }
+            inline void start()
+            {
+                m_minor = minor_faults();
+                m_major = major_faults();
+                m_start = now_ns();
+            }
+            inline void stop(result_t& result)
+            {
+                result.m_ns           = now_ns() - m_start;
+                result.m_minor_faults = minor_faults() - m_minor;
+                result.m_major_faults = major_faults() - m_major;
+            }
+
+            u64 m_start;
+            u64 m_minor;
+            u64 m_major;
+        };
+
+    } // namespace nbench
+} // namespace ncore
+
+#define BENCHMARK(name)                                                           \
+    static void                    s_bench_##name(ncore::nbench::context_t& ctx); \
+    static ncore::nbench::registrar_t s_register_##name(#name, s_bench_##name);   \
+    static void                    s_bench_##name(ncore::nbench::context_t& ctx)
+
+#endif
@@ -0,0 +1,87 @@
+#include "ccore/c_target.h"
+#include "cbase/c_runes.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/private/c_memory.h"
+
+#include "bench.h"
+
+#include <stdio.h>
+
+using namespace ncore;
+
+namespace
+{
+    struct arena_setup_t
+    {
+        const char*            m_name;
+        npath::varena_config_t m_config;
+    };
+
+    static const arena_setup_t s_setups[] = {
+        {"4k+minimal", {npath::narena::PagesDefault, npath::narena::GrowMinimal, 0, 0, 0}},
+        {"4k+geometric", {npath::narena::PagesDefault, npath::narena::GrowGeometric, 0, 0, 0}},
+        {"4k+geometric+prefault", {npath::narena::PagesDefault, npath::narena::GrowGeometric, 1, 0, 0}},
+        {"thp+geometric+prefault", {npath::narena::PagesTransparentHuge, npath::narena::GrowGeometric, 1, 0, 0}},
+        {"hugetlb+geometric+prefault", {npath::narena::PagesHugeTLB, npath::narena::GrowGeometric, 1, 0, 0}},
+    };
+    static const s32 s_num_setups = sizeof(s_setups) / sizeof(s_setups[0]);
+} // namespace
+
+// Grow an arena item by item through ensure_capacity, which is what the string pool and the
+// folder array do, and count the page faults it takes.
+BENCHMARK(arena_fill)
+{
+    u64 const max_items = 128 * 1024 * 1024;           // 1 GB of u64
+    u64 const num_items = 16 * 1024 * 1024 * ctx.m_scale; // 128 MB per scale step
+
+    for (s32 s = 0; s < s_num_setups; ++s)
+    {
+        nbench::result_t result;
+        nbench::init_result(result, s_setups[s].m_name, num_items);
+        nbench::measure_t measure;
+
+        // hugetlb pages only back the initial capacity, so that one is told how much will be filled
+        npath::varena_t arena;
+        npath::g_init_arena(arena, s_setups[s].m_config.m_pages == npath::narena::PagesHugeTLB ? num_items : 0, max_items, sizeof(u64), s_setups[s].m_config);
+        for (u64 i = 0; i < num_items; ++i)
+        {
+            arena.ensure_capacity((u32)i, sizeof(u64));
+            *(u64*)arena.ptr_of((u32)i, sizeof(u64)) = i;
+        }
+
+        measure.stop(result);
+        result.m_bytes = arena.committed_bytes();
+        ctx.report(result);
+
+        npath::g_teardown_arena(arena);
+    }
+}
+
+// Startup cost of a registry: construct it and register a synthetic tree of folders
+BENCHMARK(paths_startup)
+{
+    u32 const num_dirs = 256 * 1024 * ctx.m_scale;
+
+    for (s32 s = 0; s < s_num_setups; ++s)
+    {
+        nbench::result_t result;
+        nbench::init_result(result, s_setups[s].m_name, num_dirs);
+        nbench::measure_t measure;
+
+        npath::paths_t* paths = npath::g_construct_paths(ctx.m_allocator, 1024 * 1024 * 1024, s_setups[s].m_config);
+
+        char path[128];
+        for (u32 i = 0; i < num_dirs; ++i)
+        {
+            snprintf(path, sizeof(path), "bench:/d%u/s%u/t%u/", i & 0xff, (i >> 8) & 0xff, i >> 16);
+            paths->register_fulldirpath(ascii::make_crunes(path));
+        }
+
+        measure.stop(result);
+        ctx.report(result);
+
+        npath::g_destruct_paths(ctx.m_allocator, paths);
+    }
+}
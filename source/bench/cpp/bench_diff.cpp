@@ -0,0 +1,201 @@
+#include "ccore/c_target.h"
+#include "cbase/c_runes.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_filepath.h"
+#include "cpath/c_diff.h"
+#include "cpath/private/c_fingerprints.h"
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace ncore;
+
+namespace
+{
+    // Two files per folder, the second registry has 1% of the changes: every 100th folder has a modified file
+    // (different size), every 200th lost a file and every 200th (another one) got a new file.
+    static u32 s_register(npath::paths_t* paths, nbench::pathlist_t const& list, bool changed)
+    {
+        npath::filestat_t stat;
+        memset(&stat, 0, sizeof(stat));
+        u32 last = 0;
+        for (u32 i = 0; i < list.m_count; ++i)
+        {
+            dirpath_t dir = paths->register_fulldirpath(ascii::make_crunes(list.at(i)));
+            for (u32 f = 0; f < 3; ++f)
+            {
+                bool const present = f == 0 || (f == 1 && !(changed && i % 200 == 1)) || (f == 2 && changed && i % 200 == 2);
+                if (!present)
+                    continue;
+                npath::ifile_t const file = paths->file_of(dir.filename(ascii::make_crunes(f == 0 ? "a.cpp" : (f == 1 ? "b.h" : "c.txt"))));
+                stat.m_size               = (changed && f == 0 && i % 100 == 0) ? 2 : 1;
+                paths->set_file_stat(file, stat);
+                last = file > last ? file : last;
+            }
+        }
+        return last; // files are numbered 1..last
+    }
+
+    static void s_ignore(u32 kind, filepath_t const* a, filepath_t const* b, void* user) {}
+
+    static int s_compare_paths(void const* a, void const* b) { return strcmp(*(const char* const*)a, *(const char* const*)b); }
+
+    // Renders the full path of files 1..num_files into 'text' and sorts the pointers to them, returns the bytes used
+    static u64 s_render_sorted(npath::paths_t* paths, u32 num_files, char* text, const char** lines)
+    {
+        u64 used = 0;
+        for (npath::ifile_t file = 1; file <= num_files; ++file)
+        {
+            s32 const len   = paths->file_to_ospath(file, text + used, 1024);
+            lines[file - 1] = text + used;
+            used += len + 1;
+        }
+        qsort(lines, num_files, sizeof(const char*), s_compare_paths);
+        return used;
+    }
+} // namespace
+
+// Deployment delta between two registries with 1% changes. The baseline is how a manifest diff is done without
+// the registry: render the paths of both sides, sort them as strings and merge (names only, the modified files are
+// not even detected). diff_t walks both folder trees in lockstep and compares names only between siblings. Scale 1
+// is about 2M files per side, --scale 5 gives the 10M entry trees. Ops are files of the first registry.
+BENCHMARK(diff)
+{
+    u32 const          count = 1024 * 1024 * ctx.m_scale;
+    nbench::pathlist_t list;
+    nbench::init_pathlist(ctx.m_allocator, list, count, (u64)count * 128);
+    nbench::generate_source_tree(list, count, 1);
+
+    npath::paths_t* a  = npath::g_construct_paths(ctx.m_allocator);
+    npath::paths_t* b  = npath::g_construct_paths(ctx.m_allocator);
+    u32 const       na = s_register(a, list, false);
+    u32 const       nb = s_register(b, list, true);
+    a->mount(a->register_fulldirpath(ascii::make_crunes("bench:/")), "/r"); // only used to render the paths
+    b->mount(b->register_fulldirpath(ascii::make_crunes("bench:/")), "/r");
+
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "render+sort+merge", na);
+        u64 const    max_text = 4 * (list.m_size + (u64)list.m_count * 16); // at most 2 files per folder per side
+        char*        text     = (char*)ctx.m_allocator->allocate((u32)max_text);
+        const char** lines    = (const char**)ctx.m_allocator->allocate((na + nb) * sizeof(const char*));
+
+        nbench::measure_t measure;
+        u64 const         used = s_render_sorted(a, na, text, lines);
+        s_render_sorted(b, nb, text + used, lines + na);
+        u32       changes = 0;
+        for (u32 i = 0, j = 0; i < na || j < nb;)
+        {
+            s32 const c = i == na ? 1 : (j == nb ? -1 : strcmp(lines[i], lines[na + j]));
+            changes += c != 0 ? 1 : 0;
+            i += c <= 0 ? 1 : 0;
+            j += c >= 0 ? 1 : 0;
+        }
+        measure.stop(result);
+        result.m_bytes = changes;
+        ctx.report(result);
+
+        ctx.m_allocator->deallocate(lines);
+        ctx.m_allocator->deallocate(text);
+    }
+
+    static const char* s_configs[] = {"diff names", "diff metadata"};
+    for (u32 c = 0; c < 2; ++c)
+    {
+        nbench::result_t result;
+        nbench::init_result(result, s_configs[c], na);
+        npath::diff_stats_t stats;
+        nbench::measure_t   measure;
+        npath::diff_t::run(a, b, c == 0 ? npath::ndiff::CompareNames : npath::ndiff::CompareMetadata, s_ignore, nullptr, stats);
+        measure.stop(result);
+        result.m_bytes = stats.m_added + stats.m_removed + stats.m_modified;
+        ctx.report(result);
+    }
+
+    // with fingerprints (computed before the measurement) only the folders on the path to a change are walked
+    a->enable_fingerprints();
+    b->enable_fingerprints();
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "diff pruned", na);
+        npath::diff_stats_t stats;
+        nbench::measure_t   measure;
+        npath::diff_t::run(a, b, npath::ndiff::CompareNames, s_ignore, nullptr, stats);
+        measure.stop(result);
+        result.m_bytes = stats.m_added + stats.m_removed + stats.m_modified;
+        ctx.report(result);
+    }
+
+    npath::g_destruct_paths(ctx.m_allocator, a);
+    npath::g_destruct_paths(ctx.m_allocator, b);
+    nbench::exit_pathlist(ctx.m_allocator, list);
+}
+
+// Fingerprints of the first registry of the diff benchmark: computing all of them on 1 worker and on all hardware
+// threads (a level at a time), changing one file and querying the root (the parent chain is recomputed) and
+// querying the root when nothing changed. Ops are files for the first two, changes or queries for the others.
+BENCHMARK(fingerprints)
+{
+    u32 const          count = 1024 * 1024 * ctx.m_scale;
+    nbench::pathlist_t list;
+    nbench::init_pathlist(ctx.m_allocator, list, count, (u64)count * 128);
+    nbench::generate_source_tree(list, count, 1);
+
+    npath::paths_t* paths = npath::g_construct_paths(ctx.m_allocator);
+    u32 const       files = s_register(paths, list, false);
+    dirpath_t const root  = paths->register_fulldirpath(ascii::make_crunes("bench:/"));
+    paths->enable_fingerprints(1);
+
+    static const u32   s_threads[] = {1, 0};
+    static const char* s_configs[] = {"compute/1", "compute/all"};
+    for (u32 t = 0; t < 2; ++t)
+    {
+        nbench::result_t result;
+        nbench::init_result(result, s_configs[t], files);
+        npath::g_fingerprint_invalidate(paths);
+        nbench::measure_t measure;
+        paths->update_fingerprints(s_threads[t]);
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    u32 const            changes = 100000;
+    npath::fingerprint_t fp;
+    npath::filestat_t    stat;
+    memset(&stat, 0, sizeof(stat));
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "change+query", changes);
+        nbench::measure_t measure;
+        for (u32 i = 0; i < changes; ++i)
+        {
+            stat.m_size = i;
+            paths->set_file_stat((npath::ifile_t)(1 + ((u64)i * 7919) % files), stat);
+            paths->get_fingerprint(root, fp);
+            result.m_bytes += fp.m_lo & 1; // keep the queries alive
+        }
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "query", changes);
+        nbench::measure_t measure;
+        for (u32 i = 0; i < changes; ++i)
+        {
+            paths->get_fingerprint(root, fp);
+            result.m_bytes += fp.m_lo & 1;
+        }
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    npath::g_destruct_paths(ctx.m_allocator, paths);
+    nbench::exit_pathlist(ctx.m_allocator, list);
+}
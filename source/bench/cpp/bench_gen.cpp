@@ -0,0 +1,145 @@
+#include "ccore/c_target.h"
+#include "ccore/c_allocator.h"
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace ncore
+{
+    namespace nbench
+    {
+        void init_pathlist(alloc_t* allocator, pathlist_t& list, u32 max_paths, u64 max_bytes)
+        {
+            list.m_text     = g_allocate_array<char>(allocator, (u32)max_bytes);
+            list.m_offsets  = g_allocate_array<u32>(allocator, max_paths);
+            list.m_count    = 0;
+            list.m_max      = max_paths;
+            list.m_size     = 0;
+            list.m_capacity = max_bytes;
+        }
+
+        void exit_pathlist(alloc_t* allocator, pathlist_t& list)
+        {
+            g_deallocate_array(allocator, list.m_text);
+            g_deallocate_array(allocator, list.m_offsets);
+            list.m_count = 0;
+        }
+
+        bool add_path(pathlist_t& list, const char* path)
+        {
+            u64 const len = strlen(path) + 1;
+            if (list.m_count == list.m_max || (list.m_size + len) > list.m_capacity)
+                return false;
+            memcpy(list.m_text + list.m_size, path, len);
+            list.m_offsets[list.m_count++] = (u32)list.m_size;
+            list.m_size += len;
+            return true;
+        }
+
+        void generate_wide(pathlist_t& list, u32 count)
+        {
+            char path[64];
+            for (u32 i = 0; i < count; ++i)
+            {
+                snprintf(path, sizeof(path), "bench:/wide/f%07u/", i);
+                if (!add_path(list, path))
+                    break;
+            }
+        }
+
+        void generate_deep(pathlist_t& list, u32 count, u32 depth)
+        {
+            char path[4096];
+            for (u32 i = 0; i < count; ++i)
+            {
+                // every path is the next level of the current chain, a new chain starts every 'depth' paths
+                s32       len   = snprintf(path, sizeof(path), "bench:/deep/c%u/", i / depth);
+                u32 const level = i % depth;
+                for (u32 l = 0; l <= level && len < (s32)(sizeof(path) - 16); ++l)
+                    len += snprintf(path + len, sizeof(path) - len, "l%u/", l);
+                if (!add_path(list, path))
+                    break;
+            }
+        }
+
+        static inline u32 s_random(u32& state)
+        {
+            // xorshift32
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+
+        // Folder names that show up in real source trees, so the string pool sees realistic sharing
+        static const char* s_names[] = {"src", "source", "include", "lib", "libs", "test", "tests", "docs", "build", "bin", "obj", "core", "common", "platform", "render", "audio", "physics", "net", "ui", "tools", "scripts", "data", "assets", "shaders", "textures",
+                                        "models", "config", "private", "public", "internal", "detail", "impl", "linux", "windows", "mac", "x64", "arm64", "debug", "release", "third_party", "vendor", "external", "util", "utils", "io", "math", "memory", "thread"};
+        static const u32   s_num_names = sizeof(s_names) / sizeof(s_names[0]);
+
+        void generate_source_tree(pathlist_t& list, u32 count, u32 seed)
+        {
+            const u32 c_max_depth = 12;
+            char      path[1024];
+            s32       lengths[c_max_depth + 1];
+            u32       state = seed != 0 ? seed : 0x9E3779B9;
+
+            // Depth-first walk of a random tree, the fan-out gets smaller the deeper we go
+            s32 len    = snprintf(path, sizeof(path), "bench:/src/");
+            lengths[0] = len;
+            u32 depth  = 0;
+            while (list.m_count < count)
+            {
+                u32 const r = s_random(state);
+                if (depth < c_max_depth && (r % 100) < (70 - depth * 6))
+                {
+                    // go down, pick a name, half of the time make it unique to keep the tree growing
+                    const char* name = s_names[(r >> 8) % s_num_names];
+                    if ((r >> 16) & 1)
+                        len += snprintf(path + len, sizeof(path) - len, "%s/", name);
+                    else
+                        len += snprintf(path + len, sizeof(path) - len, "%s_%u/", name, (r >> 17) % 1000);
+                    lengths[++depth] = len;
+                    if (!add_path(list, path))
+                        break;
+                }
+                else if (depth > 0)
+                {
+                    // go up
+                    len       = lengths[--depth];
+                    path[len] = 0;
+                }
+            }
+        }
+
+        bool load_manifest(const char* filename, pathlist_t& list)
+        {
+            FILE* file = fopen(filename, "rb");
+            if (file == nullptr)
+                return false;
+
+            char line[4096];
+            char path[4096 + 8];
+            while (fgets(line, sizeof(line), file) != nullptr)
+            {
+                s32 len = (s32)strlen(line);
+                while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+                    line[--len] = 0;
+                if (len == 0)
+                    continue;
+
+                // Windows style paths keep their device ("c:"), the rest goes onto device "m:"
+                if (strchr(line, ':') != nullptr)
+                    snprintf(path, sizeof(path), "%s", line);
+                else
+                    snprintf(path, sizeof(path), "m:%s%s", line[0] == '/' ? "" : "/", line);
+                if (!add_path(list, path))
+                    break;
+            }
+            fclose(file);
+            return list.m_count > 0;
+        }
+
+    } // namespace nbench
+} // namespace ncore
@@ -0,0 +1,215 @@
+#include "ccore/c_target.h"
+#include "cbase/c_runes.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_filepath.h"
+#include "cpath/c_glob.h"
+
+#include "bench.h"
+
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+using namespace ncore;
+
+namespace
+{
+    // Path glob over a rendered path, '*' and '?' stay within a folder name and "**/" matches zero or more folders
+    static bool s_path_match(const char* p, const char* s)
+    {
+        while (*p != 0)
+        {
+            if (p[0] == '*' && p[1] == '*')
+            {
+                if (p[2] == 0)
+                    return true;
+                for (const char* t = s;; ++t) // "**/", zero or more folders
+                {
+                    if (s_path_match(p + 3, t))
+                        return true;
+                    t = strchr(t, '/');
+                    if (t == nullptr)
+                        return false;
+                }
+            }
+            if (*p == '*')
+            {
+                for (;; ++s)
+                {
+                    if (s_path_match(p + 1, s))
+                        return true;
+                    if (*s == 0 || *s == '/')
+                        return false;
+                }
+            }
+            if (*s == 0 || (*p == '?' ? *s == '/' : *p != *s))
+                return false;
+            p += 1;
+            s += 1;
+        }
+        return *s == 0;
+    }
+
+    // Three files per folder, the generated list can hold a folder more than once, every file node is kept once
+    // (new nodes get the next index). Returns the number of files.
+    static u32 s_register_files(npath::paths_t* paths, nbench::pathlist_t const& list, npath::ifile_t* files)
+    {
+        u32  num_files = 0;
+        char name[32];
+        for (u32 i = 0; i < list.m_count; ++i)
+        {
+            dirpath_t dir = paths->register_fulldirpath(ascii::make_crunes(list.at(i)));
+            for (u32 f = 0; f < 3; ++f)
+            {
+                snprintf(name, sizeof(name), f == 0 ? "f%u.cpp" : (f == 1 ? "f%u.h" : "readme.md"), i);
+                npath::ifile_t const file = paths->file_of(dir.filename(ascii::make_crunes(name)));
+                if (num_files == 0 || file > files[num_files - 1])
+                    files[num_files++] = file;
+            }
+        }
+        return num_files;
+    }
+
+    static void s_ignore(npath::ifile_t file, void* user) {}
+
+    static const char* s_patterns[] = {"src/**/*.cpp", "src/core/**/*.h", "src/*/test*/*.cpp", "src/**/readme.md"};
+    static const char* s_render[]   = {"render+match src/**/*.cpp", "render+match src/core/**/*.h", "render+match src/*/test*/*.cpp", "render+match src/**/readme.md"};
+    static const char* s_serial[]   = {"glob src/**/*.cpp", "glob src/core/**/*.h", "glob src/*/test*/*.cpp", "glob src/**/readme.md"};
+    static const char* s_parallel[] = {"glob mt src/**/*.cpp", "glob mt src/core/**/*.h", "glob mt src/*/test*/*.cpp", "glob mt src/**/readme.md"};
+} // namespace
+
+// Glob queries over a generated source tree (three files per folder). The baseline renders the full path of every
+// file and matches the pattern against the string, the glob engine walks the folder tree and only enters the
+// folders the pattern can match. Ops are registered files for all configurations, so ns/op compare directly.
+BENCHMARK(glob)
+{
+    u32 const          count = 64 * 1024 * ctx.m_scale;
+    nbench::pathlist_t list;
+    nbench::init_pathlist(ctx.m_allocator, list, count, (u64)count * 128);
+    nbench::generate_source_tree(list, count, 1);
+
+    npath::paths_t* paths = npath::g_construct_paths(ctx.m_allocator);
+    dirpath_t       root  = paths->register_fulldirpath(ascii::make_crunes("bench:/"));
+    paths->mount(root, "/r"); // only used to render the full paths, never opened
+
+    npath::ifile_t* files     = (npath::ifile_t*)ctx.m_allocator->allocate(list.m_count * 3 * sizeof(npath::ifile_t));
+    u32 const       num_files = s_register_files(paths, list, files);
+
+    char path[1024];
+    for (u32 p = 0; p < sizeof(s_patterns) / sizeof(s_patterns[0]); ++p)
+    {
+        u32 expected = 0;
+        {
+            nbench::result_t result;
+            nbench::init_result(result, s_render[p], num_files);
+            nbench::measure_t measure;
+            for (u32 i = 0; i < num_files; ++i)
+            {
+                s32 const len = paths->file_to_ospath(files[i], path, sizeof(path));
+                if (len > 3 && s_path_match(s_patterns[p], path + 3)) // skip "/r/"
+                    expected += 1;
+            }
+            measure.stop(result);
+            result.m_bytes = expected; // keep the matches alive
+            ctx.report(result);
+        }
+
+        npath::glob_t* glob = npath::g_compile_glob(ctx.m_allocator, paths, ascii::make_crunes(s_patterns[p]));
+        for (u32 mode = 0; mode < 2; ++mode)
+        {
+            nbench::result_t result;
+            nbench::init_result(result, mode == 0 ? s_serial[p] : s_parallel[p], num_files);
+            nbench::measure_t measure;
+            u32 const         matches = glob->match(root, s_ignore, nullptr, mode == 0 ? 1 : 0);
+            measure.stop(result);
+            if (matches != expected)
+                printf("glob '%s' found %u files, render+match %u\n", s_patterns[p], matches, expected);
+            ctx.report(result);
+        }
+        npath::g_destruct_glob(ctx.m_allocator, glob);
+    }
+
+    ctx.m_allocator->deallocate(files);
+    npath::g_destruct_paths(ctx.m_allocator, paths);
+    nbench::exit_pathlist(ctx.m_allocator, list);
+}
+
+// Extension index against the glob walk: all ".cpp" files and the ".h" files below "src/core". The index is
+// enabled on a full tree and also before registering the same tree again, which keeps the folder numbers and the
+// sorted runs current per folder and file. Ops are the files found.
+BENCHMARK(extindex)
+{
+    u32 const          count = 64 * 1024 * ctx.m_scale;
+    nbench::pathlist_t list;
+    nbench::init_pathlist(ctx.m_allocator, list, count, (u64)count * 128);
+    nbench::generate_source_tree(list, count, 1);
+
+    npath::paths_t* paths = npath::g_construct_paths(ctx.m_allocator);
+    dirpath_t       root  = paths->register_fulldirpath(ascii::make_crunes("bench:/"));
+    npath::ifile_t* files = (npath::ifile_t*)ctx.m_allocator->allocate(list.m_count * 3 * sizeof(npath::ifile_t));
+    u32 const       total = s_register_files(paths, list, files);
+
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "enable", total);
+        nbench::measure_t measure;
+        paths->enable_extindex();
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    npath::string_t const cpp  = paths->find_string(ascii::make_crunes(".cpp"));
+    npath::string_t const h    = paths->find_string(ascii::make_crunes(".h"));
+    dirpath_t const       core = root.down(ascii::make_crunes("src")).down(ascii::make_crunes("core"));
+
+    const char* globs[]   = {"**/*.cpp", "src/core/**/*.h"};
+    const char* configs[] = {"glob **/*.cpp", "glob src/core/**/*.h"};
+    for (u32 g = 0; g < 2; ++g)
+    {
+        npath::glob_t*   glob = npath::g_compile_glob(ctx.m_allocator, paths, ascii::make_crunes(globs[g]));
+        nbench::result_t result;
+        nbench::init_result(result, configs[g], 0);
+        nbench::measure_t measure;
+        result.m_ops = glob->match(root, s_ignore, nullptr, 1);
+        measure.stop(result);
+        ctx.report(result);
+        npath::g_destruct_glob(ctx.m_allocator, glob);
+    }
+
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "index .cpp", 0);
+        nbench::measure_t measure;
+        result.m_ops = paths->files_with_extension(cpp, files, total);
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "index src/core .h", 0);
+        nbench::measure_t measure;
+        result.m_ops = paths->files_with_extension(core, h, files, total);
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    {
+        npath::paths_t* indexed = npath::g_construct_paths(ctx.m_allocator);
+        indexed->register_fulldirpath(ascii::make_crunes("bench:/"));
+        indexed->enable_extindex();
+        nbench::result_t result;
+        nbench::init_result(result, "register, index enabled", total);
+        nbench::measure_t measure;
+        s_register_files(indexed, list, files);
+        measure.stop(result);
+        ctx.report(result);
+        npath::g_destruct_paths(ctx.m_allocator, indexed);
+    }
+
+    ctx.m_allocator->deallocate(files);
+    npath::g_destruct_paths(ctx.m_allocator, paths);
+    nbench::exit_pathlist(ctx.m_allocator, list);
+}
@@ -0,0 +1,127 @@
+#include "ccore/c_target.h"
+#include "cbase/c_runes.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_filepath.h"
+#include "cpath/c_walker.h"
+#include "cpath/c_listing.h"
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace ncore;
+
+// Paging through one folder of 1M files (1M * scale) in name order, 100 entries per page. The files are registered
+// in a scrambled order. The baseline is what a pager does without the name index: collect the files of the folder,
+// sort them by name (walker_t with nwalk::SortedByName) and skip to the page, for a sample of 16 pages. The name
+// index is built on the first listing, after that every page is a cursor step, and a page from a resume token (a
+// request that comes back with the last entry of the previous page) adds one binary search. The last pass registers a
+// file before every page. Ops are pages, except for the build where they are files.
+BENCHMARK(listing)
+{
+    u32 const       count = 1024 * 1024 * ctx.m_scale;
+    u32 const       page  = 100;
+    npath::paths_t* paths = npath::g_construct_paths(ctx.m_allocator);
+    dirpath_t       dir   = paths->register_fulldirpath(ascii::make_crunes("bench:/big/"));
+    char            name[32];
+    for (u32 i = 0; i < count; ++i)
+    {
+        snprintf(name, sizeof(name), "f%08u.dat", (u32)(((u64)i * 2654435761u) % count));
+        paths->file_of(dir.filename(ascii::make_crunes(name)));
+    }
+    u32 const pages = (count + page - 1) / page;
+
+    npath::walknode_t* nodes = (npath::walknode_t*)ctx.m_allocator->allocate(page * sizeof(npath::walknode_t));
+
+    {
+        u32 const        samples = 16;
+        nbench::result_t result;
+        nbench::init_result(result, "collect+sort", samples);
+        nbench::measure_t measure;
+        for (u32 s = 0; s < samples; ++s)
+        {
+            npath::walker_t*  walker = npath::g_construct_walker(ctx.m_allocator, dir, npath::nwalk::SortedByName | npath::nwalk::WithFiles);
+            u64 const         skip   = 1 + (u64)s * pages / samples * page; // the folder itself, then the pages before
+            npath::walknode_t node;
+            for (u64 i = 0; i < skip + page && walker->next(node); ++i)
+                result.m_bytes += (i >= skip) ? (node.m_node & 1) : 0; // keep the page alive
+            npath::g_destruct_walker(ctx.m_allocator, walker);
+        }
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    npath::lister_t* lister = npath::g_construct_lister(ctx.m_allocator, dir);
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "build index", count);
+        nbench::measure_t measure;
+        result.m_bytes = lister->next(nodes, page) & 1;
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "page (cursor)", pages);
+        nbench::measure_t measure;
+        lister->seek(dir);
+        while (lister->next(nodes, page) > 0)
+            result.m_bytes += nodes[0].m_node & 1;
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "page (resume)", pages);
+        nbench::measure_t measure;
+        lister->seek(dir);
+        u32 n = lister->next(nodes, page);
+        while (n > 0)
+        {
+            lister->resume(dir, nullptr, npath::nlist::Children, nodes[n - 1]);
+            n = lister->next(nodes, page);
+        }
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "prefix seek", count / 1000);
+        nbench::measure_t measure;
+        for (u32 i = 0; i < count / 1000; ++i)
+        {
+            snprintf(name, sizeof(name), "f%05u", i);
+            lister->seek(dir, name);
+            result.m_bytes += lister->next(nodes, page) & 1;
+        }
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    {
+        // a file registered before every page, the page sorts it into the side run of the block
+        u32 const        adds = 16 * 1024;
+        nbench::result_t result;
+        nbench::init_result(result, "add+page", adds);
+        nbench::measure_t measure;
+        for (u32 i = 0; i < adds; ++i)
+        {
+            snprintf(name, sizeof(name), "g%08u.dat", (u32)(((u64)i * 2654435761u) % adds));
+            paths->file_of(dir.filename(ascii::make_crunes(name)));
+            lister->seek(dir, "g");
+            result.m_bytes += lister->next(nodes, page) & 1;
+        }
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    npath::g_destruct_lister(ctx.m_allocator, lister);
+    ctx.m_allocator->deallocate(nodes);
+    npath::g_destruct_paths(ctx.m_allocator, paths);
+}
@@ -0,0 +1,192 @@
+#include "ccore/c_target.h"
+#include "ccore/c_allocator.h"
+#include "cvmem/c_virtual_memory.h"
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(TARGET_PC)
+#    include <windows.h>
+#    include <psapi.h>
+#else
+#    include <sys/resource.h>
+#    include <time.h>
+#endif
+
+namespace ncore
+{
+    namespace nbench
+    {
+        static registrar_t* s_first = nullptr;
+        static registrar_t* s_last  = nullptr;
+
+        registrar_t::registrar_t(const char* name, bench_fn fn) : m_name(name), m_fn(fn), m_next(nullptr)
+        {
+            if (s_last == nullptr)
+                s_first = this;
+            else
+                s_last->m_next = this;
+            s_last = this;
+        }
+
+#if defined(TARGET_PC)
+        u64 now_ns()
+        {
+            LARGE_INTEGER freq, counter;
+            QueryPerformanceFrequency(&freq);
+            QueryPerformanceCounter(&counter);
+            return (u64)((counter.QuadPart * 1000000000.0) / (double)freq.QuadPart);
+        }
+
+        u64 minor_faults()
+        {
+            PROCESS_MEMORY_COUNTERS pmc;
+            GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+            return pmc.PageFaultCount;
+        }
+
+        u64 major_faults() { return 0; }
+#else
+        u64 now_ns()
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+        }
+
+        u64 minor_faults()
+        {
+            struct rusage usage;
+            getrusage(RUSAGE_SELF, &usage);
+            return (u64)usage.ru_minflt;
+        }
+
+        u64 major_faults()
+        {
+            struct rusage usage;
+            getrusage(RUSAGE_SELF, &usage);
+            return (u64)usage.ru_majflt;
+        }
+#endif
+
+        const char* g_manifest  = nullptr;
+        const char* g_scan_root = nullptr;
+
+        void init_result(result_t& result, const char* config, u64 ops)
+        {
+            memset(&result, 0, sizeof(result));
+            result.m_config = config;
+            result.m_ops    = ops;
+        }
+
+        // One JSON object per line, easy to diff and to feed into a regression checker
+        void context_t::report(result_t const& r)
+        {
+            double const ns_per_op      = r.m_ops > 0 ? (double)r.m_ns / (double)r.m_ops : 0.0;
+            double const ops_per_s      = r.m_ns > 0 ? ((double)r.m_ops * 1000000000.0) / (double)r.m_ns : 0.0;
+            double const bytes_per_path = r.m_paths > 0 ? (double)r.m_bytes / (double)r.m_paths : 0.0;
+            printf("{\"bench\":\"%s\",\"config\":\"%s\",\"ops\":%llu,\"ns\":%llu,\"ns_per_op\":%.2f,\"ops_per_sec\":%.0f,\"p50_ns\":%.1f,\"p90_ns\":%.1f,\"p99_ns\":%.1f,\"max_ns\":%.1f,\"minor_faults\":%llu,\"major_faults\":%llu,\"bytes\":%llu,\"bytes_per_path\":%.2f}\n", m_name,
+                   r.m_config != nullptr ? r.m_config : "", (unsigned long long)r.m_ops, (unsigned long long)r.m_ns, ns_per_op, ops_per_s, r.m_p50_ns, r.m_p90_ns, r.m_p99_ns, r.m_max_ns, (unsigned long long)r.m_minor_faults, (unsigned long long)r.m_major_faults,
+                   (unsigned long long)r.m_bytes, bytes_per_path);
+            fflush(stdout);
+        }
+
+        void sampler_t::init(alloc_t* allocator, u64 num_ops)
+        {
+            m_max_samples = (u32)(num_ops / c_batch_ops) + 1;
+            m_samples     = g_allocate_array<f32>(allocator, m_max_samples);
+            m_num_samples = 0;
+            m_batch_start = 0;
+        }
+
+        void sampler_t::exit(alloc_t* allocator) { g_deallocate_array(allocator, m_samples); }
+
+        static int s_compare_f32(const void* a, const void* b)
+        {
+            f32 const fa = *(f32 const*)a;
+            f32 const fb = *(f32 const*)b;
+            return fa < fb ? -1 : (fa > fb ? 1 : 0);
+        }
+
+        void sampler_t::finalize(result_t& result)
+        {
+            if (m_num_samples == 0)
+                return;
+            qsort(m_samples, m_num_samples, sizeof(f32), s_compare_f32);
+            result.m_p50_ns = m_samples[(m_num_samples * 50) / 100];
+            result.m_p90_ns = m_samples[(m_num_samples * 90) / 100];
+            result.m_p99_ns = m_samples[(m_num_samples * 99) / 100];
+            result.m_max_ns = m_samples[m_num_samples - 1];
+        }
+
+        class malloc_alloc_t : public alloc_t
+        {
+        public:
+            virtual void* v_allocate(u32 size, u32 alignment)
+            {
+                void* ptr = nullptr;
+#if defined(TARGET_PC)
+                ptr = _aligned_malloc(size, alignment);
+#else
+                if (alignment < sizeof(void*))
+                    alignment = sizeof(void*);
+                if (posix_memalign(&ptr, alignment, size) != 0)
+                    ptr = nullptr;
+#endif
+                return ptr;
+            }
+
+            virtual void v_deallocate(void* mem)
+            {
+#if defined(TARGET_PC)
+                _aligned_free(mem);
+#else
+                free(mem);
+#endif
+            }
+        };
+
+    } // namespace nbench
+} // namespace ncore
+
+// usage: cpath_benchmark [--scale N] [--manifest file] [--scan dir] [name-filter ...]
+int main(int argc, char** argv)
+{
+    using namespace ncore;
+
+    ncore::nvmem::initialize();
+
+    nbench::malloc_alloc_t allocator;
+    nbench::context_t      ctx;
+    ctx.m_allocator = &allocator;
+    ctx.m_name      = nullptr;
+    ctx.m_scale     = 1;
+
+    s32 first_filter = 1;
+    while ((first_filter + 1) < argc && strncmp(argv[first_filter], "--", 2) == 0)
+    {
+        if (strcmp(argv[first_filter], "--scale") == 0)
+            ctx.m_scale = (u32)atoi(argv[first_filter + 1]);
+        else if (strcmp(argv[first_filter], "--manifest") == 0)
+            nbench::g_manifest = argv[first_filter + 1];
+        else if (strcmp(argv[first_filter], "--scan") == 0)
+            nbench::g_scan_root = argv[first_filter + 1];
+        first_filter += 2;
+    }
+
+    for (nbench::registrar_t* b = nbench::s_first; b != nullptr; b = b->m_next)
+    {
+        bool run = first_filter >= argc;
+        for (s32 i = first_filter; i < argc && !run; ++i)
+            run = strstr(b->m_name, argv[i]) != nullptr;
+        if (!run)
+            continue;
+
+        ctx.m_name = b->m_name;
+        b->m_fn(ctx);
+    }
+    return 0;
+}
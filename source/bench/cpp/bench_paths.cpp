@@ -0,0 +1,710 @@
+#include "ccore/c_target.h"
+#include "cbase/c_runes.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_device.h"
+#include "cpath/c_filepath.h"
+#include "cpath/c_walker.h"
+#include "cpath/private/c_folders.h"
+
+#include "bench.h"
+
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+using namespace ncore;
+
+namespace
+{
+    struct shape_t
+    {
+        const char*        m_name;
+        nbench::pathlist_t m_paths;
+    };
+
+    const s32 c_max_shapes = 4;
+
+    struct workload_t
+    {
+        shape_t m_shapes[c_max_shapes];
+        s32     m_count;
+    };
+
+    // wide, deep and source-tree shapes plus the manifest given on the command line
+    static void s_init_workload(nbench::context_t& ctx, workload_t& w)
+    {
+        u32 const count = 1024 * 1024 * ctx.m_scale;
+        w.m_count       = 0;
+
+        shape_t& wide = w.m_shapes[w.m_count++];
+        wide.m_name   = "wide";
+        nbench::init_pathlist(ctx.m_allocator, wide.m_paths, count, (u64)count * 24);
+        nbench::generate_wide(wide.m_paths, count);
+
+        shape_t& deep = w.m_shapes[w.m_count++];
+        deep.m_name   = "deep";
+        nbench::init_pathlist(ctx.m_allocator, deep.m_paths, count / 16, (u64)(count / 16) * 160);
+        nbench::generate_deep(deep.m_paths, count / 16, 32);
+
+        shape_t& tree = w.m_shapes[w.m_count++];
+        tree.m_name   = "source_tree";
+        nbench::init_pathlist(ctx.m_allocator, tree.m_paths, count, (u64)count * 128);
+        nbench::generate_source_tree(tree.m_paths, count, 1);
+
+        if (nbench::g_manifest != nullptr)
+        {
+            shape_t& manifest = w.m_shapes[w.m_count];
+            manifest.m_name   = "manifest";
+            nbench::init_pathlist(ctx.m_allocator, manifest.m_paths, 64 * 1024 * 1024, (u64)2 * 1024 * 1024 * 1024 - 1);
+            if (nbench::load_manifest(nbench::g_manifest, manifest.m_paths))
+                w.m_count += 1;
+            else
+                nbench::exit_pathlist(ctx.m_allocator, manifest.m_paths);
+        }
+    }
+
+    static void s_exit_workload(nbench::context_t& ctx, workload_t& w)
+    {
+        for (s32 i = 0; i < w.m_count; ++i)
+            nbench::exit_pathlist(ctx.m_allocator, w.m_shapes[i].m_paths);
+        w.m_count = 0;
+    }
+
+    static u64 s_committed_bytes(npath::paths_t const* paths)
+    {
+        npath::paths_stats_t stats;
+        paths->stats(stats);
+        return stats.m_string_data.m_committed + stats.m_string_array.m_committed + stats.m_string_nodes.m_committed + stats.m_folder_array.m_committed + stats.m_folder_nodes.m_committed + stats.m_device_array.m_committed;
+    }
+
+    static dirpath_t* s_register_all(nbench::context_t& ctx, npath::paths_t* paths, nbench::pathlist_t const& list)
+    {
+        dirpath_t* dirs = (dirpath_t*)ctx.m_allocator->allocate(list.m_count * sizeof(dirpath_t));
+        for (u32 i = 0; i < list.m_count; ++i)
+            new (&dirs[i]) dirpath_t(paths->register_fulldirpath(ascii::make_crunes(list.at(i))));
+        return dirs;
+    }
+
+    static void s_release_all(nbench::context_t& ctx, dirpath_t* dirs, u32 count)
+    {
+        for (u32 i = 0; i < count; ++i)
+            dirs[i].~dirpath_t();
+        ctx.m_allocator->deallocate(dirs);
+    }
+} // namespace
+
+// Interning of individual folder names into the string pool, first pass inserts, second pass hits
+BENCHMARK(intern)
+{
+    workload_t w;
+    s_init_workload(ctx, w);
+    for (s32 s = 0; s < w.m_count; ++s)
+    {
+        nbench::pathlist_t const& list  = w.m_shapes[s].m_paths;
+        npath::paths_t*           paths = npath::g_construct_paths(ctx.m_allocator);
+
+        for (s32 pass = 0; pass < 2; ++pass)
+        {
+            nbench::result_t result;
+            nbench::init_result(result, pass == 0 ? w.m_shapes[s].m_name : "hit", 0);
+            nbench::sampler_t sampler;
+            sampler.init(ctx.m_allocator, (u64)list.m_count * 8);
+
+            nbench::measure_t measure;
+            sampler.begin();
+            for (u32 i = 0; i < list.m_count; ++i)
+            {
+                // every component after the device
+                const char* str = list.at(i);
+                const char* sep = strchr(str, ':');
+                const char* cur = sep != nullptr ? sep + 2 : str;
+                while (*cur != 0)
+                {
+                    const char* end = strchr(cur, '/');
+                    if (end == nullptr)
+                        end = cur + strlen(cur);
+                    crunes_t name = ascii::make_crunes(str, (u32)(cur - str), (u32)(end - str), (u32)(end - str));
+                    paths->find_or_insert_string(name);
+                    sampler.end(result.m_ops++);
+                    cur = *end != 0 ? end + 1 : end;
+                }
+            }
+            measure.stop(result);
+            sampler.finalize(result);
+            sampler.exit(ctx.m_allocator);
+            ctx.report(result);
+        }
+        npath::g_destruct_paths(ctx.m_allocator, paths);
+    }
+    s_exit_workload(ctx, w);
+}
+
+// register_fulldirpath on an empty registry, then again on the populated registry (pure lookup)
+BENCHMARK(register_fulldirpath)
+{
+    workload_t w;
+    s_init_workload(ctx, w);
+    for (s32 s = 0; s < w.m_count; ++s)
+    {
+        nbench::pathlist_t const& list  = w.m_shapes[s].m_paths;
+        npath::paths_t*           paths = npath::g_construct_paths(ctx.m_allocator);
+
+        for (s32 pass = 0; pass < 2; ++pass)
+        {
+            nbench::result_t result;
+            nbench::init_result(result, pass == 0 ? w.m_shapes[s].m_name : "lookup", list.m_count);
+            nbench::sampler_t sampler;
+            sampler.init(ctx.m_allocator, list.m_count);
+
+            nbench::measure_t measure;
+            sampler.begin();
+            for (u32 i = 0; i < list.m_count; ++i)
+            {
+                paths->register_fulldirpath(ascii::make_crunes(list.at(i)));
+                sampler.end(i);
+            }
+            measure.stop(result);
+            sampler.finalize(result);
+            sampler.exit(ctx.m_allocator);
+
+            result.m_bytes = s_committed_bytes(paths);
+            result.m_paths = list.m_count;
+            ctx.report(result);
+        }
+        npath::g_destruct_paths(ctx.m_allocator, paths);
+    }
+    s_exit_workload(ctx, w);
+}
+
+// Navigation: walk every registered path up to its device root, and step down to the first child
+BENCHMARK(down_up)
+{
+    workload_t w;
+    s_init_workload(ctx, w);
+    for (s32 s = 0; s < w.m_count; ++s)
+    {
+        nbench::pathlist_t const& list  = w.m_shapes[s].m_paths;
+        npath::paths_t*           paths = npath::g_construct_paths(ctx.m_allocator);
+        dirpath_t*                dirs  = s_register_all(ctx, paths, list);
+
+        nbench::result_t up;
+        nbench::init_result(up, w.m_shapes[s].m_name, 0);
+        nbench::measure_t measure_up;
+        for (u32 i = 0; i < list.m_count; ++i)
+        {
+            dirpath_t d     = dirs[i];
+            s32 const depth = d.depth();
+            for (s32 l = 0; l < depth; ++l)
+                d = d.up();
+            up.m_ops += depth;
+        }
+        measure_up.stop(up);
+        ctx.report(up);
+
+        nbench::result_t down;
+        nbench::init_result(down, "down", list.m_count);
+        nbench::measure_t measure_down;
+        for (u32 i = 0; i < list.m_count; ++i)
+            dirs[i].down();
+        measure_down.stop(down);
+        ctx.report(down);
+
+        s_release_all(ctx, dirs, list.m_count);
+        npath::g_destruct_paths(ctx.m_allocator, paths);
+    }
+    s_exit_workload(ctx, w);
+}
+
+BENCHMARK(compare)
+{
+    workload_t w;
+    s_init_workload(ctx, w);
+    for (s32 s = 0; s < w.m_count; ++s)
+    {
+        nbench::pathlist_t const& list  = w.m_shapes[s].m_paths;
+        npath::paths_t*           paths = npath::g_construct_paths(ctx.m_allocator);
+        dirpath_t*                dirs  = s_register_all(ctx, paths, list);
+
+        nbench::result_t result;
+        nbench::init_result(result, w.m_shapes[s].m_name, list.m_count - 1);
+        nbench::sampler_t sampler;
+        sampler.init(ctx.m_allocator, list.m_count);
+
+        s32               sum = 0;
+        nbench::measure_t measure;
+        sampler.begin();
+        for (u32 i = 1; i < list.m_count; ++i)
+        {
+            sum += dirs[i - 1].compare(dirs[i]);
+            sampler.end(i - 1);
+        }
+        measure.stop(result);
+        sampler.finalize(result);
+        sampler.exit(ctx.m_allocator);
+        result.m_bytes = (u64)(sum & 1); // keep the compares alive
+        ctx.report(result);
+
+        s_release_all(ctx, dirs, list.m_count);
+        npath::g_destruct_paths(ctx.m_allocator, paths);
+    }
+    s_exit_workload(ctx, w);
+}
+
+BENCHMARK(render)
+{
+    workload_t w;
+    s_init_workload(ctx, w);
+    for (s32 s = 0; s < w.m_count; ++s)
+    {
+        nbench::pathlist_t const& list  = w.m_shapes[s].m_paths;
+        npath::paths_t*           paths = npath::g_construct_paths(ctx.m_allocator);
+        dirpath_t*                dirs  = s_register_all(ctx, paths, list);
+
+        nbench::result_t result;
+        nbench::init_result(result, w.m_shapes[s].m_name, list.m_count);
+        nbench::sampler_t sampler;
+        sampler.init(ctx.m_allocator, list.m_count);
+
+        utf32::rune       buffer[4096];
+        nbench::measure_t measure;
+        sampler.begin();
+        for (u32 i = 0; i < list.m_count; ++i)
+        {
+            runes_t str(buffer, 0, 0, 4096);
+            dirs[i].full_path_to_string(str);
+            result.m_bytes += str.m_end;
+            sampler.end(i);
+        }
+        measure.stop(result);
+        sampler.finalize(result);
+        sampler.exit(ctx.m_allocator);
+        result.m_paths = list.m_count; // bytes/path = average rendered length
+        ctx.report(result);
+
+        s_release_all(ctx, dirs, list.m_count);
+        npath::g_destruct_paths(ctx.m_allocator, paths);
+    }
+    s_exit_workload(ctx, w);
+}
+
+// Depth-first walk over every folder below the device root of the first path, in registration order (pre-order and
+// post-order) and sorted by name. Ops are the folders yielded, the sorted walk pays for the lexicographic compares.
+BENCHMARK(walk)
+{
+    static const char* s_modes[] = {"pre-order", "post-order", "sorted"};
+    static const u32    s_flags[] = {npath::nwalk::PreOrder, npath::nwalk::PostOrder, npath::nwalk::PreOrder | npath::nwalk::SortedByName};
+
+    workload_t w;
+    s_init_workload(ctx, w);
+    for (s32 s = 0; s < w.m_count; ++s)
+    {
+        nbench::pathlist_t const& list  = w.m_shapes[s].m_paths;
+        npath::paths_t*           paths = npath::g_construct_paths(ctx.m_allocator);
+        dirpath_t*                dirs  = s_register_all(ctx, paths, list);
+        dirpath_t const           root  = dirs[0].device();
+
+        npath::walker_t* walker = npath::g_construct_walker(ctx.m_allocator, root);
+        for (u32 m = 0; m < 3; ++m)
+        {
+            nbench::result_t result;
+            nbench::init_result(result, m == 0 ? w.m_shapes[s].m_name : s_modes[m], 0);
+            nbench::measure_t measure;
+            walker->reset(root, s_flags[m]);
+            npath::walknode_t node;
+            while (walker->next(node))
+            {
+                result.m_ops += 1;
+                result.m_bytes += node.m_depth; // keep the nodes alive
+            }
+            measure.stop(result);
+            ctx.report(result);
+        }
+        npath::g_destruct_walker(ctx.m_allocator, walker);
+
+        s_release_all(ctx, dirs, list.m_count);
+        npath::g_destruct_paths(ctx.m_allocator, paths);
+    }
+    s_exit_workload(ctx, w);
+}
+
+// Device table: constructing an empty registry (its cost does not depend on how many devices it can hold),
+// registering 4096 devices (4096 * scale) by name, finding each of them by name and finding the device of each
+// device root folder (paths_t::device_of). Ops are registries for the first, devices for the others.
+BENCHMARK(devices)
+{
+    u32 const num_devices = 4096 * ctx.m_scale;
+
+    {
+        u32 const        count = 256;
+        nbench::result_t result;
+        nbench::init_result(result, "construct", count);
+        nbench::measure_t measure;
+        for (u32 i = 0; i < count; ++i)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(ctx.m_allocator);
+            npath::g_destruct_paths(ctx.m_allocator, paths);
+        }
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    npath::paths_t*  paths = npath::g_construct_paths(ctx.m_allocator);
+    npath::string_t* names = (npath::string_t*)ctx.m_allocator->allocate(num_devices * sizeof(npath::string_t));
+    char             name[32];
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "register", num_devices);
+        nbench::measure_t measure;
+        for (u32 i = 0; i < num_devices; ++i)
+        {
+            snprintf(name, sizeof(name), "tenant%u:", i);
+            names[i] = paths->register_device(ascii::make_crunes(name))->m_name;
+        }
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "find_device", num_devices);
+        nbench::measure_t measure;
+        for (u32 i = 0; i < num_devices; ++i)
+            result.m_bytes += paths->m_devices->find_device(names[i]) & 1;
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "device_of", num_devices);
+        nbench::measure_t measure;
+        for (npath::idevice_t i = 1; i <= (npath::idevice_t)num_devices; ++i)
+            result.m_bytes += paths->device_of(paths->m_devices->get_device(i)->m_path)->m_index & 1;
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    ctx.m_allocator->deallocate(names);
+    npath::g_destruct_paths(ctx.m_allocator, paths);
+}
+
+// Rendering the full path of 64K folders (64K * scale) that live 4 levels below "e:/", through the physical device and
+// through an alias 4 redirections away (a3: -> a2: -> a1: -> a0: -> e:/data/app/). The baseline is the walk from the
+// folder up to the top of its tree (paths_t::folder_to_string), the device renders its cached prefix and only walks
+// the folders below its root, an alias costs the same as the physical device. 'retarget' points a0: back and forth
+// between two folders, the three aliases that depend on it are moved along.
+BENCHMARK(aliases)
+{
+    u32 const       count = 64 * 1024 * ctx.m_scale;
+    npath::paths_t* paths = npath::g_construct_paths(ctx.m_allocator);
+    dirpath_t       app   = paths->register_fulldirpath(ascii::make_crunes("e:/data/app/"));
+    dirpath_t       other = paths->register_fulldirpath(ascii::make_crunes("e:/data/other/"));
+    paths->register_alias(ascii::make_crunes("a0:"), app);
+    paths->register_alias(ascii::make_crunes("a1:"), paths->register_fulldirpath(ascii::make_crunes("a0:/")));
+    paths->register_alias(ascii::make_crunes("a2:"), paths->register_fulldirpath(ascii::make_crunes("a1:/")));
+    npath::device_t* alias    = paths->register_alias(ascii::make_crunes("a3:"), paths->register_fulldirpath(ascii::make_crunes("a2:/")));
+    npath::device_t* physical = paths->register_device(ascii::make_crunes("e:"));
+
+    npath::node_t* folders = (npath::node_t*)ctx.m_allocator->allocate(count * sizeof(npath::node_t));
+    char           name[64];
+    for (u32 i = 0; i < count; ++i)
+    {
+        snprintf(name, sizeof(name), "a3:/bin%u/", i);
+        dirpath_t const dir = paths->register_fulldirpath(ascii::make_crunes(name));
+        folders[i]          = paths->m_files->m_array.ptr_of(paths->file_of(dir.filename(ascii::make_crunes("x"))))->m_folder;
+    }
+
+    utf32::rune runes[256];
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "walk to the top", count);
+        nbench::measure_t measure;
+        for (u32 i = 0; i < count; ++i)
+        {
+            runes_t r(runes, 0, 0, 256);
+            paths->folder_to_string(folders[i], npath::c_invalid_node, r);
+            result.m_bytes += (u32)(r.m_end - r.m_str);
+        }
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "physical device", count);
+        nbench::measure_t measure;
+        for (u32 i = 0; i < count; ++i)
+        {
+            runes_t r(runes, 0, 0, 256);
+            physical->to_string(folders[i], r);
+            result.m_bytes += (u32)(r.m_end - r.m_str);
+        }
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "alias (4 hops)", count);
+        nbench::measure_t measure;
+        for (u32 i = 0; i < count; ++i)
+        {
+            runes_t r(runes, 0, 0, 256);
+            alias->to_string(folders[i], r);
+            result.m_bytes += (u32)(r.m_end - r.m_str);
+        }
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    {
+        u32 const        rounds = 1024;
+        nbench::result_t result;
+        nbench::init_result(result, "retarget", rounds);
+        nbench::measure_t measure;
+        for (u32 i = 0; i < rounds; ++i)
+            paths->register_alias(ascii::make_crunes("a0:"), (i & 1) ? app : other);
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    ctx.m_allocator->deallocate(folders);
+    npath::g_destruct_paths(ctx.m_allocator, paths);
+}
+
+// An asset union over three layers: base has 64K files (64K * scale) in 256 folders, dlc has every 10th and patch
+// every 100th of them. Every file is looked up once in a scrambled order. The baseline checks the layers in turn
+// with the names as strings: look up the interned folder and file names and descend the tree of the layer. The
+// union resolves through its own tree, the first lookup of a path descends the layers by string_t, after that the
+// resolution is cached per node. 'after a change' adds a file to a layer, which invalidates the cache, and looks
+// everything up again.
+BENCHMARK(unions)
+{
+    u32 const        count = 64 * 1024 * ctx.m_scale;
+    npath::paths_t*  paths = npath::g_construct_paths(ctx.m_allocator);
+    const char*      roots[3]  = {"e:/patch/", "e:/dlc/", "e:/base/"};
+    const char*      names[3]  = {"patch:", "dlc:", "base:"};
+    u32 const        every[3]  = {100, 10, 1};
+    npath::device_t* layers[3];
+    char             name[64];
+    for (u32 l = 0; l < 3; ++l)
+    {
+        dirpath_t const root = paths->register_fulldirpath(ascii::make_crunes(roots[l]));
+        layers[l]            = paths->register_alias(ascii::make_crunes(names[l]), root);
+        for (u32 i = 0; i < count; i += every[l])
+        {
+            snprintf(name, sizeof(name), "%sdir%u/", names[l], i % 256);
+            dirpath_t const dir = paths->register_fulldirpath(ascii::make_crunes(name));
+            snprintf(name, sizeof(name), "file%u.png", i);
+            paths->file_of(dir.filename(ascii::make_crunes(name)));
+        }
+    }
+    paths->register_union(ascii::make_crunes("assets:"), layers, 3);
+
+    filepath_t* files = (filepath_t*)ctx.m_allocator->allocate(count * sizeof(filepath_t));
+    for (u32 i = 0; i < count; ++i)
+    {
+        u32 const n = (u32)(((u64)i * 2654435761u) % count);
+        snprintf(name, sizeof(name), "assets:/dir%u/", n % 256);
+        dirpath_t const dir = paths->register_fulldirpath(ascii::make_crunes(name));
+        snprintf(name, sizeof(name), "file%u.png", n);
+        new (&files[i]) filepath_t(dir.filename(ascii::make_crunes(name)));
+    }
+
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "strings per layer", count);
+        nbench::measure_t measure;
+        char              dirname[16];
+        for (u32 i = 0; i < count; ++i)
+        {
+            u32 const n = (u32)(((u64)i * 2654435761u) % count);
+            snprintf(dirname, sizeof(dirname), "dir%u", n % 256);
+            snprintf(name, sizeof(name), "file%u", n);
+            for (u32 l = 0; l < 3; ++l)
+            {
+                npath::node_t const dir = layers[l]->find_dir(layers[l]->m_path, paths->find_string(ascii::make_crunes(dirname)));
+                if (dir == npath::c_invalid_node)
+                    continue;
+                npath::ifile_t const file = layers[l]->find_file(dir, paths->find_string(ascii::make_crunes(name)), paths->find_string(ascii::make_crunes(".png")));
+                if (file != npath::c_invalid_file)
+                {
+                    result.m_bytes += l;
+                    break;
+                }
+            }
+        }
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    filepath_t out(paths->m_devices->get_default_device());
+    static const char* configs[3] = {"union (cold)", "union (cached)", "after a change"};
+    for (u32 pass = 0; pass < 3; ++pass)
+    {
+        if (pass == 2)
+            paths->file_of(paths->register_fulldirpath(ascii::make_crunes("base:/dir0/")).filename(ascii::make_crunes("new.png")));
+        nbench::result_t result;
+        nbench::init_result(result, configs[pass], count);
+        nbench::measure_t measure;
+        for (u32 i = 0; i < count; ++i)
+            result.m_bytes += paths->resolve(files[i], out) ? 1 : 0;
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    for (u32 i = 0; i < count; ++i)
+        files[i].~filepath_t();
+    ctx.m_allocator->deallocate(files);
+    npath::g_destruct_paths(ctx.m_allocator, paths);
+}
+
+// What callers did before the registration normalized: copy the path and normalize the copy (separators, "." and "..")
+static u32 s_normalize_copy(const char* src, char* dst)
+{
+    u32 len = 0;
+    u32 marks[64]; // start of each folder in dst
+    u32 depth = 0;
+    for (const char* s = src; *s != 0;)
+    {
+        const char* e = s;
+        while (*e != 0 && *e != '/' && *e != '\\')
+            ++e;
+        u32 const n = (u32)(e - s);
+        if (n == 2 && s[0] == '.' && s[1] == '.')
+            len = depth > 0 ? marks[--depth] : len;
+        else if (n > 1 || (n == 1 && s[0] != '.'))
+        {
+            marks[depth++] = len;
+            memcpy(dst + len, s, n);
+            len += n;
+            dst[len++] = '/';
+        }
+        s = (*e != 0) ? e + 1 : e;
+    }
+    dst[len] = 0;
+    return len;
+}
+
+// Registering 64K paths (64K * scale) of 4 folders that exist already, written clean ("n:/dir1/dir2/dir3/dir4/") and
+// unnormalized ("n:\dir1//./dir2/tmp/../dir3\dir4\"), and the unnormalized ones copied and normalized by the caller
+// before they are registered.
+BENCHMARK(normalize)
+{
+    u32 const       count = 64 * 1024 * ctx.m_scale;
+    npath::paths_t* paths = npath::g_construct_paths(ctx.m_allocator);
+    char*           clean = (char*)ctx.m_allocator->allocate(count * 64);
+    char*           messy = (char*)ctx.m_allocator->allocate(count * 64);
+    for (u32 i = 0; i < count; ++i)
+    {
+        u32 const a = i % 16, b = (i / 16) % 16, c = (i / 256) % 16, d = i / 4096;
+        snprintf(clean + i * 64, 64, "n:/d%u/d%u/d%u/d%u/", a, b, c, d);
+        snprintf(messy + i * 64, 64, "n:\\d%u//./d%u/tmp/../d%u\\d%u\\", a, b, c, d);
+        paths->register_fulldirpath(ascii::make_crunes(clean + i * 64));
+    }
+
+    static const char* configs[3] = {"clean", "unnormalized", "copy+normalize"};
+    char               copy[64];
+    for (u32 pass = 0; pass < 3; ++pass)
+    {
+        nbench::result_t result;
+        nbench::init_result(result, configs[pass], count);
+        nbench::measure_t measure;
+        for (u32 i = 0; i < count; ++i)
+        {
+            const char* path = (pass == 0 ? clean : messy) + i * 64;
+            if (pass == 2)
+            {
+                copy[0] = path[0];
+                copy[1] = path[1];
+                s_normalize_copy(path + 2, copy + 2);
+                path = copy;
+            }
+            result.m_bytes += paths->register_fulldirpath(ascii::make_crunes(path)).isEmpty() ? 0 : 1;
+        }
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    ctx.m_allocator->deallocate(messy);
+    ctx.m_allocator->deallocate(clean);
+    npath::g_destruct_paths(ctx.m_allocator, paths);
+}
+
+// Registering 64K POSIX paths (64K * scale) that exist already, below 512 mount prefixes ("/mnt/vol17/" -> "vol17:")
+// and on the root device ("/srv/..."). The baseline finds the longest prefix by comparing the path with every
+// prefix string and registers the rest on its device, the trie steps down one component at a time.
+BENCHMARK(prefixes)
+{
+    u32 const         count    = 64 * 1024 * ctx.m_scale;
+    u32 const         mounts   = 512;
+    npath::paths_t*   paths    = npath::g_construct_paths(ctx.m_allocator);
+    char*             prefixes = (char*)ctx.m_allocator->allocate(mounts * 32);
+    npath::device_t** devices  = (npath::device_t**)ctx.m_allocator->allocate(mounts * sizeof(npath::device_t*));
+    char              name[64];
+    for (u32 m = 0; m < mounts; ++m)
+    {
+        snprintf(name, sizeof(name), "vol%u:", m);
+        devices[m] = paths->register_device(ascii::make_crunes(name));
+        snprintf(prefixes + m * 32, 32, "/mnt/vol%u/", m);
+        paths->register_prefix(ascii::make_crunes(prefixes + m * 32), devices[m]);
+    }
+
+    char* mounted = (char*)ctx.m_allocator->allocate(count * 64);
+    char* rooted  = (char*)ctx.m_allocator->allocate(count * 64);
+    for (u32 i = 0; i < count; ++i)
+    {
+        u32 const m = (u32)(((u64)i * 2654435761u) % mounts);
+        snprintf(mounted + i * 64, 64, "/mnt/vol%u/d%u/e%u/", m, i % 64, i);
+        snprintf(rooted + i * 64, 64, "/srv/vol%u/d%u/e%u/", m, i % 64, i);
+        paths->register_fulldirpath(ascii::make_crunes(mounted + i * 64));
+        paths->register_fulldirpath(ascii::make_crunes(rooted + i * 64));
+    }
+
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "linear prefix scan", count);
+        nbench::measure_t measure;
+        for (u32 i = 0; i < count; ++i)
+        {
+            const char* path = mounted + i * 64;
+            u32         best = mounts, best_len = 0;
+            for (u32 m = 0; m < mounts; ++m)
+            {
+                u32 const len = (u32)strlen(prefixes + m * 32);
+                if (len > best_len && strncmp(path, prefixes + m * 32, len) == 0)
+                {
+                    best     = m;
+                    best_len = len;
+                }
+            }
+            u32 const len = (u32)strlen(path);
+            dirpath_t dir(devices[best]);
+            devices[best]->register_dirpath(ascii::make_crunes(path, best_len, len, len), dir);
+            result.m_bytes += dir.isEmpty() ? 0 : 1;
+        }
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    static const char* configs[2] = {"trie (512 prefixes)", "root device"};
+    for (u32 pass = 0; pass < 2; ++pass)
+    {
+        const char*      paths_of = pass == 0 ? mounted : rooted;
+        nbench::result_t result;
+        nbench::init_result(result, configs[pass], count);
+        nbench::measure_t measure;
+        for (u32 i = 0; i < count; ++i)
+            result.m_bytes += paths->register_fulldirpath(ascii::make_crunes(paths_of + i * 64)).isEmpty() ? 0 : 1;
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    ctx.m_allocator->deallocate(rooted);
+    ctx.m_allocator->deallocate(mounted);
+    ctx.m_allocator->deallocate(devices);
+    ctx.m_allocator->deallocate(prefixes);
+    npath::g_destruct_paths(ctx.m_allocator, paths);
+}
@@ -0,0 +1,301 @@
+#include "ccore/c_target.h"
+#include "cbase/c_runes.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_filepath.h"
+#include "cpath/c_scanner.h"
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(TARGET_LINUX) || defined(TARGET_MAC)
+#    include <dirent.h>
+#    include <fcntl.h>
+#    include <stdlib.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+
+using namespace ncore;
+
+namespace
+{
+    static const char* s_extensions[] = {".cpp", ".h", ".txt", ".md"};
+    static const u32   c_files_per_dir = 4;
+
+    // Materialize a generated source tree on disk, every folder gets a few files
+    static bool s_create_tree(nbench::pathlist_t const& list, const char* root)
+    {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/src", root);
+        if (mkdir(path, 0755) != 0)
+            return false;
+        for (u32 i = 0; i < list.m_count; ++i)
+        {
+            const char* rel = strchr(list.at(i), '/'); // skip the "bench:" device
+            s32 const   len = snprintf(path, sizeof(path), "%s%s", root, rel);
+            mkdir(path, 0755);
+            for (u32 f = 0; f < c_files_per_dir; ++f)
+            {
+                snprintf(path + len, sizeof(path) - len, "file%u%s", f, s_extensions[f]);
+                s32 const fd = open(path, O_CREAT | O_WRONLY, 0644);
+                if (fd >= 0)
+                    close(fd);
+            }
+        }
+        return true;
+    }
+
+    static void s_remove_tree(nbench::pathlist_t const& list, const char* root)
+    {
+        char path[4096];
+        for (u32 i = list.m_count; i > 0; --i)
+        {
+            const char* rel = strchr(list.at(i - 1), '/');
+            s32 const   len = snprintf(path, sizeof(path), "%s%s", root, rel);
+            for (u32 f = 0; f < c_files_per_dir; ++f)
+            {
+                snprintf(path + len, sizeof(path) - len, "file%u%s", f, s_extensions[f]);
+                unlink(path);
+            }
+            path[len] = 0;
+            rmdir(path);
+        }
+        snprintf(path, sizeof(path), "%s/src", root);
+        rmdir(path);
+        rmdir(root);
+    }
+
+    struct walk_t
+    {
+        npath::paths_t* m_paths; // nullptr = only enumerate
+        u64             m_entries;
+        char            m_ospath[4096];
+        char            m_regpath[4096]; // "walk:/relative/path/"
+    };
+
+    // What an indexer without cpath support does: a single threaded readdir walk that builds the full
+    // path of every entry and registers it through the string interface.
+    static void s_readdir_walk(walk_t& walk, s32 oslen, s32 reglen)
+    {
+        DIR* dir = opendir(walk.m_ospath);
+        if (dir == nullptr)
+            return;
+
+        dirpath_t dirpath = walk.m_paths != nullptr ? walk.m_paths->register_fulldirpath(ascii::make_crunes(walk.m_regpath)) : dirpath_t(nullptr);
+        while (struct dirent* entry = readdir(dir))
+        {
+            const char* name = entry->d_name;
+            if (name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0)))
+                continue;
+            walk.m_entries += 1;
+            if (entry->d_type == DT_DIR)
+            {
+                s32 const sub_oslen  = oslen + snprintf(walk.m_ospath + oslen, sizeof(walk.m_ospath) - oslen, "/%s", name);
+                s32 const sub_reglen = reglen + snprintf(walk.m_regpath + reglen, sizeof(walk.m_regpath) - reglen, "%s/", name);
+                s_readdir_walk(walk, sub_oslen, sub_reglen);
+                walk.m_ospath[oslen]   = 0;
+                walk.m_regpath[reglen] = 0;
+            }
+            else if (walk.m_paths != nullptr)
+            {
+                dirpath.filename(ascii::make_crunes(name));
+            }
+        }
+        closedir(dir);
+    }
+
+    static void s_report_walk(nbench::context_t& ctx, const char* root, const char* config, bool do_register)
+    {
+        walk_t walk;
+        walk.m_paths   = do_register ? npath::g_construct_paths(ctx.m_allocator) : nullptr;
+        walk.m_entries = 0;
+        s32 const oslen  = snprintf(walk.m_ospath, sizeof(walk.m_ospath), "%s", root);
+        s32 const reglen = snprintf(walk.m_regpath, sizeof(walk.m_regpath), "walk:/");
+
+        nbench::result_t result;
+        nbench::init_result(result, config, 0);
+        nbench::measure_t measure;
+        s_readdir_walk(walk, oslen, reglen);
+        measure.stop(result);
+        result.m_ops = walk.m_entries;
+        ctx.report(result);
+
+        if (walk.m_paths != nullptr)
+            npath::g_destruct_paths(ctx.m_allocator, walk.m_paths);
+    }
+
+    static void s_report_scan(nbench::context_t& ctx, const char* root, const char* config, u32 num_threads)
+    {
+        npath::paths_t* paths = npath::g_construct_paths(ctx.m_allocator);
+        dirpath_t       scan  = paths->register_fulldirpath(ascii::make_crunes("scan:/"));
+
+        npath::scan_config_t scan_config = npath::g_default_scan_config;
+        scan_config.m_num_threads        = num_threads;
+        npath::scan_stats_t stats;
+
+        nbench::result_t result;
+        nbench::init_result(result, config, 0);
+        nbench::measure_t measure;
+        npath::scanner_t::scan(scan, root, scan_config, stats);
+        measure.stop(result);
+        result.m_ops = (stats.m_folders - 1) + stats.m_files + stats.m_symlinks + stats.m_others;
+        ctx.report(result);
+
+        npath::g_destruct_paths(ctx.m_allocator, paths);
+    }
+    // A generated source tree in /tmp, or the folder given with '--scan <dir>' (then 'list' stays empty)
+    static bool s_open_tree(nbench::context_t& ctx, nbench::pathlist_t& list, u32 count, char* root, u32 root_size)
+    {
+        list.m_count = 0;
+        if (nbench::g_scan_root != nullptr)
+        {
+            snprintf(root, root_size, "%s", nbench::g_scan_root);
+            return true;
+        }
+        nbench::init_pathlist(ctx.m_allocator, list, count, (u64)count * 128);
+        nbench::generate_source_tree(list, count, 7);
+        snprintf(root, root_size, "/tmp/cpath_bench_XXXXXX");
+        if (mkdtemp(root) == nullptr || !s_create_tree(list, root))
+        {
+            rmdir(root);
+            nbench::exit_pathlist(ctx.m_allocator, list);
+            return false;
+        }
+        return true;
+    }
+
+    static void s_close_tree(nbench::context_t& ctx, nbench::pathlist_t& list, const char* root)
+    {
+        if (nbench::g_scan_root != nullptr)
+            return;
+        s_remove_tree(list, root);
+        nbench::exit_pathlist(ctx.m_allocator, list);
+    }
+
+    // Navigate to every sampled path with down(name), the folders on the way are read on first touch
+    static void s_report_touch(nbench::context_t& ctx, dirpath_t const& lazy, nbench::pathlist_t const& list, const char* config, u32 step)
+    {
+        nbench::result_t result;
+        nbench::init_result(result, config, 0);
+        nbench::sampler_t sampler;
+        sampler.init(ctx.m_allocator, list.m_count / step + 1);
+
+        nbench::measure_t measure;
+        sampler.begin();
+        for (u32 i = 0; i < list.m_count; i += step)
+        {
+            const char* str = list.at(i);
+            const char* cur = strchr(str, '/') + 1; // skip the "bench:" device
+            dirpath_t   dir = lazy;
+            while (*cur != 0)
+            {
+                const char* end = strchr(cur, '/');
+                dir             = dir.down(ascii::make_crunes(str, (u32)(cur - str), (u32)(end - str), (u32)(end - str)));
+                cur             = end + 1;
+            }
+            dir.down(); // and the leaf itself
+            sampler.end(result.m_ops++);
+        }
+        measure.stop(result);
+        sampler.finalize(result);
+        sampler.exit(ctx.m_allocator);
+        ctx.report(result);
+    }
+} // namespace
+
+// Populate a registry from disk: single threaded readdir (with and without registering every path
+// through the string interface) against the parallel scanner. Uses '--scan <dir>' when given,
+// otherwise a generated source tree in /tmp. Ops are directory entries.
+BENCHMARK(scan)
+{
+    char               root[512];
+    nbench::pathlist_t list;
+    if (!s_open_tree(ctx, list, 16 * 1024 * ctx.m_scale, root, sizeof(root)))
+        return;
+
+    // warm the dentry and inode caches, we measure enumeration and registration, not the disk
+    s_report_walk(ctx, root, "warmup", false);
+
+    char      config[64];
+    u32 const threads = npath::g_default_scan_config.m_num_threads != 0 ? npath::g_default_scan_config.m_num_threads : (u32)sysconf(_SC_NPROCESSORS_ONLN);
+    s_report_walk(ctx, root, "readdir", false);
+    s_report_walk(ctx, root, "readdir+register", true);
+    s_report_scan(ctx, root, "scanner/1", 1);
+    snprintf(config, sizeof(config), "scanner/%u", threads);
+    s_report_scan(ctx, root, config, threads);
+
+    s_close_tree(ctx, list, root);
+}
+
+// Lazy materialization: nothing is read until a folder is enumerated. Reports the cost of making the whole
+// tree available with an eager scan, the first touch of the root, the first touch of sampled paths (every
+// folder on the way is read from disk) and touching them again. The generated tree has about 1M entries
+// (200K folders with 4 files each), with '--scan <dir>' only the scan and the root are measured.
+BENCHMARK(lazy)
+{
+    char               root[512];
+    nbench::pathlist_t list;
+    if (!s_open_tree(ctx, list, 200 * 1024 * ctx.m_scale, root, sizeof(root)))
+        return;
+
+    s_report_walk(ctx, root, "warmup", false);
+    s_report_scan(ctx, root, "eager scan/1", 1);
+
+    npath::paths_t* paths = npath::g_construct_paths(ctx.m_allocator);
+    dirpath_t       lazy  = paths->register_fulldirpath(ascii::make_crunes("lazy:/"));
+    paths->enable_lazy(lazy, root);
+
+    nbench::result_t result;
+    nbench::init_result(result, "root first touch", 1);
+    nbench::measure_t measure;
+    lazy.down();
+    measure.stop(result);
+    ctx.report(result);
+
+    if (list.m_count > 0)
+    {
+        s_report_touch(ctx, lazy, list, "path first touch", 64);
+        s_report_touch(ctx, lazy, list, "path second touch", 64);
+    }
+
+    npath::g_destruct_paths(ctx.m_allocator, paths);
+    s_close_tree(ctx, list, root);
+}
+
+// Content hashes: the first pass hashes every file, the second finds every hash valid (same size and mtime)
+// and reads nothing. The generated files are empty, so this measures the per-file cost of the pass, with
+// '--scan <dir>' real contents are hashed. Ops are files.
+BENCHMARK(hash)
+{
+    char               root[512];
+    nbench::pathlist_t list;
+    if (!s_open_tree(ctx, list, 16 * 1024 * ctx.m_scale, root, sizeof(root)))
+        return;
+
+    npath::paths_t* paths = npath::g_construct_paths(ctx.m_allocator);
+    dirpath_t       scan  = paths->register_fulldirpath(ascii::make_crunes("hash:/"));
+
+    npath::scan_config_t config = npath::g_default_scan_config;
+    npath::scan_stats_t  stats;
+    npath::scanner_t::scan(scan, root, config, stats);
+
+    const char* configs[] = {"hash all", "hash unchanged"};
+    for (u32 pass = 0; pass < 2; ++pass)
+    {
+        nbench::result_t result;
+        nbench::init_result(result, configs[pass], 0);
+        nbench::measure_t measure;
+        npath::scanner_t::hash(scan, root, config, stats);
+        measure.stop(result);
+        result.m_ops = stats.m_files;
+        ctx.report(result);
+    }
+
+    npath::g_destruct_paths(ctx.m_allocator, paths);
+    s_close_tree(ctx, list, root);
+}
+
+#endif
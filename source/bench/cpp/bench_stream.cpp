@@ -0,0 +1,258 @@
+#include "ccore/c_target.h"
+#include "cbase/c_runes.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_filepath.h"
+#include "cpath/c_filestream.h"
+#include "cpath/c_batchread.h"
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(TARGET_LINUX) || defined(TARGET_MAC)
+#    include <fcntl.h>
+#    include <stdlib.h>
+#    include <unistd.h>
+
+using namespace ncore;
+
+namespace
+{
+    static const u32   c_small_size = 4 * 1024;
+    static const u32   c_chunk_size = 64 * 1024;
+    static u8          s_chunk[c_chunk_size];
+    static volatile u8 s_sink; // keeps the checksums alive
+
+    static bool s_write_file(const char* path, u64 size)
+    {
+        s32 const fd = open(path, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+        if (fd < 0)
+            return false;
+        for (u64 written = 0; written < size; written += c_chunk_size)
+        {
+            u64 const n = (size - written) < c_chunk_size ? (size - written) : c_chunk_size;
+            if (write(fd, s_chunk, n) != (ssize_t)n)
+                break;
+        }
+        close(fd);
+        return true;
+    }
+
+    // Touch every 64th byte of what was read, so the reads can't be skipped
+    static u8 s_checksum(u8 const* data, u64 size)
+    {
+        u8 sum = 0;
+        for (u64 i = 0; i < size; i += 64)
+            sum += data[i];
+        return sum;
+    }
+
+    enum emethod
+    {
+        MethodFread,
+        MethodMapped,
+        MethodSequential,
+    };
+
+    static u64 s_read_fread(const char* path)
+    {
+        FILE* file = fopen(path, "rb");
+        if (file == nullptr)
+            return 0;
+        u64 total = 0;
+        while (size_t n = fread(s_chunk, 1, c_chunk_size, file))
+        {
+            s_sink += s_checksum(s_chunk, n);
+            total += n;
+        }
+        fclose(file);
+        return total;
+    }
+
+    static u64 s_read_stream(filepath_t const& filepath, emethod method)
+    {
+        filestream_t stream = open_filestream(filepath, method == MethodMapped ? npath::nstream::ModeMapped : npath::nstream::ModeSequential);
+        u64          total  = 0;
+        if (method == MethodMapped)
+        {
+            u8 const* view = nullptr;
+            while (u64 n = stream.view(view, c_chunk_size))
+            {
+                s_sink += s_checksum(view, n);
+                total += n;
+            }
+        }
+        else
+        {
+            while (u64 n = stream.read(s_chunk, c_chunk_size))
+            {
+                s_sink += s_checksum(s_chunk, n);
+                total += n;
+            }
+        }
+        stream.close();
+        return total;
+    }
+
+    struct fileset_t
+    {
+        char            m_root[512];
+        u32             m_count;
+        npath::paths_t* m_paths;
+        filepath_t*     m_filepaths;
+    };
+
+    // 'passes' reads every file of the set that many times, ops are files read
+    static void s_report_read(nbench::context_t& ctx, fileset_t& set, const char* config, emethod method, bool use_fread, u32 passes)
+    {
+        nbench::result_t result;
+        nbench::init_result(result, config, 0);
+        char              path[1024];
+        nbench::measure_t measure;
+        for (u32 p = 0; p < passes; ++p)
+        {
+            for (u32 i = 0; i < set.m_count; ++i)
+            {
+                if (use_fread)
+                {
+                    snprintf(path, sizeof(path), "%s/file%u.bin", set.m_root, i);
+                    s_read_fread(path);
+                }
+                else
+                {
+                    s_read_stream(set.m_filepaths[i], method);
+                }
+                result.m_ops += 1;
+            }
+        }
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    static bool s_open_fileset(nbench::context_t& ctx, fileset_t& set, u32 count, u64 size)
+    {
+        snprintf(set.m_root, sizeof(set.m_root), "/tmp/cpath_stream_XXXXXX");
+        if (mkdtemp(set.m_root) == nullptr)
+            return false;
+
+        set.m_count     = count;
+        set.m_paths     = npath::g_construct_paths(ctx.m_allocator);
+        set.m_filepaths = g_allocate_array<filepath_t>(ctx.m_allocator, count);
+
+        dirpath_t dir = set.m_paths->register_fulldirpath(ascii::make_crunes("stream:/"));
+        set.m_paths->mount(dir, set.m_root);
+
+        char path[1024];
+        char name[64];
+        for (u32 i = 0; i < count; ++i)
+        {
+            snprintf(path, sizeof(path), "%s/file%u.bin", set.m_root, i);
+            snprintf(name, sizeof(name), "file%u.bin", i);
+            s_write_file(path, size);
+            new (&set.m_filepaths[i]) filepath_t(dir.filename(ascii::make_crunes(name)));
+        }
+        return true;
+    }
+
+    // All files of the set read into one buffer of 'size' bytes per file through a batchreader_t, ops are files
+    static void s_report_batch(nbench::context_t& ctx, fileset_t& set, const char* config, u8 backend, u64 size)
+    {
+        u8*    storage = g_allocate_array<u8>(ctx.m_allocator, (u32)(size * set.m_count));
+        void** buffers = g_allocate_array<void*>(ctx.m_allocator, set.m_count);
+        u64*   sizes   = g_allocate_array<u64>(ctx.m_allocator, set.m_count);
+        for (u32 i = 0; i < set.m_count; ++i)
+        {
+            buffers[i] = storage + i * size;
+            sizes[i]   = size;
+        }
+
+        npath::batch_config_t batch = npath::g_default_batch_config;
+        batch.m_backend             = backend;
+        npath::batchreader_t* reader = npath::g_construct_batchreader(ctx.m_allocator, set.m_paths, batch);
+        if (backend != npath::nbatch::BackendUring || reader->backend() == npath::nbatch::BackendUring)
+        {
+            nbench::result_t result;
+            nbench::init_result(result, config, set.m_count);
+            nbench::measure_t measure;
+            reader->submit(set.m_filepaths, buffers, sizes, set.m_count);
+            npath::read_result_t results[256];
+            while (reader->pending() > 0)
+            {
+                u32 const n = reader->poll(results, 256, true);
+                for (u32 i = 0; i < n; ++i)
+                    s_sink += s_checksum((u8 const*)buffers[results[i].m_request], results[i].m_bytes);
+            }
+            measure.stop(result);
+            ctx.report(result);
+        }
+        npath::g_destruct_batchreader(ctx.m_allocator, reader);
+
+        g_deallocate_array(ctx.m_allocator, storage);
+        g_deallocate_array(ctx.m_allocator, buffers);
+        g_deallocate_array(ctx.m_allocator, sizes);
+    }
+
+    static void s_close_fileset(nbench::context_t& ctx, fileset_t& set)
+    {
+        char path[1024];
+        for (u32 i = 0; i < set.m_count; ++i)
+        {
+            set.m_filepaths[i].~filepath_t();
+            snprintf(path, sizeof(path), "%s/file%u.bin", set.m_root, i);
+            unlink(path);
+        }
+        g_deallocate_array(ctx.m_allocator, set.m_filepaths);
+        npath::g_destruct_paths(ctx.m_allocator, set.m_paths);
+        rmdir(set.m_root);
+    }
+} // namespace
+
+// Reading whole files with fread against filestream_t, mapped (zero-copy views) and sequential (buffered
+// pread with readahead hints). The files are in the page cache, the first pass warms it. 'small' reads 4096
+// files of 4KB each twice (more files than the idle pool keeps open), 'large' reads one 64MB file four times,
+// its mapping is reused by every pass after the first.
+BENCHMARK(filestream)
+{
+    for (u32 i = 0; i < c_chunk_size; ++i)
+        s_chunk[i] = (u8)(i * 31);
+
+    fileset_t small;
+    if (!s_open_fileset(ctx, small, 4096 * ctx.m_scale, c_small_size))
+        return;
+    s_report_read(ctx, small, "warmup", MethodFread, true, 1);
+    s_report_read(ctx, small, "small fread", MethodFread, true, 2);
+    s_report_read(ctx, small, "small sequential", MethodSequential, false, 2);
+    s_report_read(ctx, small, "small mapped", MethodMapped, false, 2);
+    s_close_fileset(ctx, small);
+
+    fileset_t large;
+    if (!s_open_fileset(ctx, large, 1, (u64)64 * 1024 * 1024 * ctx.m_scale))
+        return;
+    s_report_read(ctx, large, "warmup", MethodFread, true, 1);
+    s_report_read(ctx, large, "large fread", MethodFread, true, 4);
+    s_report_read(ctx, large, "large sequential", MethodSequential, false, 4);
+    s_report_read(ctx, large, "large mapped", MethodMapped, false, 4);
+    s_close_fileset(ctx, large);
+}
+
+// Reading 4096 small files: one after the other with fread against a batchreader_t with io_uring (64 reads in
+// flight, skipped when the kernel doesn't allow io_uring) and with the thread pool. Ops are files.
+BENCHMARK(batchread)
+{
+    for (u32 i = 0; i < c_chunk_size; ++i)
+        s_chunk[i] = (u8)(i * 7);
+
+    fileset_t set;
+    if (!s_open_fileset(ctx, set, 4096 * ctx.m_scale, c_small_size))
+        return;
+    s_report_read(ctx, set, "warmup", MethodFread, true, 1);
+    s_report_read(ctx, set, "fread", MethodFread, true, 1);
+    s_report_batch(ctx, set, "batch/io_uring", npath::nbatch::BackendUring, c_small_size);
+    s_report_batch(ctx, set, "batch/threads", npath::nbatch::BackendThreads, c_small_size);
+    s_close_fileset(ctx, set);
+}
+
+#endif
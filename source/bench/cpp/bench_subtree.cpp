@@ -0,0 +1,181 @@
+#include "ccore/c_target.h"
+#include "cbase/c_runes.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_filepath.h"
+#include "cpath/c_subtree.h"
+
+#include "bench.h"
+
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+using namespace ncore;
+
+namespace
+{
+    struct usage_t
+    {
+        u64 m_folders;
+        u64 m_files;
+        u64 m_names; // sum of the file name ids, touches every file node
+    };
+
+    // The bytes of a folder without rollups, on the calling thread
+    static void s_bytes(npath::paths_t* paths, npath::ifile_t file, void* acc, void* user)
+    {
+        npath::filestat_t fs;
+        if (paths->get_file_stat(file, fs))
+            ((usage_t*)acc)->m_names += fs.m_size;
+    }
+
+    static void s_init(void* acc, void* user) { memset(acc, 0, sizeof(usage_t)); }
+    static void s_folder(npath::paths_t* paths, npath::node_t folder, void* acc, void* user) { ((usage_t*)acc)->m_folders += 1; }
+    static void s_file(npath::paths_t* paths, npath::ifile_t file, void* acc, void* user)
+    {
+        usage_t* u = (usage_t*)acc;
+        u->m_files += 1;
+        u->m_names += file;
+    }
+    static void s_merge(void* acc, void const* other, void* user)
+    {
+        usage_t*       u = (usage_t*)acc;
+        usage_t const* o = (usage_t const*)other;
+        u->m_folders += o->m_folders;
+        u->m_files += o->m_files;
+        u->m_names += o->m_names;
+    }
+} // namespace
+
+// Scaling of subtree_t::parallel_reduce over a generated source tree with two files per folder, the reducer counts
+// folders and files (the per-worker accumulators are merged at the end). Scale 1 is about 2M nodes, --scale 10 is
+// the 20M node tree. Ops are nodes visited, the configuration is the number of workers (0 = hardware threads).
+BENCHMARK(subtree)
+{
+    u32 const          count = 1024 * 1024 * ctx.m_scale;
+    nbench::pathlist_t list;
+    nbench::init_pathlist(ctx.m_allocator, list, count, (u64)count * 128);
+    nbench::generate_source_tree(list, count, 1);
+
+    npath::paths_t* paths = npath::g_construct_paths(ctx.m_allocator);
+    dirpath_t       root  = paths->register_fulldirpath(ascii::make_crunes("bench:/"));
+    for (u32 i = 0; i < list.m_count; ++i)
+    {
+        dirpath_t dir = paths->register_fulldirpath(ascii::make_crunes(list.at(i)));
+        paths->file_of(dir.filename(ascii::make_crunes("a.cpp")));
+        paths->file_of(dir.filename(ascii::make_crunes("b.h")));
+    }
+
+    static const u32   s_threads[] = {1, 2, 4, 8, 16, 0};
+    static const char* s_configs[] = {"reduce/1", "reduce/2", "reduce/4", "reduce/8", "reduce/16", "reduce/all"};
+    npath::reducer_t   reducer     = {sizeof(usage_t), s_init, s_folder, s_file, s_merge, nullptr};
+    for (u32 t = 0; t < sizeof(s_threads) / sizeof(s_threads[0]); ++t)
+    {
+        nbench::result_t result;
+        nbench::init_result(result, s_configs[t], 0);
+        usage_t           usage;
+        nbench::measure_t measure;
+        npath::subtree_t::parallel_reduce(root, reducer, &usage, s_threads[t]);
+        measure.stop(result);
+        result.m_ops   = usage.m_folders + usage.m_files;
+        result.m_bytes = usage.m_names & 1; // keep the sum alive
+        ctx.report(result);
+    }
+
+    npath::g_destruct_paths(ctx.m_allocator, paths);
+    nbench::exit_pathlist(ctx.m_allocator, list);
+}
+
+// Rollups on the same tree with a size and mtime per file: the bulk recompute, the incremental update of one file
+// (set_file_stat, every folder on the parent chain) and "how big is this folder" for every registered folder,
+// answered from the rollups and, for a sample of 1024 folders, by walking the sub tree (parallel_reduce on one
+// worker). Ops are files for the first two, folders queried for the others.
+BENCHMARK(rollups)
+{
+    u32 const          count = 1024 * 1024 * ctx.m_scale;
+    nbench::pathlist_t list;
+    nbench::init_pathlist(ctx.m_allocator, list, count, (u64)count * 128);
+    nbench::generate_source_tree(list, count, 1);
+
+    npath::paths_t*   paths = npath::g_construct_paths(ctx.m_allocator);
+    dirpath_t*        dirs  = (dirpath_t*)ctx.m_allocator->allocate(list.m_count * sizeof(dirpath_t));
+    npath::filestat_t stat;
+    memset(&stat, 0, sizeof(stat));
+    u32 num_files = 0;
+    for (u32 i = 0; i < list.m_count; ++i)
+    {
+        new (&dirs[i]) dirpath_t(paths->register_fulldirpath(ascii::make_crunes(list.at(i))));
+        for (u32 f = 0; f < 2; ++f)
+        {
+            npath::ifile_t const file = paths->file_of(dirs[i].filename(ascii::make_crunes(f == 0 ? "a.cpp" : "b.h")));
+            stat.m_size     = 1000 + i;
+            stat.m_mtime_ns = (s64)i * 1000 + f;
+            paths->set_file_stat(file, stat);
+            num_files = file > num_files ? file : num_files;
+        }
+    }
+
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "recompute", num_files);
+        nbench::measure_t measure;
+        paths->enable_rollups();
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    {
+        nbench::result_t result;
+        nbench::init_result(result, "set_file_stat", num_files);
+        nbench::measure_t measure;
+        for (npath::ifile_t file = 1; file <= num_files; ++file)
+        {
+            stat.m_size     = file;
+            stat.m_mtime_ns = (s64)file * 7;
+            paths->set_file_stat(file, stat);
+        }
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    // every file got older, the first pass rebuilds the mtime of the stale folders
+    static const char* s_query[] = {"get_rollup (first)", "get_rollup"};
+    for (u32 pass = 0; pass < 2; ++pass)
+    {
+        nbench::result_t result;
+        nbench::init_result(result, s_query[pass], list.m_count);
+        npath::rollup_t   rollup;
+        nbench::measure_t measure;
+        for (u32 i = 0; i < list.m_count; ++i)
+        {
+            paths->get_rollup(dirs[i], rollup);
+            result.m_bytes += rollup.m_bytes & 1; // keep the queries alive
+        }
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    {
+        u32 const        samples = list.m_count < 1024 ? list.m_count : 1024;
+        npath::reducer_t reducer = {sizeof(usage_t), s_init, nullptr, s_bytes, s_merge, nullptr};
+        nbench::result_t result;
+        nbench::init_result(result, "walk sub tree", samples);
+        usage_t           usage;
+        nbench::measure_t measure;
+        for (u32 i = 0; i < samples; ++i)
+        {
+            npath::subtree_t::parallel_reduce(dirs[(u64)i * list.m_count / samples], reducer, &usage, 1);
+            result.m_bytes += usage.m_names & 1;
+        }
+        measure.stop(result);
+        ctx.report(result);
+    }
+
+    for (u32 i = 0; i < list.m_count; ++i)
+        dirs[i].~dirpath_t();
+    ctx.m_allocator->deallocate(dirs);
+    npath::g_destruct_paths(ctx.m_allocator, paths);
+    nbench::exit_pathlist(ctx.m_allocator, list);
+}
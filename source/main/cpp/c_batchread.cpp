@@ -0,0 +1,440 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_filepath.h"
+#include "cpath/c_batchread.h"
+#include "cpath/c_instrument.h"
+#include "cpath/private/c_threads.h"
+
+#include <string.h>
+
+#if defined(TARGET_LINUX) || defined(TARGET_MAC)
+#    define CPATH_BATCH_POSIX
+#    include <errno.h>
+#    include <fcntl.h>
+#    include <sys/uio.h>
+#    include <unistd.h>
+#endif
+
+#if defined(TARGET_LINUX)
+#    define CPATH_BATCH_URING
+#    include <linux/io_uring.h>
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#endif
+
+namespace ncore
+{
+    namespace npath
+    {
+        const batch_config_t g_default_batch_config = {64, 0, nbatch::BackendAuto, {0, 0, 0}};
+
+        static const s32 c_max_ospath    = 4096;
+        static const u32 c_invalid_index = 0xFFFFFFFF;
+
+        struct batchreader_t::request_t
+        {
+            u8*     m_buffer;
+            u64     m_size;
+            u64     m_bytes;
+            ifile_t m_file;
+            s32     m_fd;
+            s32     m_error;
+            u32     m_next; // done list
+#if defined(CPATH_BATCH_URING)
+            struct iovec m_iov;
+#endif
+        };
+
+        // --------------------------------------------------------------------------------------------------------------
+        // platform layer
+
+#if defined(CPATH_BATCH_POSIX)
+        static const s32 c_error_not_found = ENOENT;
+
+        static s32 s_open(char const* ospath, s32& out_error)
+        {
+            s32 const fd = ::open(ospath, O_RDONLY | O_CLOEXEC);
+            out_error    = fd < 0 ? errno : 0;
+            return fd;
+        }
+
+        static void s_close(s32 fd) { ::close(fd); }
+
+        // Blocking read of the whole buffer or up to the end of the file
+        static s32 s_read_all(s32 fd, u8* buffer, u64 size, u64& out_bytes)
+        {
+            out_bytes = 0;
+            while (out_bytes < size)
+            {
+                ssize_t const n = ::pread(fd, buffer + out_bytes, (size_t)(size - out_bytes), (off_t)out_bytes);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n < 0)
+                    return errno;
+                if (n == 0)
+                    break;
+                out_bytes += (u64)n;
+            }
+            return 0;
+        }
+#else
+        static const s32 c_error_not_found = 2;
+
+        static s32 s_open(char const* ospath, s32& out_error)
+        {
+            out_error = c_error_not_found;
+            return -1;
+        }
+        static void s_close(s32 fd) {}
+        static s32  s_read_all(s32 fd, u8* buffer, u64 size, u64& out_bytes)
+        {
+            out_bytes = 0;
+            return c_error_not_found;
+        }
+#endif
+
+        // Open the file of a request, the OS path is rendered on the stack
+        static bool s_open_request(paths_t const* paths, batchreader_t::request_t* r)
+        {
+            char ospath[c_max_ospath];
+            if (r->m_file == c_invalid_file || paths->file_to_ospath(r->m_file, ospath, c_max_ospath) < 0)
+            {
+                r->m_error = c_error_not_found;
+                return false;
+            }
+            r->m_fd = s_open(ospath, r->m_error);
+            return r->m_fd >= 0;
+        }
+
+        static void s_push_done(batchreader_t* b, u32 index)
+        {
+            b->m_requests.ptr_of(index)->m_next = c_invalid_index;
+            if (b->m_done_tail != c_invalid_index)
+                b->m_requests.ptr_of(b->m_done_tail)->m_next = index;
+            else
+                b->m_done_head = index;
+            b->m_done_tail = index;
+        }
+
+        // --------------------------------------------------------------------------------------------------------------
+        // io_uring, raw system calls on the shared rings (no liburing)
+
+#if defined(CPATH_BATCH_URING)
+        struct batchreader_t::uring_t
+        {
+            s32           m_fd;
+            u32           m_entries; // submission queue size, also the maximum number of reads in flight
+            u8*           m_sq_ring;
+            u64           m_sq_ring_size;
+            u8*           m_cq_ring; // == m_sq_ring with IORING_FEAT_SINGLE_MMAP
+            u64           m_cq_ring_size;
+            io_uring_sqe* m_sqes;
+            u64           m_sqes_size;
+            u32*          m_sq_tail;
+            u32           m_sq_mask;
+            u32*          m_sq_array;
+            u32*          m_cq_head;
+            u32*          m_cq_tail;
+            u32           m_cq_mask;
+            io_uring_cqe* m_cqes;
+            u32           m_to_submit; // queued since the last io_uring_enter
+            DCORE_CLASS_PLACEMENT_NEW_DELETE
+        };
+
+        static void s_destruct_uring(alloc_t* allocator, batchreader_t::uring_t*& u)
+        {
+            if (u->m_sqes != nullptr)
+                ::munmap(u->m_sqes, (size_t)u->m_sqes_size);
+            if (u->m_cq_ring != nullptr && u->m_cq_ring != u->m_sq_ring)
+                ::munmap(u->m_cq_ring, (size_t)u->m_cq_ring_size);
+            if (u->m_sq_ring != nullptr)
+                ::munmap(u->m_sq_ring, (size_t)u->m_sq_ring_size);
+            ::close(u->m_fd);
+            g_destruct(allocator, u);
+            u = nullptr;
+        }
+
+        static batchreader_t::uring_t* s_construct_uring(alloc_t* allocator, u32 queue_depth)
+        {
+            io_uring_params params;
+            memset(&params, 0, sizeof(params));
+            s32 const fd = (s32)::syscall(__NR_io_uring_setup, queue_depth, &params);
+            if (fd < 0)
+                return nullptr; // ENOSYS, or blocked by a seccomp policy / io_uring_disabled
+
+            batchreader_t::uring_t* u = g_construct<batchreader_t::uring_t>(allocator);
+            u->m_fd                   = fd;
+            u->m_entries              = params.sq_entries;
+            u->m_sq_ring_size         = params.sq_off.array + params.sq_entries * sizeof(u32);
+            u->m_cq_ring_size         = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            u->m_sqes_size            = params.sq_entries * sizeof(io_uring_sqe);
+            u->m_sq_ring              = nullptr;
+            u->m_cq_ring              = nullptr;
+            u->m_sqes                 = nullptr;
+            u->m_to_submit            = 0;
+
+            bool const single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (single && u->m_cq_ring_size > u->m_sq_ring_size)
+                u->m_sq_ring_size = u->m_cq_ring_size;
+
+            void* sq = ::mmap(nullptr, (size_t)u->m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+            if (sq == MAP_FAILED)
+            {
+                s_destruct_uring(allocator, u);
+                return nullptr;
+            }
+            u->m_sq_ring = (u8*)sq;
+
+            void* cq = single ? sq : ::mmap(nullptr, (size_t)u->m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            void* se = cq == MAP_FAILED ? MAP_FAILED : ::mmap(nullptr, (size_t)u->m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+            u->m_cq_ring = cq != MAP_FAILED ? (u8*)cq : nullptr;
+            u->m_sqes    = se != MAP_FAILED ? (io_uring_sqe*)se : nullptr;
+            if (u->m_cq_ring == nullptr || u->m_sqes == nullptr)
+            {
+                s_destruct_uring(allocator, u);
+                return nullptr;
+            }
+
+            u->m_sq_tail  = (u32*)(u->m_sq_ring + params.sq_off.tail);
+            u->m_sq_mask  = *(u32*)(u->m_sq_ring + params.sq_off.ring_mask);
+            u->m_sq_array = (u32*)(u->m_sq_ring + params.sq_off.array);
+            u->m_cq_head  = (u32*)(u->m_cq_ring + params.cq_off.head);
+            u->m_cq_tail  = (u32*)(u->m_cq_ring + params.cq_off.tail);
+            u->m_cq_mask  = *(u32*)(u->m_cq_ring + params.cq_off.ring_mask);
+            u->m_cqes     = (io_uring_cqe*)(u->m_cq_ring + params.cq_off.cqes);
+            return u;
+        }
+
+        static s32 s_enter(batchreader_t::uring_t* u, u32 min_complete)
+        {
+            while (true)
+            {
+                long const r = ::syscall(__NR_io_uring_enter, u->m_fd, u->m_to_submit, min_complete, min_complete > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+                if (r >= 0)
+                {
+                    u->m_to_submit -= (u32)r;
+                    return 0;
+                }
+                if (errno != EINTR)
+                    return errno;
+            }
+        }
+
+        // Open the next requests and queue their reads until the submission queue is full
+        static void s_issue_uring(batchreader_t* b)
+        {
+            batchreader_t::uring_t* u = b->m_uring;
+            while (b->m_num_issued < b->m_num_requests && b->m_in_flight < u->m_entries)
+            {
+                u32 const                 index = b->m_num_issued++;
+                batchreader_t::request_t* r     = b->m_requests.ptr_of(index);
+                if (!s_open_request(b->m_paths, r))
+                {
+                    s_push_done(b, index);
+                    continue;
+                }
+
+                r->m_iov.iov_base = r->m_buffer;
+                r->m_iov.iov_len  = (size_t)r->m_size;
+
+                // Only this thread produces submissions, the kernel reads the tail with acquire semantics
+                u32 const     tail = *u->m_sq_tail;
+                u32 const     slot = tail & u->m_sq_mask;
+                io_uring_sqe* sqe  = &u->m_sqes[slot];
+                memset(sqe, 0, sizeof(io_uring_sqe));
+                sqe->opcode         = IORING_OP_READV; // READV is in every io_uring kernel, READ needs 5.6
+                sqe->fd             = r->m_fd;
+                sqe->addr           = (u64)&r->m_iov;
+                sqe->len            = 1;
+                sqe->off            = 0;
+                sqe->user_data      = index;
+                u->m_sq_array[slot] = slot;
+                g_store_release(*u->m_sq_tail, tail + 1);
+                u->m_to_submit += 1;
+                b->m_in_flight += 1;
+            }
+        }
+
+        // A short read of a regular file means the end of the file, it is not resubmitted
+        static void s_reap_uring(batchreader_t* b)
+        {
+            batchreader_t::uring_t* u    = b->m_uring;
+            u32                     head = *u->m_cq_head;
+            u32 const               tail = g_load_acquire(*u->m_cq_tail);
+            while (head != tail)
+            {
+                io_uring_cqe const*       cqe   = &u->m_cqes[head & u->m_cq_mask];
+                u32 const                 index = (u32)cqe->user_data;
+                batchreader_t::request_t* r     = b->m_requests.ptr_of(index);
+                r->m_error                      = cqe->res < 0 ? -cqe->res : 0;
+                r->m_bytes                      = cqe->res < 0 ? 0 : (u64)cqe->res;
+                s_close(r->m_fd);
+                r->m_fd = -1;
+                s_push_done(b, index);
+                b->m_in_flight -= 1;
+                head += 1;
+            }
+            g_store_release(*u->m_cq_head, head);
+        }
+
+        static void s_poll_uring(batchreader_t* b, bool wait)
+        {
+            s_issue_uring(b);
+            u32 const min_complete = (wait && b->m_done_head == c_invalid_index && b->m_in_flight > 0) ? 1 : 0;
+            if (b->m_uring->m_to_submit > 0 || min_complete > 0)
+                s_enter(b->m_uring, min_complete);
+            s_reap_uring(b);
+
+            // Refill the slots that just completed so the queue stays deep while the caller processes results
+            s_issue_uring(b);
+            if (b->m_uring->m_to_submit > 0)
+                s_enter(b->m_uring, 0);
+        }
+#else
+        struct batchreader_t::uring_t
+        {
+            s32 m_fd;
+        };
+
+        static batchreader_t::uring_t* s_construct_uring(alloc_t* allocator, u32 queue_depth) { return nullptr; }
+        static void                    s_destruct_uring(alloc_t* allocator, batchreader_t::uring_t*& u) {}
+        static void                    s_poll_uring(batchreader_t* b, bool wait) {}
+#endif
+
+        // --------------------------------------------------------------------------------------------------------------
+        // thread pool
+
+        static void s_read_work(workpool_t*, u32, void* item, void* user)
+        {
+            batchreader_t* const            b = (batchreader_t*)user;
+            batchreader_t::request_t* const r = b->m_requests.ptr_of((u32)*(u64 const*)item);
+            if (!s_open_request(b->m_paths, r))
+                return;
+            r->m_error = s_read_all(r->m_fd, r->m_buffer, r->m_size, r->m_bytes);
+            s_close(r->m_fd);
+            r->m_fd = -1;
+        }
+
+        static void s_poll_threads(batchreader_t* b)
+        {
+            u32 const first = b->m_num_issued;
+            u32 const count = b->m_num_requests - first;
+            if (count == 0)
+                return;
+
+            workpool_t* pool = g_construct_workpool(b->m_allocator, b->m_config.m_num_threads, sizeof(u64), count, s_read_work, b);
+            for (u64 i = first; i < b->m_num_requests; ++i)
+                g_push_work(pool, 0, &i); // work items are padded to 8 bytes
+            g_run_workpool(pool);
+            g_destruct_workpool(b->m_allocator, pool);
+
+            for (u32 i = first; i < b->m_num_requests; ++i)
+                s_push_done(b, i);
+            b->m_num_issued = b->m_num_requests;
+        }
+
+        // --------------------------------------------------------------------------------------------------------------
+        // batchreader_t
+
+        batchreader_t* g_construct_batchreader(alloc_t* allocator, paths_t* paths, batch_config_t const& config)
+        {
+            batchreader_t* b  = g_construct<batchreader_t>(allocator);
+            b->m_allocator    = allocator;
+            b->m_paths        = paths;
+            b->m_config       = config;
+            b->m_backend      = nbatch::BackendThreads;
+            b->m_num_requests = 0;
+            b->m_num_issued   = 0;
+            b->m_num_returned = 0;
+            b->m_in_flight    = 0;
+            b->m_done_head    = c_invalid_index;
+            b->m_done_tail    = c_invalid_index;
+            b->m_uring        = nullptr;
+            g_setup_vpool(b->m_requests, 0, 64 * 1024 * 1024);
+
+            if (config.m_backend != nbatch::BackendThreads)
+                b->m_uring = s_construct_uring(allocator, config.m_queue_depth > 0 ? config.m_queue_depth : 1);
+            if (b->m_uring != nullptr)
+                b->m_backend = nbatch::BackendUring;
+            return b;
+        }
+
+        void g_destruct_batchreader(alloc_t* allocator, batchreader_t*& b)
+        {
+            // Reads still in flight write into the caller's buffers, wait for them
+            while (b->m_in_flight > 0)
+            {
+                read_result_t results[64];
+                b->poll(results, 64, true);
+            }
+            if (b->m_uring != nullptr)
+                s_destruct_uring(allocator, b->m_uring);
+            g_teardown_vpool(b->m_requests);
+            g_destruct(allocator, b);
+            b = nullptr;
+        }
+
+        u32 batchreader_t::submit(filepath_t const* filepaths, void* const* buffers, u64 const* sizes, u32 count)
+        {
+            u32 const first = m_num_requests;
+            if (count == 0)
+                return first;
+            m_requests.ensure_capacity(first + count - 1);
+            for (u32 i = 0; i < count; ++i)
+            {
+                request_t* r = m_requests.ptr_of(first + i);
+                r->m_buffer  = (u8*)buffers[i];
+                r->m_size    = sizes[i];
+                r->m_bytes   = 0;
+                r->m_file    = m_paths->file_of(filepaths[i]);
+                r->m_fd      = -1;
+                r->m_error   = 0;
+                r->m_next    = c_invalid_index;
+            }
+            m_num_requests += count;
+            return first;
+        }
+
+        u32 batchreader_t::poll(read_result_t* out_results, u32 max_results, bool wait)
+        {
+            CPATH_SCOPE("batchreader_t::poll");
+            if (m_uring != nullptr)
+                s_poll_uring(this, wait);
+            else
+                s_poll_threads(this);
+
+            u32 n = 0;
+            while (n < max_results && m_done_head != c_invalid_index)
+            {
+                request_t const* r       = m_requests.ptr_of(m_done_head);
+                out_results[n].m_request = m_done_head;
+                out_results[n].m_error   = r->m_error;
+                out_results[n].m_bytes   = r->m_bytes;
+                n += 1;
+                m_done_head = r->m_next;
+            }
+            if (m_done_head == c_invalid_index)
+                m_done_tail = c_invalid_index;
+            m_num_returned += n;
+            return n;
+        }
+
+        u32 batchreader_t::drain(read_done_fn fn, void* user)
+        {
+            u32 total = 0;
+            while (pending() > 0)
+            {
+                read_result_t results[64];
+                u32 const     n = poll(results, 64, true);
+                for (u32 i = 0; i < n; ++i)
+                    fn(results[i], user);
+                total += n;
+            }
+            return total;
+        }
+
+    } // namespace npath
+} // namespace ncore
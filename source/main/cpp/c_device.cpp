@@ -11,7 +11,16 @@
 #include "cpath/c_filepath.h"
 #include "cpath/private/c_strings.h"
 #include "cpath/private/c_folders.h"
+#include "cpath/private/c_lazy.h"
+#include "cpath/private/c_extindex.h"
+#include "cpath/private/c_rollups.h"
+#include "cpath/private/c_fingerprints.h"
+#include "cpath/private/c_nameindex.h"
+#include "cpath/private/c_unions.h"
 #include "cpath/c_device.h"
+#include "cpath/c_instrument.h"
+
+#include <string.h>
 
 namespace ncore
 {
@@ -24,38 +33,31 @@ namespace ncore
         // --------------------------------------------------------------------------------------------------------------
         // --------------------------------------------------------------------------------------------------------------
 
-        // Once all devices are registered we can connect them through their path
+        // The full path of the root, e.g. "e:/data/app/", rendered into devices_t::m_prefixes. An alias needs no
+        // walk over its redirectors, its root is a folder of the physical tree.
         void device_t::finalize(devices_t* devices)
         {
-            if (m_redirector == c_invalid_device)
+            m_prefix     = devices->m_prefix_used;
+            m_prefix_len = 0;
+            if (m_path == c_invalid_node || m_path == c_empty_node)
+                return;
+            ASSERT(m_redirector != c_invalid_device || m_owner->m_folders->m_array.ptr_of(m_path)->m_parent == c_invalid_node);
+
+            s32 const len = m_owner->folder_to_strlen(m_path, c_invalid_node);
+            devices->m_prefix_used += len;
+            devices->m_prefixes.ensure_capacity(devices->m_prefix_used);
+            char*  dst  = devices->m_prefixes.ptr_of(m_prefix) + len;
+            node_t iter = m_path;
+            while (iter != c_invalid_node)
             {
-                // This is the root device, so it should have a path.
-                ASSERT(m_path != c_invalid_node);
-                // The path should be a folder_t* with no parent.
-                folder_t* folder = m_owner->m_folders->m_array.ptr_of(m_path);
-                ASSERT(folder->m_parent == c_invalid_node);
-            }
-            else
-            {
-                // The redirector should be a device_t*.
-                device_t* redirector = devices->get_device(m_redirector);
-
-                // Navigate up to the top directory of this path, we are going to connect it to the redirector.
-                folder_t* folder = m_owner->m_folders->m_array.ptr_of(m_path);
-                if (folder != nullptr)
-                {
-                    while (folder->m_parent != c_invalid_node)
-                        folder = m_owner->m_folders->m_array.ptr_of(folder->m_parent);
-
-                    // Chain the path of this device to the redirector.
-                    folder->m_parent = redirector->m_path;
-                }
-                else
-                {
-                    // This alias doesn't have a path, so we are going to chain the redirector's path to this device.
-                    m_path = redirector->m_path;
-                }
+                folder_t const*         folder = m_owner->m_folders->m_array.ptr_of(iter);
+                strings_t::str_t const* name   = m_owner->m_strings->index_to_object(folder->m_name);
+                *--dst                         = '/';
+                dst -= name->m_len;
+                memcpy(dst, name->m_str, name->m_len);
+                iter = folder->m_parent;
             }
+            m_prefix_len = len;
         }
 
         // example: projects\binary_reader\bin\, "projects\" -> "binary_reader\" -> "bin\"
@@ -67,19 +69,71 @@ namespace ncore
             return !is_empty(folder);
         }
 
-        void device_t::register_dirpath(crunes_t const& _dirpath_first_folder, dirpath_t& out_dirpath)
+        static inline bool s_is_separator(char c) { return c == '/' || c == '\\'; }
+
+        // The end of the last ".." in [first, last), 'first' when the path has none
+        static u32 s_last_dotdot(const char* str, u32 first, u32 last)
         {
-            if (!is_empty(_dirpath_first_folder))
+            for (u32 i = last; i >= first + 2; --i)
             {
-                crunes_t folder      = _dirpath_first_folder;
-                node_t   parent_node = c_invalid_node;
-                do
+                if (str[i - 1] == '.' && str[i - 2] == '.' && (i == last || s_is_separator(str[i])) && (i - 2 == first || s_is_separator(str[i - 3])))
+                    return i;
+            }
+            return first;
+        }
+
+        // Whether the name that ends at 'end' is taken back by a ".." before 'last'
+        static bool s_is_popped(const char* str, u32 end, u32 last)
+        {
+            s32 depth = 1;
+            u32 begin = end + 1;
+            for (u32 i = begin; i <= last; ++i)
+            {
+                if (i < last && !s_is_separator(str[i]))
+                    continue;
+                u32 const len = i - begin;
+                if (len == 2 && str[begin] == '.' && str[begin + 1] == '.')
                 {
-                    string_t folder_pathstr = m_owner->find_or_insert_string(folder);
-                    node_t   folder_node    = add_dir(parent_node, folder_pathstr);
-                    parent_node             = folder_node;
-                } while (s_next_folder(folder, '/'));
+                    if (--depth == 0)
+                        return true;
+                }
+                else if (len > 1 || (len == 1 && str[begin] != '.'))
+                {
+                    depth += 1;
+                }
+                begin = i + 1;
+            }
+            return false;
+        }
+
+        // One pass over the path below the device, "projects\binary_reader/./bin//" -> "projects" -> "binary_reader"
+        // -> "bin". Both '/' and '\' separate folders, empty names (repeated separators) and "." are skipped, ".."
+        // does not go above the root of the device. A name that a later ".." takes back is not registered, so
+        // "a/b/../../c" does not leave "a" or "a/b" behind; nothing is copied. Only the names before the last ".."
+        // look ahead, a path without ".." is a single pass.
+        void device_t::register_dirpath(crunes_t const& dirpath, dirpath_t& out_dirpath)
+        {
+            ASSERT(dirpath.m_type == utf8::TYPE || dirpath.m_type == ascii::TYPE);
+            const char* const str    = dirpath.m_ascii;
+            u32 const         dotdot = s_last_dotdot(str, dirpath.m_str, dirpath.m_end);
+            node_t            node   = m_path;
+            u32               begin  = dirpath.m_str;
+            crunes_t          name   = dirpath;
+            for (u32 i = dirpath.m_str; i <= dirpath.m_end; ++i)
+            {
+                if (i < dirpath.m_end && !s_is_separator(str[i]))
+                    continue;
+                u32 const  len  = i - begin;
+                bool const dots = (len == 1 && str[begin] == '.') || (len == 2 && str[begin] == '.' && str[begin + 1] == '.');
+                if (len > 0 && !dots && (i >= dotdot || !s_is_popped(str, i, dotdot)))
+                {
+                    name.m_str = begin;
+                    name.m_end = i;
+                    node       = add_dir(node, m_owner->find_or_insert_string(name));
+                }
+                begin = i + 1;
             }
+            out_dirpath = dirpath_t(this, node);
         }
 
         void device_t::register_filepath(crunes_t const& _filepath_first_folder, filepath_t& out_filepath)
@@ -104,65 +158,40 @@ namespace ncore
             }
         }
 
-        void device_t::to_string(runes_t& tr) const
+        void device_t::to_string(runes_t& str) const
         {
-            s32             i            = 0;
-            idevice_t       device_index = m_index;
-            device_t const* devices[32];
-            do
-            {
-                device_t* device             = m_owner->m_devices->m_arr_devices[device_index];
-                devices[i++]                 = device;
-                device_index = device->m_redirector;
-            } while (device_index != c_invalid_device && i < 32);
-
-            device_t const* device = devices[--i];
-
-            // should be the root device (has filedevice), so first emit the device name.
-            // this device should not have any device path.
-            crunes_t device_str;
-            m_owner->m_strings->view_string(device->name(), device_str);
-            // TODO append this device's path to the string
-
-            // the rest of the devices are aliases and should be appending their paths
-            while (--i >= 0)
-            {
-                device = devices[i];
-                m_owner->m_strings->view_string(device->name(), device_str);
-                // TODO append this device's path to the string
-            }
+            char const* prefix = m_owner->m_devices->m_prefixes.ptr_of(m_prefix);
+            nrunes::concatenate(str, utf8::make_crunes((utf8::pcrune)prefix, 0, m_prefix_len, m_prefix_len));
         }
 
-        s32 device_t::to_strlen() const
-        {
-            // our 'path' are connected up to the main device, so we only need to walk the path
-            s32       strlen = 0;
-            folder_t* folder = m_owner->m_folders->m_array.ptr_of(m_path);
-            while (folder->m_parent != c_invalid_node)
-            {
-                strlen += m_owner->m_strings->get_len(folder->m_name);
-                folder = m_owner->m_folders->m_array.ptr_of(folder->m_parent);
-            }
+        s32 device_t::to_strlen() const { return m_prefix_len; }
 
-            return strlen;
+        // The folders below the root and the prefix, a folder that is not below the root (e.g. registered before
+        // an alias was pointed elsewhere) is rendered from the top of its tree
+        void device_t::to_string(node_t path, runes_t& str) const
+        {
+            if (path != c_empty_node && path != c_invalid_node)
+                m_owner->folder_to_string(path, m_path, this, str);
         }
 
         s32 device_t::to_strlen(node_t path) const
         {
-            // our 'path' are connected up to the main device, so we only need to walk the path
-            s32       strlen = 0;
-            folder_t* folder = m_owner->m_folders->m_array.ptr_of(path);
-            while (folder->m_parent != c_invalid_node)
+            if (path == c_empty_node || path == c_invalid_node)
+                return 0;
+            s32    len  = 0;
+            node_t iter = path;
+            while (iter != m_path && iter != c_invalid_node)
             {
-                strlen += m_owner->m_strings->get_len(folder->m_name);
-                folder = m_owner->m_folders->m_array.ptr_of(folder->m_parent);
+                folder_t const* folder = m_owner->m_folders->m_array.ptr_of(iter);
+                len += m_owner->m_strings->get_len(folder->m_name) + 1;
+                iter = folder->m_parent;
             }
-
-            return strlen;
+            return iter == m_path ? len + m_prefix_len : len;
         }
 
         static s8 s_compare_str_with_folder(u32 find_str, u32 _node_folder, void const* user_data)
         {
+            CPATH_COUNT(FolderCompare);
             paths_t const* const  root        = (paths_t const*)user_data;
             folder_t const* const node_folder = root->m_folders->m_array.ptr_of(_node_folder);
             return root->m_strings->compare(find_str, node_folder->m_name);
@@ -178,25 +207,129 @@ namespace ncore
 
         node_t device_t::add_dir(node_t parent, string_t str)
         {
+            CPATH_COUNT(FolderAdd);
+            CPATH_SCOPE("device_t::add_dir");
+
             // Parent node is a folder_t*, so we need to get the folder_t* and then
             // use the tree of folders to see if there is a folder_t* that holds 'str'.
             // If there is no such folder, then we need to create a new folder_t* and
             // insert it into the tree of folders of parent.
+            if (parent == c_invalid_node)
+                parent = m_path; // relative to the root of this device
+
+            node_t temp_node = m_owner->m_folders->m_count + 1;
+            g_ensure_folder_capacity(m_owner->m_folders, temp_node);
+
             folder_t* folder     = m_owner->m_folders->m_array.ptr_of(parent);
-            node_t    temp_node  = m_owner->m_folders->m_count + 1;
             node_t    found_node = c_invalid_node;
-            if (ntree32::insert(m_owner->m_folders->m_tree, folder->m_folders, temp_node, str, s_compare_str_with_folder, this, found_node))
+            if (ntree32::insert(m_owner->m_folders->m_tree, folder->m_folders, temp_node, str, s_compare_str_with_folder, m_owner, found_node))
             {
                 m_owner->m_folders->m_count += 1;
-                m_owner->m_folders->m_array.ensure_capacity(found_node);
-                folder_t* new_folder  = m_owner->m_folders->m_array.ptr_of(found_node);
-                new_folder->m_name    = str;
-                new_folder->m_folders = c_invalid_node;
-                new_folder->m_parent  = parent;
+                g_ensure_folder_capacity(m_owner->m_folders, found_node);
+                folder_t* new_folder = m_owner->m_folders->m_array.ptr_of(found_node);
+                new_folder->reset();
+                new_folder->m_name   = str;
+                new_folder->m_parent = parent;
+                new_folder->m_flags  = folder->m_flags & nfolder::FlagLazy; // below a lazy root, read on first enumeration
+                g_add_child_folder(m_owner->m_folders, m_owner->m_folders->m_array.ptr_of(parent), new_folder);
+                if (m_owner->m_extindex != nullptr)
+                    g_extindex_add_folder(m_owner->m_extindex, m_owner->m_folders, found_node);
+                if (m_owner->m_nameindex != nullptr)
+                    g_nameindex_add(m_owner, parent, found_node);
+                if (m_owner->m_fingerprints != nullptr)
+                    g_fingerprint_dirty(m_owner, found_node);
+                if (m_owner->m_unions != nullptr)
+                    g_unions_changed(m_owner, parent);
             }
             return found_node;
         }
 
+        static s8 s_compare_file_with_file(u32 _find_file, u32 _node_file, void const* user_data)
+        {
+            paths_t const* const root      = (paths_t const*)user_data;
+            file_t const* const  find_file = root->m_files->m_array.ptr_of(_find_file);
+            file_t const* const  node_file = root->m_files->m_array.ptr_of(_node_file);
+            s8 const             c         = root->m_strings->compare(find_file->m_filename, node_file->m_filename);
+            if (c != 0)
+                return c;
+            return root->m_strings->compare(find_file->m_extension, node_file->m_extension);
+        }
+
+        ifile_t device_t::add_file(node_t parent, string_t filename, string_t extension, u8 type)
+        {
+            if (parent == c_invalid_node)
+                parent = m_path;
+
+            // The temp slot holds the key, the tree compares file against file
+            files_t* files     = m_owner->m_files;
+            node_t   temp_node = files->m_count + 1;
+            g_ensure_file_capacity(files, temp_node);
+            file_t* key      = files->m_array.ptr_of(temp_node);
+            key->m_filename  = filename;
+            key->m_extension = extension;
+
+            folder_t*  folder     = m_owner->m_folders->m_array.ptr_of(parent);
+            node_t     found_node = c_invalid_node;
+            bool const inserted   = ntree32::insert(files->m_tree, folder->m_files, temp_node, temp_node, s_compare_file_with_file, m_owner, found_node);
+            if (inserted)
+            {
+                files->m_count += 1;
+                g_ensure_file_capacity(files, found_node);
+                file_t* new_file      = files->m_array.ptr_of(found_node);
+                new_file->reset();
+                new_file->m_filename  = filename;
+                new_file->m_extension = extension;
+                new_file->m_folder    = parent;
+                new_file->m_sibling   = folder->m_file;
+                folder->m_file        = found_node;
+                folder->m_num_files += 1;
+                if (m_owner->m_extindex != nullptr)
+                    g_extindex_add(m_owner->m_extindex, files, found_node, extension);
+                if (m_owner->m_rollups != nullptr)
+                    g_rollup_add(m_owner, found_node);
+                if (m_owner->m_nameindex != nullptr)
+                    g_nameindex_add(m_owner, parent, found_node | c_nameentry_file);
+                if (m_owner->m_unions != nullptr)
+                    g_unions_changed(m_owner, parent);
+            }
+            file_t* const file = files->m_array.ptr_of(found_node);
+            if (m_owner->m_fingerprints != nullptr && (inserted || file->m_type != type))
+                g_fingerprint_dirty(m_owner, parent);
+            file->m_type = type;
+            return found_node;
+        }
+
+        node_t device_t::find_dir(node_t parent, string_t str) const
+        {
+            if (parent == c_invalid_node)
+                parent = m_path;
+            folder_t const* folder     = m_owner->m_folders->m_array.ptr_of(parent);
+            node_t          found_node = c_invalid_node;
+            if (ntree32::find(m_owner->m_folders->m_tree, folder->m_folders, str, s_compare_str_with_folder, m_owner, found_node))
+                return found_node;
+            return c_invalid_node;
+        }
+
+        ifile_t device_t::find_file(node_t parent, string_t filename, string_t extension) const
+        {
+            if (parent == c_invalid_node)
+                parent = m_path;
+
+            // Same as add_file, the key goes into the temp slot
+            files_t* files     = m_owner->m_files;
+            node_t   temp_node = files->m_count + 1;
+            g_ensure_file_capacity(files, temp_node);
+            file_t* key      = files->m_array.ptr_of(temp_node);
+            key->m_filename  = filename;
+            key->m_extension = extension;
+
+            folder_t const* folder     = m_owner->m_folders->m_array.ptr_of(parent);
+            node_t          found_node = c_invalid_node;
+            if (ntree32::find(files->m_tree, folder->m_files, temp_node, s_compare_file_with_file, m_owner, found_node))
+                return found_node;
+            return c_invalid_file;
+        }
+
         node_t device_t::get_parent_path(node_t path) const
         {
             folder_t* folder = m_owner->m_folders->m_array.ptr_of(path);
@@ -205,8 +338,11 @@ namespace ncore
 
         node_t device_t::get_first_child_dir(node_t path) const
         {
-            folder_t* folder     = m_owner->m_folders->m_array.ptr_of(path);
-            node_t    first_child = ntree32::c_invalid_node;
+            folder_t* folder = m_owner->m_folders->m_array.ptr_of(path);
+            if ((g_load_acquire(folder->m_flags) & (nfolder::FlagLazy | nfolder::FlagExpanded)) == nfolder::FlagLazy)
+                g_expand_folder(m_owner, path);
+
+            node_t first_child = ntree32::c_invalid_node;
             if (folder->m_folders != ntree32::c_invalid_node)
             {
                 ntree32::iterator_t it = ntree32::iterate(m_owner->m_folders->m_tree, folder->m_folders);
@@ -222,110 +358,259 @@ namespace ncore
         // --------------------------------------------------------------------------------------------------------------
         // --------------------------------------------------------------------------------------------------------------
 
-        static s8 s_compare_name_with_device(u32 name, u32 device, void const* user_data)
+        static const s32 c_max_devices = 1024 * 1024; // address space only, memory is committed as devices are registered
+
+        static inline u32 s_hash(u32 key, u32 mask) { return (key * 0x9E3779B1u) & mask; }
+
+        static void s_table_insert(vpool_t<u32>& table, u32 size, u32 key, idevice_t device)
         {
-            devices_t const* devices = (devices_t const*)user_data;
-            device_t const*  dev     = devices->m_arr_devices[device];
-            return dev->m_owner->compare_str(name, dev->name());
+            u32 const mask = size - 1;
+            u32       i    = s_hash(key, mask);
+            while (*table.ptr_of(i) != 0)
+                i = (i + 1) & mask;
+            *table.ptr_of(i) = (u32)device + 1;
         }
 
-        idevice_t devices_t::find_device(string_t devicename) const
+        // Keep the tables at most half full, the devices are re-inserted
+        static void s_grow_tables(devices_t* devices)
         {
-            ntree32::node_t found = c_invalid_node;
-            if (ntree32::find(m_device_tree, m_device_tree_root, devicename, s_compare_name_with_device, this, found))
+            devices->m_table_size *= 2;
+            devices->m_name_table.ensure_capacity(devices->m_table_size);
+            devices->m_root_table.ensure_capacity(devices->m_table_size);
+            memset(devices->m_name_table.ptr(), 0, devices->m_table_size * sizeof(u32));
+            memset(devices->m_root_table.ptr(), 0, devices->m_table_size * sizeof(u32));
+            for (idevice_t i = 1; i < devices->m_num_devices; ++i)
             {
-                return (idevice_t)found;
+                device_t const* device = devices->m_array.ptr_of(i);
+                s_table_insert(devices->m_name_table, devices->m_table_size, device->m_name, i);
+                if (device->m_redirector == c_invalid_device)
+                    s_table_insert(devices->m_root_table, devices->m_table_size, device->m_path, i); // an alias does not own its root
             }
-            return c_invalid_device;
         }
 
-        idevice_t devices_t::register_device(string_t devicename)
+        idevice_t devices_t::find_device(string_t devicename) const
         {
-            idevice_t device = find_device(devicename);
-            if (device == c_invalid_device)
+            u32 const mask = m_table_size - 1;
+            for (u32 i = s_hash(devicename, mask);; i = (i + 1) & mask)
             {
-                ntree32::node_t temp     = m_max_devices + 1;
-                ntree32::node_t inserted = ntree32::c_invalid_node;
-                if (ntree32::insert(m_device_tree, m_device_tree_root, temp, devicename, s_compare_name_with_device, this, inserted))
-                {
-                    // node_t    path_node = m_owner->m_folder_tree.new_node();
-                    // folder_t* folder    = m_owner->m_folder_array.ptr_of(path_node);
-                    // folder->reset();
-                    // folder->m_name = devicename;
-                    // m_owner->m_folder_count += 1;
-                    node_t path_node                      = m_owner->allocate_folder(devicename);
-                    m_arr_devices[inserted]->m_owner      = m_owner;
-                    m_arr_devices[inserted]->m_name       = devicename;
-                    m_arr_devices[inserted]->m_path       = path_node;
-                    m_arr_devices[inserted]->m_index      = inserted;
-                    m_arr_devices[inserted]->m_redirector = c_invalid_device;
-                    m_arr_devices[inserted]->m_userdata1  = 0;
-                    m_arr_devices[inserted]->m_userdata2  = 0;
-
-                    return (idevice_t)inserted;
-                }
+                u32 const entry = *m_name_table.ptr_of(i);
+                if (entry == 0)
+                    return c_invalid_device;
+                if (m_array.ptr_of(entry - 1)->m_name == devicename)
+                    return (idevice_t)(entry - 1);
             }
-            return device;
         }
 
-        device_t* devices_t::get_device(idevice_t index) const
+        device_t* devices_t::device_of_root(node_t root) const
         {
-            if (index == c_invalid_device)
-                return nullptr;
-            return m_arr_devices[index];
+            u32 const mask = m_table_size - 1;
+            for (u32 i = s_hash(root, mask);; i = (i + 1) & mask)
+            {
+                u32 const entry = *m_root_table.ptr_of(i);
+                if (entry == 0)
+                    return nullptr;
+                device_t* device = m_array.ptr_of(entry - 1);
+                if (device->m_path == root)
+                    return device;
+            }
         }
 
-        device_t* devices_t::get_default_device() const { return m_arr_devices[0]; }
-
-        device_t* g_construct_device(alloc_t* allocator, paths_t* owner, idevice_t index)
+        idevice_t devices_t::register_device(string_t devicename)
         {
-            device_t* device = g_construct<device_t>(allocator);
-            device->m_owner      = owner;
-            device->m_name       = c_invalid_string;
-            device->m_path       = c_invalid_node;
+            idevice_t const found = find_device(devicename);
+            if (found != c_invalid_device)
+                return found;
+            ASSERT(m_num_devices < m_max_devices);
+            if (m_num_devices >= m_max_devices)
+                return c_invalid_device;
+
+            if ((u32)(m_num_devices + 1) * 2 > m_table_size)
+                s_grow_tables(this);
+
+            idevice_t const index = m_num_devices++;
+            m_array.ensure_capacity(index + 1);
+            device_t* device     = m_array.ptr_of(index);
+            device->m_owner      = m_owner;
+            device->m_name       = devicename;
+            device->m_path       = m_owner->allocate_folder(devicename);
             device->m_index      = index;
             device->m_redirector = c_invalid_device;
+            device->m_union      = -1;
             device->m_userdata1  = 0;
             device->m_userdata2  = 0;
-            return device;
+            device->finalize(this);
+            s_table_insert(m_name_table, m_table_size, devicename, index);
+            s_table_insert(m_root_table, m_table_size, device->m_path, index);
+            return index;
         }
 
-        void g_destruct_device(alloc_t* allocator, device_t*& device)
+        struct replant_t
+        {
+            folders_t const* m_folders;
+            device_t*        m_physical;
+            node_t           m_path;
+        };
+
+        // The same folder below the new root, top-down one name at a time
+        static void s_replant_folder(node_t folder, void* user)
         {
-            g_destruct(allocator, device);
-            device = nullptr;
+            replant_t* replant = (replant_t*)user;
+            replant->m_path    = replant->m_physical->add_dir(replant->m_path, replant->m_folders->m_array.ptr_of(folder)->m_name);
         }
 
-        devices_t* g_construct_devices(alloc_t* allocator, paths_t* owner, strings_t* strings)
+        // The aliases that redirect to 'changed' keep their place below its root, its root moved away from 'old_root'
+        static void s_rebase(devices_t* devices, idevice_t changed, node_t old_root)
         {
-            devices_t* devices = g_construct<devices_t>(allocator);
-            devices->m_owner = owner;
-            devices->m_strings = strings;
+            device_t const*  target  = devices->m_array.ptr_of(changed);
+            folders_t const* folders = devices->m_owner->m_folders;
+            for (idevice_t i = 1; i < devices->m_num_devices; ++i)
+            {
+                device_t* alias = devices->m_array.ptr_of(i);
+                if (alias->m_redirector != changed)
+                    continue;
+
+                if (!g_folder_is_below(folders, alias->m_path, old_root))
+                    continue; // not below the old root, it was pointed at a folder of another device
+
+                node_t const alias_root = alias->m_path;
+                replant_t    replant    = {folders, devices->m_owner->device_of(target->m_path), target->m_path};
+                g_for_each_folder_down(folders, alias_root, old_root, s_replant_folder, &replant);
+                alias->m_path = replant.m_path;
+                alias->finalize(devices);
+                if (alias_root != alias->m_path)
+                    s_rebase(devices, i, alias_root);
+            }
+        }
 
-            s32 const c_extra_devices = 2; // For 'find' and 'temp' slots
-            devices->m_num_devices    = 1;
-            devices->m_max_devices    = 62;
-            devices->m_arr_devices    = g_allocate_array<device_t*>(allocator, devices->m_max_devices + c_extra_devices);
-            for (idevice_t i = 0; i < devices->m_max_devices; ++i)
-                devices->m_arr_devices[i] = g_construct_device(allocator, owner, i);
-            for (idevice_t i = devices->m_max_devices; i < devices->m_max_devices + c_extra_devices; ++i)
-                devices->m_arr_devices[i] = nullptr;
-            devices->m_device_nodes = g_allocate_array<ntree32::nnode_t>(allocator, devices->m_max_devices + c_extra_devices);
-            ntree32::setup_tree(devices->m_device_tree, devices->m_device_nodes);
-            devices->m_device_tree_root = c_invalid_node;
+        idevice_t devices_t::register_alias(string_t devicename, idevice_t redirector, node_t target)
+        {
+            if (redirector == c_invalid_device || redirector == c_default_device || redirector >= m_num_devices)
+                return c_invalid_device;
+            if (target == c_invalid_node || target == c_empty_node)
+                return c_invalid_device;
+
+            idevice_t index = find_device(devicename);
+            if (index != c_invalid_device && m_array.ptr_of(index)->m_redirector == c_invalid_device)
+                return c_invalid_device; // a physical device (or a union) owns a folder tree, it cannot be redirected
+            for (idevice_t iter = redirector; iter != c_invalid_device; iter = m_array.ptr_of(iter)->m_redirector)
+            {
+                if (iter == index)
+                    return c_invalid_device; // cycle
+            }
 
-            //device_t* default_device = devices->m_arr_devices[0];
+            if (index == c_invalid_device)
+            {
+                ASSERT(m_num_devices < m_max_devices);
+                if (m_num_devices >= m_max_devices)
+                    return c_invalid_device;
+                if ((u32)(m_num_devices + 1) * 2 > m_table_size)
+                    s_grow_tables(this);
+
+                index = m_num_devices++;
+                m_array.ensure_capacity(index + 1);
+                device_t* device    = m_array.ptr_of(index);
+                device->m_owner     = m_owner;
+                device->m_name      = devicename;
+                device->m_path      = c_invalid_node;
+                device->m_index     = index;
+                device->m_union     = -1;
+                device->m_userdata1 = 0;
+                device->m_userdata2 = 0;
+                s_table_insert(m_name_table, m_table_size, devicename, index);
+            }
+
+            device_t*    device   = m_array.ptr_of(index);
+            node_t const old_root = device->m_path;
+            device->m_redirector  = redirector;
+            device->m_path        = target;
+            device->finalize(this);
+            if (old_root != c_invalid_node && old_root != target)
+                s_rebase(this, index, old_root);
+            if (m_owner->m_unions != nullptr)
+                g_unions_invalidate(m_owner); // it may be a layer, or an alias below one
+            return index;
+        }
+
+        // A union has a folder tree of its own like a physical device, it holds the paths that are resolved
+        idevice_t devices_t::register_union(string_t devicename, idevice_t const* layers, u32 num_layers)
+        {
+            if (num_layers == 0 || num_layers > c_max_layers)
+                return c_invalid_device;
+            idevice_t index = find_device(devicename);
+            if (index != c_invalid_device && m_array.ptr_of(index)->m_union < 0)
+                return c_invalid_device;
+            for (u32 i = 0; i < num_layers; ++i)
+            {
+                idevice_t const layer = layers[i];
+                if (layer == c_invalid_device || layer == c_default_device || layer >= m_num_devices || m_array.ptr_of(layer)->m_union >= 0)
+                    return c_invalid_device; // a union is not a layer
+            }
 
+            if (index == c_invalid_device)
+                index = register_device(devicename);
+            if (index == c_invalid_device)
+                return c_invalid_device;
+            device_t* device = m_array.ptr_of(index);
+            device->m_union  = g_unions_set(m_owner, device->m_union, index, layers, num_layers);
+            return index;
+        }
+
+        device_t* devices_t::get_device(idevice_t index) const
+        {
+            if (index == c_invalid_device || index >= m_num_devices)
+                return nullptr;
+            return m_array.ptr_of(index);
+        }
+
+        device_t* devices_t::get_default_device() const { return m_array.ptr_of(c_default_device); }
+
+        void devices_t::get_stats(paths_stats_t& stats) const
+        {
+            stats.m_device_array.m_reserved  = m_array.m_arena.reserved_bytes() + m_name_table.m_arena.reserved_bytes() + m_root_table.m_arena.reserved_bytes() + m_prefixes.m_arena.reserved_bytes();
+            stats.m_device_array.m_committed = m_array.m_arena.committed_bytes() + m_name_table.m_arena.committed_bytes() + m_root_table.m_arena.committed_bytes() + m_prefixes.m_arena.committed_bytes();
+            stats.m_device_count             = m_num_devices;
+        }
+
+        devices_t* g_construct_devices(alloc_t* allocator, paths_t* owner, strings_t* strings)
+        {
+            devices_t* devices     = g_construct<devices_t>(allocator);
+            devices->m_owner       = owner;
+            devices->m_strings     = strings;
+            devices->m_num_devices = 1;
+            devices->m_max_devices = c_max_devices;
+            devices->m_table_size  = 16;
+            g_setup_vpool(devices->m_array, 0, c_max_devices, owner->m_config);
+            g_setup_vpool(devices->m_name_table, 0, (u64)c_max_devices * 2, owner->m_config);
+            g_setup_vpool(devices->m_root_table, 0, (u64)c_max_devices * 2, owner->m_config);
+            g_setup_vpool(devices->m_prefixes, 0, (u64)c_max_devices * 256, owner->m_config); // re-finalized aliases append
+            devices->m_prefix_used = 0;
+            devices->m_name_table.ensure_capacity(devices->m_table_size);
+            devices->m_root_table.ensure_capacity(devices->m_table_size);
+            memset(devices->m_name_table.ptr(), 0, devices->m_table_size * sizeof(u32));
+            memset(devices->m_root_table.ptr(), 0, devices->m_table_size * sizeof(u32));
+
+            // The default device, it has no name and no folder
+            devices->m_array.ensure_capacity(1);
+            device_t* device     = devices->m_array.ptr_of(c_default_device);
+            device->m_owner      = owner;
+            device->m_name       = c_invalid_string;
+            device->m_path       = c_invalid_node;
+            device->m_index      = c_default_device;
+            device->m_redirector = c_invalid_device;
+            device->m_prefix     = 0;
+            device->m_prefix_len = 0;
+            device->m_union      = -1;
+            device->m_userdata1  = 0;
+            device->m_userdata2  = 0;
             return devices;
         }
 
         void g_destruct_devices(alloc_t* allocator, devices_t*& devices)
         {
-            for (idevice_t i = 0; i < devices->m_max_devices; ++i)
-                g_destruct(allocator, devices->m_arr_devices[i]);
-            g_deallocate_array(allocator, devices->m_arr_devices);
-            g_deallocate_array(allocator, devices->m_device_nodes);
-            ntree32::teardown_tree(devices->m_device_tree);
+            g_teardown_vpool(devices->m_array);
+            g_teardown_vpool(devices->m_name_table);
+            g_teardown_vpool(devices->m_root_table);
+            g_teardown_vpool(devices->m_prefixes);
             g_destruct(allocator, devices);
             devices = nullptr;
         }
@@ -0,0 +1,398 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_device.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_filepath.h"
+#include "cpath/c_diff.h"
+#include "cpath/c_instrument.h"
+#include "cpath/private/c_folders.h"
+#include "cpath/private/c_fingerprints.h"
+#include "cpath/private/c_lazy.h"
+#include "cpath/private/c_strings.h"
+#include "cpath/private/c_threads.h"
+
+#include <string.h>
+
+namespace ncore
+{
+    namespace npath
+    {
+        struct diffpair_t
+        {
+            node_t m_a; // c_invalid_node, the sub tree of m_b is added
+            node_t m_b; // c_invalid_node, the sub tree of m_a is removed
+        };
+
+        struct diff_walk_t
+        {
+            paths_t*            m_paths[2];
+            device_t*           m_devices[2];
+            u32                 m_flags;
+            bool                m_prune; // skip folder pairs with equal fingerprints
+            diff_fn             m_fn;
+            void*               m_user;
+            diff_stats_t*       m_stats;
+            u32                 m_top;
+            u32                 m_max_top; // every node of either side is pushed at most once
+            vpool_t<diffpair_t> m_stack;
+            vpool_t<u32>        m_scratch; // the sorted files or sub folders of both sides
+        };
+
+        // c_empty_string ("nil") is a file without extension, like a registered ""
+        static inline void s_view(paths_t const* paths, string_t str, const char*& out_str, u32& out_len)
+        {
+            if (str == c_empty_string)
+            {
+                out_str = "";
+                out_len = 0;
+                return;
+            }
+            strings_t::str_t const* s = paths->m_strings->index_to_object(str);
+            out_str                   = s->m_str;
+            out_len                   = s->m_len;
+        }
+
+        // Byte order, also between the string pools of two registries
+        static s8 s_compare_names(paths_t const* pa, string_t a, paths_t const* pb, string_t b)
+        {
+            if (pa == pb && a == b)
+                return 0;
+            const char* sa;
+            const char* sb;
+            u32         la, lb;
+            s_view(pa, a, sa, la);
+            s_view(pb, b, sb, lb);
+            u32 const len = la < lb ? la : lb;
+            for (u32 i = 0; i < len; ++i)
+            {
+                if (sa[i] != sb[i])
+                    return (u8)sa[i] < (u8)sb[i] ? -1 : 1;
+            }
+            return la == lb ? 0 : (la < lb ? -1 : 1);
+        }
+
+        static s8 s_compare(paths_t const* pa, u32 a, paths_t const* pb, u32 b, bool files)
+        {
+            if (!files)
+                return s_compare_names(pa, pa->m_folders->m_array.ptr_of(a)->m_name, pb, pb->m_folders->m_array.ptr_of(b)->m_name);
+            file_t const* fa = pa->m_files->m_array.ptr_of(a);
+            file_t const* fb = pb->m_files->m_array.ptr_of(b);
+            s8 const      c  = s_compare_names(pa, fa->m_filename, pb, fb->m_filename);
+            return c != 0 ? c : s_compare_names(pa, fa->m_extension, pb, fb->m_extension);
+        }
+
+        static void s_sift_down(paths_t const* paths, u32* items, u32 root, u32 count, bool files)
+        {
+            while (true)
+            {
+                u32 child = root * 2 + 1;
+                if (child >= count)
+                    return;
+                if (child + 1 < count && s_compare(paths, items[child], paths, items[child + 1], files) < 0)
+                    child += 1;
+                if (s_compare(paths, items[root], paths, items[child], files) >= 0)
+                    return;
+                u32 const t  = items[root];
+                items[root]  = items[child];
+                items[child] = t;
+                root         = child;
+            }
+        }
+
+        static void s_sort(paths_t const* paths, u32* items, u32 count, bool files)
+        {
+            for (u32 i = count / 2; i > 0; --i)
+                s_sift_down(paths, items, i - 1, count, files);
+            for (u32 end = count; end > 1; --end)
+            {
+                u32 const t    = items[0];
+                items[0]       = items[end - 1];
+                items[end - 1] = t;
+                s_sift_down(paths, items, 0, end - 1, files);
+            }
+        }
+
+        static inline folder_t const* s_enter(paths_t* paths, node_t node)
+        {
+            folder_t const* folder = paths->m_folders->m_array.ptr_of(node);
+            if (paths->m_lazy != nullptr && (g_load_acquire(folder->m_flags) & (nfolder::FlagLazy | nfolder::FlagExpanded)) == nfolder::FlagLazy)
+                g_expand_folder(paths, node);
+            return folder;
+        }
+
+        // The files (or sub folders) of a folder that are not tombstones, sorted by name, at 'offset' in the scratch
+        static u32 s_gather(diff_walk_t* w, u32 side, folder_t const* folder, u32 offset, bool files)
+        {
+            paths_t* const paths = w->m_paths[side];
+            w->m_scratch.ensure_capacity(offset + (files ? folder->m_num_files : folder->m_num_folders));
+            u32* const items = w->m_scratch.ptr_of(offset);
+            u32        count = 0;
+            if (files)
+            {
+                for (ifile_t file = folder->m_file; file != c_invalid_file;)
+                {
+                    file_t const* f = paths->m_files->m_array.ptr_of(file);
+                    if ((f->m_flags & nfile::FlagDeleted) == 0)
+                        items[count++] = file;
+                    file = f->m_sibling;
+                }
+            }
+            else
+            {
+                for (node_t child = folder->m_child; child != c_invalid_folder;)
+                {
+                    folder_t const* c = paths->m_folders->m_array.ptr_of(child);
+                    if ((c->m_flags & nfolder::FlagDeleted) == 0)
+                        items[count++] = child;
+                    child = c->m_sibling;
+                }
+            }
+            s_sort(paths, items, count, files);
+            return count;
+        }
+
+        static void s_emit(diff_walk_t* w, u32 kind, ifile_t a, ifile_t b)
+        {
+            file_t const* fa = a != c_invalid_file ? w->m_paths[0]->m_files->m_array.ptr_of(a) : nullptr;
+            file_t const* fb = b != c_invalid_file ? w->m_paths[1]->m_files->m_array.ptr_of(b) : nullptr;
+            filepath_t const pa(w->m_devices[0], fa != nullptr ? fa->m_folder : c_invalid_node, fa != nullptr ? fa->m_filename : c_empty_string, fa != nullptr ? fa->m_extension : c_empty_string);
+            filepath_t const pb(w->m_devices[1], fb != nullptr ? fb->m_folder : c_invalid_node, fb != nullptr ? fb->m_filename : c_empty_string, fb != nullptr ? fb->m_extension : c_empty_string);
+            switch (kind)
+            {
+                case ndiff::KindAdded: w->m_stats->m_added += 1; break;
+                case ndiff::KindRemoved: w->m_stats->m_removed += 1; break;
+                default: w->m_stats->m_modified += 1; break;
+            }
+            w->m_fn(kind, fa != nullptr ? &pa : nullptr, fb != nullptr ? &pb : nullptr, w->m_user);
+        }
+
+        static bool s_modified(diff_walk_t const* w, ifile_t a, ifile_t b)
+        {
+            paths_t const* const pa = w->m_paths[0];
+            paths_t const* const pb = w->m_paths[1];
+            if (pa->m_files->m_array.ptr_of(a)->m_type != pb->m_files->m_array.ptr_of(b)->m_type)
+                return true;
+            if (w->m_flags & ndiff::CompareHash)
+            {
+                contenthash_t ha, hb;
+                if (pa->get_file_hash(a, ha) && pb->get_file_hash(b, hb))
+                    return ha.m_lo != hb.m_lo || ha.m_hi != hb.m_hi;
+            }
+            if (w->m_flags & ndiff::CompareMetadata)
+            {
+                filestat_t sa, sb;
+                bool const va = pa->get_file_stat(a, sa);
+                bool const vb = pb->get_file_stat(b, sb);
+                if (va != vb)
+                    return true; // e.g. missing on disk on one side
+                if (va)
+                    return sa.m_size != sb.m_size || sa.m_mtime_ns != sb.m_mtime_ns;
+            }
+            return false;
+        }
+
+        static inline void s_push(diff_walk_t* w, node_t a, node_t b)
+        {
+            ASSERTS(w->m_top < w->m_max_top, "diff: pair stack overflow");
+            w->m_stack.ensure_capacity(w->m_top + 1);
+            diffpair_t* pair = w->m_stack.ptr_of(w->m_top++);
+            pair->m_a        = a;
+            pair->m_b        = b;
+        }
+
+        // Everything below a folder that is only on one side
+        static void s_one_side(diff_walk_t* w, u32 side, node_t node)
+        {
+            paths_t* const  paths  = w->m_paths[side];
+            folder_t const* folder = s_enter(paths, node);
+            for (ifile_t file = folder->m_file; file != c_invalid_file;)
+            {
+                file_t const* f = paths->m_files->m_array.ptr_of(file);
+                if ((f->m_flags & nfile::FlagDeleted) == 0)
+                {
+                    if (side == 0)
+                        s_emit(w, ndiff::KindRemoved, file, c_invalid_file);
+                    else
+                        s_emit(w, ndiff::KindAdded, c_invalid_file, file);
+                }
+                file = f->m_sibling;
+            }
+            for (node_t child = folder->m_child; child != c_invalid_folder;)
+            {
+                folder_t const* c = paths->m_folders->m_array.ptr_of(child);
+                if ((c->m_flags & nfolder::FlagDeleted) == 0)
+                    s_push(w, side == 0 ? child : c_invalid_node, side == 0 ? c_invalid_node : child);
+                child = c->m_sibling;
+            }
+        }
+
+        static bool s_same_fingerprint(diff_walk_t* w, node_t a, node_t b)
+        {
+            u64 a_lo, a_hi, b_lo, b_hi;
+            g_fingerprint_get(w->m_paths[0], a, a_lo, a_hi);
+            g_fingerprint_get(w->m_paths[1], b, b_lo, b_hi);
+            return a_lo == b_lo && a_hi == b_hi;
+        }
+
+        static void s_both_sides(diff_walk_t* w, node_t a, node_t b)
+        {
+            if (w->m_prune && s_same_fingerprint(w, a, b))
+            {
+                w->m_stats->m_pruned += 1;
+                return;
+            }
+
+            paths_t* const  pa = w->m_paths[0];
+            paths_t* const  pb = w->m_paths[1];
+            folder_t const* fa = s_enter(pa, a);
+            folder_t const* fb = s_enter(pb, b);
+            w->m_stats->m_folders += 1;
+
+            // Files, merged by name
+            u32 const na = s_gather(w, 0, fa, 0, true);
+            u32 const nb = s_gather(w, 1, fb, na, true);
+            u32       i = 0, j = 0;
+            while (i < na || j < nb)
+            {
+                ifile_t const x = i < na ? *w->m_scratch.ptr_of(i) : c_invalid_file;
+                ifile_t const y = j < nb ? *w->m_scratch.ptr_of(na + j) : c_invalid_file;
+                s8 const      c = i == na ? 1 : (j == nb ? -1 : s_compare(pa, x, pb, y, true));
+                if (c < 0)
+                {
+                    s_emit(w, ndiff::KindRemoved, x, c_invalid_file);
+                    i += 1;
+                }
+                else if (c > 0)
+                {
+                    s_emit(w, ndiff::KindAdded, c_invalid_file, y);
+                    j += 1;
+                }
+                else
+                {
+                    w->m_stats->m_files += 1;
+                    if (s_modified(w, x, y))
+                        s_emit(w, ndiff::KindModified, x, y);
+                    i += 1;
+                    j += 1;
+                }
+            }
+
+            // Sub folders, merged by name, pairs and one sided sub trees go on the stack
+            u32 const ma = s_gather(w, 0, fa, 0, false);
+            u32 const mb = s_gather(w, 1, fb, ma, false);
+            i = j = 0;
+            while (i < ma || j < mb)
+            {
+                node_t const x = i < ma ? *w->m_scratch.ptr_of(i) : c_invalid_node;
+                node_t const y = j < mb ? *w->m_scratch.ptr_of(ma + j) : c_invalid_node;
+                s8 const     c = i == ma ? 1 : (j == mb ? -1 : s_compare(pa, x, pb, y, false));
+                s_push(w, c <= 0 ? x : c_invalid_node, c >= 0 ? y : c_invalid_node);
+                i += c <= 0 ? 1 : 0;
+                j += c >= 0 ? 1 : 0;
+            }
+        }
+
+        static void s_setup(diff_walk_t& w, paths_t* a, paths_t* b, u32 flags, diff_fn fn, void* user, diff_stats_t& out_stats)
+        {
+            w.m_paths[0] = a;
+            w.m_paths[1] = b;
+            w.m_flags    = flags;
+            w.m_fn       = fn;
+            w.m_user     = user;
+            w.m_stats    = &out_stats;
+            w.m_top      = 0;
+
+            // Equal fingerprints mean equal names, types and content (hash, otherwise size and mtime), which says
+            // nothing about the metadata of files that have a hash when only the metadata is compared. A lazy folder
+            // that was not read yet is empty to its fingerprint, while the diff reads it.
+            bool const fingerprints = a->m_fingerprints != nullptr && b->m_fingerprints != nullptr && a->m_lazy == nullptr && b->m_lazy == nullptr;
+            w.m_prune               = fingerprints && ((flags & ndiff::CompareMetadata) == 0 || (flags & ndiff::CompareHash) != 0);
+
+            // Disjoint folders stack the children of both sides at once
+            u32 const max_items = a->m_max_items > b->m_max_items ? a->m_max_items : b->m_max_items;
+            w.m_max_top         = a->m_max_items + b->m_max_items;
+            g_setup_vpool(w.m_stack, 0, w.m_max_top, a->m_config);
+            g_setup_vpool(w.m_scratch, 0, (u64)max_items * 2, a->m_config);
+            memset(&out_stats, 0, sizeof(out_stats));
+        }
+
+        static void s_teardown(diff_walk_t& w)
+        {
+            g_teardown_vpool(w.m_stack);
+            g_teardown_vpool(w.m_scratch);
+        }
+
+        static void s_run(diff_walk_t* w, device_t* da, node_t a, device_t* db, node_t b)
+        {
+            w->m_devices[0] = da;
+            w->m_devices[1] = db;
+            s_push(w, a, b);
+            while (w->m_top > 0)
+            {
+                diffpair_t const pair = *w->m_stack.ptr_of(--w->m_top);
+                if (pair.m_a == c_invalid_node)
+                    s_one_side(w, 1, pair.m_b);
+                else if (pair.m_b == c_invalid_node)
+                    s_one_side(w, 0, pair.m_a);
+                else
+                    s_both_sides(w, pair.m_a, pair.m_b);
+            }
+        }
+
+        static inline node_t s_node_of(device_t const* device, node_t path) { return (path == c_empty_node || path == c_invalid_node) ? device->m_path : path; }
+
+        void diff_t::run(dirpath_t const& a, dirpath_t const& b, u32 flags, diff_fn fn, void* user, diff_stats_t& out_stats)
+        {
+            CPATH_SCOPE("diff_t::run");
+            memset(&out_stats, 0, sizeof(out_stats));
+            if (a.m_device == nullptr || b.m_device == nullptr)
+                return;
+
+            diff_walk_t w;
+            s_setup(w, a.m_device->m_owner, b.m_device->m_owner, flags, fn, user, out_stats);
+            s_run(&w, a.m_device, s_node_of(a.m_device, a.m_path), b.m_device, s_node_of(b.m_device, b.m_path));
+            s_teardown(w);
+        }
+
+        // Devices with their own folder tree, a redirected device is a view on the tree of another one
+        static inline bool s_has_tree(device_t const* device) { return device != nullptr && device->m_redirector == c_invalid_device && device->m_path != c_invalid_node && device->m_path != c_empty_node; }
+
+        // The device of 'other' with the name of 'device' (of 'paths'), through the string pool and the name table of 'other'
+        static device_t* s_same_device(paths_t const* other, paths_t const* paths, device_t const* device)
+        {
+            string_t const name = other->find_string(paths->get_crunes(device->m_name));
+            if (name == c_invalid_string)
+                return nullptr;
+            device_t* const d = other->m_devices->get_device(other->m_devices->find_device(name));
+            return s_has_tree(d) ? d : nullptr;
+        }
+
+        void diff_t::run(paths_t* a, paths_t* b, u32 flags, diff_fn fn, void* user, diff_stats_t& out_stats)
+        {
+            CPATH_SCOPE("diff_t::run");
+            diff_walk_t w;
+            s_setup(w, a, b, flags, fn, user, out_stats);
+
+            for (s32 i = 0; i < a->m_devices->m_num_devices; ++i)
+            {
+                device_t* const da = a->m_devices->get_device(i);
+                if (!s_has_tree(da))
+                    continue;
+                device_t* const db = s_same_device(b, a, da);
+                s_run(&w, da, da->m_path, db, db != nullptr ? db->m_path : c_invalid_node);
+            }
+            for (s32 j = 0; j < b->m_devices->m_num_devices; ++j)
+            {
+                device_t* const db = b->m_devices->get_device(j);
+                if (s_has_tree(db) && s_same_device(a, b, db) == nullptr)
+                    s_run(&w, nullptr, c_invalid_node, db, db->m_path);
+            }
+
+            s_teardown(w);
+        }
+
+    } // namespace npath
+} // namespace ncore
@@ -8,6 +8,8 @@
 #include "cpath/c_dirpath.h"
 #include "cpath/c_device.h"
 #include "cpath/private/c_folders.h"
+#include "cpath/private/c_lazy.h"
+#include "cpath/c_instrument.h"
 
 namespace ncore
 {
@@ -43,12 +45,13 @@ namespace ncore
         m_path   = path;
     }
 
+    // Folders are interned and live as long as the registry, a dirpath doesn't own anything, so the
+    // destructor must not touch the registry (it may already be destroyed)
     dirpath_t::~dirpath_t()
     {
-        npath::paths_t* root = m_device->m_owner;
-        m_device             = nullptr;
-        m_base               = root->unregister_string(m_base);
-        m_path               = root->unregister_string(m_path);
+        m_device = nullptr;
+        m_base   = npath::c_empty_node;
+        m_path   = npath::c_empty_node;
     }
 
     void dirpath_t::clear()
@@ -130,19 +133,11 @@ namespace ncore
 
     s32 dirpath_t::depth() const
     {
-        if (m_path == 0)
+        if (m_path == npath::c_empty_node || m_path == npath::c_invalid_node)
             return 0;
-        s32              levels = 1;
-        npath::paths_t*  root   = m_device->m_owner;
-        npath::node_t    iter   = m_path;
-        npath::folder_t* folder = root->m_folders->m_array.ptr_of(iter);
-        while (folder->m_parent != 0)
-        {
-            iter   = folder->m_parent;
-            folder = root->m_folders->m_array.ptr_of(iter);
-            ++levels;
-        }
-        return levels;
+        // The depth is maintained when a folder is added, no need to walk up the parent chain
+        npath::paths_t* root = m_device->m_owner;
+        return (s32)root->m_folders->m_array.ptr_of(m_path)->m_depth;
     }
 
     dirpath_t dirpath_t::up() const
@@ -150,20 +145,33 @@ namespace ncore
         npath::paths_t*  root   = m_device->m_owner;
         npath::folder_t* folder = root->m_folders->m_array.ptr_of(m_path);
         npath::node_t    path   = folder->m_parent;
+        CPATH_COUNT(ParentWalk);
         return dirpath_t(m_device, m_base, path);
     }
 
     dirpath_t dirpath_t::down() const
     {
+        CPATH_COUNT(ChildLookup);
         // npath::paths_t* const root = m_device->m_owner;
-        npath::node_t const base = m_device->get_first_child_dir(m_path);
-        npath::node_t const path = m_base;
-        return dirpath_t(m_device, base, path);
+        npath::node_t const path = m_device->get_first_child_dir(m_path);
+        if (path == npath::c_invalid_node)
+            return dirpath_t(m_device); // no sub folders, empty
+        return dirpath_t(m_device, m_base, path);
     }
 
     dirpath_t dirpath_t::down(crunes_t const& folder) const
     {
-        npath::paths_t*     root       = m_device->m_owner;
+        CPATH_COUNT(ChildLookup);
+        npath::paths_t* root = m_device->m_owner;
+        if (root->m_lazy != nullptr)
+        {
+            root->expand(m_path); // lazy folders are read from disk before their children are looked up
+            // other readers insert strings and folders while they expand, the insert is serialized with them
+            npath::lock_t       lock(root->m_lazy->m_lock);
+            npath::string_t     folder_str = root->find_or_insert_string(folder);
+            npath::node_t const path       = m_device->add_dir(m_path, folder_str);
+            return dirpath_t(m_device, m_base, path);
+        }
         npath::string_t     folder_str = root->find_or_insert_string(folder);
         npath::node_t const path       = m_device->add_dir(m_path, folder_str);
         return dirpath_t(m_device, m_base, path);
@@ -186,26 +194,54 @@ namespace ncore
         return 0;
     }
 
+    // Every folder is interned, so two dirpaths are equal when they point to the same folder.
+    // The order of unequal dirpaths is by folder index, use collate() for a lexicographic order.
     s32 dirpath_t::compare(const dirpath_t& other) const
     {
-        s8 const de = s_compare_devices(m_device, other.m_device);
-        return (de == 0) ? 0 : other.m_device->m_owner->compare_str(m_path, other.m_path);
+        if (m_path != other.m_path)
+            return m_path < other.m_path ? -1 : 1;
+        if (m_path == npath::c_empty_node || m_path == npath::c_invalid_node)
+            return s_compare_devices(m_device, other.m_device);
+        return 0;
+    }
+
+    s32 dirpath_t::collate(const dirpath_t& other) const
+    {
+        s8 const c = m_device->m_owner->collate_folder(m_path, other.m_path);
+        if (c == 0 && (m_path == npath::c_empty_node || m_path == npath::c_invalid_node))
+            return s_compare_devices(m_device, other.m_device);
+        return c;
     }
 
-    void dirpath_t::relative_path_to_string(runes_t& str) const {}
-    s32  dirpath_t::relative_path_to_strlen() const { return 0; }
+    void dirpath_t::relative_path_to_string(runes_t& str) const { m_device->m_owner->folder_to_string(m_path, m_base, str); }
+    s32  dirpath_t::relative_path_to_strlen() const { return m_device->m_owner->folder_to_strlen(m_path, m_base); }
+
+    // The top-most folder below the device root, or the device root itself
+    static npath::node_t s_root_folder(npath::paths_t* root, npath::node_t path)
+    {
+        if (path == npath::c_empty_node || path == npath::c_invalid_node)
+            return path;
+        npath::folder_t* folder = root->m_folders->m_array.ptr_of(path);
+        while (folder->m_parent != npath::c_invalid_folder && root->m_folders->m_array.ptr_of(folder->m_parent)->m_parent != npath::c_invalid_folder)
+        {
+            path   = folder->m_parent;
+            folder = root->m_folders->m_array.ptr_of(path);
+        }
+        return path;
+    }
 
     // (device = "E", base = "documents\old\inventory\", path = "books\sci-fi\") -> "E:\documents\"
-    void dirpath_t::root_path_to_string(runes_t& str) const {}
-    s32  dirpath_t::root_path_to_strlen() const { return 0; }
+    void dirpath_t::root_path_to_string(runes_t& str) const { m_device->m_owner->folder_to_string(s_root_folder(m_device->m_owner, m_path), npath::c_invalid_node, str); }
+    s32  dirpath_t::root_path_to_strlen() const { return m_device->m_owner->folder_to_strlen(s_root_folder(m_device->m_owner, m_path), npath::c_invalid_node); }
 
     // (device = "E", base = "documents\old\inventory\", path = "books\sci-fi\") -> "E:\documents\old\inventory\"
-    void dirpath_t::base_path_to_string(runes_t& str) const {}
-    s32  dirpath_t::base_path_to_strlen() const { return 0; }
+    void dirpath_t::base_path_to_string(runes_t& str) const { m_device->to_string(m_base, str); }
+    s32  dirpath_t::base_path_to_strlen() const { return m_device->to_strlen(m_base); }
 
     // (device = "E", base = "documents\old\inventory\", path = "books\sci-fi\") -> "E:\documents\old\inventory\books\sci-fi\"
-    void dirpath_t::full_path_to_string(runes_t& str) const {}
-    s32  dirpath_t::full_path_to_strlen() const { return 0; }
+    // The cached prefix of the device and the folders below its root, an alias renders as its resolved folder
+    void dirpath_t::full_path_to_string(runes_t& str) const { m_device->to_string(m_path, str); }
+    s32  dirpath_t::full_path_to_strlen() const { return m_device->to_strlen(m_path); }
 
     dirpath_t& dirpath_t::operator=(dirpath_t const& other)
     {
@@ -0,0 +1,456 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+
+#include "cpath/c_path.h"
+#include "cpath/private/c_extindex.h"
+#include "cpath/private/c_folders.h"
+#include "cpath/private/c_rollups.h"
+#include "cpath/private/c_fingerprints.h"
+#include "cpath/private/c_unions.h"
+
+#include <string.h>
+
+namespace ncore
+{
+    namespace npath
+    {
+        static const u32 c_invalid_slot     = 0xFFFFFFFF;
+        static const u32 c_max_extensions   = 1024 * 1024;
+        static const u32 c_min_bucket_files = 8;
+        static const u32 c_min_compact      = 64;                    // entries, below this tombstones stay
+        static const u64 c_root_span        = (u64)1 << 43;          // the numbers of one folder tree, 2^20 devices fit in 64 bits
+
+        // A bucket holds at most the files of its extension and a full block doubles, so a live block is less than
+        // twice its count (or the minimum of 8) and the blocks it abandoned add up to less than the live one.
+        static u64 s_max_files(u32 max_items) { return (u64)max_items * 4 + (u64)c_min_bucket_files * 2 * c_max_extensions; }
+
+        extindex_t* g_construct_extindex(alloc_t* allocator, u32 max_items, varena_config_t const& config)
+        {
+            extindex_t* index = g_construct<extindex_t>(allocator);
+            g_setup_vpool(index->m_files, 0, s_max_files(max_items), config);
+            g_setup_vpool(index->m_slot, 0, (u64)max_items * 2, config); // doubles, file ids are below max_items
+            g_setup_vpool(index->m_buckets, 0, c_max_extensions, config);
+            g_setup_vpool(index->m_table, 0, c_max_extensions * 2, config);
+            g_setup_vpool(index->m_enter, 0, max_items, config);
+            g_setup_vpool(index->m_leave, 0, max_items, config);
+            g_setup_vpool(index->m_size, 0, max_items, config);
+            g_setup_vpool(index->m_scratch, 0, max_items, config);
+            index->m_used        = 0;
+            index->m_num_buckets = 0;
+            index->m_table_size  = 64;
+            index->m_slots       = 0;
+            index->m_roots       = 0;
+            index->m_table.ensure_capacity(index->m_table_size);
+            memset(index->m_table.ptr(), 0, index->m_table_size * sizeof(u32));
+            return index;
+        }
+
+        void g_destruct_extindex(alloc_t* allocator, extindex_t*& index)
+        {
+            g_teardown_vpool(index->m_files);
+            g_teardown_vpool(index->m_slot);
+            g_teardown_vpool(index->m_buckets);
+            g_teardown_vpool(index->m_table);
+            g_teardown_vpool(index->m_enter);
+            g_teardown_vpool(index->m_leave);
+            g_teardown_vpool(index->m_size);
+            g_teardown_vpool(index->m_scratch);
+            g_destruct(allocator, index);
+            index = nullptr;
+        }
+
+        static inline u32 s_hash(string_t ext, u32 mask) { return (ext * 0x9E3779B1u) & mask; }
+
+        extbucket_t* g_extindex_find(extindex_t const* index, string_t extension)
+        {
+            u32 const mask = index->m_table_size - 1;
+            for (u32 i = s_hash(extension, mask);; i = (i + 1) & mask)
+            {
+                u32 const entry = *index->m_table.ptr_of(i);
+                if (entry == 0)
+                    return nullptr;
+                extbucket_t* bucket = index->m_buckets.ptr_of(entry - 1);
+                if (bucket->m_ext == extension)
+                    return bucket;
+            }
+        }
+
+        static void s_table_insert(extindex_t* index, u32 bucket)
+        {
+            u32 const      mask = index->m_table_size - 1;
+            string_t const ext  = index->m_buckets.ptr_of(bucket)->m_ext;
+            u32            i    = s_hash(ext, mask);
+            while (*index->m_table.ptr_of(i) != 0)
+                i = (i + 1) & mask;
+            *index->m_table.ptr_of(i) = bucket + 1;
+        }
+
+        static extbucket_t* s_add_bucket(extindex_t* index, string_t extension)
+        {
+            // Keep the table at most half full, the buckets are re-inserted (there are few extensions)
+            if ((index->m_num_buckets + 1) * 2 > index->m_table_size)
+            {
+                index->m_table_size *= 2;
+                index->m_table.ensure_capacity(index->m_table_size);
+                memset(index->m_table.ptr(), 0, index->m_table_size * sizeof(u32));
+                for (u32 b = 0; b < index->m_num_buckets; ++b)
+                    s_table_insert(index, b);
+            }
+
+            u32 const b = index->m_num_buckets++;
+            index->m_buckets.ensure_capacity(b + 1);
+            extbucket_t* bucket = index->m_buckets.ptr_of(b);
+            bucket->m_ext       = extension;
+            bucket->m_offset    = index->m_used;
+            bucket->m_count     = 0;
+            bucket->m_entries   = 0;
+            bucket->m_capacity  = c_min_bucket_files;
+            index->m_used += c_min_bucket_files;
+            index->m_files.ensure_capacity(index->m_used);
+            s_table_insert(index, b);
+            return bucket;
+        }
+
+        static inline u64 s_key(extindex_t const* index, files_t const* files, u32 entry) { return *index->m_enter.ptr_of(files->m_array.ptr_of(entry & ~c_extentry_removed)->m_folder); }
+
+        static void s_set_slots(extindex_t* index, extbucket_t const* bucket, u32 begin, u32 end)
+        {
+            u32 const* const entries = index->m_files.ptr_of(bucket->m_offset);
+            for (u32 i = begin; i < end; ++i)
+                *index->m_slot.ptr_of(entries[i] & ~c_extentry_removed) = i;
+        }
+
+        // Merges the sorted runs [begin, middle) and [middle, end) of a bucket
+        static void s_merge(extindex_t* index, files_t const* files, extbucket_t const* bucket, u32 begin, u32 middle, u32 end)
+        {
+            u32* const entries = index->m_files.ptr_of(bucket->m_offset);
+            index->m_scratch.ensure_capacity(middle - begin);
+            u32* const left = index->m_scratch.ptr();
+            memcpy(left, entries + begin, (middle - begin) * sizeof(u32));
+
+            u32 l = 0, r = middle, out = begin;
+            while (l < middle - begin && r < end)
+            {
+                if (s_key(index, files, entries[r]) < s_key(index, files, left[l]))
+                    entries[out++] = entries[r++];
+                else
+                    entries[out++] = left[l++];
+            }
+            while (l < middle - begin)
+                entries[out++] = left[l++];
+            s_set_slots(index, bucket, begin, end);
+        }
+
+        void g_extindex_add(extindex_t* index, files_t const* files, ifile_t file, string_t extension)
+        {
+            if (file >= index->m_slots)
+            {
+                u32 const slots = file + 1 > index->m_slots * 2 ? file + 1 : index->m_slots * 2;
+                index->m_slot.ensure_capacity(slots);
+                memset(index->m_slot.ptr_of(index->m_slots), 0xFF, (slots - index->m_slots) * sizeof(u32));
+                index->m_slots = slots;
+            }
+
+            extbucket_t* bucket = g_extindex_find(index, extension);
+            u32 const    slot   = *index->m_slot.ptr_of(file);
+            if (slot != c_invalid_slot)
+            {
+                // Already in, a tombstone comes back in place (its folder didn't change)
+                u32* const entry = index->m_files.ptr_of(bucket->m_offset + slot);
+                if ((*entry & c_extentry_removed) != 0)
+                {
+                    *entry = file;
+                    bucket->m_count += 1;
+                }
+                return;
+            }
+
+            if (bucket == nullptr)
+                bucket = s_add_bucket(index, extension);
+            if (bucket->m_entries == bucket->m_capacity)
+            {
+                // Move to the end with twice the capacity, the old block is abandoned
+                u32 const offset = index->m_used;
+                index->m_used += bucket->m_capacity * 2;
+                index->m_files.ensure_capacity(index->m_used);
+                memcpy(index->m_files.ptr_of(offset), index->m_files.ptr_of(bucket->m_offset), bucket->m_entries * sizeof(u32));
+                bucket->m_offset = offset;
+                bucket->m_capacity *= 2;
+            }
+
+            *index->m_files.ptr_of(bucket->m_offset + bucket->m_entries) = file;
+            *index->m_slot.ptr_of(file)                                  = bucket->m_entries;
+            bucket->m_entries += 1;
+            bucket->m_count += 1;
+
+            // The new entry is a run of one, merge the runs of the trailing zero bits of the entry count
+            u32 const end = bucket->m_entries;
+            for (u32 size = 1; (end & size) == 0; size *= 2)
+                s_merge(index, files, bucket, end - size * 2, end - size, end);
+        }
+
+        // Merges every run into one and drops the tombstones, a sorted list splits into sorted runs of any size
+        static void s_compact(extindex_t* index, files_t const* files, extbucket_t* bucket)
+        {
+            u32 const end = bucket->m_entries;
+            for (u32 begin = end & (end - 1); begin > 0;)
+            {
+                u32 const prev = begin & (begin - 1);
+                s_merge(index, files, bucket, prev, begin, end);
+                begin = prev;
+            }
+
+            u32* const entries = index->m_files.ptr_of(bucket->m_offset);
+            u32        count   = 0;
+            for (u32 i = 0; i < end; ++i)
+            {
+                if ((entries[i] & c_extentry_removed) != 0)
+                    *index->m_slot.ptr_of(entries[i] & ~c_extentry_removed) = c_invalid_slot;
+                else
+                    entries[count++] = entries[i];
+            }
+            bucket->m_entries = count;
+            s_set_slots(index, bucket, 0, count);
+        }
+
+        void g_extindex_remove(extindex_t* index, files_t const* files, ifile_t file, string_t extension)
+        {
+            if (file >= index->m_slots || *index->m_slot.ptr_of(file) == c_invalid_slot)
+                return;
+            extbucket_t* bucket = g_extindex_find(index, extension);
+            ASSERT(bucket != nullptr);
+
+            u32* const entry = index->m_files.ptr_of(bucket->m_offset + *index->m_slot.ptr_of(file));
+            if ((*entry & c_extentry_removed) != 0)
+                return;
+            *entry |= c_extentry_removed;
+            bucket->m_count -= 1;
+            if (bucket->m_entries >= c_min_compact && bucket->m_count * 2 < bucket->m_entries)
+                s_compact(index, files, bucket);
+        }
+
+        // Numbers the sub tree of 'top' evenly over the interval of 'top', which doesn't change. Pre-order over the
+        // child and sibling links, so there is no stack.
+        static void s_renumber(extindex_t* index, folders_t const* folders, node_t top)
+        {
+            u64 const tokens = (u64)*index->m_size.ptr_of(top) * 2 - 2; // an enter and a leave per descendant
+            u64 const gap    = (*index->m_leave.ptr_of(top) - *index->m_enter.ptr_of(top)) / (tokens + 1);
+            ASSERT(gap >= 1);
+
+            u64    number = *index->m_enter.ptr_of(top);
+            node_t node   = folders->m_array.ptr_of(top)->m_child;
+            while (node != c_invalid_folder)
+            {
+                number += gap;
+                *index->m_enter.ptr_of(node) = number;
+                folder_t const* folder       = folders->m_array.ptr_of(node);
+                if (folder->m_child != c_invalid_folder)
+                {
+                    node = folder->m_child;
+                    continue;
+                }
+                while (true)
+                {
+                    number += gap;
+                    *index->m_leave.ptr_of(node) = number;
+                    folder                       = folders->m_array.ptr_of(node);
+                    if (folder->m_sibling != c_invalid_folder)
+                    {
+                        node = folder->m_sibling;
+                        break;
+                    }
+                    node = folder->m_parent;
+                    if (node == top)
+                    {
+                        node = c_invalid_folder;
+                        break;
+                    }
+                }
+            }
+        }
+
+        // The sizes of the sub tree of 'top', post-order like s_renumber
+        static void s_count(extindex_t* index, folders_t const* folders, node_t top)
+        {
+            node_t node = top;
+            while (true)
+            {
+                *index->m_size.ptr_of(node) = 1;
+                folder_t const* folder      = folders->m_array.ptr_of(node);
+                if (folder->m_child != c_invalid_folder)
+                {
+                    node = folder->m_child;
+                    continue;
+                }
+                while (node != top)
+                {
+                    folder = folders->m_array.ptr_of(node);
+                    *index->m_size.ptr_of(folder->m_parent) += *index->m_size.ptr_of(node);
+                    if (folder->m_sibling != c_invalid_folder)
+                    {
+                        node = folder->m_sibling;
+                        break;
+                    }
+                    node = folder->m_parent;
+                }
+                if (node == top)
+                    return;
+            }
+        }
+
+        static void s_add_root(extindex_t* index, folders_t const* folders, node_t root)
+        {
+            ASSERT((u64)index->m_roots < ((u64)-1) / c_root_span);
+            *index->m_enter.ptr_of(root) = (u64)index->m_roots * c_root_span;
+            *index->m_leave.ptr_of(root) = (u64)index->m_roots * c_root_span + c_root_span - 1;
+            index->m_roots += 1;
+            s_count(index, folders, root);
+            s_renumber(index, folders, root);
+        }
+
+        void g_extindex_build_intervals(extindex_t* index, folders_t const* folders)
+        {
+            u32 const count = folders->m_count;
+            index->m_enter.ensure_capacity(count);
+            index->m_leave.ensure_capacity(count);
+            index->m_size.ensure_capacity(count);
+            index->m_roots = 0;
+            for (node_t root = 0; root < count; ++root)
+            {
+                if (folders->m_array.ptr_of(root)->m_parent == c_invalid_folder)
+                    s_add_root(index, folders, root);
+            }
+        }
+
+        // Like in list labelling the density a range may have goes down with its size (by 0.8 per bit of its width),
+        // after a renumbering the range takes a number of inserts in proportion to its size before it is full again
+        static bool s_is_sparse(u64 tokens, u64 width)
+        {
+            u64 limit = width;
+            for (u64 w = width; w > 1; w >>= 1)
+                limit -= limit / 5;
+            return tokens <= limit;
+        }
+
+        void g_extindex_add_folder(extindex_t* index, folders_t const* folders, node_t folder)
+        {
+            index->m_enter.ensure_capacity(folder + 1);
+            index->m_leave.ensure_capacity(folder + 1);
+            index->m_size.ensure_capacity(folder + 1);
+
+            folder_t const* f = folders->m_array.ptr_of(folder);
+            if (f->m_parent == c_invalid_folder)
+            {
+                s_add_root(index, folders, folder);
+                return;
+            }
+
+            // A new folder is the first child of its parent, it takes the upper half of the gap in front of the
+            // sibling that was first, the lower half is left for the next one
+            *index->m_size.ptr_of(folder) = 1;
+            for (node_t a = f->m_parent; a != c_invalid_folder; a = folders->m_array.ptr_of(a)->m_parent)
+                *index->m_size.ptr_of(a) += 1;
+            u64 const lo = *index->m_enter.ptr_of(f->m_parent);
+            u64 const hi = f->m_sibling != c_invalid_folder ? *index->m_enter.ptr_of(f->m_sibling) : *index->m_leave.ptr_of(f->m_parent);
+            if (hi - lo >= 2)
+            {
+                *index->m_enter.ptr_of(folder) = lo + (hi - lo) / 2;
+                *index->m_leave.ptr_of(folder) = hi;
+                return;
+            }
+
+            // No gap, renumber the smallest ancestor that is sparse enough (the folder tree when none is)
+            node_t top = f->m_parent;
+            while (true)
+            {
+                folder_t const* t     = folders->m_array.ptr_of(top);
+                u64 const       width = *index->m_leave.ptr_of(top) - *index->m_enter.ptr_of(top);
+                if (t->m_parent == c_invalid_folder || s_is_sparse((u64)*index->m_size.ptr_of(top) * 2, width))
+                    break;
+                top = t->m_parent;
+            }
+            s_renumber(index, folders, top);
+        }
+
+        // First position in the sorted run [lo, hi) whose folder enter is not below 'enter'
+        static u32 s_lower_bound(extindex_t const* index, files_t const* files, u32 const* entries, u32 lo, u32 hi, u64 enter)
+        {
+            while (lo < hi)
+            {
+                u32 const mid = (lo + hi) / 2;
+                if (s_key(index, files, entries[mid]) < enter)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            return lo;
+        }
+
+        static inline void s_emit(u32 entry, ifile_t* out_files, u32 max_files, u32& count)
+        {
+            if ((entry & c_extentry_removed) != 0)
+                return;
+            if (count < max_files)
+                out_files[count] = entry;
+            count += 1;
+        }
+
+        u32 g_extindex_files(extindex_t const* index, extbucket_t const* bucket, ifile_t* out_files, u32 max_files)
+        {
+            u32 const* const entries = index->m_files.ptr_of(bucket->m_offset);
+            u32              count   = 0;
+            for (u32 i = 0; i < bucket->m_entries && count < max_files; ++i)
+                s_emit(entries[i], out_files, max_files, count);
+            return bucket->m_count;
+        }
+
+        u32 g_extindex_files_below(extindex_t const* index, extbucket_t const* bucket, files_t const* files, node_t folder, ifile_t* out_files, u32 max_files)
+        {
+            u32 const* const entries = index->m_files.ptr_of(bucket->m_offset);
+            u64 const        enter   = *index->m_enter.ptr_of(folder);
+            u64 const        leave   = *index->m_leave.ptr_of(folder);
+            u32              count   = 0;
+            u32              begin   = 0;
+            for (u32 size = 0x80000000; size > 0; size >>= 1)
+            {
+                if ((bucket->m_entries & size) == 0)
+                    continue;
+                u32 const end   = begin + size;
+                u32 const first = s_lower_bound(index, files, entries, begin, end, enter);
+                u32 const last  = s_lower_bound(index, files, entries, first, end, leave);
+                for (u32 i = first; i < last; ++i)
+                    s_emit(entries[i], out_files, max_files, count);
+                begin = end;
+            }
+            return count;
+        }
+
+        void g_set_file_deleted(paths_t* paths, ifile_t file, bool deleted)
+        {
+            file_t* const f   = paths->m_files->m_array.ptr_of(file);
+            bool const    was = (f->m_flags & nfile::FlagDeleted) != 0;
+            if (was == deleted)
+                return;
+            f->m_flags = deleted ? (u8)(f->m_flags | nfile::FlagDeleted) : (u8)(f->m_flags & ~nfile::FlagDeleted);
+            if (paths->m_rollups != nullptr)
+            {
+                if (deleted)
+                    g_rollup_remove(paths, file);
+                else
+                    g_rollup_add(paths, file);
+            }
+            if (paths->m_fingerprints != nullptr)
+                g_fingerprint_dirty(paths, f->m_folder);
+            if (paths->m_unions != nullptr)
+                g_unions_changed(paths, f->m_folder);
+            if (paths->m_extindex == nullptr)
+                return;
+            if (deleted)
+                g_extindex_remove(paths->m_extindex, paths->m_files, file, f->m_extension);
+            else
+                g_extindex_add(paths->m_extindex, paths->m_files, file, f->m_extension);
+        }
+
+    } // namespace npath
+} // namespace ncore
@@ -6,6 +6,7 @@
 #include "cpath/c_dirpath.h"
 #include "cpath/c_filepath.h"
 #include "cpath/c_device.h"
+#include "cpath/private/c_strings.h"
 
 namespace ncore
 {
@@ -36,6 +37,14 @@ namespace ncore
 
     filepath_t::~filepath_t() {}
 
+    filepath_t& filepath_t::operator=(filepath_t const& other)
+    {
+        m_dirpath   = other.m_dirpath;
+        m_filename  = other.m_filename;
+        m_extension = other.m_extension;
+        return *this;
+    }
+
     void filepath_t::clear()
     {
         // npath::paths_t* root = m_dirpath.m_device->m_owner;
@@ -77,14 +86,22 @@ namespace ncore
 
     s8 filepath_t::compare(const filepath_t& right) const
     {
-        npath::paths_t* root = m_dirpath.m_device->m_owner;
-        s8 const        fe   = root->compare_str(m_filename, right.m_filename);
-        if (fe != 0)
-            return fe;
-        s8 const ce = root->compare_str(m_extension, right.m_extension);
-        if (ce != 0)
-            return ce;
-        return m_dirpath.compare(right.m_dirpath);
+        // filename and extension are interned strings, so identity is enough
+        if (m_filename != right.m_filename)
+            return m_filename < right.m_filename ? -1 : 1;
+        if (m_extension != right.m_extension)
+            return m_extension < right.m_extension ? -1 : 1;
+        s32 const de = m_dirpath.compare(right.m_dirpath);
+        return de < 0 ? -1 : (de > 0 ? 1 : 0);
+    }
+
+    s8 filepath_t::collate(const filepath_t& right) const
+    {
+        // Files in the same folder compare as "name.ext", otherwise a folder above the other file can decide
+        npath::paths_t const* paths = m_dirpath.m_device->m_owner;
+        if (m_dirpath.collate(right.m_dirpath) == 0)
+            return paths->m_strings->collate_files(m_filename, m_extension, right.m_filename, right.m_extension);
+        return paths->collate_file(m_dirpath.m_path, m_filename, m_extension, right.m_dirpath.m_path, right.m_filename, right.m_extension);
     }
 
 } // namespace ncore
@@ -0,0 +1,464 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_filepath.h"
+#include "cpath/c_device.h"
+#include "cpath/c_filestream.h"
+#include "cpath/c_instrument.h"
+#include "cpath/private/c_streams.h"
+
+#include <string.h>
+
+#if defined(TARGET_LINUX) || defined(TARGET_MAC)
+#    define CPATH_STREAMS_POSIX
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+namespace ncore
+{
+    namespace npath
+    {
+        static const s32 c_max_ospath         = 4096;
+        static const u64 c_prefault_threshold = 1024 * 1024; // mappings up to this size are faulted in ahead of use
+
+        streams_t* g_construct_streams(alloc_t* allocator, paths_t* paths, u32 max_idle)
+        {
+            streams_t* s       = g_construct<streams_t>(allocator);
+            s->m_paths         = paths;
+            s->m_file_capacity = 0;
+            s->m_num_mappings  = 0;
+            s->m_free_mapping  = c_invalid_mapping;
+            s->m_idle_head     = c_invalid_mapping;
+            s->m_idle_tail     = c_invalid_mapping;
+            s->m_num_idle      = 0;
+            s->m_max_idle      = max_idle;
+            s->m_num_streams   = 0;
+            s->m_free_stream   = c_invalid_stream;
+            s->m_opens         = 0;
+            s->m_reuses        = 0;
+            s->m_lock.init();
+            g_setup_vpool(s->m_file_mapping, 0, paths->m_max_items);
+            g_setup_vpool(s->m_mappings, 0, 1024 * 1024);
+            g_setup_vpool(s->m_streams, 0, 1024 * 1024);
+            return s;
+        }
+
+        // --------------------------------------------------------------------------------------------------------------
+        // platform layer
+
+#if defined(CPATH_STREAMS_POSIX)
+        static inline s64 s_mtime_ns(struct stat const& st)
+        {
+#    if defined(TARGET_MAC)
+            return (s64)st.st_mtimespec.tv_sec * 1000000000 + (s64)st.st_mtimespec.tv_nsec;
+#    else
+            return (s64)st.st_mtim.tv_sec * 1000000000 + (s64)st.st_mtim.tv_nsec;
+#    endif
+        }
+
+        static bool s_open_file(const char* ospath, mapping_t* m)
+        {
+            m->m_fd = ::open(ospath, O_RDONLY | O_CLOEXEC);
+            if (m->m_fd < 0)
+                return false;
+            struct stat st;
+            if (::fstat(m->m_fd, &st) != 0 || !S_ISREG(st.st_mode))
+            {
+                ::close(m->m_fd);
+                m->m_fd = -1;
+                return false;
+            }
+            m->m_size     = (u64)st.st_size;
+            m->m_mtime_ns = s_mtime_ns(st);
+            m->m_dev      = (u64)st.st_dev;
+            m->m_ino      = (u64)st.st_ino;
+            return true;
+        }
+
+        // An idle descriptor is only reused when the path still names the file that was opened and it did not
+        // change, the descriptor itself would still see the old file after it was replaced by a rename
+        static bool s_is_unchanged(const char* ospath, mapping_t const* m)
+        {
+            struct stat st;
+            return ::stat(ospath, &st) == 0 && (u64)st.st_dev == m->m_dev && (u64)st.st_ino == m->m_ino && (u64)st.st_size == m->m_size && s_mtime_ns(st) == m->m_mtime_ns;
+        }
+
+        static bool s_map_file(alloc_t* allocator, mapping_t* m)
+        {
+            // A small file is read, mapping it costs a page fault and a munmap that take longer than the copy
+            if (m->m_size <= streams_t::c_copy_threshold)
+            {
+                u8* copy = g_allocate_array<u8>(allocator, (u32)m->m_size);
+                if (::pread(m->m_fd, copy, (size_t)m->m_size, 0) != (ssize_t)m->m_size)
+                {
+                    g_deallocate_array(allocator, copy);
+                    return false;
+                }
+                m->m_data   = copy;
+                m->m_copied = 1;
+                return true;
+            }
+
+            void* data = ::mmap(nullptr, (size_t)m->m_size, PROT_READ, MAP_PRIVATE, m->m_fd, 0);
+            if (data == MAP_FAILED)
+                return false;
+            // Small files are read completely, fault them in now, large files are usually read front to back
+            ::madvise(data, (size_t)m->m_size, m->m_size <= c_prefault_threshold ? MADV_WILLNEED : MADV_SEQUENTIAL);
+            m->m_data = (u8*)data;
+            return true;
+        }
+
+        static void s_close_file(alloc_t* allocator, mapping_t* m)
+        {
+            if (m->m_data != nullptr && m->m_copied != 0)
+                g_deallocate_array(allocator, m->m_data);
+            else if (m->m_data != nullptr)
+                ::munmap(m->m_data, (size_t)m->m_size);
+            ::close(m->m_fd);
+            m->m_data   = nullptr;
+            m->m_fd     = -1;
+            m->m_copied = 0;
+        }
+
+        static void s_advise_sequential(mapping_t const* m)
+        {
+#    if defined(TARGET_LINUX)
+            ::posix_fadvise(m->m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#    endif
+        }
+
+        static void s_advise_willneed(mapping_t const* m, u64 offset, u64 size)
+        {
+#    if defined(TARGET_LINUX)
+            ::posix_fadvise(m->m_fd, (off_t)offset, (off_t)size, POSIX_FADV_WILLNEED);
+#    endif
+        }
+
+        static s64 s_read_at(mapping_t const* m, void* out, u64 size, u64 offset) { return (s64)::pread(m->m_fd, out, (size_t)size, (off_t)offset); }
+#else
+        static bool s_open_file(const char* ospath, mapping_t* m) { return false; }
+        static bool s_is_unchanged(const char* ospath, mapping_t const* m) { return false; }
+        static bool s_map_file(alloc_t* allocator, mapping_t* m) { return false; }
+        static void s_close_file(alloc_t* allocator, mapping_t* m) {}
+        static void s_advise_sequential(mapping_t const* m) {}
+        static void s_advise_willneed(mapping_t const* m, u64 offset, u64 size) {}
+        static s64  s_read_at(mapping_t const* m, void* out, u64 size, u64 offset) { return -1; }
+#endif
+
+        void g_destruct_streams(alloc_t* allocator, streams_t*& streams)
+        {
+            for (u32 i = 0; i < streams->m_num_streams; ++i)
+            {
+                stream_t* s = streams->m_streams.ptr_of(i);
+                if (s->m_mapping != c_invalid_mapping && s->m_buffer != nullptr)
+                    g_deallocate_array(allocator, s->m_buffer);
+            }
+            for (u32 i = 0; i < streams->m_num_mappings; ++i)
+            {
+                mapping_t* m = streams->m_mappings.ptr_of(i);
+                if (m->m_fd >= 0)
+                    s_close_file(allocator, m);
+            }
+            g_teardown_vpool(streams->m_file_mapping);
+            g_teardown_vpool(streams->m_mappings);
+            g_teardown_vpool(streams->m_streams);
+            streams->m_lock.exit();
+            g_destruct(allocator, streams);
+            streams = nullptr;
+        }
+
+        // --------------------------------------------------------------------------------------------------------------
+        // descriptor pool, all calls are made while holding the streams lock
+
+        static void s_unlink_idle(streams_t* s, u32 index)
+        {
+            mapping_t* m = s->m_mappings.ptr_of(index);
+            if (m->m_prev != c_invalid_mapping)
+                s->m_mappings.ptr_of(m->m_prev)->m_next = m->m_next;
+            else
+                s->m_idle_head = m->m_next;
+            if (m->m_next != c_invalid_mapping)
+                s->m_mappings.ptr_of(m->m_next)->m_prev = m->m_prev;
+            else
+                s->m_idle_tail = m->m_prev;
+            m->m_prev = m->m_next = c_invalid_mapping;
+            s->m_num_idle -= 1;
+        }
+
+        static void s_free_mapping(streams_t* s, u32 index)
+        {
+            mapping_t* m = s->m_mappings.ptr_of(index);
+            s_close_file(s->m_paths->m_allocator, m);
+            *s->m_file_mapping.ptr_of(m->m_file) = c_invalid_mapping;
+            m->m_next                            = s->m_free_mapping;
+            s->m_free_mapping                    = index;
+        }
+
+        static u32 s_acquire_mapping(streams_t* s, ifile_t file)
+        {
+            if (file >= s->m_file_capacity)
+            {
+                s->m_file_mapping.ensure_capacity(file);
+                for (u32 i = s->m_file_capacity; i <= file; ++i)
+                    *s->m_file_mapping.ptr_of(i) = c_invalid_mapping;
+                s->m_file_capacity = file + 1;
+            }
+
+            char ospath[c_max_ospath];
+            if (s->m_paths->file_to_ospath(file, ospath, c_max_ospath) < 0)
+                return c_invalid_mapping;
+
+            u32 index = *s->m_file_mapping.ptr_of(file);
+            if (index != c_invalid_mapping)
+            {
+                mapping_t* m = s->m_mappings.ptr_of(index);
+                if (m->m_refs == 0)
+                {
+                    s_unlink_idle(s, index);
+                    if (!s_is_unchanged(ospath, m))
+                    {
+                        s_free_mapping(s, index);
+                        index = c_invalid_mapping;
+                    }
+                }
+                if (index != c_invalid_mapping)
+                {
+                    m->m_refs += 1;
+                    s->m_opens += 1;
+                    s->m_reuses += 1;
+                    return index;
+                }
+            }
+
+            mapping_t opened;
+            opened.m_file   = file;
+            opened.m_data   = nullptr;
+            opened.m_refs   = 1;
+            opened.m_prev   = c_invalid_mapping;
+            opened.m_next   = c_invalid_mapping;
+            opened.m_copied = 0;
+            if (!s_open_file(ospath, &opened))
+                return c_invalid_mapping;
+
+            index = s->m_free_mapping;
+            if (index != c_invalid_mapping)
+            {
+                s->m_free_mapping = s->m_mappings.ptr_of(index)->m_next;
+            }
+            else
+            {
+                index = s->m_num_mappings++;
+                s->m_mappings.ensure_capacity(index);
+            }
+            *s->m_mappings.ptr_of(index)    = opened;
+            *s->m_file_mapping.ptr_of(file) = index;
+            s->m_opens += 1;
+            return index;
+        }
+
+        // The last stream of a file keeps it open on the idle list, the least recently used idle files are closed
+        static void s_release_mapping(streams_t* s, u32 index)
+        {
+            mapping_t* m = s->m_mappings.ptr_of(index);
+            if (--m->m_refs != 0)
+                return;
+
+            m->m_prev = c_invalid_mapping;
+            m->m_next = s->m_idle_head;
+            if (s->m_idle_head != c_invalid_mapping)
+                s->m_mappings.ptr_of(s->m_idle_head)->m_prev = index;
+            else
+                s->m_idle_tail = index;
+            s->m_idle_head = index;
+            s->m_num_idle += 1;
+
+            while (s->m_num_idle > s->m_max_idle)
+            {
+                u32 const tail = s->m_idle_tail;
+                s_unlink_idle(s, tail);
+                s_free_mapping(s, tail);
+            }
+        }
+
+    } // namespace npath
+
+    // ------------------------------------------------------------------------------------------------------------------
+    // filestream_t
+
+    filestream_t::filestream_t() : m_streams(nullptr), m_stream(npath::c_invalid_stream) {}
+
+    filestream_t open_filestream(filepath_t const& filepath, u8 mode)
+    {
+        filestream_t           fs;
+        npath::device_t* const device = filepath.m_dirpath.m_device;
+        if (device == nullptr)
+            return fs;
+
+        npath::paths_t* const   paths   = device->m_owner;
+        npath::streams_t* const streams = paths->m_streams;
+        if (streams == nullptr)
+            return fs; // nothing is mounted
+
+        CPATH_SCOPE("open_filestream");
+        npath::lock_t       lock(streams->m_lock);
+        npath::ifile_t const file  = paths->file_of(filepath);
+        u32 const            index = file != npath::c_invalid_file ? npath::s_acquire_mapping(streams, file) : npath::c_invalid_mapping;
+        if (index == npath::c_invalid_mapping)
+            return fs;
+
+        npath::mapping_t* m = streams->m_mappings.ptr_of(index);
+        if (mode == npath::nstream::ModeMapped && m->m_data == nullptr && m->m_size > 0 && !npath::s_map_file(paths->m_allocator, m))
+            mode = npath::nstream::ModeSequential; // can't be mapped (e.g. a special file system), read it instead
+
+        u32 stream = streams->m_free_stream;
+        if (stream != npath::c_invalid_stream)
+        {
+            streams->m_free_stream = streams->m_streams.ptr_of(stream)->m_next;
+        }
+        else
+        {
+            stream = streams->m_num_streams++;
+            streams->m_streams.ensure_capacity(stream);
+        }
+
+        npath::stream_t* s = streams->m_streams.ptr_of(stream);
+        s->m_mapping       = index;
+        s->m_mode          = mode;
+        s->m_position      = 0;
+        s->m_buffer        = nullptr;
+        s->m_buffer_base   = 0;
+        s->m_buffer_len    = 0;
+        s->m_next          = npath::c_invalid_stream;
+        if (mode == npath::nstream::ModeSequential)
+        {
+            s->m_buffer = g_allocate_array<u8>(paths->m_allocator, npath::streams_t::c_buffer_size);
+            npath::s_advise_sequential(m);
+        }
+
+        fs.m_streams = streams;
+        fs.m_stream  = stream;
+        return fs;
+    }
+
+    bool filestream_t::is_open() const { return m_stream != npath::c_invalid_stream; }
+
+    u64 filestream_t::size() const
+    {
+        if (m_stream == npath::c_invalid_stream)
+            return 0;
+        return m_streams->m_mappings.ptr_of(m_streams->m_streams.ptr_of(m_stream)->m_mapping)->m_size;
+    }
+
+    u64 filestream_t::position() const { return m_stream != npath::c_invalid_stream ? m_streams->m_streams.ptr_of(m_stream)->m_position : 0; }
+
+    bool filestream_t::seek(u64 position)
+    {
+        if (m_stream == npath::c_invalid_stream || position > size())
+            return false;
+        m_streams->m_streams.ptr_of(m_stream)->m_position = position;
+        return true;
+    }
+
+    u64 filestream_t::read(void* out, u64 size)
+    {
+        if (m_stream == npath::c_invalid_stream)
+            return 0;
+        npath::stream_t* const        s = m_streams->m_streams.ptr_of(m_stream);
+        npath::mapping_t const* const m = m_streams->m_mappings.ptr_of(s->m_mapping);
+        if (s->m_position >= m->m_size)
+            return 0;
+        if (size > (m->m_size - s->m_position))
+            size = m->m_size - s->m_position;
+
+        if (s->m_mode == npath::nstream::ModeMapped)
+        {
+            memcpy(out, m->m_data + s->m_position, (size_t)size);
+            s->m_position += size;
+            return size;
+        }
+
+        u8* dst  = (u8*)out;
+        u64 done = 0;
+        while (done < size)
+        {
+            u64 const pos = s->m_position;
+            if (pos >= s->m_buffer_base && pos < (s->m_buffer_base + s->m_buffer_len))
+            {
+                u64 n = (s->m_buffer_base + s->m_buffer_len) - pos;
+                if (n > (size - done))
+                    n = size - done;
+                memcpy(dst + done, s->m_buffer + (pos - s->m_buffer_base), (size_t)n);
+                s->m_position += n;
+                done += n;
+                continue;
+            }
+
+            // Large reads go straight to the caller, small ones refill the buffer
+            if ((size - done) >= npath::streams_t::c_buffer_size)
+            {
+                s64 const n = npath::s_read_at(m, dst + done, size - done, pos);
+                if (n <= 0)
+                    break;
+                s->m_position += (u64)n;
+                done += (u64)n;
+                continue;
+            }
+
+            s64 const n = npath::s_read_at(m, s->m_buffer, npath::streams_t::c_buffer_size, pos);
+            if (n <= 0)
+                break;
+            s->m_buffer_base = pos;
+            s->m_buffer_len  = (u32)n;
+            npath::s_advise_willneed(m, pos + (u64)n, npath::streams_t::c_buffer_size); // the next buffer
+        }
+        return done;
+    }
+
+    u64 filestream_t::view(u8 const*& out_data, u64 size)
+    {
+        out_data = nullptr;
+        if (m_stream == npath::c_invalid_stream)
+            return 0;
+        npath::stream_t* const        s = m_streams->m_streams.ptr_of(m_stream);
+        npath::mapping_t const* const m = m_streams->m_mappings.ptr_of(s->m_mapping);
+        if (s->m_mode != npath::nstream::ModeMapped || s->m_position >= m->m_size)
+            return 0;
+        if (size > (m->m_size - s->m_position))
+            size = m->m_size - s->m_position;
+        out_data = m->m_data + s->m_position;
+        s->m_position += size;
+        return size;
+    }
+
+    u8 const* filestream_t::data() const
+    {
+        if (m_stream == npath::c_invalid_stream)
+            return nullptr;
+        npath::stream_t const* const s = m_streams->m_streams.ptr_of(m_stream);
+        return s->m_mode == npath::nstream::ModeMapped ? m_streams->m_mappings.ptr_of(s->m_mapping)->m_data : nullptr;
+    }
+
+    void filestream_t::close()
+    {
+        if (m_stream == npath::c_invalid_stream)
+            return;
+
+        npath::lock_t    lock(m_streams->m_lock);
+        npath::stream_t* s = m_streams->m_streams.ptr_of(m_stream);
+        if (s->m_buffer != nullptr)
+            g_deallocate_array(m_streams->m_paths->m_allocator, s->m_buffer);
+        npath::s_release_mapping(m_streams, s->m_mapping);
+        s->m_mapping             = npath::c_invalid_mapping;
+        s->m_buffer              = nullptr;
+        s->m_next                = m_streams->m_free_stream;
+        m_streams->m_free_stream = m_stream;
+        m_stream                 = npath::c_invalid_stream;
+    }
+
+} // namespace ncore
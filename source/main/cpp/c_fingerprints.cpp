@@ -0,0 +1,379 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+
+#include "cpath/c_path.h"
+#include "cpath/private/c_folders.h"
+#include "cpath/private/c_strings.h"
+#include "cpath/private/c_metadata.h"
+#include "cpath/private/c_hashes.h"
+#include "cpath/private/c_threads.h"
+#include "cpath/private/c_fingerprints.h"
+
+#include <string.h>
+
+namespace ncore
+{
+    namespace npath
+    {
+        static const u32 c_level_chunk  = 1024; // dirty folders per work item
+        static const u32 c_min_parallel = 4096; // a level with fewer dirty folders is computed on the calling thread
+
+        fingerprints_t* g_construct_fingerprints(alloc_t* allocator, u32 max_items, varena_config_t const& config)
+        {
+            fingerprints_t* fp = g_construct<fingerprints_t>(allocator);
+            g_setup_vpool(fp->m_lo, 0, max_items, config);
+            g_setup_vpool(fp->m_hi, 0, max_items, config);
+            g_setup_vpool(fp->m_files, 0, max_items, config);
+            g_setup_vpool(fp->m_children, 0, max_items, config);
+            g_setup_vpool(fp->m_entry, 0, max_items, config);
+            g_setup_vpool(fp->m_dirty, 0, max_items, config);
+            g_setup_vpool(fp->m_pending, 0, max_items, config);
+            fp->m_num_pending = 0;
+            fp->m_sweep       = true;
+            fp->m_capacity    = 0;
+            return fp;
+        }
+
+        void g_destruct_fingerprints(alloc_t* allocator, fingerprints_t*& fingerprints)
+        {
+            g_teardown_vpool(fingerprints->m_lo);
+            g_teardown_vpool(fingerprints->m_hi);
+            g_teardown_vpool(fingerprints->m_files);
+            g_teardown_vpool(fingerprints->m_children);
+            g_teardown_vpool(fingerprints->m_entry);
+            g_teardown_vpool(fingerprints->m_dirty);
+            g_teardown_vpool(fingerprints->m_pending);
+            g_destruct(allocator, fingerprints);
+            fingerprints = nullptr;
+        }
+
+        static inline void s_queue(fingerprints_t* fp, node_t folder)
+        {
+            fp->m_pending.ensure_capacity(fp->m_num_pending + 1);
+            *fp->m_pending.ptr_of(fp->m_num_pending++) = folder;
+            *fp->m_dirty.ptr_of(folder) |= nfingerprint::FlagQueued;
+        }
+
+        // New folders start dirty, empty and not in the sum of their parent
+        static void s_ensure_capacity(fingerprints_t* fp, u32 count)
+        {
+            if (count <= fp->m_capacity)
+                return;
+            fp->m_lo.ensure_capacity(count);
+            fp->m_hi.ensure_capacity(count);
+            fp->m_files.ensure_capacity(count);
+            fp->m_children.ensure_capacity(count);
+            fp->m_entry.ensure_capacity(count);
+            fp->m_dirty.ensure_capacity(count);
+
+            u32 const n = count - fp->m_capacity;
+            memset(fp->m_files.ptr_of(fp->m_capacity), 0, n * sizeof(fpsum_t));
+            memset(fp->m_children.ptr_of(fp->m_capacity), 0, n * sizeof(fpsum_t));
+            memset(fp->m_entry.ptr_of(fp->m_capacity), 0, n * sizeof(fpsum_t));
+            memset(fp->m_dirty.ptr_of(fp->m_capacity), nfingerprint::FlagDirty | nfingerprint::FlagFilesDirty, n);
+            if (!fp->m_sweep)
+            {
+                for (u32 i = fp->m_capacity; i < count; ++i)
+                    s_queue(fp, i);
+            }
+            fp->m_capacity = count;
+        }
+
+        void g_fingerprint_dirty(paths_t* paths, node_t folder)
+        {
+            fingerprints_t* const fp = paths->m_fingerprints;
+            s_ensure_capacity(fp, paths->m_folders->m_count);
+            u8 flags = nfingerprint::FlagDirty | nfingerprint::FlagFilesDirty;
+            for (node_t a = folder; a != c_invalid_folder; a = paths->m_folders->m_array.ptr_of(a)->m_parent)
+            {
+                u8* const  dirty = fp->m_dirty.ptr_of(a);
+                bool const done  = a != folder && (*dirty & nfingerprint::FlagDirty) != 0;
+                *dirty |= flags;
+                if (!fp->m_sweep && (*dirty & nfingerprint::FlagQueued) == 0)
+                    s_queue(fp, a);
+                if (done)
+                    break;
+                flags = nfingerprint::FlagDirty;
+            }
+        }
+
+        // The sums of the sub folder entries stay valid, every folder is computed again and replaces its entry
+        void g_fingerprint_invalidate(paths_t* paths)
+        {
+            fingerprints_t* const fp = paths->m_fingerprints;
+            s_ensure_capacity(fp, paths->m_folders->m_count);
+            memset(fp->m_dirty.ptr_of(0), nfingerprint::FlagDirty | nfingerprint::FlagFilesDirty, fp->m_capacity);
+            fp->m_num_pending = 0;
+            fp->m_sweep       = true;
+        }
+
+        // --------------------------------------------------------------------------------------------------------------
+        // computing a folder
+
+        enum esource
+        {
+            SourceNone     = 0,
+            SourceHash     = 1, // content hash of a file
+            SourceMetadata = 2, // size and mtime of a file
+            SourceFolder   = 3, // fingerprint of a sub folder
+        };
+
+        // What is hashed for every file and sub folder, names are hashed as bytes so the string pools of two
+        // registries give the same entries
+        struct entry_t
+        {
+            u64 m_name[2];
+            u64 m_ext[2];
+            u64 m_content[2];
+            u8  m_type;   // nfile type, 0 for a sub folder
+            u8  m_source; // esource
+            u8  m_padding[6];
+        };
+
+        // c_empty_string ("nil") is a file without extension, like a registered ""
+        static void s_hash_name(paths_t const* paths, string_t str, u64* out_hash)
+        {
+            contenthash_t h;
+            if (str == c_empty_string)
+            {
+                g_hash128("", 0, h);
+            }
+            else
+            {
+                strings_t::str_t const* s = paths->m_strings->index_to_object(str);
+                g_hash128(s->m_str, s->m_len, h);
+            }
+            out_hash[0] = h.m_lo;
+            out_hash[1] = h.m_hi;
+        }
+
+        static void s_file_content(paths_t const* paths, ifile_t file, entry_t& e)
+        {
+            hashes_t const* h = paths->m_hashes;
+            if (h != nullptr && file < h->m_capacity && (*h->m_flags.ptr_of(file) & nmeta::FlagValid) != 0)
+            {
+                e.m_content[0] = *h->m_lo.ptr_of(file);
+                e.m_content[1] = *h->m_hi.ptr_of(file);
+                e.m_source     = SourceHash;
+                return;
+            }
+            metadata_t const* m = paths->m_metadata;
+            if (m != nullptr && file < m->m_files.m_capacity && (*m->m_files.m_flags.ptr_of(file) & nmeta::FlagValid) != 0)
+            {
+                e.m_content[0] = *m->m_files.m_size.ptr_of(file);
+                e.m_content[1] = (u64)*m->m_files.m_mtime.ptr_of(file);
+                e.m_source     = SourceMetadata;
+            }
+        }
+
+        static inline void s_add(fpsum_t& sum, fpsum_t const& x)
+        {
+            sum.m_lo += x.m_lo;
+            sum.m_hi += x.m_hi + (sum.m_lo < x.m_lo ? 1 : 0);
+            sum.m_count += x.m_count;
+        }
+
+        static inline void s_sub(fpsum_t& sum, fpsum_t const& x)
+        {
+            u64 const borrow = sum.m_lo < x.m_lo ? 1 : 0;
+            sum.m_lo -= x.m_lo;
+            sum.m_hi -= x.m_hi + borrow;
+            sum.m_count -= x.m_count;
+        }
+
+        static inline void s_add_entry(fpsum_t& sum, entry_t const& e)
+        {
+            contenthash_t h;
+            g_hash128(&e, sizeof(e), h);
+            fpsum_t const x = {h.m_lo, h.m_hi, 1};
+            s_add(sum, x);
+        }
+
+        // The fingerprint of a dirty folder and its new entry for the sum of its parent, the sub folders are done
+        static void s_compute(paths_t* paths, node_t node, fpsum_t& out_entry)
+        {
+            fingerprints_t* const fp     = paths->m_fingerprints;
+            folder_t const*       folder = paths->m_folders->m_array.ptr_of(node);
+            u8* const             dirty  = fp->m_dirty.ptr_of(node);
+            entry_t               e;
+
+            if ((*dirty & nfingerprint::FlagFilesDirty) != 0)
+            {
+                fpsum_t files = {0, 0, 0};
+                for (ifile_t file = folder->m_file; file != c_invalid_file;)
+                {
+                    file_t const* f = paths->m_files->m_array.ptr_of(file);
+                    if ((f->m_flags & nfile::FlagDeleted) == 0)
+                    {
+                        memset(&e, 0, sizeof(e));
+                        s_hash_name(paths, f->m_filename, e.m_name);
+                        s_hash_name(paths, f->m_extension, e.m_ext);
+                        e.m_type = f->m_type;
+                        s_file_content(paths, file, e);
+                        s_add_entry(files, e);
+                    }
+                    file = f->m_sibling;
+                }
+                *fp->m_files.ptr_of(node) = files;
+            }
+
+            fpsum_t sum = *fp->m_files.ptr_of(node);
+            s_add(sum, *fp->m_children.ptr_of(node));
+            contenthash_t h;
+            g_hash128(&sum, sizeof(sum), h);
+            *fp->m_lo.ptr_of(node) = h.m_lo;
+            *fp->m_hi.ptr_of(node) = h.m_hi;
+            *dirty                 = 0;
+
+            memset(&out_entry, 0, sizeof(out_entry));
+            if ((folder->m_flags & nfolder::FlagDeleted) == 0)
+            {
+                memset(&e, 0, sizeof(e));
+                s_hash_name(paths, folder->m_name, e.m_name);
+                e.m_content[0] = h.m_lo;
+                e.m_content[1] = h.m_hi;
+                e.m_source     = SourceFolder;
+                s_add_entry(out_entry, e);
+            }
+        }
+
+        // Replaces the entry of a folder in the sum of its parent
+        static void s_apply(paths_t* paths, node_t node, fpsum_t const& entry)
+        {
+            fingerprints_t* const fp     = paths->m_fingerprints;
+            node_t const          parent = paths->m_folders->m_array.ptr_of(node)->m_parent;
+            if (parent == c_invalid_folder)
+                return;
+            fpsum_t* const children = fp->m_children.ptr_of(parent);
+            fpsum_t* const previous = fp->m_entry.ptr_of(node);
+            s_sub(*children, *previous);
+            s_add(*children, entry);
+            *previous = entry;
+        }
+
+        // --------------------------------------------------------------------------------------------------------------
+        // recomputing the dirty folders
+
+        struct level_item_t
+        {
+            u32 m_begin;
+            u32 m_end;
+        };
+
+        struct level_run_t
+        {
+            paths_t*      m_paths;
+            node_t const* m_order;
+            fpsum_t*      m_entries; // the new entry of every folder in m_order
+        };
+
+        static void s_level_work(workpool_t*, u32, void* item, void* user)
+        {
+            level_run_t const*  run   = (level_run_t const*)user;
+            level_item_t const* range = (level_item_t const*)item;
+            for (u32 i = range->m_begin; i < range->m_end; ++i)
+                s_compute(run->m_paths, run->m_order[i], run->m_entries[i]);
+        }
+
+        // The dirty folders are sorted by depth (counting sort) and computed from the deepest level up. A folder only
+        // depends on the level below it, so a large level is split over the workers of the pool. The new entries
+        // go into the sums of the parents afterwards, on the calling thread, siblings share a parent.
+        static void s_recompute(paths_t* paths, node_t const* dirty, u32 count, u32 num_threads)
+        {
+            alloc_t* const   alloc   = paths->m_allocator;
+            folders_t* const folders = paths->m_folders;
+            u32 const        levels  = folders->m_max_depth + 1;
+            u32 const        workers = num_threads != 0 ? num_threads : (count >= c_min_parallel ? g_hardware_threads() : 1);
+            u32*             offsets = g_allocate_array<u32>(alloc, levels);
+            node_t*          order   = g_allocate_array<node_t>(alloc, count);
+            fpsum_t*         entries = g_allocate_array<fpsum_t>(alloc, count);
+
+            // offsets[d] is the start of level d, after the placement it is the end of level d
+            memset(offsets, 0, levels * sizeof(u32));
+            for (u32 i = 0; i < count; ++i)
+            {
+                u32 const depth = folders->m_array.ptr_of(dirty[i])->m_depth;
+                if (depth + 1 < levels)
+                    offsets[depth + 1] += 1;
+            }
+            for (u32 d = 1; d < levels; ++d)
+                offsets[d] += offsets[d - 1];
+            for (u32 i = 0; i < count; ++i)
+                order[offsets[folders->m_array.ptr_of(dirty[i])->m_depth]++] = dirty[i];
+
+            workpool_t* pool = nullptr;
+            level_run_t run  = {paths, order, entries};
+            for (u32 d = levels; d > 0; --d)
+            {
+                u32 const begin = d >= 2 ? offsets[d - 2] : 0;
+                u32 const end   = offsets[d - 1];
+                if (workers > 1 && (end - begin) >= c_min_parallel)
+                {
+                    if (pool == nullptr)
+                        pool = g_construct_workpool(alloc, workers, sizeof(level_item_t), count / c_level_chunk + 1, s_level_work, &run);
+                    for (u32 i = begin; i < end; i += c_level_chunk)
+                    {
+                        level_item_t item;
+                        item.m_begin = i;
+                        item.m_end   = (end - i) > c_level_chunk ? i + c_level_chunk : end;
+                        g_push_work(pool, 0, &item);
+                    }
+                    g_run_workpool(pool);
+                }
+                else
+                {
+                    for (u32 i = begin; i < end; ++i)
+                        s_compute(paths, order[i], entries[i]);
+                }
+                for (u32 i = begin; i < end; ++i)
+                    s_apply(paths, order[i], entries[i]);
+            }
+
+            if (pool != nullptr)
+                g_destruct_workpool(alloc, pool);
+            g_deallocate_array(alloc, entries);
+            g_deallocate_array(alloc, order);
+            g_deallocate_array(alloc, offsets);
+        }
+
+        void g_fingerprint_update(paths_t* paths, u32 num_threads)
+        {
+            fingerprints_t* const fp    = paths->m_fingerprints;
+            u32 const             count = paths->m_folders->m_count;
+            s_ensure_capacity(fp, count);
+
+            if (fp->m_sweep)
+            {
+                node_t*   dirty = g_allocate_array<node_t>(paths->m_allocator, count);
+                u32       n     = 0;
+                u8 const* flags = fp->m_dirty.ptr_of(0);
+                for (u32 i = 0; i < count; ++i)
+                {
+                    if ((flags[i] & nfingerprint::FlagDirty) != 0)
+                        dirty[n++] = i;
+                }
+                if (n > 0)
+                    s_recompute(paths, dirty, n, num_threads);
+                g_deallocate_array(paths->m_allocator, dirty);
+            }
+            else if (fp->m_num_pending > 0)
+            {
+                s_recompute(paths, fp->m_pending.ptr_of(0), fp->m_num_pending, num_threads);
+            }
+            fp->m_num_pending = 0;
+            fp->m_sweep       = false;
+        }
+
+        void g_fingerprint_get(paths_t* paths, node_t folder, u64& out_lo, u64& out_hi)
+        {
+            fingerprints_t* const fp = paths->m_fingerprints;
+            s_ensure_capacity(fp, paths->m_folders->m_count);
+            if ((*fp->m_dirty.ptr_of(folder) & nfingerprint::FlagDirty) != 0)
+                g_fingerprint_update(paths, 0);
+            out_lo = *fp->m_lo.ptr_of(folder);
+            out_hi = *fp->m_hi.ptr_of(folder);
+        }
+
+    } // namespace npath
+} // namespace ncore
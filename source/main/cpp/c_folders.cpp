@@ -14,12 +14,18 @@ namespace ncore
 {
     namespace npath
     {
-        folders_t* g_construct_folders(alloc_t* allocator, u32 max_items)
+        folders_t* g_construct_folders(alloc_t* allocator, u32 max_items, varena_config_t const& config)
         {
-            folders_t* f = g_construct<folders_t>(allocator);
-            f->m_count   = 1;
-            g_setup_vpool(f->m_array, 8192, max_items);
-            g_setup_vpool(f->m_nodes, 8192, max_items);
+            folders_t* f       = g_construct<folders_t>(allocator);
+            f->m_count         = 1;
+            f->m_num_parents   = 0;
+            f->m_num_children  = 0;
+            f->m_max_children  = 0;
+            f->m_max_depth     = 0;
+            f->m_collate_count = 0;
+            g_setup_vpool(f->m_array, 8192, max_items, config);
+            g_setup_vpool(f->m_nodes, 8192, max_items, config);
+            g_setup_vpool(f->m_collate, 0, max_items, config);
             ntree32::setup_tree(f->m_tree, (ntree32::nnode_t*)f->m_nodes.ptr());
             ntree32::node_t default_folder_node = f->m_tree.new_node();
             ASSERT(default_folder_node == c_empty_folder);
@@ -32,56 +38,127 @@ namespace ncore
         {
             g_teardown_vpool(folders->m_array);
             g_teardown_vpool(folders->m_nodes);
+            g_teardown_vpool(folders->m_collate);
             ntree32::teardown_tree(folders->m_tree);
             g_destruct(allocator, folders);
             folders = nullptr;
         }
 
+        void g_ensure_folder_capacity(folders_t* folders, u32 index)
+        {
+            folders->m_array.ensure_capacity(index);
+            folders->m_nodes.ensure_capacity(index);
+        }
+
         node_t g_allocate_folder(folders_t* folders, string_t name)
         {
+            g_ensure_folder_capacity(folders, folders->m_count + 1);
             node_t    path_node = folders->m_tree.new_node();
             folder_t* folder    = folders->m_array.ptr_of(path_node);
-            folder->m_parent    = c_invalid_folder;
-            folder->m_name      = name;
-            folder->m_folders   = c_invalid_node;
+            folder->reset();
+            folder->m_name = name;
             folders->m_count += 1;
             return path_node;
         }
 
+        void g_add_child_folder(folders_t* folders, folder_t* parent, folder_t* child)
+        {
+            child->m_depth = parent->m_depth + 1;
+            if (child->m_depth > folders->m_max_depth)
+                folders->m_max_depth = child->m_depth;
+
+            folders->m_num_children += 1;
+            if (parent->m_num_folders++ == 0)
+                folders->m_num_parents += 1;
+            if (parent->m_num_folders > folders->m_max_children)
+                folders->m_max_children = parent->m_num_folders;
+
+            child->m_sibling = parent->m_child;
+            parent->m_child  = folders->m_array.idx_of(child);
+        }
+
+        bool g_folder_is_below(folders_t const* folders, node_t folder, node_t ancestor)
+        {
+            node_t iter = folder;
+            while (iter != ancestor && iter != c_invalid_node)
+                iter = folders->m_array.ptr_of(iter)->m_parent;
+            return iter == ancestor;
+        }
+
+        // The chain is collected bottom-up in segments, the segments above are visited first
+        static const s32 c_folder_segment = 64;
+
+        void g_for_each_folder_down(folders_t const* folders, node_t to, node_t from, folder_fn fn, void* user)
+        {
+            if (to == c_empty_node || to == c_invalid_node)
+                return;
+            node_t chain[c_folder_segment];
+            s32    count = 0;
+            node_t iter  = to;
+            while (iter != from && iter != c_invalid_node && count < c_folder_segment)
+            {
+                chain[count++] = iter;
+                iter           = folders->m_array.ptr_of(iter)->m_parent;
+            }
+            if (iter != from && iter != c_invalid_node)
+                g_for_each_folder_down(folders, iter, from, fn, user);
+            for (s32 i = count - 1; i >= 0; --i)
+                fn(chain[i], user);
+        }
+
+        void g_get_stats(folders_t const* folders, paths_stats_t& stats)
+        {
+            stats.m_folder_array.m_reserved  = folders->m_array.m_arena.reserved_bytes();
+            stats.m_folder_array.m_committed = folders->m_array.m_arena.committed_bytes();
+            stats.m_folder_nodes.m_reserved  = folders->m_nodes.m_arena.reserved_bytes();
+            stats.m_folder_nodes.m_committed = folders->m_nodes.m_arena.committed_bytes();
+
+            stats.m_folder_count = folders->m_count;
+            stats.m_max_children = folders->m_max_children;
+            stats.m_avg_children = folders->m_num_parents > 0 ? (f32)folders->m_num_children / (f32)folders->m_num_parents : 0.0f;
+            stats.m_max_depth    = folders->m_max_depth;
+            stats.m_wasted_bytes += sizeof(folder_t) + sizeof(ntree32::nnode_t); // temp slot used by insert
+        }
+
+        files_t* g_construct_files(alloc_t* allocator, u32 max_items, varena_config_t const& config)
+        {
+            files_t* f = g_construct<files_t>(allocator);
+            f->m_count = 1;
+            g_setup_vpool(f->m_array, 8192, max_items, config);
+            g_setup_vpool(f->m_nodes, 8192, max_items, config);
+            ntree32::setup_tree(f->m_tree, (ntree32::nnode_t*)f->m_nodes.ptr());
+            ntree32::node_t default_file_node = f->m_tree.new_node();
+            ASSERT(default_file_node == c_empty_file);
+            file_t* default_file = f->m_array.ptr_of(c_empty_file);
+            default_file->reset();
+            return f;
+        }
+
+        void g_destruct_files(alloc_t* allocator, files_t*& files)
+        {
+            g_teardown_vpool(files->m_array);
+            g_teardown_vpool(files->m_nodes);
+            ntree32::teardown_tree(files->m_tree);
+            g_destruct(allocator, files);
+            files = nullptr;
+        }
+
+        void g_ensure_file_capacity(files_t* files, u32 index)
+        {
+            files->m_array.ensure_capacity(index);
+            files->m_nodes.ensure_capacity(index);
+        }
+
+        void g_get_stats(files_t const* files, paths_stats_t& stats)
+        {
+            stats.m_file_array.m_reserved  = files->m_array.m_arena.reserved_bytes();
+            stats.m_file_array.m_committed = files->m_array.m_arena.committed_bytes();
+            stats.m_file_nodes.m_reserved  = files->m_nodes.m_arena.reserved_bytes();
+            stats.m_file_nodes.m_committed = files->m_nodes.m_arena.committed_bytes();
 
-        // files_t* g_construct_files(alloc_t* allocator, u32 max_items)
-        // {
-        //     files_t* f = g_construct<files_t>(allocator);
-        //     f->m_count   = 1;
-        //     f->m_array.init(8192, max_items);
-        //     f->m_nodes.init(8192, max_items);
-        //     ntree32::setup_tree(f->m_tree, (ntree32::nnode_t*)f->m_nodes.ptr());
-        //     ntree32::node_t default_folder_node = f->m_tree.new_node();
-        //     ASSERT(default_folder_node == c_empty_folder);
-        //     file_t* default_file = f->m_array.ptr_of(c_empty_folder);
-        //     default_file->m_filename  = c_empty_string;
-        //     default_file->m_extension = c_empty_string;
-        //     return f;
-        // }
-
-        // void g_destruct_files(alloc_t* allocator, files_t*& files)
-        // {
-        //     files->m_array.exit();
-        //     files->m_nodes.exit();
-        //     ntree32::teardown_tree(files->m_tree);
-        //     g_destruct(allocator, files);
-        //     files = nullptr;
-        // }
-
-        // node_t     g_allocate_file(files_t* files, string_t filename, string_t extension)
-        // {
-        //     node_t    path_node = files->m_tree.new_node();
-        //     file_t*   file      = files->m_array.ptr_of(path_node);
-        //     file->m_filename    = filename;
-        //     file->m_extension   = extension;
-        //     files->m_count += 1;
-        //     return path_node;
-        // }
+            stats.m_file_count = files->m_count;
+            stats.m_wasted_bytes += sizeof(file_t) + sizeof(ntree32::nnode_t); // temp slot used by insert
+        }
 
     } // namespace npath
 } // namespace ncore
@@ -0,0 +1,530 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+#include "cbase/c_runes.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_device.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_glob.h"
+#include "cpath/private/c_folders.h"
+#include "cpath/private/c_lazy.h"
+#include "cpath/private/c_strings.h"
+#include "cpath/private/c_threads.h"
+#include "cpath/c_instrument.h"
+
+#include <string.h>
+
+namespace ncore
+{
+    namespace npath
+    {
+        // --------------------------------------------------------------------------------------------------------------
+        // Compiling
+        // --------------------------------------------------------------------------------------------------------------
+
+        static u8 s_kind_of(const char* text, u32 len)
+        {
+            if (len == 1 && text[0] == '*')
+                return nglob::KindAny;
+            for (u32 i = 0; i < len; ++i)
+            {
+                if (text[i] == '*' || text[i] == '?' || text[i] == '[')
+                    return nglob::KindWildcard;
+            }
+            return nglob::KindLiteral;
+        }
+
+        glob_t* g_compile_glob(alloc_t* allocator, paths_t* paths, crunes_t const& pattern)
+        {
+            const char* const str = pattern.m_ascii + pattern.m_str;
+            u32 const         len = pattern.m_end - pattern.m_str;
+            if (len >= glob_t::c_max_text)
+                return nullptr;
+
+            glob_t* glob      = g_construct<glob_t>(allocator);
+            glob->m_paths     = paths;
+            glob->m_num_parts = 0;
+            memcpy(glob->m_text, str, len);
+            glob->m_text[len] = 0;
+
+            // Split into components, empty ones ("//", a leading or trailing '/') are skipped
+            for (u32 start = 0; start < len;)
+            {
+                u32 end = start;
+                while (end < len && glob->m_text[end] != '/')
+                    end += 1;
+                if (end > start)
+                {
+                    bool const any_depth = (end - start) == 2 && glob->m_text[start] == '*' && glob->m_text[start + 1] == '*';
+                    if (any_depth && glob->m_num_parts > 0 && glob->m_parts[glob->m_num_parts - 1].m_kind == nglob::KindAnyDepth)
+                    {
+                        start = end + 1; // "**/**" is "**"
+                        continue;
+                    }
+                    if (glob->m_num_parts == glob_t::c_max_parts - 1) // keep room for the file component of a trailing "**"
+                    {
+                        g_destruct(allocator, glob);
+                        return nullptr;
+                    }
+
+                    globpart_t& part = glob->m_parts[glob->m_num_parts++];
+                    part.m_kind      = any_depth ? (u8)nglob::KindAnyDepth : s_kind_of(glob->m_text + start, end - start);
+                    part.m_ext_kind  = nglob::KindLiteral;
+                    part.m_has_ext   = 0;
+                    part.m_padding   = 0;
+                    part.m_name      = (u16)start;
+                    part.m_name_len  = (u16)(end - start);
+                    part.m_ext       = (u16)end;
+                    part.m_ext_len   = 0;
+                }
+                start = end + 1;
+            }
+
+            // "src/**" matches every file below "src"
+            if (glob->m_num_parts == 0 || glob->m_parts[glob->m_num_parts - 1].m_kind == nglob::KindAnyDepth)
+            {
+                globpart_t& part = glob->m_parts[glob->m_num_parts++];
+                part.m_kind      = nglob::KindAny;
+                part.m_ext_kind  = nglob::KindLiteral;
+                part.m_has_ext   = 0;
+                part.m_padding   = 0;
+                part.m_name      = 0;
+                part.m_name_len  = 0;
+                part.m_ext       = 0;
+                part.m_ext_len   = 0;
+                return glob;
+            }
+
+            // The file component, split at the first '.' like register_filename. A literal without a '.' is a file
+            // without an extension, a wildcard without a '.' is matched against the whole file name.
+            globpart_t& file = glob->m_parts[glob->m_num_parts - 1];
+            u32 dot = file.m_name;
+            while (dot < u32(file.m_name + file.m_name_len) && glob->m_text[dot] != '.')
+                dot += 1;
+            if (dot < u32(file.m_name + file.m_name_len))
+            {
+                file.m_has_ext  = 1;
+                file.m_ext      = (u16)dot;
+                file.m_ext_len  = (u16)(file.m_name + file.m_name_len - dot);
+                file.m_ext_kind = s_kind_of(glob->m_text + file.m_ext, file.m_ext_len);
+                file.m_name_len = (u16)(dot - file.m_name);
+                file.m_kind     = s_kind_of(glob->m_text + file.m_name, file.m_name_len);
+            }
+            else if (file.m_kind == nglob::KindLiteral)
+            {
+                file.m_has_ext = 1;
+            }
+            return glob;
+        }
+
+        void g_destruct_glob(alloc_t* allocator, glob_t*& glob)
+        {
+            if (glob == nullptr)
+                return;
+            g_destruct(allocator, glob);
+            glob = nullptr;
+        }
+
+        // --------------------------------------------------------------------------------------------------------------
+        // Matching
+        // --------------------------------------------------------------------------------------------------------------
+
+        // '*' any run of bytes, '?' one byte, '[abc]', '[a-z]', '[!a-z]' (or '[^a-z]') one byte of (not) the set
+        static bool s_match_class(const char*& p, const char* pend, u8 c)
+        {
+            p += 1; // '['
+            bool const negate = p < pend && (*p == '!' || *p == '^');
+            if (negate)
+                p += 1;
+            bool found = false;
+            bool first = true;
+            while (p < pend && (*p != ']' || first))
+            {
+                u8 lo = (u8)*p++;
+                u8 hi = lo;
+                if (p + 1 < pend && *p == '-' && p[1] != ']')
+                {
+                    hi = (u8)p[1];
+                    p += 2;
+                }
+                found = found || (c >= lo && c <= hi);
+                first = false;
+            }
+            if (p < pend)
+                p += 1; // ']'
+            return found != negate;
+        }
+
+        static bool s_match(const char* p, const char* pend, const char* s, const char* send)
+        {
+            const char* star_p = nullptr;
+            const char* star_s = nullptr;
+            while (s < send)
+            {
+                if (p < pend && *p == '*')
+                {
+                    star_p = ++p;
+                    star_s = s;
+                    continue;
+                }
+                if (p < pend)
+                {
+                    const char* next = p;
+                    bool        hit;
+                    if (*p == '?')
+                    {
+                        hit  = true;
+                        next = p + 1;
+                    }
+                    else if (*p == '[')
+                    {
+                        hit = s_match_class(next, pend, (u8)*s);
+                    }
+                    else
+                    {
+                        hit  = *p == *s;
+                        next = p + 1;
+                    }
+                    if (hit)
+                    {
+                        p = next;
+                        s += 1;
+                        continue;
+                    }
+                }
+                if (star_p == nullptr)
+                    return false;
+                p = star_p; // let the last '*' take one more byte
+                s = ++star_s;
+            }
+            while (p < pend && *p == '*')
+                p += 1;
+            return p == pend;
+        }
+
+        struct glob_count_t
+        {
+            u32 m_matches;
+            u8  m_padding[60];
+        };
+
+        struct glob_walk_t
+        {
+            glob_t const* m_glob;
+            paths_t*      m_paths;
+            device_t*     m_device;
+            glob_fn       m_fn;
+            void*         m_user;
+            workpool_t*   m_pool;    // nullptr when walking on the calling thread
+            glob_count_t* m_counts;  // per worker
+            u64           m_literal; // components that are KindLiteral
+            u64           m_depth;   // components that are KindAnyDepth
+            u32           m_last;    // the file component
+            string_t      m_names[glob_t::c_max_parts];
+            string_t      m_ext;
+        };
+
+        struct glob_item_t
+        {
+            u32 m_node;
+            u32 m_padding;
+            u64 m_states;
+        };
+
+        // An empty name or extension is either "" (register_filename) or c_empty_string (a default filepath_t)
+        static string_t s_find_literal(paths_t* paths, const char* text, u32 len)
+        {
+            string_t const str = paths->find_string(ascii::make_crunes(text, 0, len, len));
+            return (str == c_invalid_string && len == 0) ? c_empty_string : str;
+        }
+
+        static inline bool s_same_ext(glob_walk_t const* walk, string_t ext)
+        {
+            return ext == walk->m_ext || (ext == c_empty_string && walk->m_glob->m_parts[walk->m_last].m_ext_len == 0);
+        }
+
+        static inline bool s_match_string(glob_walk_t const* walk, u32 offset, u32 len, string_t str)
+        {
+            crunes_t view;
+            walk->m_paths->m_strings->view_string(str, view);
+            const char* const p = walk->m_glob->m_text + offset;
+            return s_match(p, p + len, view.m_ascii + view.m_str, view.m_ascii + view.m_end);
+        }
+
+        // Add the components that follow a "**", it matches zero folders as well
+        static inline u64 s_closure(glob_walk_t const* walk, u64 states)
+        {
+            for (u32 i = 0; i < walk->m_last; ++i)
+            {
+                if ((states & walk->m_depth) & ((u64)1 << i))
+                    states |= (u64)1 << (i + 1);
+            }
+            return states;
+        }
+
+        // The states after entering 'child' from a folder in 'states'
+        static u64 s_step(glob_walk_t const* walk, u64 states, folder_t const* child)
+        {
+            u64 next = 0;
+            for (u32 i = 0; i < walk->m_last; ++i)
+            {
+                if ((states & ((u64)1 << i)) == 0)
+                    continue;
+                globpart_t const& part = walk->m_glob->m_parts[i];
+                switch (part.m_kind)
+                {
+                    case nglob::KindAnyDepth: next |= (u64)1 << i; break;
+                    case nglob::KindAny: next |= (u64)1 << (i + 1); break;
+                    case nglob::KindLiteral:
+                        if (child->m_name == walk->m_names[i])
+                            next |= (u64)1 << (i + 1);
+                        break;
+                    default:
+                        if (s_match_string(walk, part.m_name, part.m_name_len, child->m_name))
+                            next |= (u64)1 << (i + 1);
+                        break;
+                }
+            }
+            return next;
+        }
+
+        static bool s_match_file(glob_walk_t const* walk, file_t const* f)
+        {
+            globpart_t const& part = walk->m_glob->m_parts[walk->m_last];
+            if (part.m_has_ext)
+            {
+                if (part.m_ext_kind == nglob::KindLiteral ? !s_same_ext(walk, f->m_extension) : !s_match_string(walk, part.m_ext, part.m_ext_len, f->m_extension))
+                    return false;
+                switch (part.m_kind)
+                {
+                    case nglob::KindAny: return true;
+                    case nglob::KindLiteral: return f->m_filename == walk->m_names[walk->m_last];
+                    default: return s_match_string(walk, part.m_name, part.m_name_len, f->m_filename);
+                }
+            }
+            if (part.m_kind == nglob::KindAny)
+                return true;
+
+            // A wildcard without a '.' sees the whole file name
+            crunes_t filename, extension;
+            walk->m_paths->m_strings->view_string(f->m_filename, filename);
+            walk->m_paths->m_strings->view_string(f->m_extension, extension);
+            u32 const name_len = filename.m_end - filename.m_str;
+            u32 const ext_len  = f->m_extension != c_empty_string ? extension.m_end - extension.m_str : 0;
+            char      name[512];
+            if (name_len + ext_len > sizeof(name))
+                return false;
+            memcpy(name, filename.m_ascii + filename.m_str, name_len);
+            memcpy(name + name_len, extension.m_ascii + extension.m_str, ext_len);
+            const char* const p = walk->m_glob->m_text + part.m_name;
+            return s_match(p, p + part.m_name_len, name, name + name_len + ext_len);
+        }
+
+        static const u32 c_scan_files = 16;
+
+        static void s_visit(glob_walk_t* walk, u32 worker, node_t node, u64 states);
+
+        static inline void s_descend(glob_walk_t* walk, u32 worker, node_t child, u64 states)
+        {
+            if (walk->m_pool != nullptr)
+            {
+                glob_item_t item = {child, 0, states};
+                g_push_work(walk->m_pool, worker, &item);
+            }
+            else
+            {
+                s_visit(walk, worker, child, states);
+            }
+        }
+
+        static void s_visit(glob_walk_t* walk, u32 worker, node_t node, u64 states)
+        {
+            paths_t* const  paths  = walk->m_paths;
+            folder_t const* folder = paths->m_folders->m_array.ptr_of(node);
+            if (paths->m_lazy != nullptr && (g_load_acquire(folder->m_flags) & (nfolder::FlagLazy | nfolder::FlagExpanded)) == nfolder::FlagLazy)
+                g_expand_folder(paths, node);
+
+            states = s_closure(walk, states);
+
+            u64 const file_state = (u64)1 << walk->m_last;
+            if (states & file_state)
+            {
+                globpart_t const& part  = walk->m_glob->m_parts[walk->m_last];
+                u32               count = 0;
+                if (walk->m_pool == nullptr && folder->m_num_files > c_scan_files && part.m_kind == nglob::KindLiteral && part.m_has_ext && part.m_ext_kind == nglob::KindLiteral)
+                {
+                    // find_file probes with a temp slot, so it is only used on the calling thread, a few files
+                    // are faster to scan (string_t compares) than to look up (string compares)
+                    ifile_t f = walk->m_device->find_file(node, walk->m_names[walk->m_last], walk->m_ext);
+                    if (f == c_invalid_file && part.m_ext_len == 0 && walk->m_ext != c_empty_string)
+                        f = walk->m_device->find_file(node, walk->m_names[walk->m_last], c_empty_string);
+                    if (f != c_invalid_file && (paths->m_files->m_array.ptr_of(f)->m_flags & nfile::FlagDeleted) == 0)
+                    {
+                        walk->m_fn(f, walk->m_user);
+                        count += 1;
+                    }
+                }
+                else
+                {
+                    for (ifile_t f = folder->m_file; f != c_invalid_file;)
+                    {
+                        file_t const* file = paths->m_files->m_array.ptr_of(f);
+                        if ((file->m_flags & nfile::FlagDeleted) == 0 && s_match_file(walk, file))
+                        {
+                            walk->m_fn(f, walk->m_user);
+                            count += 1;
+                        }
+                        f = file->m_sibling;
+                    }
+                }
+                walk->m_counts[worker].m_matches += count;
+            }
+
+            u64 const folder_states = states & ~file_state;
+            if (folder_states == 0)
+                return; // nothing below this folder can match
+
+            if ((folder_states & ~walk->m_literal) == 0)
+            {
+                // Only literal names are left, look the sub folders up instead of scanning them
+                node_t found[glob_t::c_max_parts];
+                u32    num_found = 0;
+                for (u32 i = 0; i < walk->m_last; ++i)
+                {
+                    if ((folder_states & ((u64)1 << i)) == 0)
+                        continue;
+                    node_t const child = walk->m_device->find_dir(node, walk->m_names[i]);
+                    if (child == c_invalid_node)
+                        continue;
+                    bool seen = false;
+                    for (u32 j = 0; j < num_found && !seen; ++j)
+                        seen = found[j] == child;
+                    if (seen)
+                        continue; // two components with the same name
+                    found[num_found++] = child;
+
+                    folder_t const* c = paths->m_folders->m_array.ptr_of(child);
+                    if ((c->m_flags & nfolder::FlagDeleted) == 0)
+                        s_descend(walk, worker, child, s_step(walk, folder_states, c));
+                }
+                return;
+            }
+
+            for (node_t child = folder->m_child; child != c_invalid_folder;)
+            {
+                folder_t const* c = paths->m_folders->m_array.ptr_of(child);
+                if ((c->m_flags & nfolder::FlagDeleted) == 0)
+                {
+                    u64 const next = s_step(walk, folder_states, c);
+                    if (next != 0)
+                        s_descend(walk, worker, child, next);
+                }
+                child = c->m_sibling;
+            }
+        }
+
+        static void s_glob_work(workpool_t*, u32 worker, void* item, void* user)
+        {
+            glob_item_t const* const task = (glob_item_t const*)item;
+            s_visit((glob_walk_t*)user, worker, task->m_node, task->m_states);
+        }
+
+        u32 glob_t::match(dirpath_t const& root, glob_fn fn, void* user, u32 num_threads) const
+        {
+            CPATH_SCOPE("glob_t::match");
+            if (m_num_parts == 0 || root.m_device == nullptr)
+                return 0;
+
+            glob_walk_t walk;
+            walk.m_glob    = this;
+            walk.m_paths   = m_paths;
+            walk.m_device  = root.m_device;
+            walk.m_fn      = fn;
+            walk.m_user    = user;
+            walk.m_pool    = nullptr;
+            walk.m_literal = 0;
+            walk.m_depth   = 0;
+            walk.m_last    = m_num_parts - 1;
+            walk.m_ext     = c_empty_string;
+
+            // Every component has to match, a literal that was never registered matches nothing
+            for (u32 i = 0; i < m_num_parts; ++i)
+            {
+                globpart_t const& part = m_parts[i];
+                walk.m_names[i]        = c_invalid_string;
+                if (part.m_kind == nglob::KindLiteral)
+                {
+                    walk.m_names[i] = s_find_literal(m_paths, m_text + part.m_name, part.m_name_len);
+                    if (walk.m_names[i] == c_invalid_string)
+                        return 0;
+                    if (i != walk.m_last)
+                        walk.m_literal |= (u64)1 << i;
+                }
+                else if (part.m_kind == nglob::KindAnyDepth)
+                {
+                    walk.m_depth |= (u64)1 << i;
+                }
+            }
+            globpart_t const& file = m_parts[walk.m_last];
+            if (file.m_has_ext && file.m_ext_kind == nglob::KindLiteral)
+            {
+                walk.m_ext = s_find_literal(m_paths, m_text + file.m_ext, file.m_ext_len);
+                if (walk.m_ext == c_invalid_string)
+                    return 0;
+            }
+
+            node_t const start = (root.m_path == c_empty_node || root.m_path == c_invalid_node) ? root.m_device->m_path : root.m_path;
+
+            u32 matches = 0;
+            if (num_threads == 1)
+            {
+                glob_count_t count;
+                count.m_matches = 0;
+                walk.m_counts   = &count;
+                s_visit(&walk, 0, start, 1);
+                matches = count.m_matches;
+            }
+            else
+            {
+                alloc_t* const alloc = m_paths->m_allocator;
+                u32 const      workers = num_threads != 0 ? num_threads : g_hardware_threads();
+                walk.m_pool            = g_construct_workpool(alloc, workers, sizeof(glob_item_t), m_paths->m_max_items, s_glob_work, &walk);
+                walk.m_counts          = g_allocate_array<glob_count_t>(alloc, g_num_workers(walk.m_pool));
+                memset(walk.m_counts, 0, g_num_workers(walk.m_pool) * sizeof(glob_count_t));
+
+                glob_item_t item = {start, 0, 1};
+                g_push_work(walk.m_pool, 0, &item);
+                g_run_workpool(walk.m_pool);
+
+                for (u32 i = 0; i < g_num_workers(walk.m_pool); ++i)
+                    matches += walk.m_counts[i].m_matches;
+                g_deallocate_array(alloc, walk.m_counts);
+                g_destruct_workpool(alloc, walk.m_pool);
+            }
+            return matches;
+        }
+
+        struct glob_collect_t
+        {
+            ifile_t* m_files;
+            u32      m_count;
+            u32      m_max;
+        };
+
+        static void s_collect(ifile_t file, void* user)
+        {
+            glob_collect_t* c = (glob_collect_t*)user;
+            if (c->m_count < c->m_max)
+                c->m_files[c->m_count++] = file;
+        }
+
+        u32 glob_t::collect(dirpath_t const& root, ifile_t* out_files, u32 max_files) const
+        {
+            glob_collect_t c = {out_files, 0, max_files};
+            match(root, s_collect, &c, 1);
+            return c.m_count;
+        }
+
+    } // namespace npath
+} // namespace ncore
@@ -0,0 +1,196 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+
+#include "cpath/c_path.h"
+#include "cpath/private/c_hashes.h"
+
+#include <string.h>
+
+// The MurmurHash tail falls through its cases on purpose
+#if defined(__clang__)
+#    define CPATH_FALLTHROUGH [[clang::fallthrough]]
+#elif defined(__GNUC__) && __GNUC__ >= 7
+#    define CPATH_FALLTHROUGH __attribute__((fallthrough))
+#else
+#    define CPATH_FALLTHROUGH
+#endif
+
+namespace ncore
+{
+    namespace npath
+    {
+        hashes_t* g_construct_hashes(alloc_t* allocator, u32 max_items, varena_config_t const& config)
+        {
+            hashes_t* h = g_construct<hashes_t>(allocator);
+            g_setup_vpool(h->m_lo, 0, max_items, config);
+            g_setup_vpool(h->m_hi, 0, max_items, config);
+            g_setup_vpool(h->m_size, 0, max_items, config);
+            g_setup_vpool(h->m_mtime, 0, max_items, config);
+            g_setup_vpool(h->m_flags, 0, max_items, config);
+            h->m_capacity = 0;
+            return h;
+        }
+
+        void g_destruct_hashes(alloc_t* allocator, hashes_t*& hashes)
+        {
+            g_teardown_vpool(hashes->m_lo);
+            g_teardown_vpool(hashes->m_hi);
+            g_teardown_vpool(hashes->m_size);
+            g_teardown_vpool(hashes->m_mtime);
+            g_teardown_vpool(hashes->m_flags);
+            g_destruct(allocator, hashes);
+            hashes = nullptr;
+        }
+
+        void g_ensure_hashes_capacity(hashes_t* h, u32 count)
+        {
+            if (count <= h->m_capacity)
+                return;
+            h->m_lo.ensure_capacity(count);
+            h->m_hi.ensure_capacity(count);
+            h->m_size.ensure_capacity(count);
+            h->m_mtime.ensure_capacity(count);
+            h->m_flags.ensure_capacity(count);
+            memset(h->m_flags.ptr_of(h->m_capacity), 0, count - h->m_capacity);
+            h->m_capacity = count;
+        }
+
+        void g_set_hash(hashes_t* h, ifile_t file, u64 size, s64 mtime_ns, contenthash_t const& hash)
+        {
+            u8* const  flags   = h->m_flags.ptr_of(file);
+            bool const changed = (*flags & nmeta::FlagValid) == 0 || *h->m_lo.ptr_of(file) != hash.m_lo || *h->m_hi.ptr_of(file) != hash.m_hi;
+            *h->m_lo.ptr_of(file)    = hash.m_lo;
+            *h->m_hi.ptr_of(file)    = hash.m_hi;
+            *h->m_size.ptr_of(file)  = size;
+            *h->m_mtime.ptr_of(file) = mtime_ns;
+            *flags                   = (u8)(nmeta::FlagValid | (changed ? nmeta::FlagChanged : 0));
+        }
+
+        // --------------------------------------------------------------------------------------------------------------
+        // MurmurHash3 x64 128-bit (public domain, Austin Appleby)
+
+        static inline u64 s_rotl(u64 x, s8 r) { return (x << r) | (x >> (64 - r)); }
+
+        static inline u64 s_fmix(u64 k)
+        {
+            k ^= k >> 33;
+            k *= 0xff51afd7ed558ccdULL;
+            k ^= k >> 33;
+            k *= 0xc4ceb9fe1a85ec53ULL;
+            k ^= k >> 33;
+            return k;
+        }
+
+        static inline u64 s_load64(u8 const* p)
+        {
+            u64 v;
+            memcpy(&v, p, sizeof(v)); // little-endian targets only
+            return v;
+        }
+
+        void g_hash128(void const* data, u64 size, contenthash_t& out_hash)
+        {
+            u8 const* const bytes   = (u8 const*)data;
+            u64 const       nblocks = size / 16;
+            u64 const       c1      = 0x87c37b91114253d5ULL;
+            u64 const       c2      = 0x4cf5ad432745937fULL;
+
+            u64 h1 = 0;
+            u64 h2 = 0;
+            for (u64 i = 0; i < nblocks; ++i)
+            {
+                u64 k1 = s_load64(bytes + i * 16);
+                u64 k2 = s_load64(bytes + i * 16 + 8);
+
+                k1 *= c1;
+                k1 = s_rotl(k1, 31);
+                k1 *= c2;
+                h1 ^= k1;
+                h1 = s_rotl(h1, 27);
+                h1 += h2;
+                h1 = h1 * 5 + 0x52dce729;
+
+                k2 *= c2;
+                k2 = s_rotl(k2, 33);
+                k2 *= c1;
+                h2 ^= k2;
+                h2 = s_rotl(h2, 31);
+                h2 += h1;
+                h2 = h2 * 5 + 0x38495ab5;
+            }
+
+            u8 const* tail = bytes + nblocks * 16;
+            u64       k1   = 0;
+            u64       k2   = 0;
+            switch (size & 15)
+            {
+                case 15:
+                    k2 ^= (u64)tail[14] << 48;
+                    CPATH_FALLTHROUGH;
+                case 14:
+                    k2 ^= (u64)tail[13] << 40;
+                    CPATH_FALLTHROUGH;
+                case 13:
+                    k2 ^= (u64)tail[12] << 32;
+                    CPATH_FALLTHROUGH;
+                case 12:
+                    k2 ^= (u64)tail[11] << 24;
+                    CPATH_FALLTHROUGH;
+                case 11:
+                    k2 ^= (u64)tail[10] << 16;
+                    CPATH_FALLTHROUGH;
+                case 10:
+                    k2 ^= (u64)tail[9] << 8;
+                    CPATH_FALLTHROUGH;
+                case 9:
+                    k2 ^= (u64)tail[8];
+                    k2 *= c2;
+                    k2 = s_rotl(k2, 33);
+                    k2 *= c1;
+                    h2 ^= k2;
+                    CPATH_FALLTHROUGH;
+                case 8:
+                    k1 ^= (u64)tail[7] << 56;
+                    CPATH_FALLTHROUGH;
+                case 7:
+                    k1 ^= (u64)tail[6] << 48;
+                    CPATH_FALLTHROUGH;
+                case 6:
+                    k1 ^= (u64)tail[5] << 40;
+                    CPATH_FALLTHROUGH;
+                case 5:
+                    k1 ^= (u64)tail[4] << 32;
+                    CPATH_FALLTHROUGH;
+                case 4:
+                    k1 ^= (u64)tail[3] << 24;
+                    CPATH_FALLTHROUGH;
+                case 3:
+                    k1 ^= (u64)tail[2] << 16;
+                    CPATH_FALLTHROUGH;
+                case 2:
+                    k1 ^= (u64)tail[1] << 8;
+                    CPATH_FALLTHROUGH;
+                case 1:
+                    k1 ^= (u64)tail[0];
+                    k1 *= c1;
+                    k1 = s_rotl(k1, 31);
+                    k1 *= c2;
+                    h1 ^= k1;
+            }
+
+            h1 ^= size;
+            h2 ^= size;
+            h1 += h2;
+            h2 += h1;
+            h1 = s_fmix(h1);
+            h2 = s_fmix(h2);
+            h1 += h2;
+            h2 += h1;
+
+            out_hash.m_lo = h1;
+            out_hash.m_hi = h2;
+        }
+
+    } // namespace npath
+} // namespace ncore
@@ -0,0 +1,244 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+
+#include "cpath/c_instrument.h"
+
+#ifdef CPATH_INSTRUMENT
+
+#    include <stdio.h>
+#    if defined(TARGET_PC)
+#        include <windows.h>
+#    else
+#        include <time.h>
+#    endif
+
+namespace ncore
+{
+    namespace npath
+    {
+        namespace ninstrument
+        {
+            const s32 c_max_threads = 64;
+            const u32 c_max_events  = 16 * 1024; // per thread, oldest events are overwritten
+
+            struct event_t
+            {
+                const char* m_name;
+                u64         m_start_ns;
+                u64         m_end_ns;
+            };
+
+            // Every thread gets its own block, counters are written without any synchronization.
+            // Reading another thread's counters (snapshot_all) is racy but good enough for diagnostics.
+            // A thread hands its block back when it exits, the next thread continues counting in it.
+            struct thread_block_t
+            {
+                u64     m_counters[CounterCount];
+                u32     m_num_events; // total recorded, index = m_num_events % c_max_events
+                event_t m_events[c_max_events];
+            };
+
+            // Threads that find every block taken share the last one, which is only written with atomics
+            static thread_block_t        s_blocks[c_max_threads];
+            static thread_block_t* const s_shared      = &s_blocks[c_max_threads - 1];
+            static s32                   s_num_blocks  = 0; // blocks handed out at least once, excluding the shared one
+            static bool                  s_shared_used = false;
+            static s32                   s_free[c_max_threads]; // blocks released by threads that have exited
+            static s32                   s_num_free = 0;
+            static s32                   s_lock     = 0;
+
+            static inline void s_acquire(s32* lock)
+            {
+#    if defined(_MSC_VER)
+                while (_InterlockedExchange((long volatile*)lock, 1) != 0) {}
+#    else
+                while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE) != 0) {}
+#    endif
+            }
+
+            static inline void s_release(s32* lock)
+            {
+#    if defined(_MSC_VER)
+                _InterlockedExchange((long volatile*)lock, 0);
+#    else
+                __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+#    endif
+            }
+
+            static inline u64 s_atomic_add(u64* value, u64 n)
+            {
+#    if defined(_MSC_VER)
+                return (u64)_InterlockedExchangeAdd64((__int64 volatile*)value, (__int64)n);
+#    else
+                return __atomic_fetch_add(value, n, __ATOMIC_RELAXED);
+#    endif
+            }
+
+            static inline u32 s_atomic_inc(u32* value)
+            {
+#    if defined(_MSC_VER)
+                return (u32)_InterlockedIncrement((long volatile*)value) - 1;
+#    else
+                return __atomic_fetch_add(value, 1, __ATOMIC_RELAXED);
+#    endif
+            }
+
+            static thread_block_t* s_claim()
+            {
+                thread_block_t* block = s_shared;
+                s_acquire(&s_lock);
+                if (s_num_free > 0)
+                    block = &s_blocks[s_free[--s_num_free]];
+                else if (s_num_blocks < (c_max_threads - 1))
+                    block = &s_blocks[s_num_blocks++];
+                else
+                    s_shared_used = true;
+                s_release(&s_lock);
+                return block;
+            }
+
+            static void s_return(thread_block_t* block)
+            {
+                if (block == s_shared)
+                    return;
+                s_acquire(&s_lock);
+                s_free[s_num_free++] = (s32)(block - s_blocks);
+                s_release(&s_lock);
+            }
+
+            // Only touched when a thread claims its block, the destructor hands it back on thread exit
+            struct thread_slot_t
+            {
+                thread_block_t* m_block;
+                ~thread_slot_t()
+                {
+                    if (m_block != nullptr)
+                        s_return(m_block);
+                }
+            };
+
+            static thread_local thread_block_t* t_block = nullptr;
+            static thread_local thread_slot_t   t_slot  = {nullptr};
+
+            static inline thread_block_t* s_block()
+            {
+                if (t_block == nullptr)
+                {
+                    t_block        = s_claim();
+                    t_slot.m_block = t_block;
+                }
+                return t_block;
+            }
+
+            // The shared block is the last one, it is only in use once all the others have been handed out
+            static inline s32 s_block_count()
+            {
+                s_acquire(&s_lock);
+                s32 const count = s_shared_used ? c_max_threads : s_num_blocks;
+                s_release(&s_lock);
+                return count;
+            }
+
+            void count(ecounter counter, u64 n)
+            {
+                thread_block_t* block = s_block();
+                if (block != s_shared)
+                    block->m_counters[counter] += n;
+                else
+                    s_atomic_add(&block->m_counters[counter], n);
+            }
+
+            void snapshot_thread(snapshot_t& out)
+            {
+                thread_block_t const* block = s_block();
+                for (s32 i = 0; i < CounterCount; ++i)
+                    out.m_counters[i] = block->m_counters[i];
+                out.m_threads = 1;
+            }
+
+            void snapshot_all(snapshot_t& out)
+            {
+                for (s32 i = 0; i < CounterCount; ++i)
+                    out.m_counters[i] = 0;
+                s32 const num_blocks = s_block_count();
+                for (s32 b = 0; b < num_blocks; ++b)
+                {
+                    for (s32 i = 0; i < CounterCount; ++i)
+                        out.m_counters[i] += s_blocks[b].m_counters[i];
+                }
+                out.m_threads = (u32)num_blocks;
+            }
+
+            void reset_all()
+            {
+                s32 const num_blocks = s_block_count();
+                for (s32 b = 0; b < num_blocks; ++b)
+                {
+                    for (s32 i = 0; i < CounterCount; ++i)
+                        s_blocks[b].m_counters[i] = 0;
+                    s_blocks[b].m_num_events = 0;
+                }
+            }
+
+            bool g_trace_enabled = false;
+
+            void enable_trace(bool enable) { g_trace_enabled = enable; }
+
+            void trace_event(const char* name, u64 start_ns, u64 end_ns)
+            {
+                if (!g_trace_enabled)
+                    return;
+                thread_block_t* block = s_block();
+                u32 const       index = block != s_shared ? block->m_num_events++ : s_atomic_inc(&block->m_num_events);
+                event_t&        event = block->m_events[index % c_max_events];
+                event.m_name          = name;
+                event.m_start_ns      = start_ns;
+                event.m_end_ns        = end_ns;
+            }
+
+            void write_chrome_trace(write_fn writer, void* user)
+            {
+                char      line[256];
+                s32       len   = snprintf(line, sizeof(line), "{\"traceEvents\":[");
+                bool      first = true;
+                s32 const num_blocks = s_block_count();
+                writer(line, (u32)len, user);
+                for (s32 b = 0; b < num_blocks; ++b)
+                {
+                    thread_block_t const* block  = &s_blocks[b];
+                    u32 const             count  = block->m_num_events < c_max_events ? block->m_num_events : c_max_events;
+                    u32 const             oldest = block->m_num_events - count;
+                    for (u32 i = 0; i < count; ++i)
+                    {
+                        event_t const& e = block->m_events[(oldest + i) % c_max_events];
+                        len = snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", first ? "" : ",", e.m_name, b, (double)e.m_start_ns / 1000.0, (double)(e.m_end_ns - e.m_start_ns) / 1000.0);
+                        writer(line, (u32)len, user);
+                        first = false;
+                    }
+                }
+                len = snprintf(line, sizeof(line), "],\"displayTimeUnit\":\"ns\"}");
+                writer(line, (u32)len, user);
+            }
+
+#    if defined(TARGET_PC)
+            u64 now_ns()
+            {
+                LARGE_INTEGER freq, counter;
+                QueryPerformanceFrequency(&freq);
+                QueryPerformanceCounter(&counter);
+                return (u64)((counter.QuadPart * 1000000000.0) / (double)freq.QuadPart);
+            }
+#    else
+            u64 now_ns()
+            {
+                struct timespec ts;
+                clock_gettime(CLOCK_MONOTONIC, &ts);
+                return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+            }
+#    endif
+
+        } // namespace ninstrument
+    } // namespace npath
+} // namespace ncore
+
+#endif
@@ -0,0 +1,125 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+#include "cbase/c_runes.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_device.h"
+#include "cpath/c_instrument.h"
+#include "cpath/private/c_extindex.h"
+#include "cpath/private/c_folders.h"
+#include "cpath/private/c_lazy.h"
+#include "cpath/private/c_strings.h"
+
+#include <string.h>
+
+#if defined(TARGET_LINUX) || defined(TARGET_MAC)
+#    define CPATH_LAZY_POSIX
+#    include <dirent.h>
+#    include <fcntl.h>
+#    include <sys/stat.h>
+#endif
+
+namespace ncore
+{
+    namespace npath
+    {
+        static const s32 c_max_ospath = 4096;
+
+        lazy_t* g_construct_lazy(alloc_t* allocator)
+        {
+            lazy_t* lazy     = g_construct<lazy_t>(allocator);
+            lazy->m_expanded = 0;
+            lazy->m_lock.init();
+            return lazy;
+        }
+
+        void g_destruct_lazy(alloc_t* allocator, lazy_t*& lazy)
+        {
+            lazy->m_lock.exit();
+            g_destruct(allocator, lazy);
+            lazy = nullptr;
+        }
+
+        void g_mark_lazy(paths_t* paths, node_t node)
+        {
+            lock_t    lock(paths->m_lazy->m_lock);
+            folder_t* folder = paths->m_folders->m_array.ptr_of(node);
+            g_store_release(folder->m_flags, (folder->m_flags | nfolder::FlagLazy) & ~nfolder::FlagExpanded);
+        }
+
+#if defined(CPATH_LAZY_POSIX)
+        static bool s_read_folder(paths_t* paths, device_t* device, node_t node, const char* ospath)
+        {
+            DIR* dir = ::opendir(ospath);
+            if (dir == nullptr)
+                return false;
+
+            while (struct dirent* entry = ::readdir(dir))
+            {
+                const char* name = entry->d_name;
+                if (name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0)))
+                    continue;
+
+                u8 type = entry->d_type;
+                if (type == DT_UNKNOWN)
+                {
+                    struct stat st;
+                    if (::fstatat(::dirfd(dir), name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+                        continue;
+                    type = S_ISDIR(st.st_mode) ? DT_DIR : (S_ISREG(st.st_mode) ? DT_REG : (S_ISLNK(st.st_mode) ? DT_LNK : DT_FIFO));
+                }
+
+                u32 const      len = (u32)strlen(name);
+                crunes_t const str = utf8::make_crunes((utf8::pcrune)name, 0, len, len);
+                if (type == DT_DIR)
+                {
+                    // add_dir passes FlagLazy on to the new folder, it will be read on its own first enumeration
+                    node_t const child = device->add_dir(node, paths->find_or_insert_string(str));
+                    paths->m_folders->m_array.ptr_of(child)->m_flags &= ~nfolder::FlagDeleted;
+                }
+                else
+                {
+                    string_t filename, extension;
+                    paths->register_filename(str, filename, extension);
+                    ifile_t const file = device->add_file(node, filename, extension, type == DT_REG ? nfile::TypeRegular : (type == DT_LNK ? nfile::TypeSymlink : nfile::TypeOther));
+                    g_set_file_deleted(paths, file, false);
+                }
+            }
+            ::closedir(dir);
+            return true;
+        }
+#else
+        static bool s_read_folder(paths_t* paths, device_t* device, node_t node, const char* ospath) { return false; }
+#endif
+
+        bool g_expand_folder(paths_t* paths, node_t node)
+        {
+            lazy_t* const lazy   = paths->m_lazy;
+            folder_t*     folder = paths->m_folders->m_array.ptr_of(node);
+            u32 const     flags  = g_load_acquire(folder->m_flags);
+            if (lazy == nullptr || (flags & nfolder::FlagLazy) == 0)
+                return false;
+            if ((flags & nfolder::FlagExpanded) != 0)
+                return true;
+
+            CPATH_SCOPE("paths_t::expand");
+            lock_t lock(lazy->m_lock);
+            if ((folder->m_flags & nfolder::FlagExpanded) != 0)
+                return true; // another reader expanded it while we were waiting
+
+            // A folder that can't be read is not retried, it is expanded as an empty folder
+            bool      read = false;
+            char      ospath[c_max_ospath];
+            device_t* device = paths->device_of(node);
+            if (device != nullptr && paths->folder_to_ospath(node, ospath, c_max_ospath) >= 0)
+                read = s_read_folder(paths, device, node, ospath);
+            lazy->m_expanded += 1;
+
+            // Publish the children, readers that see FlagExpanded see the complete child tree
+            g_store_release(folder->m_flags, folder->m_flags | nfolder::FlagExpanded);
+            return read;
+        }
+
+    } // namespace npath
+} // namespace ncore
@@ -0,0 +1,205 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_device.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_listing.h"
+#include "cpath/private/c_folders.h"
+#include "cpath/private/c_nameindex.h"
+
+#include <string.h>
+
+namespace ncore
+{
+    namespace npath
+    {
+        static const u32 c_stale = 0xFFFFFFFF; // level_t::m_version, the position still has to be computed
+
+        lister_t* g_construct_lister(alloc_t* allocator, dirpath_t const& dir, const char* prefix, u32 flags)
+        {
+            lister_t* lister              = g_construct<lister_t>(allocator);
+            lister->m_paths               = nullptr;
+            lister->m_flags               = flags;
+            lister->m_top                 = 0;
+            lister->m_prefix_len          = 0;
+            lister->m_stack.m_arena.m_ptr = nullptr;
+            lister->seek(dir, prefix, flags);
+            return lister;
+        }
+
+        void g_destruct_lister(alloc_t* allocator, lister_t*& lister)
+        {
+            if (lister->m_stack.m_arena.m_ptr != nullptr)
+                g_teardown_vpool(lister->m_stack);
+            g_destruct(allocator, lister);
+            lister = nullptr;
+        }
+
+        static void s_push(lister_t* lister, node_t folder, u32 last)
+        {
+            lister->m_stack.ensure_capacity(lister->m_top + 1);
+            lister_t::level_t* level = lister->m_stack.ptr_of(lister->m_top++);
+            level->m_folder          = folder;
+            level->m_pos             = 0;
+            level->m_end             = 0;
+            level->m_side_pos        = 0;
+            level->m_side_end        = 0;
+            level->m_version         = c_stale;
+            level->m_last            = last;
+        }
+
+        static void s_reset(lister_t* lister, paths_t* paths, const char* prefix, u32 flags)
+        {
+            if (lister->m_stack.m_arena.m_ptr == nullptr)
+            {
+                // a level per folder on the path down, never more than there are folders
+                lister->m_paths = paths;
+                g_setup_vpool(lister->m_stack, 0, paths->m_max_items, paths->m_config);
+            }
+            ASSERT(lister->m_paths == paths);
+            paths->enable_nameindex();
+
+            lister->m_flags      = flags;
+            lister->m_top        = 0;
+            lister->m_prefix_len = 0;
+            if (prefix != nullptr)
+            {
+                u32 len = (u32)strlen(prefix);
+                ASSERT(len <= lister_t::c_max_prefix);
+                len = len < lister_t::c_max_prefix ? len : lister_t::c_max_prefix;
+                memcpy(lister->m_prefix, prefix, len);
+                lister->m_prefix_len = len;
+            }
+        }
+
+        void lister_t::seek(dirpath_t const& dir, const char* prefix, u32 flags)
+        {
+            m_top = 0;
+            if (dir.m_device == nullptr)
+                return;
+            s_reset(this, dir.m_device->m_owner, prefix, flags);
+            s_push(this, (dir.m_path == c_empty_node || dir.m_path == c_invalid_node) ? dir.m_device->m_path : dir.m_path, c_invalid_node);
+        }
+
+        void lister_t::resume(dirpath_t const& dir, const char* prefix, u32 flags, walknode_t const& last)
+        {
+            m_top = 0;
+            if (dir.m_device == nullptr)
+                return;
+            s_reset(this, dir.m_device->m_owner, prefix, flags);
+
+            // The folders from the one of 'last' up to the dirpath, each level continues after the one below it
+            node_t const     root    = (dir.m_path == c_empty_node || dir.m_path == c_invalid_node) ? dir.m_device->m_path : dir.m_path;
+            folders_t const* folders = m_paths->m_folders;
+            u32 const        entry   = last.m_type == nwalk::TypeFile ? (last.m_node | c_nameentry_file) : last.m_node;
+            node_t const     folder  = last.m_type == nwalk::TypeFile ? m_paths->m_files->m_array.ptr_of(last.m_node)->m_folder : folders->m_array.ptr_of(last.m_node)->m_parent;
+            u32              depth   = 1;
+            for (node_t f = folder; f != root; f = folders->m_array.ptr_of(f)->m_parent)
+            {
+                if (f == c_invalid_folder || (m_flags & nlist::Recursive) == 0)
+                {
+                    s_push(this, root, c_invalid_node); // not below the dirpath, from the start
+                    return;
+                }
+                depth += 1;
+            }
+
+            m_stack.ensure_capacity(depth + 1);
+            m_top = depth;
+            u32 child = entry;
+            for (node_t f = folder; depth > 0; f = folders->m_array.ptr_of(f)->m_parent)
+            {
+                level_t* level   = m_stack.ptr_of(--depth);
+                level->m_folder  = f;
+                level->m_pos      = 0;
+                level->m_end      = 0;
+                level->m_side_pos = 0;
+                level->m_side_end = 0;
+                level->m_version  = c_stale;
+                level->m_last    = child;
+                child            = f;
+            }
+            if (last.m_type == nwalk::TypeFolder && (m_flags & nlist::Recursive) != 0 && (folders->m_array.ptr_of(last.m_node)->m_flags & nfolder::FlagDeleted) == 0)
+                s_push(this, last.m_node, c_invalid_node);
+        }
+
+        // The range [pos, end) of one sorted run [begin, end) that follows the entry that was listed last
+        static void s_range(lister_t* lister, lister_t::level_t const* level, nameblock_t const* block, bool first, u32 begin, u32 end, u32& out_pos, u32& out_end)
+        {
+            bool const prefix = first && lister->m_prefix_len > 0;
+            if (level->m_last != c_invalid_node)
+                out_pos = g_nameindex_after(lister->m_paths, block, begin, end, level->m_last);
+            else if (prefix)
+                out_pos = g_nameindex_seek(lister->m_paths, block, begin, end, lister->m_prefix, lister->m_prefix_len, false);
+            else
+                out_pos = begin;
+            out_end = prefix ? g_nameindex_seek(lister->m_paths, block, out_pos, end, lister->m_prefix, lister->m_prefix_len, true) : end;
+        }
+
+        // The block was (re)sorted, the positions in both runs are computed again
+        static void s_position(lister_t* lister, lister_t::level_t* level, nameblock_t const* block, bool first)
+        {
+            s_range(lister, level, block, first, 0, block->m_sorted, level->m_pos, level->m_end);
+            s_range(lister, level, block, first, block->m_sorted, block->m_sorted + block->m_side, level->m_side_pos, level->m_side_end);
+            level->m_version = block->m_version;
+        }
+
+        u32 lister_t::next(walknode_t* out_nodes, u32 max_nodes)
+        {
+            u32 n = 0;
+            while (n < max_nodes && m_top > 0)
+            {
+                level_t*           level = m_stack.ptr_of(m_top - 1);
+                nameblock_t const* block = g_nameindex_block(m_paths, level->m_folder);
+                bool const         first = m_top == 1;
+                if (level->m_version != block->m_version)
+                    s_position(this, level, block, first);
+
+                // The lower of the heads of the two runs
+                u32 const* const entries = m_paths->m_nameindex->m_entries.ptr_of(block->m_offset);
+                bool const       run     = level->m_pos < level->m_end;
+                bool const       side    = level->m_side_pos < level->m_side_end;
+                if (!run && !side)
+                {
+                    m_top -= 1;
+                    continue;
+                }
+                u32 entry;
+                if (run && (!side || g_nameindex_compare(m_paths, entries[level->m_pos], entries[level->m_side_pos]) < 0))
+                    entry = entries[level->m_pos++];
+                else
+                    entry = entries[level->m_side_pos++];
+                level->m_last = entry;
+
+                u16 const depth = (u16)m_top;
+                if (entry & c_nameentry_file)
+                {
+                    ifile_t const file = entry & ~c_nameentry_file;
+                    if (m_paths->m_files->m_array.ptr_of(file)->m_flags & nfile::FlagDeleted)
+                        continue;
+                    walknode_t& out = out_nodes[n++];
+                    out.m_node      = file;
+                    out.m_depth     = depth;
+                    out.m_type      = nwalk::TypeFile;
+                    out.m_padding   = 0;
+                }
+                else
+                {
+                    if (m_paths->m_folders->m_array.ptr_of(entry)->m_flags & nfolder::FlagDeleted)
+                        continue;
+                    walknode_t& out = out_nodes[n++];
+                    out.m_node      = entry;
+                    out.m_depth     = depth;
+                    out.m_type      = nwalk::TypeFolder;
+                    out.m_padding   = 0;
+                    if (m_flags & nlist::Recursive)
+                        s_push(this, entry, c_invalid_node);
+                }
+            }
+            return n;
+        }
+
+    } // namespace npath
+} // namespace ncore
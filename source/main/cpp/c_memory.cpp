@@ -1,80 +1,257 @@
+#include "ccore/c_debug.h"
 #include "cpath/private/c_memory.h"
+#include "cpath/c_instrument.h"
 #include "cvmem/c_virtual_memory.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(TARGET_LINUX)
+#    include <sys/mman.h>
+#    ifndef MAP_HUGETLB
+#        define MAP_HUGETLB 0x40000
+#    endif
+#    ifndef MADV_HUGEPAGE
+#        define MADV_HUGEPAGE 14
+#    endif
+#    ifndef MADV_POPULATE_WRITE
+#        define MADV_POPULATE_WRITE 23
+#    endif
+#endif
+
 namespace ncore
 {
     namespace npath
     {
         const u32 c_capacity_bias = 4;
 
-        void g_init_arena(varena_t& m)
+        const varena_config_t g_default_arena_config = {narena::PagesDefault, narena::GrowMinimal, 0, 0, 0};
+
+        static inline u64 s_align_up(u64 size, u64 alignment) { return ((size + alignment - 1) / alignment) * alignment; }
+
+        // An arena that cannot hand out the memory it was asked for would have its users write past the
+        // committed range into whatever is mapped behind it, so stop right here instead.
+        static void s_fatal(const char* reason)
         {
-            m.m_ptr = nullptr;
-            m.m_reserved = 0;
-            m.m_committed = 0;
+            ASSERTS(false, reason);
+            ::fputs(reason, stderr); // also when asserts are compiled out
+            ::fputc('\n', stderr);
+            ::abort();
+        }
+
+        // --------------------------------------------------------------------------------------------------------------
+        // Platform layer, on Linux we talk to mmap/madvise directly since huge pages need an aligned
+        // reservation and hugetlb pages need their own mapping flags. Everywhere else we go through nvmem.
+        // --------------------------------------------------------------------------------------------------------------
+
+#if defined(TARGET_LINUX)
+        // 'hugetlb' is the number of bytes at the start of the range that should be on hugetlb pages
+        static u8* s_vm_reserve(u64 size, u64& hugetlb, u8& pages)
+        {
+            if (pages == narena::PagesHugeTLB && hugetlb == 0)
+                pages = narena::PagesTransparentHuge; // nothing is expected to be committed
+
+            if (pages != narena::PagesDefault)
+            {
+                // Huge pages are only used for 2 MB aligned ranges, so over-reserve and trim
+                u64 const slop = narena::c_huge_page_size;
+                void*     ptr  = ::mmap(nullptr, size + slop, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+                if (ptr == MAP_FAILED)
+                    return nullptr;
+                u8* const base    = (u8*)ptr;
+                u8* const aligned = (u8*)s_align_up((u64)base, slop);
+                if (aligned > base)
+                    ::munmap(base, aligned - base);
+                if ((base + size + slop) > (aligned + size))
+                    ::munmap(aligned + size, (base + size + slop) - (aligned + size));
+
+                if (pages == narena::PagesHugeTLB)
+                {
+                    // The hugetlb pool backs a mapping up front, so only the expected commit goes there and the rest
+                    // of the reservation stays on transparent huge pages. No MAP_NORESERVE, with it the mmap always
+                    // succeeds and an empty pool only shows up as a SIGBUS on the first write.
+                    if (::mmap(aligned, hugetlb, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_FIXED, -1, 0) == MAP_FAILED)
+                    {
+                        // No pool configured or too small, the failed mmap may have unmapped the range
+                        if (::mmap(aligned, hugetlb, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0) == MAP_FAILED)
+                        {
+                            ::munmap(aligned, size);
+                            return nullptr;
+                        }
+                        pages = narena::PagesTransparentHuge;
+                    }
+                }
+                if (pages != narena::PagesHugeTLB)
+                    hugetlb = 0;
+                return aligned;
+            }
+
+            hugetlb   = 0;
+            void* ptr = ::mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            return ptr != MAP_FAILED ? (u8*)ptr : nullptr;
         }
 
-        void g_init_arena(varena_t& m, u64 initial_capacity, u64 max_capacity, u32 item_size)
+        static bool s_vm_commit(varena_t& m, u8* ptr, u64 size)
         {
-            u32 const page_size = nvmem::page_size();
+            if (::mprotect(ptr, size, PROT_READ | PROT_WRITE) != 0)
+                return false;
+
+            // Past the hugetlb part the range is advised as transparent huge pages
+            u8* const advise = ptr > (m.m_ptr + m.m_hugetlb) ? ptr : (m.m_ptr + m.m_hugetlb);
+            if (m.m_config.m_pages != narena::PagesDefault && (ptr + size) > advise && ::madvise(advise, (ptr + size) - advise, MADV_HUGEPAGE) != 0 && m.m_config.m_pages == narena::PagesTransparentHuge)
+                m.m_config.m_pages = narena::PagesDefault; // THP disabled in this kernel, the range stays on regular pages
+            return true;
+        }
+
+        static bool s_vm_prefault(u8* ptr, u64 size) { return ::madvise(ptr, size, MADV_POPULATE_WRITE) == 0; }
+
+        static void s_vm_decommit(u8* ptr, u64 size)
+        {
+            ::madvise(ptr, size, MADV_DONTNEED);
+            ::mprotect(ptr, size, PROT_NONE);
+        }
 
-            m.m_ptr                    = nullptr;
-            u64 const reserved_size  = ((max_capacity * item_size + page_size - 1) / page_size) * page_size;
-            u64 const committed_size = ((initial_capacity * item_size + page_size - 1) / page_size) * page_size;
+        static void s_vm_release(u8* ptr, u64 size) { ::munmap(ptr, size); }
 
-            // u64 address_range, u32& page_size, u32 reserve_flags, void*& baseptr
+        static u32 s_vm_page_size(u8 pages) { return pages == narena::PagesDefault ? nvmem::page_size() : narena::c_huge_page_size; }
+#else
+        static u8* s_vm_reserve(u64 size, u64& hugetlb, u8& pages)
+        {
+            pages         = narena::PagesDefault; // huge pages are only supported on Linux
+            hugetlb       = 0;
             void* baseptr = nullptr;
-            nvmem::reserve(reserved_size, nvmem::nprotect::ReadWrite, baseptr);
-            m.m_ptr = (u8*)baseptr;
+            nvmem::reserve(size, nvmem::nprotect::ReadWrite, baseptr);
+            return (u8*)baseptr;
+        }
 
-            if (m.m_ptr && committed_size > 0)
+        static bool s_vm_commit(varena_t& m, u8* ptr, u64 size) { return nvmem::commit(ptr, size); }
+        static bool s_vm_prefault(u8* ptr, u64 size) { return false; }
+        static void s_vm_decommit(u8* ptr, u64 size) { nvmem::decommit(ptr, size); }
+        static void s_vm_release(u8* ptr, u64 size) { nvmem::release(ptr, size); }
+        static u32  s_vm_page_size(u8 pages) { return nvmem::page_size(); }
+#endif
+
+        static void s_commit(varena_t& m, u8* ptr, u64 size)
+        {
+            if (!s_vm_commit(m, ptr, size))
+                s_fatal("varena_t: failed to commit memory");
+            if (m.m_config.m_prefault != 0 && !s_vm_prefault(ptr, size))
             {
-                nvmem::commit(m.m_ptr, committed_size);
-                m.m_committed = committed_size / item_size;
+                // Touch every page, one fault per page but at least all of them happen here and not
+                // scattered over the hot path.
+                u8 volatile* page = ptr;
+                u8 volatile* end  = ptr + size;
+                u32 const    step = nvmem::page_size();
+                while (page < end)
+                {
+                    *page = 0;
+                    page += step;
+                }
             }
-            m.m_reserved = reserved_size / item_size;
+        }
+
+        // Grow the committed range so that it holds at least 'required' items, plus 'slack' items when the
+        // reservation has room for them
+        static void s_grow(varena_t& m, u64 required, u32 slack, u32 item_size)
+        {
+            if (required > m.m_reserved)
+                s_fatal("varena_t: capacity exceeds the reservation");
+
+            u64 const committed_size = m.committed_bytes();
+            u64 const reserved_size  = m.m_reserved * item_size;
+
+            u64 target = (required + slack) * item_size;
+            if (m.m_config.m_growth == narena::GrowGeometric && target < (committed_size * 2))
+                target = committed_size * 2;
+            if (target < (committed_size + m.m_config.m_commit_step))
+                target = committed_size + m.m_config.m_commit_step;
+            target = s_align_up(target, m.m_page_size);
+            if (target > reserved_size)
+                target = reserved_size;
+
+            if (target > committed_size)
+            {
+                CPATH_COUNT(ArenaCommit);
+                CPATH_COUNT_N(ArenaCommitBytes, target - committed_size);
+                CPATH_SCOPE("varena_t::grow");
+                s_commit(m, m.m_ptr + committed_size, target - committed_size);
+                m.m_committed = target / item_size;
+            }
+        }
+
+        void g_init_arena(varena_t& m)
+        {
+            m.m_ptr       = nullptr;
+            m.m_reserved  = 0;
+            m.m_committed = 0;
+            m.m_item_size = 1;
+            m.m_page_size = nvmem::page_size();
+            m.m_hugetlb   = 0;
+            m.m_config    = g_default_arena_config;
+        }
+
+        void g_init_arena(varena_t& m, u64 initial_capacity, u64 max_capacity, u32 item_size) { g_init_arena(m, initial_capacity, max_capacity, item_size, g_default_arena_config); }
+
+        void g_init_arena(varena_t& m, u64 initial_capacity, u64 max_capacity, u32 item_size, varena_config_t const& config)
+        {
+            m.m_config    = config;
+            m.m_item_size = item_size;
+            m.m_committed = 0;
+
+            // One item more than asked for, vpool_t::ensure_capacity(n) makes index n valid and is also called
+            // with a count, so ensure_capacity(max_capacity) has to stay within the reservation
+            u32 const page_size     = s_vm_page_size(m.m_config.m_pages);
+            u64 const reserved_size = s_align_up((max_capacity + 1) * item_size, page_size);
+
+            // hugetlb pages only for the initial capacity, the expected commit
+            u64 const initial_size = s_align_up(initial_capacity * item_size, page_size);
+            m.m_hugetlb            = initial_size < reserved_size ? initial_size : reserved_size;
+
+            m.m_ptr       = s_vm_reserve(reserved_size, m.m_hugetlb, m.m_config.m_pages);
+            m.m_page_size = s_vm_page_size(m.m_config.m_pages); // may have fallen back to another page type
+            m.m_reserved  = m.m_ptr != nullptr ? reserved_size / item_size : 0;
+            m.m_hugetlb   = m.m_ptr != nullptr ? m.m_hugetlb : 0;
+
+            // The initial capacity is a hint, an array that may only hold a few items commits just those
+            if (m.m_ptr != nullptr && initial_capacity > 0)
+                s_grow(m, initial_capacity < m.m_reserved ? initial_capacity : m.m_reserved, 0, item_size);
         }
 
         void g_teardown_arena(varena_t& m)
         {
-            nvmem::release(m.m_ptr, m.m_reserved);
+            if (m.m_ptr != nullptr)
+                s_vm_release(m.m_ptr, s_align_up(m.reserved_bytes(), m.m_page_size));
             m.m_ptr       = nullptr;
             m.m_reserved  = 0;
             m.m_committed = 0;
+            m.m_hugetlb   = 0;
         }
 
+        u64 varena_t::committed_bytes() const { return s_align_up(m_committed * m_item_size, m_page_size); }
+
         void varena_t::reset(u64 initial_capacity, u32 item_size)
         {
             // Figure out how much memory we need to uncommit
-            u32 const page_size      = nvmem::page_size();
-            u32 const committed_size = m_committed * item_size;
-            u32 const initial_size   = ((initial_capacity * item_size + page_size - 1) / page_size) * page_size;
-            u32 const uncommit_size  = committed_size - initial_size;
+            u64 const committed_size = committed_bytes();
+            u64 const initial_size   = s_align_up(initial_capacity * item_size, m_page_size);
 
-            if (uncommit_size > 0)
+            if (committed_size > initial_size)
             {
-                nvmem::decommit(m_ptr + initial_size, uncommit_size);
-                m_committed = initial_capacity;
+                s_vm_decommit(m_ptr + initial_size, committed_size - initial_size);
+                m_committed = initial_size / item_size;
             }
         }
 
         void varena_t::add_capacity(u64 capacity, u32 item_size)
         {
-            // commit size = capacity * item size
-            u32 const page_size   = nvmem::page_size();
-            u32 const commit_size = ((capacity * item_size + page_size - 1) / page_size) * page_size;
-
-            if (commit_size > 0)
-            {
-                nvmem::commit(m_ptr + m_committed * item_size, commit_size);
-                m_committed += commit_size / item_size;
-            }
+            if (capacity > 0)
+                s_grow(*this, m_committed + capacity, 0, item_size);
         }
 
         void varena_t::ensure_capacity(u32 index, u32 item_size, u32 add_capacity_when_needed)
         {
-            if ((index + c_capacity_bias) >= m_committed)
-                add_capacity((index + c_capacity_bias) - m_committed, item_size);
+            if (((u64)index + c_capacity_bias) >= m_committed)
+                s_grow(*this, (u64)index + 1, c_capacity_bias, item_size);
         }
 
         u8* varena_t::allocate(u8*& ptr, u32 items, u32 item_size)
@@ -86,7 +263,10 @@ namespace ncore
         u8* varena_t::reserve(u8* ptr, u32 items, u32 item_size)
         {
             if ((ptr + items * item_size) > (m_ptr + m_committed * item_size))
-                add_capacity(items + c_capacity_bias, item_size);
+            {
+                u64 const required = (u64)((ptr - m_ptr) + items * item_size + item_size - 1) / item_size;
+                s_grow(*this, required, c_capacity_bias, item_size);
+            }
             return ptr;
         }
 
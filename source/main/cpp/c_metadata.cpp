@@ -0,0 +1,101 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+
+#include "cpath/c_path.h"
+#include "cpath/private/c_metadata.h"
+
+#include <string.h>
+
+namespace ncore
+{
+    namespace npath
+    {
+        static void s_setup_columns(columns_t& c, u32 max_items, varena_config_t const& config)
+        {
+            g_setup_vpool(c.m_size, 0, max_items, config);
+            g_setup_vpool(c.m_mtime, 0, max_items, config);
+            g_setup_vpool(c.m_inode, 0, max_items, config);
+            g_setup_vpool(c.m_device, 0, max_items, config);
+            g_setup_vpool(c.m_mode, 0, max_items, config);
+            g_setup_vpool(c.m_flags, 0, max_items, config);
+            c.m_capacity = 0;
+        }
+
+        static void s_teardown_columns(columns_t& c)
+        {
+            g_teardown_vpool(c.m_size);
+            g_teardown_vpool(c.m_mtime);
+            g_teardown_vpool(c.m_inode);
+            g_teardown_vpool(c.m_device);
+            g_teardown_vpool(c.m_mode);
+            g_teardown_vpool(c.m_flags);
+            c.m_capacity = 0;
+        }
+
+        metadata_t* g_construct_metadata(alloc_t* allocator, u32 max_items, varena_config_t const& config)
+        {
+            metadata_t* m = g_construct<metadata_t>(allocator);
+            s_setup_columns(m->m_folders, max_items, config);
+            s_setup_columns(m->m_files, max_items, config);
+            return m;
+        }
+
+        void g_destruct_metadata(alloc_t* allocator, metadata_t*& metadata)
+        {
+            s_teardown_columns(metadata->m_folders);
+            s_teardown_columns(metadata->m_files);
+            g_destruct(allocator, metadata);
+            metadata = nullptr;
+        }
+
+        void g_ensure_metadata_capacity(columns_t& c, u32 count)
+        {
+            if (count <= c.m_capacity)
+                return;
+            c.m_size.ensure_capacity(count);
+            c.m_mtime.ensure_capacity(count);
+            c.m_inode.ensure_capacity(count);
+            c.m_device.ensure_capacity(count);
+            c.m_mode.ensure_capacity(count);
+            c.m_flags.ensure_capacity(count);
+
+            // Only the flags need clearing, the other fields are meaningless without FlagValid
+            memset(c.m_flags.ptr_of(c.m_capacity), 0, count - c.m_capacity);
+            c.m_capacity = count;
+        }
+
+        void g_get_metadata(columns_t const& c, u32 index, filestat_t& out_stat)
+        {
+            out_stat.m_size     = *c.m_size.ptr_of(index);
+            out_stat.m_mtime_ns = *c.m_mtime.ptr_of(index);
+            out_stat.m_inode    = *c.m_inode.ptr_of(index);
+            out_stat.m_device   = *c.m_device.ptr_of(index);
+            out_stat.m_mode     = *c.m_mode.ptr_of(index);
+            out_stat.m_flags    = *c.m_flags.ptr_of(index);
+        }
+
+        void g_set_metadata(columns_t& c, u32 index, filestat_t const& stat)
+        {
+            u8* const flags = c.m_flags.ptr_of(index);
+
+            bool changed = (*flags & nmeta::FlagValid) == 0;
+            changed      = changed || *c.m_size.ptr_of(index) != stat.m_size || *c.m_mtime.ptr_of(index) != stat.m_mtime_ns;
+            changed      = changed || *c.m_inode.ptr_of(index) != stat.m_inode || *c.m_device.ptr_of(index) != stat.m_device || *c.m_mode.ptr_of(index) != stat.m_mode;
+
+            *c.m_size.ptr_of(index)   = stat.m_size;
+            *c.m_mtime.ptr_of(index)  = stat.m_mtime_ns;
+            *c.m_inode.ptr_of(index)  = stat.m_inode;
+            *c.m_device.ptr_of(index) = stat.m_device;
+            *c.m_mode.ptr_of(index)   = stat.m_mode;
+            *flags                    = (u8)(nmeta::FlagValid | (changed ? nmeta::FlagChanged : 0));
+        }
+
+        void g_set_metadata_missing(columns_t& c, u32 index)
+        {
+            u8* const flags = c.m_flags.ptr_of(index);
+            *flags          = (u8)(nmeta::FlagMissing | ((*flags & nmeta::FlagValid) != 0 ? nmeta::FlagChanged : 0));
+        }
+
+    } // namespace npath
+} // namespace ncore
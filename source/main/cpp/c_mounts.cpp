@@ -0,0 +1,27 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+
+#include "cpath/private/c_mounts.h"
+
+namespace ncore
+{
+    namespace npath
+    {
+        mounts_t* g_construct_mounts(alloc_t* allocator)
+        {
+            mounts_t* mounts = g_construct<mounts_t>(allocator);
+            mounts->m_count  = 0;
+            return mounts;
+        }
+
+        void g_destruct_mounts(alloc_t* allocator, mounts_t*& mounts)
+        {
+            for (s32 i = 0; i < mounts->m_count; ++i)
+                g_deallocate_array(allocator, mounts->m_mounts[i].m_ospath);
+            g_destruct(allocator, mounts);
+            mounts = nullptr;
+        }
+
+    } // namespace npath
+} // namespace ncore
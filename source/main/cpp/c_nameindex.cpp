@@ -0,0 +1,360 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+
+#include "cpath/c_path.h"
+#include "cpath/private/c_nameindex.h"
+#include "cpath/private/c_folders.h"
+#include "cpath/private/c_lazy.h"
+#include "cpath/private/c_strings.h"
+#include "cpath/private/c_threads.h"
+
+#include <string.h>
+
+namespace ncore
+{
+    namespace npath
+    {
+        nameindex_t* g_construct_nameindex(alloc_t* allocator, u32 max_items, varena_config_t const& config)
+        {
+            nameindex_t* index = g_construct<nameindex_t>(allocator);
+            // a folder and a file per item, a live block is at most twice its entries plus one, the abandoned
+            // blocks are at most as large as the live ones
+            g_setup_vpool(index->m_entries, 0, (u64)max_items * 8, config);
+            g_setup_vpool(index->m_blocks, 0, max_items, config);
+            g_setup_vpool(index->m_scratch, 0, (u64)max_items * 2, config); // the entries of a folder
+            index->m_used     = 0;
+            index->m_capacity = 0;
+            return index;
+        }
+
+        void g_destruct_nameindex(alloc_t* allocator, nameindex_t*& index)
+        {
+            g_teardown_vpool(index->m_entries);
+            g_teardown_vpool(index->m_blocks);
+            g_teardown_vpool(index->m_scratch);
+            g_destruct(allocator, index);
+            index = nullptr;
+        }
+
+        // The rendered name of an entry in (at most) three parts, "name" "/" for a folder, "name" ".ext" for a file
+        struct namekey_t
+        {
+            const char* m_str[3];
+            u32         m_len[3];
+        };
+
+        static inline void s_part(strings_t const* strings, string_t str, namekey_t& key, u32 part)
+        {
+            if (str == c_empty_string)
+            {
+                key.m_str[part] = "";
+                key.m_len[part] = 0;
+                return;
+            }
+            strings_t::str_t const* s = strings->index_to_object(str);
+            key.m_str[part]           = s->m_str;
+            key.m_len[part]           = s->m_len;
+        }
+
+        static void s_key(paths_t const* paths, u32 entry, namekey_t& key)
+        {
+            if (entry & c_nameentry_file)
+            {
+                file_t const* f = paths->m_files->m_array.ptr_of(entry & ~c_nameentry_file);
+                s_part(paths->m_strings, f->m_filename, key, 0);
+                s_part(paths->m_strings, f->m_extension, key, 1);
+                key.m_str[2] = "";
+                key.m_len[2] = 0;
+            }
+            else
+            {
+                s_part(paths->m_strings, paths->m_folders->m_array.ptr_of(entry)->m_name, key, 0);
+                key.m_str[1] = "/";
+                key.m_len[1] = 1;
+                key.m_str[2] = "";
+                key.m_len[2] = 0;
+            }
+        }
+
+        // Byte order of the two keys, both cut to 'limit' bytes
+        static s8 s_compare_keys(namekey_t const& a, namekey_t const& b, u32 limit)
+        {
+            u32 pa = 0, ia = 0, pb = 0, ib = 0;
+            for (u32 n = 0; n < limit; ++n)
+            {
+                while (pa < 3 && ia == a.m_len[pa])
+                {
+                    pa += 1;
+                    ia = 0;
+                }
+                while (pb < 3 && ib == b.m_len[pb])
+                {
+                    pb += 1;
+                    ib = 0;
+                }
+                if (pa == 3 || pb == 3)
+                    return pa == pb ? 0 : (pa == 3 ? -1 : 1);
+                u8 const ca = (u8)a.m_str[pa][ia++];
+                u8 const cb = (u8)b.m_str[pb][ib++];
+                if (ca != cb)
+                    return ca < cb ? -1 : 1;
+            }
+            return 0;
+        }
+
+        // Total order, equal names (not expected between siblings) by entry
+        static s8 s_compare_entries(paths_t const* paths, u32 a, u32 b)
+        {
+            if (a == b)
+                return 0;
+            namekey_t ka, kb;
+            s_key(paths, a, ka);
+            s_key(paths, b, kb);
+            s8 const c = s_compare_keys(ka, kb, 0xFFFFFFFF);
+            if (c != 0)
+                return c;
+            return a < b ? -1 : 1;
+        }
+
+        static u64 s_prefix_key(paths_t const* paths, u32 entry)
+        {
+            namekey_t k;
+            s_key(paths, entry, k);
+            u64 key = 0;
+            u32 n   = 0;
+            for (u32 p = 0; p < 3 && n < 8; ++p)
+                for (u32 i = 0; i < k.m_len[p] && n < 8; ++i, ++n)
+                    key |= (u64)(u8)k.m_str[p][i] << (56 - n * 8);
+            return key;
+        }
+
+        static inline s8 s_compare_sort(paths_t const* paths, namesort_t const& a, namesort_t const& b)
+        {
+            if (a.m_key != b.m_key)
+                return a.m_key < b.m_key ? -1 : 1;
+            return s_compare_entries(paths, a.m_entry, b.m_entry);
+        }
+
+        static void s_sift_down(paths_t const* paths, namesort_t* items, u32 root, u32 count)
+        {
+            while (true)
+            {
+                u32 child = root * 2 + 1;
+                if (child >= count)
+                    return;
+                if (child + 1 < count && s_compare_sort(paths, items[child], items[child + 1]) < 0)
+                    child += 1;
+                if (s_compare_sort(paths, items[root], items[child]) >= 0)
+                    return;
+                namesort_t const t = items[root];
+                items[root]        = items[child];
+                items[child]       = t;
+                root               = child;
+            }
+        }
+
+        static void s_sort(paths_t const* paths, namesort_t* items, u32 count)
+        {
+            for (u32 i = count / 2; i > 0; --i)
+                s_sift_down(paths, items, i - 1, count);
+            for (u32 end = count; end > 1; --end)
+            {
+                namesort_t const t = items[0];
+                items[0]           = items[end - 1];
+                items[end - 1]     = t;
+                s_sift_down(paths, items, 0, end - 1);
+            }
+        }
+
+        static nameblock_t* s_block_of(nameindex_t* index, folders_t const* folders, node_t folder)
+        {
+            if (folder >= index->m_capacity)
+            {
+                u32 const capacity = folders->m_count > folder + 1 ? folders->m_count : folder + 1;
+                index->m_blocks.ensure_capacity(capacity);
+                memset(index->m_blocks.ptr_of(index->m_capacity), 0, (capacity - index->m_capacity) * sizeof(nameblock_t));
+                index->m_capacity = capacity;
+            }
+            return index->m_blocks.ptr_of(folder);
+        }
+
+        static void s_allocate(nameindex_t* index, nameblock_t* block, u32 capacity)
+        {
+            u32 const offset = index->m_used;
+            index->m_used += capacity;
+            index->m_entries.ensure_capacity(index->m_used);
+            if (block->m_count > 0)
+                memcpy(index->m_entries.ptr_of(offset), index->m_entries.ptr_of(block->m_offset), block->m_count * sizeof(u32));
+            block->m_offset   = offset;
+            block->m_capacity = capacity;
+        }
+
+        void g_nameindex_add(paths_t* paths, node_t folder, u32 entry)
+        {
+            nameindex_t* index = paths->m_nameindex;
+            if (folder >= index->m_capacity)
+                return;
+            nameblock_t* block = index->m_blocks.ptr_of(folder);
+            if (block->m_capacity == 0)
+                return; // built on its first query
+            if (block->m_count == block->m_capacity)
+                s_allocate(index, block, block->m_capacity * 2); // the old block is abandoned
+            *index->m_entries.ptr_of(block->m_offset + block->m_count) = entry;
+            block->m_count += 1;
+        }
+
+        static void s_build(paths_t* paths, nameblock_t* block, node_t folder)
+        {
+            if (paths->m_lazy != nullptr && (g_load_acquire(paths->m_folders->m_array.ptr_of(folder)->m_flags) & (nfolder::FlagLazy | nfolder::FlagExpanded)) == nfolder::FlagLazy)
+                g_expand_folder(paths, folder);
+
+            // Both lists, tombstones included, they may come back
+            folder_t const* f     = paths->m_folders->m_array.ptr_of(folder);
+            u32             count = 0;
+            for (node_t child = f->m_child; child != c_invalid_folder; child = paths->m_folders->m_array.ptr_of(child)->m_sibling)
+                count += 1;
+            for (ifile_t file = f->m_file; file != c_invalid_file; file = paths->m_files->m_array.ptr_of(file)->m_sibling)
+                count += 1;
+
+            nameindex_t* index = paths->m_nameindex;
+            block->m_count     = 0;
+            s_allocate(index, block, count + 1);
+            u32* entries = index->m_entries.ptr_of(block->m_offset);
+            for (node_t child = f->m_child; child != c_invalid_folder; child = paths->m_folders->m_array.ptr_of(child)->m_sibling)
+                entries[block->m_count++] = child;
+            for (ifile_t file = f->m_file; file != c_invalid_file; file = paths->m_files->m_array.ptr_of(file)->m_sibling)
+                entries[block->m_count++] = file | c_nameentry_file;
+            block->m_sorted = 0;
+            block->m_side   = 0;
+        }
+
+        static inline void s_item(paths_t const* paths, namesort_t& item, u32 entry)
+        {
+            item.m_key     = s_prefix_key(paths, entry);
+            item.m_entry   = entry;
+            item.m_padding = 0;
+        }
+
+        // The side run joins the first run, only the entries of the first run above the first side entry move, they
+        // are merged from the back
+        static void s_merge_side(paths_t const* paths, nameblock_t* block)
+        {
+            nameindex_t* const index   = paths->m_nameindex;
+            u32* const         entries = index->m_entries.ptr_of(block->m_offset);
+            u32 const          sorted  = block->m_sorted;
+            u32 const          side    = block->m_side;
+            if (sorted > 0)
+            {
+                index->m_scratch.ensure_capacity(side);
+                namesort_t* const items = index->m_scratch.ptr();
+                for (u32 j = 0; j < side; ++j)
+                    s_item(paths, items[j], entries[sorted + j]);
+
+                u32 const  first = g_nameindex_after(paths, block, 0, sorted, items[0].m_entry);
+                u32        i     = sorted;
+                u32        j     = side;
+                u32        out   = sorted + side;
+                namesort_t last;
+                if (i > first)
+                    s_item(paths, last, entries[i - 1]);
+                while (j > 0)
+                {
+                    if (i > first && s_compare_sort(paths, last, items[j - 1]) > 0)
+                    {
+                        entries[--out] = entries[--i];
+                        if (i > first)
+                            s_item(paths, last, entries[i - 1]);
+                    }
+                    else
+                    {
+                        entries[--out] = items[--j].m_entry;
+                    }
+                }
+            }
+            block->m_sorted = sorted + side;
+            block->m_side   = 0;
+        }
+
+        nameblock_t* g_nameindex_block(paths_t* paths, node_t folder)
+        {
+            nameindex_t* index = paths->m_nameindex;
+            nameblock_t* block = s_block_of(index, paths->m_folders, folder);
+            if (block->m_capacity == 0)
+                s_build(paths, block, folder);
+            u32 const side  = block->m_sorted;
+            u32 const fresh = block->m_sorted + block->m_side;
+            u32 const count = block->m_count;
+            if (fresh == count)
+                return block;
+
+            // Sort the appended entries and merge them with the side run, only these two get keys, positions handed
+            // out before are stale
+            u32* const entries = index->m_entries.ptr_of(block->m_offset);
+            index->m_scratch.ensure_capacity(count - side);
+            namesort_t* const items = index->m_scratch.ptr();
+            for (u32 i = side; i < count; ++i)
+                s_item(paths, items[i - side], entries[i]);
+            s_sort(paths, items + (fresh - side), count - fresh);
+            u32 a = 0, b = fresh - side, k = side;
+            while (a < fresh - side && b < count - side)
+                entries[k++] = s_compare_sort(paths, items[a], items[b]) <= 0 ? items[a++].m_entry : items[b++].m_entry;
+            while (a < fresh - side)
+                entries[k++] = items[a++].m_entry;
+            while (b < count - side)
+                entries[k++] = items[b++].m_entry;
+            block->m_side = count - side;
+            block->m_version += 1;
+
+            // A side run past the square root of the first run joins it, a merge that rewrites up to the whole block
+            // happens once per that many entries
+            if (block->m_sorted == 0 || (u64)block->m_side * block->m_side > block->m_sorted)
+                s_merge_side(paths, block);
+            return block;
+        }
+
+        u32 g_nameindex_seek(paths_t const* paths, nameblock_t const* block, u32 begin, u32 end, const char* prefix, u32 len, bool upper)
+        {
+            namekey_t key;
+            key.m_str[0] = prefix;
+            key.m_len[0] = len;
+            key.m_str[1] = key.m_str[2] = "";
+            key.m_len[1] = key.m_len[2] = 0;
+
+            u32 const* const entries = paths->m_nameindex->m_entries.ptr_of(block->m_offset);
+            u32              lo      = begin;
+            u32              hi      = end;
+            while (lo < hi)
+            {
+                u32 const mid = (lo + hi) / 2;
+                namekey_t k;
+                s_key(paths, entries[mid], k);
+                s8 const c = s_compare_keys(k, key, len);
+                if (c < 0 || (upper && c == 0))
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            return lo;
+        }
+
+        u32 g_nameindex_after(paths_t const* paths, nameblock_t const* block, u32 begin, u32 end, u32 entry)
+        {
+            u32 const* const entries = paths->m_nameindex->m_entries.ptr_of(block->m_offset);
+            u32              lo      = begin;
+            u32              hi      = end;
+            while (lo < hi)
+            {
+                u32 const mid = (lo + hi) / 2;
+                if (s_compare_entries(paths, entries[mid], entry) <= 0)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            return lo;
+        }
+
+        s8 g_nameindex_compare(paths_t const* paths, u32 a, u32 b) { return s_compare_entries(paths, a, b); }
+
+    } // namespace npath
+} // namespace ncore
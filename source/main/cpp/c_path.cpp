@@ -11,27 +11,59 @@
 #include "cpath/c_filepath.h"
 #include "cpath/private/c_strings.h"
 #include "cpath/private/c_folders.h"
+#include "cpath/private/c_metadata.h"
+#include "cpath/private/c_lazy.h"
+#include "cpath/private/c_mounts.h"
+#include "cpath/private/c_streams.h"
+#include "cpath/private/c_hashes.h"
+#include "cpath/private/c_extindex.h"
+#include "cpath/private/c_rollups.h"
+#include "cpath/private/c_fingerprints.h"
+#include "cpath/private/c_nameindex.h"
+#include "cpath/private/c_unions.h"
+#include "cpath/private/c_prefixtrie.h"
+#include "cpath/c_instrument.h"
 #include "cpath/c_device.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 namespace ncore
 {
     namespace npath
     {
-        paths_t* g_construct_paths(alloc_t* allocator, u32 max_items)
+        paths_t* g_construct_paths(alloc_t* allocator, u32 max_items, varena_config_t const& config)
         {
-            paths_t* paths     = g_construct<paths_t>(allocator);
-            paths->m_allocator = allocator;
+            paths_t* paths        = g_construct<paths_t>(allocator);
+            paths->m_allocator    = allocator;
+            paths->m_metadata     = nullptr;
+            paths->m_lazy         = nullptr;
+            paths->m_mounts       = nullptr;
+            paths->m_streams      = nullptr;
+            paths->m_hashes       = nullptr;
+            paths->m_extindex     = nullptr;
+            paths->m_rollups      = nullptr;
+            paths->m_fingerprints = nullptr;
+            paths->m_nameindex    = nullptr;
+            paths->m_unions       = nullptr;
+            paths->m_prefixtrie   = nullptr;
+            paths->m_max_items    = max_items;
+            paths->m_config       = config;
 
-            paths->m_strings        = g_construct_strings(allocator);
+            paths->m_strings        = g_construct_strings(allocator, 16 * 1024 * 1024, config);
             string_t default_string = paths->m_strings->insert(ascii::make_crunes("nil"));
             ASSERT(default_string == c_empty_string);
 
             paths->m_devices = g_construct_devices(allocator, paths, paths->m_strings);
-            paths->m_folders = g_construct_folders(allocator, max_items);
+            paths->m_folders = g_construct_folders(allocator, max_items, config);
+            paths->m_files   = g_construct_files(allocator, max_items, config);
 
             return paths;
         }
 
+        paths_t* g_construct_paths(alloc_t* allocator, u32 max_items) { return g_construct_paths(allocator, max_items, g_default_arena_config); }
+
         paths_t* g_construct_paths(alloc_t* allocator)
         {
             // default to 1GB
@@ -42,6 +74,29 @@ namespace ncore
         {
             g_destruct_devices(allocator, paths->m_devices);
             g_destruct_folders(allocator, paths->m_folders);
+            g_destruct_files(allocator, paths->m_files);
+            if (paths->m_metadata != nullptr)
+                g_destruct_metadata(allocator, paths->m_metadata);
+            if (paths->m_lazy != nullptr)
+                g_destruct_lazy(allocator, paths->m_lazy);
+            if (paths->m_hashes != nullptr)
+                g_destruct_hashes(allocator, paths->m_hashes);
+            if (paths->m_extindex != nullptr)
+                g_destruct_extindex(allocator, paths->m_extindex);
+            if (paths->m_rollups != nullptr)
+                g_destruct_rollups(allocator, paths->m_rollups);
+            if (paths->m_fingerprints != nullptr)
+                g_destruct_fingerprints(allocator, paths->m_fingerprints);
+            if (paths->m_nameindex != nullptr)
+                g_destruct_nameindex(allocator, paths->m_nameindex);
+            if (paths->m_unions != nullptr)
+                g_destruct_unions(allocator, paths->m_unions);
+            if (paths->m_prefixtrie != nullptr)
+                g_destruct_prefixtrie(allocator, paths->m_prefixtrie);
+            if (paths->m_streams != nullptr)
+                g_destruct_streams(allocator, paths->m_streams);
+            if (paths->m_mounts != nullptr)
+                g_destruct_mounts(allocator, paths->m_mounts);
             g_destruct_strings(allocator, paths->m_strings);
             g_destruct(allocator, paths);
         }
@@ -53,7 +108,21 @@ namespace ncore
             return m_devices->get_device(idevice);
         }
 
-        node_t paths_t::allocate_folder(string_t name) { return g_allocate_folder(m_folders, name); }
+        device_t* paths_t::register_alias(crunes_t const& devicename, dirpath_t const& target)
+        {
+            string_t const devicestr = m_strings->insert(devicename);
+            node_t const   node      = (target.m_path == c_empty_node || target.m_path == c_invalid_node) ? target.m_device->m_path : target.m_path;
+            idevice_t      idevice   = m_devices->register_alias(devicestr, target.m_device->m_index, node);
+            return m_devices->get_device(idevice);
+        }
+
+        node_t paths_t::allocate_folder(string_t name)
+        {
+            node_t const folder = g_allocate_folder(m_folders, name);
+            if (m_extindex != nullptr)
+                g_extindex_add_folder(m_extindex, m_folders, folder);
+            return folder;
+        }
 
         void paths_t::register_filename(crunes_t const& filename, string_t& out_name, string_t& out_ext)
         {
@@ -99,28 +168,869 @@ namespace ncore
             return len;
         }
 
+        void paths_t::stats(paths_stats_t& out_stats) const
+        {
+            out_stats.m_wasted_bytes = 0;
+            m_strings->get_stats(out_stats);
+            m_devices->get_stats(out_stats);
+            g_get_stats(m_folders, out_stats);
+            g_get_stats(m_files, out_stats);
+        }
+
+        void paths_t::enable_metadata()
+        {
+            if (m_metadata == nullptr)
+                m_metadata = g_construct_metadata(m_allocator, m_max_items, m_config);
+        }
+
+        static const s32 c_max_ospath_depth = 256;
+
+        bool paths_t::mount(dirpath_t const& root, const char* ospath)
+        {
+            if (root.m_device == nullptr)
+                return false;
+            if (m_mounts == nullptr)
+                m_mounts = g_construct_mounts(m_allocator);
+            // Only a mounted file can be opened, constructing the streams here keeps open_filestream free of races
+            if (m_streams == nullptr)
+                m_streams = g_construct_streams(m_allocator, this);
+
+            s32 len = (s32)strlen(ospath);
+            while (len > 1 && ospath[len - 1] == '/')
+                len -= 1;
+
+            node_t const node  = (root.m_path == c_empty_node || root.m_path == c_invalid_node) ? root.m_device->m_path : root.m_path;
+            mount_t*     mount = nullptr;
+            for (s32 i = 0; i < m_mounts->m_count && mount == nullptr; ++i)
+                mount = m_mounts->m_mounts[i].m_node == node ? &m_mounts->m_mounts[i] : nullptr;
+            if (mount != nullptr)
+            {
+                g_deallocate_array(m_allocator, mount->m_ospath); // re-mount
+            }
+            else
+            {
+                if (m_mounts->m_count == mounts_t::c_max_mounts)
+                    return false;
+                mount = &m_mounts->m_mounts[m_mounts->m_count++];
+            }
+
+            mount->m_node       = node;
+            mount->m_ospath_len = len;
+            mount->m_ospath     = g_allocate_array<char>(m_allocator, len + 1);
+            memcpy(mount->m_ospath, ospath, len);
+            mount->m_ospath[len] = 0;
+            m_folders->m_array.ptr_of(node)->m_flags |= nfolder::FlagMount;
+            return true;
+        }
+
+        s32 paths_t::folder_to_ospath(node_t folder, char* out_path, s32 max_len) const
+        {
+            if (m_mounts == nullptr || folder == c_invalid_node)
+                return -1;
+
+            // Walk up to the nearest mount root, then render the names below it
+            node_t chain[c_max_ospath_depth];
+            s32    depth = 0;
+            node_t iter  = folder;
+            while (iter != c_invalid_folder && (m_folders->m_array.ptr_of(iter)->m_flags & nfolder::FlagMount) == 0)
+            {
+                if (depth == c_max_ospath_depth)
+                    return -1;
+                chain[depth++] = iter;
+                iter           = m_folders->m_array.ptr_of(iter)->m_parent;
+            }
+            if (iter == c_invalid_folder)
+                return -1;
+
+            mount_t const* mount = nullptr;
+            for (s32 i = 0; i < m_mounts->m_count && mount == nullptr; ++i)
+                mount = m_mounts->m_mounts[i].m_node == iter ? &m_mounts->m_mounts[i] : nullptr;
+            if (mount == nullptr || mount->m_ospath_len >= max_len)
+                return -1;
+
+            s32 len = mount->m_ospath_len;
+            memcpy(out_path, mount->m_ospath, len);
+            while (depth > 0)
+            {
+                crunes_t name;
+                m_strings->view_string(m_folders->m_array.ptr_of(chain[--depth])->m_name, name);
+                s32 const name_len = name.m_end - name.m_str;
+                if ((len + 1 + name_len) >= max_len)
+                    return -1;
+                out_path[len++] = '/';
+                memcpy(out_path + len, name.m_ascii + name.m_str, name_len);
+                len += name_len;
+            }
+            out_path[len] = 0;
+            return len;
+        }
+
+        s32 paths_t::file_to_ospath(ifile_t file, char* out_path, s32 max_len) const
+        {
+            file_t const* f   = m_files->m_array.ptr_of(file);
+            s32           len = folder_to_ospath(f->m_folder, out_path, max_len);
+            if (len < 0)
+                return -1;
+
+            crunes_t filename, extension;
+            m_strings->view_string(f->m_filename, filename);
+            m_strings->view_string(f->m_extension, extension);
+            s32 const name_len = filename.m_end - filename.m_str;
+            s32 const ext_len  = f->m_extension != c_empty_string ? extension.m_end - extension.m_str : 0;
+            if ((len + 1 + name_len + ext_len) >= max_len)
+                return -1;
+            out_path[len++] = '/';
+            memcpy(out_path + len, filename.m_ascii + filename.m_str, name_len);
+            len += name_len;
+            memcpy(out_path + len, extension.m_ascii + extension.m_str, ext_len);
+            len += ext_len;
+            out_path[len] = 0;
+            return len;
+        }
+
+        bool paths_t::enable_lazy(dirpath_t const& root, const char* ospath)
+        {
+            if (!mount(root, ospath))
+                return false;
+            if (m_lazy == nullptr)
+                m_lazy = g_construct_lazy(m_allocator);
+            node_t const node = (root.m_path == c_empty_node || root.m_path == c_invalid_node) ? root.m_device->m_path : root.m_path;
+            g_mark_lazy(this, node);
+            return true;
+        }
+
+        bool paths_t::expand(node_t folder) { return g_expand_folder(this, folder); }
+
+        bool paths_t::get_folder_stat(node_t folder, filestat_t& out_stat) const
+        {
+            if (m_metadata == nullptr || folder >= m_metadata->m_folders.m_capacity)
+                return false;
+            g_get_metadata(m_metadata->m_folders, folder, out_stat);
+            return (out_stat.m_flags & nmeta::FlagValid) != 0;
+        }
+
+        bool paths_t::get_file_stat(ifile_t file, filestat_t& out_stat) const
+        {
+            if (m_metadata == nullptr || file >= m_metadata->m_files.m_capacity)
+                return false;
+            g_get_metadata(m_metadata->m_files, file, out_stat);
+            return (out_stat.m_flags & nmeta::FlagValid) != 0;
+        }
+
+        u32 paths_t::changed_files(ifile_t from, ifile_t* out_files, u32 max_files) const
+        {
+            if (m_metadata == nullptr)
+                return 0;
+            u32       count = 0;
+            u32 const end   = m_metadata->m_files.m_capacity;
+            u8 const* flags = m_metadata->m_files.m_flags.ptr_of(0);
+            for (u32 i = from; i < end && count < max_files; ++i)
+            {
+                if ((flags[i] & nmeta::FlagChanged) != 0)
+                    out_files[count++] = i;
+            }
+            return count;
+        }
+
+        void paths_t::set_file_stat(ifile_t file, filestat_t const& stat)
+        {
+            enable_metadata();
+            g_ensure_metadata_capacity(m_metadata->m_files, m_files->m_count);
+            u64 old_size;
+            s64 old_mtime;
+            g_rollup_contribution(this, file, old_size, old_mtime);
+            g_set_metadata(m_metadata->m_files, file, stat);
+            if (m_rollups != nullptr && (m_files->m_array.ptr_of(file)->m_flags & nfile::FlagDeleted) == 0)
+                g_rollup_change(this, file, old_size, old_mtime);
+            if (m_fingerprints != nullptr)
+                g_fingerprint_dirty(this, m_files->m_array.ptr_of(file)->m_folder);
+        }
+
+        void paths_t::enable_hashes()
+        {
+            if (m_hashes == nullptr)
+                m_hashes = g_construct_hashes(m_allocator, m_max_items, m_config);
+        }
+
+        bool paths_t::get_file_hash(ifile_t file, contenthash_t& out_hash) const
+        {
+            if (m_hashes == nullptr || file >= m_hashes->m_capacity || (*m_hashes->m_flags.ptr_of(file) & nmeta::FlagValid) == 0)
+                return false;
+            out_hash.m_lo = *m_hashes->m_lo.ptr_of(file);
+            out_hash.m_hi = *m_hashes->m_hi.ptr_of(file);
+            return true;
+        }
+
+        u32 paths_t::changed_hashes(ifile_t from, ifile_t* out_files, u32 max_files) const
+        {
+            if (m_hashes == nullptr)
+                return 0;
+            u32       count = 0;
+            u32 const end   = m_hashes->m_capacity;
+            u8 const* flags = m_hashes->m_flags.ptr_of(0);
+            for (u32 i = from; i < end && count < max_files; ++i)
+            {
+                if ((flags[i] & nmeta::FlagChanged) != 0)
+                    out_files[count++] = i;
+            }
+            return count;
+        }
+
+        void paths_t::enable_extindex()
+        {
+            if (m_extindex != nullptr)
+                return;
+            m_extindex = g_construct_extindex(m_allocator, m_max_items, m_config);
+            g_extindex_build_intervals(m_extindex, m_folders);
+            for (ifile_t i = 1; i < m_files->m_count; ++i)
+            {
+                file_t const* f = m_files->m_array.ptr_of(i);
+                if ((f->m_flags & nfile::FlagDeleted) == 0)
+                    g_extindex_add(m_extindex, m_files, i, f->m_extension);
+            }
+        }
+
+        u32 paths_t::files_with_extension(string_t extension, ifile_t* out_files, u32 max_files) const
+        {
+            extbucket_t const* bucket = m_extindex != nullptr ? g_extindex_find(m_extindex, extension) : nullptr;
+            if (bucket == nullptr)
+                return 0;
+            return g_extindex_files(m_extindex, bucket, out_files, max_files);
+        }
+
+        u32 paths_t::files_with_extension(dirpath_t const& dir, string_t extension, ifile_t* out_files, u32 max_files) const
+        {
+            extbucket_t const* bucket = m_extindex != nullptr ? g_extindex_find(m_extindex, extension) : nullptr;
+            if (bucket == nullptr || dir.m_device == nullptr)
+                return 0;
+
+            node_t const node = (dir.m_path == c_empty_node || dir.m_path == c_invalid_node) ? dir.m_device->m_path : dir.m_path;
+            return g_extindex_files_below(m_extindex, bucket, m_files, node, out_files, max_files);
+        }
+
+        void paths_t::enable_rollups()
+        {
+            if (m_rollups != nullptr)
+                return;
+            m_rollups = g_construct_rollups(m_allocator, m_max_items, m_config);
+            g_rollup_recompute(this);
+        }
+
+        void paths_t::update_rollups()
+        {
+            if (m_rollups != nullptr)
+                g_rollup_recompute(this);
+        }
+
+        bool paths_t::get_rollup(dirpath_t const& dir, rollup_t& out_rollup)
+        {
+            if (m_rollups == nullptr || dir.m_device == nullptr)
+                return false;
+            node_t const node = (dir.m_path == c_empty_node || dir.m_path == c_invalid_node) ? dir.m_device->m_path : dir.m_path;
+            g_rollup_get(this, node, out_rollup.m_bytes, out_rollup.m_files, out_rollup.m_mtime_ns);
+            out_rollup.m_padding = 0;
+            return true;
+        }
+
+        void paths_t::enable_fingerprints(u32 num_threads)
+        {
+            if (m_fingerprints != nullptr)
+                return;
+            m_fingerprints = g_construct_fingerprints(m_allocator, m_max_items, m_config);
+            update_fingerprints(num_threads);
+        }
+
+        void paths_t::update_fingerprints(u32 num_threads)
+        {
+            CPATH_SCOPE("paths_t::update_fingerprints");
+            if (m_fingerprints != nullptr)
+                g_fingerprint_update(this, num_threads);
+        }
+
+        bool paths_t::get_fingerprint(dirpath_t const& dir, fingerprint_t& out_fingerprint)
+        {
+            if (m_fingerprints == nullptr || dir.m_device == nullptr)
+                return false;
+            node_t const node = (dir.m_path == c_empty_node || dir.m_path == c_invalid_node) ? dir.m_device->m_path : dir.m_path;
+            g_fingerprint_get(this, node, out_fingerprint.m_lo, out_fingerprint.m_hi);
+            return true;
+        }
+
+        void paths_t::enable_nameindex()
+        {
+            if (m_nameindex == nullptr)
+                m_nameindex = g_construct_nameindex(m_allocator, m_max_items, m_config);
+        }
+
+        device_t* paths_t::register_union(crunes_t const& devicename, device_t* const* layers, u32 num_layers)
+        {
+            if (num_layers > c_max_layers)
+                return nullptr;
+            if (m_unions == nullptr)
+                m_unions = g_construct_unions(m_allocator, m_max_items, m_config);
+            idevice_t indices[c_max_layers];
+            for (u32 i = 0; i < num_layers; ++i)
+                indices[i] = layers[i] != nullptr ? layers[i]->m_index : c_invalid_device;
+            string_t const  devicestr = m_strings->insert(devicename);
+            idevice_t const idevice   = m_devices->register_union(devicestr, indices, num_layers);
+            return m_devices->get_device(idevice);
+        }
+
+        bool paths_t::resolve(dirpath_t const& dir, dirpath_t& out_dir)
+        {
+            device_t* const device = dir.m_device;
+            if (device == nullptr || device->m_union < 0)
+            {
+                out_dir = dir;
+                return true;
+            }
+            union_t const*    u      = m_unions->m_unions.ptr_of(device->m_union);
+            node_t const      folder = (dir.m_path == c_empty_node || dir.m_path == c_invalid_node) ? device->m_path : dir.m_path;
+            unionhit_t const* hit    = g_unions_resolve_folder(this, u, folder);
+            if (hit->m_layer < 0)
+                return false;
+            out_dir = dirpath_t(m_devices->get_device(u->m_layers[hit->m_layer]), hit->m_node);
+            return true;
+        }
+
+        bool paths_t::resolve(filepath_t const& file, filepath_t& out_file)
+        {
+            device_t* const device = file.m_dirpath.m_device;
+            if (device == nullptr || device->m_union < 0)
+            {
+                out_file = file;
+                return true;
+            }
+            union_t const*    u   = m_unions->m_unions.ptr_of(device->m_union);
+            unionhit_t const* hit = g_unions_resolve_file(this, u, file_of(file));
+            if (hit->m_layer < 0)
+                return false;
+            file_t const* f = m_files->m_array.ptr_of(hit->m_node);
+            out_file        = filepath_t(m_devices->get_device(u->m_layers[hit->m_layer]), f->m_folder, f->m_filename, f->m_extension);
+            return true;
+        }
+
+        // Hash file layout: header, then per file: size, mtime, hash (lo, hi), path length, path ("sub/folder/name.ext")
+        static const u32 c_hashes_magic   = 0x31485043; // "CPH1"
+        static const s32 c_max_hash_path = 4096;
+
+        struct hashes_header_t
+        {
+            u32 m_magic;
+            u32 m_count;
+        };
+
+        struct hashes_record_t
+        {
+            u64 m_size;
+            s64 m_mtime_ns;
+            u64 m_lo;
+            u64 m_hi;
+            u32 m_path_len;
+            u32 m_padding;
+        };
+
+        // The path of a file relative to 'root', -1 when the file is not below it or the path doesn't fit
+        static s32 s_file_to_relpath(paths_t const* paths, node_t root, file_t const* f, char* out_path, s32 max_len)
+        {
+            node_t chain[c_max_ospath_depth];
+            s32    depth = 0;
+            for (node_t iter = f->m_folder; iter != root; iter = paths->m_folders->m_array.ptr_of(iter)->m_parent)
+            {
+                if (iter == c_invalid_folder || depth == c_max_ospath_depth)
+                    return -1;
+                chain[depth++] = iter;
+            }
+
+            s32 len = 0;
+            while (depth > 0)
+            {
+                crunes_t name;
+                paths->m_strings->view_string(paths->m_folders->m_array.ptr_of(chain[--depth])->m_name, name);
+                s32 const name_len = name.m_end - name.m_str;
+                if ((len + name_len + 1) >= max_len)
+                    return -1;
+                memcpy(out_path + len, name.m_ascii + name.m_str, name_len);
+                len += name_len;
+                out_path[len++] = '/';
+            }
+
+            crunes_t filename, extension;
+            paths->m_strings->view_string(f->m_filename, filename);
+            paths->m_strings->view_string(f->m_extension, extension);
+            s32 const name_len = filename.m_end - filename.m_str;
+            s32 const ext_len  = f->m_extension != c_empty_string ? extension.m_end - extension.m_str : 0;
+            if ((len + name_len + ext_len) >= max_len)
+                return -1;
+            memcpy(out_path + len, filename.m_ascii + filename.m_str, name_len);
+            len += name_len;
+            memcpy(out_path + len, extension.m_ascii + extension.m_str, ext_len);
+            len += ext_len;
+            out_path[len] = 0;
+            return len;
+        }
+
+        bool paths_t::save_hashes(dirpath_t const& root, const char* ospath) const
+        {
+            if (root.m_device == nullptr)
+                return false;
+            FILE* file = fopen(ospath, "wb");
+            if (file == nullptr)
+                return false;
+
+            node_t const    root_node = root.m_path == c_empty_node ? root.m_device->m_path : root.m_path;
+            hashes_header_t header    = {c_hashes_magic, 0};
+            fwrite(&header, sizeof(header), 1, file);
+
+            char      path[c_max_hash_path];
+            u32 const end = m_hashes != nullptr ? m_hashes->m_capacity : 0;
+            for (ifile_t i = 0; i < end; ++i)
+            {
+                file_t const* f = m_files->m_array.ptr_of(i);
+                if ((*m_hashes->m_flags.ptr_of(i) & nmeta::FlagValid) == 0 || (f->m_flags & nfile::FlagDeleted) != 0)
+                    continue;
+                s32 const len = s_file_to_relpath(this, root_node, f, path, c_max_hash_path);
+                if (len < 0)
+                    continue;
+
+                hashes_record_t record;
+                record.m_size     = *m_hashes->m_size.ptr_of(i);
+                record.m_mtime_ns = *m_hashes->m_mtime.ptr_of(i);
+                record.m_lo       = *m_hashes->m_lo.ptr_of(i);
+                record.m_hi       = *m_hashes->m_hi.ptr_of(i);
+                record.m_path_len = (u32)len;
+                record.m_padding  = 0;
+                fwrite(&record, sizeof(record), 1, file);
+                fwrite(path, len, 1, file);
+                header.m_count += 1;
+            }
+
+            fseek(file, 0, SEEK_SET);
+            fwrite(&header, sizeof(header), 1, file);
+            bool const ok = ferror(file) == 0;
+            fclose(file);
+            return ok;
+        }
+
+        bool paths_t::load_hashes(dirpath_t const& root, const char* ospath)
+        {
+            if (root.m_device == nullptr)
+                return false;
+            FILE* file = fopen(ospath, "rb");
+            if (file == nullptr)
+                return false;
+
+            hashes_header_t header;
+            if (fread(&header, sizeof(header), 1, file) != 1 || header.m_magic != c_hashes_magic)
+            {
+                fclose(file);
+                return false;
+            }
+
+            enable_hashes();
+            device_t* const device    = root.m_device;
+            node_t const    root_node = root.m_path == c_empty_node ? device->m_path : root.m_path;
+            char            path[c_max_hash_path];
+            u32             loaded = 0;
+            for (; loaded < header.m_count; ++loaded)
+            {
+                hashes_record_t record;
+                if (fread(&record, sizeof(record), 1, file) != 1 || record.m_path_len >= (u32)c_max_hash_path || fread(path, record.m_path_len, 1, file) != 1)
+                    break;
+
+                // Register the folders and the file below 'root', they may not have been scanned yet
+                node_t folder = root_node;
+                u32    start  = 0;
+                for (u32 i = 0; i < record.m_path_len; ++i)
+                {
+                    if (path[i] != '/')
+                        continue;
+                    folder = device->add_dir(folder, find_or_insert_string(ascii::make_crunes(path, start, i, i)));
+                    start  = i + 1;
+                }
+                string_t filename, extension;
+                register_filename(ascii::make_crunes(path, start, record.m_path_len, record.m_path_len), filename, extension);
+                ifile_t f = device->find_file(folder, filename, extension);
+                if (f == c_invalid_file)
+                    f = device->add_file(folder, filename, extension, nfile::TypeUnknown);
+
+                g_ensure_hashes_capacity(m_hashes, m_files->m_count);
+                contenthash_t const hash = {record.m_lo, record.m_hi};
+                g_set_hash(m_hashes, f, record.m_size, record.m_mtime_ns, hash);
+                *m_hashes->m_flags.ptr_of(f) = nmeta::FlagValid; // loaded, not changed
+                if (m_fingerprints != nullptr)
+                    g_fingerprint_dirty(this, folder);
+            }
+            fclose(file);
+            return loaded == header.m_count;
+        }
+
+        device_t* paths_t::device_of(node_t folder) const
+        {
+            if (folder == c_invalid_node)
+                return nullptr;
+            folder_t const* f = m_folders->m_array.ptr_of(folder);
+            while (f->m_parent != c_invalid_folder)
+            {
+                folder = f->m_parent;
+                f      = m_folders->m_array.ptr_of(folder);
+            }
+            return m_devices->device_of_root(folder);
+        }
+
+        filepath_t paths_t::get_filepath(ifile_t file) const
+        {
+            file_t const* f      = m_files->m_array.ptr_of(file);
+            device_t*     device = device_of(f->m_folder);
+            if (device == nullptr)
+                return filepath_t(m_devices->get_default_device());
+            return filepath_t(device, f->m_folder, f->m_filename, f->m_extension);
+        }
+
+        ifile_t paths_t::file_of(filepath_t const& filepath)
+        {
+            device_t* const device = filepath.m_dirpath.m_device;
+            if (device == nullptr)
+                return c_invalid_file;
+            node_t const  folder = filepath.m_dirpath.m_path == c_empty_node ? device->m_path : filepath.m_dirpath.m_path;
+            ifile_t const file   = device->find_file(folder, filepath.m_filename, filepath.m_extension);
+            if (file != c_invalid_file)
+                return file;
+            return device->add_file(folder, filepath.m_filename, filepath.m_extension, nfile::TypeUnknown);
+        }
+
+        // The chain is collected bottom-up in segments, a deeper path renders the segments above it first
+        static const s32 c_render_segment = 64;
+
+        void paths_t::folder_to_string(node_t to, node_t from, runes_t& out_str) const { folder_to_string(to, from, nullptr, out_str); }
+
+        void paths_t::folder_to_string(node_t to, node_t from, device_t const* device, runes_t& out_str) const
+        {
+            if (to == c_empty_node || to == c_invalid_node)
+                return;
+            node_t chain[c_render_segment];
+            s32    count = 0;
+            node_t iter  = to;
+            while (iter != from && iter != c_invalid_node && count < c_render_segment)
+            {
+                chain[count++] = iter;
+                iter           = m_folders->m_array.ptr_of(iter)->m_parent;
+            }
+            if (iter != from && iter != c_invalid_node)
+                folder_to_string(iter, from, device, out_str);
+            else if (iter == from && device != nullptr)
+                device->to_string(out_str);
+
+            crunes_t const slash = ascii::make_crunes("/");
+            for (s32 i = count - 1; i >= 0; --i)
+            {
+                folder_t const* folder = m_folders->m_array.ptr_of(chain[i]);
+                to_string(folder->m_name, out_str);
+                nrunes::concatenate(out_str, slash);
+            }
+        }
+
+        s32 paths_t::folder_to_strlen(node_t to, node_t from) const
+        {
+            s32    len  = 0;
+            node_t iter = to;
+            if (to == c_empty_node)
+                return len;
+            while (iter != from && iter != c_invalid_node)
+            {
+                folder_t const* folder = m_folders->m_array.ptr_of(iter);
+                len += m_strings->get_len(folder->m_name) + 1;
+                iter = folder->m_parent;
+            }
+            return len;
+        }
+
         s8 paths_t::compare_str(string_t left, string_t right) const { return m_strings->compare(left, right); }
         s8 paths_t::compare_str(folder_t* left, folder_t* right) const { return m_strings->compare(left->m_name, right->m_name); }
 
-        static bool s_next_folder(crunes_t& folder, char slash)
+        s8 paths_t::collate_folder(node_t left, node_t right) const
         {
-            folder.m_str = folder.m_end;
-            folder.m_end = folder.m_eos;
-            folder       = nrunes::findSelectUntilIncluded(folder, slash);
-            return !is_empty(folder);
+            if (left == right)
+                return 0;
+
+            // The empty and invalid folder come before anything else
+            bool const left_empty  = left == c_empty_node || left == c_invalid_node;
+            bool const right_empty = right == c_empty_node || right == c_invalid_node;
+            if (left_empty || right_empty)
+                return left_empty == right_empty ? 0 : (left_empty ? -1 : 1);
+
+            if (m_folders->m_collate_count == m_folders->m_count)
+                return *m_folders->m_collate.ptr_of(left) < *m_folders->m_collate.ptr_of(right) ? -1 : 1;
+
+            // Bring both to the same depth, an ancestor comes before its descendants
+            folder_t const* lf = m_folders->m_array.ptr_of(left);
+            folder_t const* rf = m_folders->m_array.ptr_of(right);
+            while (lf->m_depth > rf->m_depth && lf->m_parent != c_invalid_folder)
+            {
+                left = lf->m_parent;
+                lf   = m_folders->m_array.ptr_of(left);
+            }
+            if (left == right)
+                return 1;
+            while (rf->m_depth > lf->m_depth && rf->m_parent != c_invalid_folder)
+            {
+                right = rf->m_parent;
+                rf    = m_folders->m_array.ptr_of(right);
+            }
+            if (left == right)
+                return -1;
+
+            // Walk up until both are siblings (or device roots), their names decide the order
+            while (lf->m_parent != rf->m_parent && lf->m_parent != c_invalid_folder && rf->m_parent != c_invalid_folder)
+            {
+                left  = lf->m_parent;
+                right = rf->m_parent;
+                lf    = m_folders->m_array.ptr_of(left);
+                rf    = m_folders->m_array.ptr_of(right);
+            }
+            // Siblings compare as "name/" like the rendered path, device roots by their name
+            s8 const c = lf->m_parent == c_invalid_folder ? m_strings->collate(lf->m_name, rf->m_name) : m_strings->collate_folders(lf->m_name, rf->m_name);
+            if (c != 0)
+                return c;
+            return left < right ? -1 : 1;
+        }
+
+        // The sub folder of 'ancestor' on the way down to 'folder', c_invalid_folder when 'ancestor' is not above it
+        static node_t s_child_towards(folders_t const* folders, node_t ancestor, node_t folder)
+        {
+            u32 const depth = folders->m_array.ptr_of(ancestor)->m_depth;
+            while (folder != c_invalid_folder)
+            {
+                folder_t const* f = folders->m_array.ptr_of(folder);
+                if (f->m_depth <= depth)
+                    return c_invalid_folder;
+                if (f->m_parent == ancestor)
+                    return folder;
+                folder = f->m_parent;
+            }
+            return c_invalid_folder;
+        }
+
+        s8 paths_t::collate_file(node_t left_folder, string_t left_name, string_t left_ext, node_t right_folder, string_t right_name, string_t right_ext) const
+        {
+            if (left_folder == right_folder)
+                return m_strings->collate_files(left_name, left_ext, right_name, right_ext);
+
+            // A file in a folder above the other file compares its name with the sub folder on the way down
+            bool const left_empty  = left_folder == c_empty_node || left_folder == c_invalid_node;
+            bool const right_empty = right_folder == c_empty_node || right_folder == c_invalid_node;
+            if (!left_empty && !right_empty)
+            {
+                node_t child = s_child_towards(m_folders, left_folder, right_folder);
+                if (child != c_invalid_folder)
+                    return m_strings->collate_file_folder(left_name, left_ext, m_folders->m_array.ptr_of(child)->m_name);
+                child = s_child_towards(m_folders, right_folder, left_folder);
+                if (child != c_invalid_folder)
+                    return (s8)-m_strings->collate_file_folder(right_name, right_ext, m_folders->m_array.ptr_of(child)->m_name);
+            }
+            return collate_folder(left_folder, right_folder);
+        }
+
+        static inline bool s_collate_less(paths_t const* paths, node_t a, node_t b) { return paths->collate_folder(a, b) < 0; }
+
+        static void s_sift_down(paths_t const* paths, node_t* order, u32 root, u32 count)
+        {
+            while (true)
+            {
+                u32 child = root * 2 + 1;
+                if (child >= count)
+                    break;
+                if ((child + 1) < count && s_collate_less(paths, order[child], order[child + 1]))
+                    child += 1;
+                if (!s_collate_less(paths, order[root], order[child]))
+                    break;
+                node_t const t = order[root];
+                order[root]    = order[child];
+                order[child]   = t;
+                root           = child;
+            }
+        }
+
+        void paths_t::update_collation()
+        {
+            u32 const count            = m_folders->m_count;
+            m_folders->m_collate_count = 0; // sort with the name walk, not with stale keys
+            m_folders->m_collate.ensure_capacity(count);
+
+            // Heap sort all folders by their full path, the position in the sorted order is the key
+            node_t* order = g_allocate_array<node_t>(m_allocator, count);
+            for (u32 i = 0; i < count; ++i)
+                order[i] = i;
+            for (u32 i = count / 2; i > 0; --i)
+                s_sift_down(this, order, i - 1, count);
+            for (u32 end = count; end > 1; --end)
+            {
+                node_t const t = order[0];
+                order[0]       = order[end - 1];
+                order[end - 1] = t;
+                s_sift_down(this, order, 0, end - 1);
+            }
+
+            for (u32 i = 0; i < count; ++i)
+                *m_folders->m_collate.ptr_of(order[i]) = i;
+            g_deallocate_array(m_allocator, order);
+
+            m_folders->m_collate_count = count;
+        }
+
+        static inline bool s_is_separator(char c) { return c == '/' || c == '\\'; }
+
+        // The next component of a path, empty names (repeated separators) and "." are skipped, false at the end
+        static bool s_next_component(const char* str, u32& pos, u32 end, u32& out_begin, u32& out_len)
+        {
+            while (pos < end)
+            {
+                out_begin = pos;
+                while (pos < end && !s_is_separator(str[pos]))
+                    pos += 1;
+                out_len = pos - out_begin;
+                if (pos < end)
+                    pos += 1; // the separator
+                if (out_len > 1 || (out_len == 1 && str[out_begin] != '.'))
+                    return true;
+            }
+            return false;
+        }
+
+        static inline bool s_is_dotdot(const char* str, u32 begin, u32 len) { return len == 2 && str[begin] == '.' && str[begin + 1] == '.'; }
+
+        device_t* paths_t::root_device() { return register_device(ascii::make_crunes("")); }
+
+        device_t* paths_t::home_device()
+        {
+            idevice_t const index = m_devices->find_device(find_string(ascii::make_crunes("~")));
+            if (index != c_invalid_device)
+                return m_devices->get_device(index);
+            const char* const home = getenv("HOME");
+            if (home != nullptr && home[0] == '/')
+            {
+                device_t* device = register_alias(ascii::make_crunes("~"), register_fulldirpath(ascii::make_crunes(home)));
+                if (device != nullptr)
+                    return device;
+            }
+            return register_device(ascii::make_crunes("~"));
+        }
+
+        bool paths_t::register_prefix(crunes_t const& prefix, device_t* device)
+        {
+            ASSERT(prefix.m_type == utf8::TYPE || prefix.m_type == ascii::TYPE);
+            if (device == nullptr || device->m_index == c_default_device)
+                return false;
+
+            // The trie is not touched for a prefix with ".."
+            const char* const str = prefix.m_ascii;
+            u32               pos = prefix.m_str, begin, len;
+            while (s_next_component(str, pos, prefix.m_end, begin, len))
+            {
+                if (s_is_dotdot(str, begin, len))
+                    return false;
+            }
+
+            if (m_prefixtrie == nullptr)
+                m_prefixtrie = g_construct_prefixtrie(m_allocator, m_config);
+            u32 node = 0;
+            pos      = prefix.m_str;
+            while (s_next_component(str, pos, prefix.m_end, begin, len))
+            {
+                crunes_t name = prefix;
+                name.m_str    = begin;
+                name.m_end    = begin + len;
+                node          = g_prefixtrie_insert(m_prefixtrie, node, m_strings->insert(name));
+            }
+            m_prefixtrie->m_nodes.ptr_of(node)->m_device = device->m_index;
+            return true;
+        }
+
+        // Whether a ".." in the path after 'pos' goes above the folder the path is in at 'pos'
+        static bool s_leaves_folder(const char* str, u32 pos, u32 end)
+        {
+            s32 depth = 0;
+            u32 begin, len;
+            while (s_next_component(str, pos, end, begin, len))
+            {
+                if (!s_is_dotdot(str, begin, len))
+                    depth += 1;
+                else if (--depth < 0)
+                    return true;
+            }
+            return false;
+        }
+
+        // The device of the longest mount prefix of a POSIX path (the root device when none matches) and the
+        // position where the path continues below it. Only names that are interned can be in the trie, so a
+        // component is looked up in the strings without inserting it. A prefix that a later ".." goes above does
+        // not match, the path means the same with or without that prefix registered.
+        static device_t* s_match_prefix(paths_t* paths, crunes_t const& path, u32& out_rest)
+        {
+            device_t* device = nullptr;
+            out_rest         = path.m_str;
+            if (paths->m_prefixtrie != nullptr)
+            {
+                prefixtrie_t const* trie = paths->m_prefixtrie;
+                const char* const   str  = path.m_ascii;
+                u32                 node = 0;
+                u32                 pos  = path.m_str, begin, len;
+                if (trie->m_nodes.ptr_of(0)->m_device != c_invalid_device)
+                    device = paths->m_devices->get_device(trie->m_nodes.ptr_of(0)->m_device);
+                while (trie->m_nodes.ptr_of(node)->m_num_children > 0 && s_next_component(str, pos, path.m_end, begin, len))
+                {
+                    if (s_is_dotdot(str, begin, len))
+                        break;
+                    crunes_t name = path;
+                    name.m_str    = begin;
+                    name.m_end    = begin + len;
+                    string_t const istr = paths->find_string(name);
+                    if (istr == c_invalid_string)
+                        break;
+                    node = g_prefixtrie_child(trie, node, istr);
+                    if (node == c_invalid_prefix)
+                        break;
+                    prefixnode_t const* n = trie->m_nodes.ptr_of(node);
+                    if (n->m_device != c_invalid_device && !s_leaves_folder(str, pos, path.m_end))
+                    {
+                        device   = paths->m_devices->get_device(n->m_device);
+                        out_rest = pos;
+                    }
+                }
+            }
+            return device != nullptr ? device : paths->root_device();
         }
 
         dirpath_t paths_t::register_fulldirpath(crunes_t const& _fulldirpath)
         {
             // extract device, then init a 'crunes_t path' that contains everything after the device
-            // select the first 'folder' from this 'path' and call device->register_dirpath(folder, out_dirpath)
+            // and call device->register_dirpath(path, out_dirpath)
             crunes_t fulldirpath = _fulldirpath;
             fulldirpath.m_eos    = fulldirpath.m_end;
+            if (fulldirpath.m_str == fulldirpath.m_end)
+                return dirpath_t(this->m_devices->get_default_device());
 
-            // TODO On Windows (e.g. 'e:\') search for ':' and on Linux/Unix (e.g. '/home/') search for '/'.
-            // On MacOS the path will start with '/' and the device name will end at the next '/', paths can
-            // also start with `~/` which is the home directory of the user. We can likely support that but
-            // it will require a device called `~` that will be the home directory of the user.
+            // POSIX, "/home/x/" or "~/x/"
+            ASSERT(fulldirpath.m_type == utf8::TYPE || fulldirpath.m_type == ascii::TYPE);
+            const char* const str = fulldirpath.m_ascii;
+            char const        c0  = str[fulldirpath.m_str];
+            if (c0 == '/' || (c0 == '~' && (fulldirpath.m_str + 1 == fulldirpath.m_end || s_is_separator(str[fulldirpath.m_str + 1]))))
+            {
+                device_t* device = nullptr;
+                crunes_t  path   = fulldirpath;
+                if (c0 == '~')
+                {
+                    device      = home_device();
+                    path.m_str += 1;
+                }
+                else
+                {
+                    device = s_match_prefix(this, fulldirpath, path.m_str);
+                }
+                dirpath_t out_dirpath(device);
+                device->register_dirpath(path, out_dirpath);
+                return out_dirpath;
+            }
 
             crunes_t devicestr = nrunes::findSelectUntilIncluded(fulldirpath, ':');
 
@@ -135,24 +1045,11 @@ namespace ncore
                 return dirpath_t(this->m_devices->get_default_device());
             }
 
-            crunes_t path = nrunes::selectAfterExclude(fulldirpath, devicestr);
-            nrunes::trimLeft(path, '/');
-
-            crunes_t firstFolder = nrunes::findSelectUntilIncluded(path, '/');
-            node_t   path_node   = c_invalid_node;
-            if (!is_empty(firstFolder))
-            {
-                crunes_t folder      = firstFolder;
-                node_t   parent_node = c_invalid_node;
-                do
-                {
-                    string_t folder_pathstr = find_or_insert_string(folder);
-                    node_t   folder_node    = device->add_dir(parent_node, folder_pathstr);
-                    parent_node             = folder_node;
-                    path_node               = folder_node;
-                } while (s_next_folder(folder, '/'));
-            }
-            return dirpath_t(device, path_node);
+            // Everything after the device, normalized while it is registered
+            crunes_t  path = nrunes::selectAfterExclude(fulldirpath, devicestr);
+            dirpath_t out_dirpath(device);
+            device->register_dirpath(path, out_dirpath);
+            return out_dirpath;
         }
 
         filepath_t paths_t::register_fullfilepath(crunes_t const& fullfilepath)
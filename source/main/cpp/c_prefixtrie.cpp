@@ -0,0 +1,98 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+
+#include "cpath/private/c_prefixtrie.h"
+
+#include <string.h>
+
+namespace ncore
+{
+    namespace npath
+    {
+        static const u32 c_max_prefix_nodes = 1024 * 1024; // address space only
+
+        static inline u32 s_hash(u32 parent, string_t name, u32 mask) { return ((parent * 0x85EBCA6Bu) ^ (name * 0x9E3779B1u)) & mask; }
+
+        static void s_table_insert(prefixtrie_t* trie, u32 node)
+        {
+            prefixnode_t const* n    = trie->m_nodes.ptr_of(node);
+            u32 const           mask = trie->m_table_size - 1;
+            u32                 i    = s_hash(n->m_parent, n->m_name, mask);
+            while (*trie->m_table.ptr_of(i) != 0)
+                i = (i + 1) & mask;
+            *trie->m_table.ptr_of(i) = node + 1;
+        }
+
+        prefixtrie_t* g_construct_prefixtrie(alloc_t* allocator, varena_config_t const& config)
+        {
+            prefixtrie_t* trie = g_construct<prefixtrie_t>(allocator);
+            g_setup_vpool(trie->m_nodes, 0, c_max_prefix_nodes, config);
+            g_setup_vpool(trie->m_table, 0, (u64)c_max_prefix_nodes * 2, config);
+            trie->m_table_size = 16;
+            trie->m_table.ensure_capacity(trie->m_table_size);
+            memset(trie->m_table.ptr(), 0, trie->m_table_size * sizeof(u32));
+
+            trie->m_nodes.ensure_capacity(1);
+            prefixnode_t* root   = trie->m_nodes.ptr_of(0);
+            root->m_name         = c_invalid_string;
+            root->m_parent       = c_invalid_prefix;
+            root->m_device       = c_invalid_device;
+            root->m_num_children = 0;
+            trie->m_num_nodes    = 1;
+            return trie;
+        }
+
+        void g_destruct_prefixtrie(alloc_t* allocator, prefixtrie_t*& trie)
+        {
+            g_teardown_vpool(trie->m_nodes);
+            g_teardown_vpool(trie->m_table);
+            g_destruct(allocator, trie);
+            trie = nullptr;
+        }
+
+        u32 g_prefixtrie_child(prefixtrie_t const* trie, u32 parent, string_t name)
+        {
+            u32 const mask = trie->m_table_size - 1;
+            for (u32 i = s_hash(parent, name, mask);; i = (i + 1) & mask)
+            {
+                u32 const entry = *trie->m_table.ptr_of(i);
+                if (entry == 0)
+                    return c_invalid_prefix;
+                prefixnode_t const* n = trie->m_nodes.ptr_of(entry - 1);
+                if (n->m_parent == parent && n->m_name == name)
+                    return entry - 1;
+            }
+        }
+
+        u32 g_prefixtrie_insert(prefixtrie_t* trie, u32 parent, string_t name)
+        {
+            u32 const found = g_prefixtrie_child(trie, parent, name);
+            if (found != c_invalid_prefix)
+                return found;
+            ASSERT(trie->m_num_nodes < c_max_prefix_nodes);
+
+            // Keep the table at most half full, the nodes are re-inserted
+            if ((trie->m_num_nodes + 1) * 2 > trie->m_table_size)
+            {
+                trie->m_table_size *= 2;
+                trie->m_table.ensure_capacity(trie->m_table_size);
+                memset(trie->m_table.ptr(), 0, trie->m_table_size * sizeof(u32));
+                for (u32 i = 1; i < trie->m_num_nodes; ++i)
+                    s_table_insert(trie, i);
+            }
+
+            u32 const node = trie->m_num_nodes++;
+            trie->m_nodes.ensure_capacity(trie->m_num_nodes);
+            prefixnode_t* n   = trie->m_nodes.ptr_of(node);
+            n->m_name         = name;
+            n->m_parent       = parent;
+            n->m_device       = c_invalid_device;
+            n->m_num_children = 0;
+            trie->m_nodes.ptr_of(parent)->m_num_children += 1;
+            s_table_insert(trie, node);
+            return node;
+        }
+
+    } // namespace npath
+} // namespace ncore
@@ -0,0 +1,233 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+
+#include "cpath/c_path.h"
+#include "cpath/private/c_folders.h"
+#include "cpath/private/c_metadata.h"
+#include "cpath/private/c_rollups.h"
+
+#include <string.h>
+
+namespace ncore
+{
+    namespace npath
+    {
+        rollups_t* g_construct_rollups(alloc_t* allocator, u32 max_items, varena_config_t const& config)
+        {
+            rollups_t* r = g_construct<rollups_t>(allocator);
+            g_setup_vpool(r->m_bytes, 0, max_items, config);
+            g_setup_vpool(r->m_mtime, 0, max_items, config);
+            g_setup_vpool(r->m_files, 0, max_items, config);
+            g_setup_vpool(r->m_stale, 0, max_items, config);
+            g_setup_vpool(r->m_order, 0, max_items, config);
+            r->m_capacity = 0;
+            return r;
+        }
+
+        void g_destruct_rollups(alloc_t* allocator, rollups_t*& rollups)
+        {
+            g_teardown_vpool(rollups->m_bytes);
+            g_teardown_vpool(rollups->m_mtime);
+            g_teardown_vpool(rollups->m_files);
+            g_teardown_vpool(rollups->m_stale);
+            g_teardown_vpool(rollups->m_order);
+            g_destruct(allocator, rollups);
+            rollups = nullptr;
+        }
+
+        // New folders start empty
+        static void s_ensure_capacity(rollups_t* r, u32 count)
+        {
+            if (count <= r->m_capacity)
+                return;
+            r->m_bytes.ensure_capacity(count);
+            r->m_mtime.ensure_capacity(count);
+            r->m_files.ensure_capacity(count);
+            r->m_stale.ensure_capacity(count);
+
+            u32 const n = count - r->m_capacity;
+            memset(r->m_bytes.ptr_of(r->m_capacity), 0, n * sizeof(u64));
+            memset(r->m_mtime.ptr_of(r->m_capacity), 0, n * sizeof(s64));
+            memset(r->m_files.ptr_of(r->m_capacity), 0, n * sizeof(u32));
+            memset(r->m_stale.ptr_of(r->m_capacity), 0, n);
+            r->m_capacity = count;
+        }
+
+        void g_rollup_contribution(paths_t const* paths, ifile_t file, u64& out_size, s64& out_mtime)
+        {
+            metadata_t const* m = paths->m_metadata;
+            if (m == nullptr || file >= m->m_files.m_capacity || (*m->m_files.m_flags.ptr_of(file) & nmeta::FlagValid) == 0)
+            {
+                out_size  = 0;
+                out_mtime = 0;
+                return;
+            }
+            out_size  = *m->m_files.m_size.ptr_of(file);
+            out_mtime = *m->m_files.m_mtime.ptr_of(file);
+        }
+
+        void g_rollup_add(paths_t* paths, ifile_t file)
+        {
+            rollups_t* const r = paths->m_rollups;
+            s_ensure_capacity(r, paths->m_folders->m_count);
+
+            u64 size;
+            s64 mtime;
+            g_rollup_contribution(paths, file, size, mtime);
+            for (node_t a = paths->m_files->m_array.ptr_of(file)->m_folder; a != c_invalid_folder; a = paths->m_folders->m_array.ptr_of(a)->m_parent)
+            {
+                *r->m_bytes.ptr_of(a) += size;
+                *r->m_files.ptr_of(a) += 1;
+                if (mtime > *r->m_mtime.ptr_of(a))
+                {
+                    *r->m_mtime.ptr_of(a) = mtime; // newer than anything else, also when it was stale
+                    *r->m_stale.ptr_of(a) = 0;
+                }
+            }
+        }
+
+        void g_rollup_remove(paths_t* paths, ifile_t file)
+        {
+            rollups_t* const r = paths->m_rollups;
+            s_ensure_capacity(r, paths->m_folders->m_count);
+
+            u64 size;
+            s64 mtime;
+            g_rollup_contribution(paths, file, size, mtime);
+            for (node_t a = paths->m_files->m_array.ptr_of(file)->m_folder; a != c_invalid_folder; a = paths->m_folders->m_array.ptr_of(a)->m_parent)
+            {
+                *r->m_bytes.ptr_of(a) -= size;
+                *r->m_files.ptr_of(a) -= 1;
+                if (mtime != 0 && mtime == *r->m_mtime.ptr_of(a))
+                    *r->m_stale.ptr_of(a) = 1;
+            }
+        }
+
+        void g_rollup_change(paths_t* paths, ifile_t file, u64 old_size, s64 old_mtime)
+        {
+            rollups_t* const r = paths->m_rollups;
+            s_ensure_capacity(r, paths->m_folders->m_count);
+
+            u64 size;
+            s64 mtime;
+            g_rollup_contribution(paths, file, size, mtime);
+            for (node_t a = paths->m_files->m_array.ptr_of(file)->m_folder; a != c_invalid_folder; a = paths->m_folders->m_array.ptr_of(a)->m_parent)
+            {
+                *r->m_bytes.ptr_of(a) += size - old_size; // wraps around when the file shrinks
+                if (mtime > *r->m_mtime.ptr_of(a))
+                {
+                    *r->m_mtime.ptr_of(a) = mtime;
+                    *r->m_stale.ptr_of(a) = 0;
+                }
+                else if (mtime < old_mtime && old_mtime == *r->m_mtime.ptr_of(a))
+                {
+                    *r->m_stale.ptr_of(a) = 1;
+                }
+            }
+        }
+
+        void g_rollup_recompute(paths_t* paths)
+        {
+            rollups_t* const r     = paths->m_rollups;
+            u32 const        count = paths->m_folders->m_count;
+            s_ensure_capacity(r, count);
+            memset(r->m_bytes.ptr_of(0), 0, count * sizeof(u64));
+            memset(r->m_mtime.ptr_of(0), 0, count * sizeof(s64));
+            memset(r->m_files.ptr_of(0), 0, count * sizeof(u32));
+            memset(r->m_stale.ptr_of(0), 0, count);
+
+            // Every file into its own folder
+            for (ifile_t i = 1; i < paths->m_files->m_count; ++i)
+            {
+                file_t const* f = paths->m_files->m_array.ptr_of(i);
+                if ((f->m_flags & nfile::FlagDeleted) != 0)
+                    continue;
+                u64 size;
+                s64 mtime;
+                g_rollup_contribution(paths, i, size, mtime);
+                *r->m_bytes.ptr_of(f->m_folder) += size;
+                *r->m_files.ptr_of(f->m_folder) += 1;
+                if (mtime > *r->m_mtime.ptr_of(f->m_folder))
+                    *r->m_mtime.ptr_of(f->m_folder) = mtime;
+            }
+
+            // A folder is allocated after its parent, so in reverse order every folder is complete before it is
+            // added to its parent
+            for (u32 i = count; i > 0; --i)
+            {
+                node_t const node   = i - 1;
+                node_t const parent = paths->m_folders->m_array.ptr_of(node)->m_parent;
+                if (parent == c_invalid_folder)
+                    continue;
+                ASSERT(parent < node);
+                *r->m_bytes.ptr_of(parent) += *r->m_bytes.ptr_of(node);
+                *r->m_files.ptr_of(parent) += *r->m_files.ptr_of(node);
+                if (*r->m_mtime.ptr_of(node) > *r->m_mtime.ptr_of(parent))
+                    *r->m_mtime.ptr_of(parent) = *r->m_mtime.ptr_of(node);
+            }
+        }
+
+        // The newest mtime of a stale folder from its files and sub folders, sub folders that are stale themselves
+        // are rebuilt first (the other ones are exact). The stale folders are listed breadth first, so in reverse
+        // every sub folder is done before its parent.
+        static void s_rebuild_mtime(paths_t* paths, node_t node)
+        {
+            rollups_t* const r     = paths->m_rollups;
+            u32              count = 0;
+            r->m_order.ensure_capacity(count);
+            *r->m_order.ptr_of(count++) = node;
+            for (u32 i = 0; i < count; ++i)
+            {
+                for (node_t child = paths->m_folders->m_array.ptr_of(*r->m_order.ptr_of(i))->m_child; child != c_invalid_folder;)
+                {
+                    if (*r->m_stale.ptr_of(child))
+                    {
+                        r->m_order.ensure_capacity(count);
+                        *r->m_order.ptr_of(count++) = child;
+                    }
+                    child = paths->m_folders->m_array.ptr_of(child)->m_sibling;
+                }
+            }
+
+            while (count > 0)
+            {
+                node_t const    stale  = *r->m_order.ptr_of(--count);
+                folder_t const* folder = paths->m_folders->m_array.ptr_of(stale);
+                s64             newest = 0;
+                for (ifile_t file = folder->m_file; file != c_invalid_file;)
+                {
+                    file_t const* f = paths->m_files->m_array.ptr_of(file);
+                    if ((f->m_flags & nfile::FlagDeleted) == 0)
+                    {
+                        u64 size;
+                        s64 mtime;
+                        g_rollup_contribution(paths, file, size, mtime);
+                        newest = mtime > newest ? mtime : newest;
+                    }
+                    file = f->m_sibling;
+                }
+                for (node_t child = folder->m_child; child != c_invalid_folder;)
+                {
+                    s64 const mtime = *r->m_mtime.ptr_of(child);
+                    newest          = mtime > newest ? mtime : newest;
+                    child           = paths->m_folders->m_array.ptr_of(child)->m_sibling;
+                }
+                *r->m_mtime.ptr_of(stale) = newest;
+                *r->m_stale.ptr_of(stale) = 0;
+            }
+        }
+
+        void g_rollup_get(paths_t* paths, node_t folder, u64& out_bytes, u32& out_files, s64& out_mtime)
+        {
+            rollups_t* const r = paths->m_rollups;
+            s_ensure_capacity(r, paths->m_folders->m_count);
+            if (*r->m_stale.ptr_of(folder))
+                s_rebuild_mtime(paths, folder);
+            out_bytes = *r->m_bytes.ptr_of(folder);
+            out_files = *r->m_files.ptr_of(folder);
+            out_mtime = *r->m_mtime.ptr_of(folder);
+        }
+
+    } // namespace npath
+} // namespace ncore
@@ -0,0 +1,703 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+#include "cbase/c_runes.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_device.h"
+#include "cpath/c_scanner.h"
+#include "cpath/c_instrument.h"
+#include "cpath/private/c_extindex.h"
+#include "cpath/private/c_folders.h"
+#include "cpath/private/c_hashes.h"
+#include "cpath/private/c_metadata.h"
+#include "cpath/private/c_rollups.h"
+#include "cpath/private/c_fingerprints.h"
+#include "cpath/private/c_unions.h"
+#include "cpath/private/c_strings.h"
+#include "cpath/private/c_threads.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#if defined(TARGET_LINUX) || defined(TARGET_MAC)
+#    define CPATH_SCANNER_POSIX
+#    include <dirent.h>
+#    include <errno.h>
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#    if defined(TARGET_LINUX)
+#        include <sys/syscall.h>
+#    endif
+#endif
+
+namespace ncore
+{
+    namespace npath
+    {
+        const scan_config_t g_default_scan_config = {0, 0};
+
+#if defined(CPATH_SCANNER_POSIX)
+
+        // Same layout as the kernel's linux_dirent64, on other platforms we fill it from readdir
+        struct dirent_t
+        {
+            u64  m_ino;
+            s64  m_off;
+            u16  m_reclen;
+            u8   m_type;
+            char m_name[1];
+        };
+
+        static const u32 c_dirent_buffer_size = 64 * 1024;
+        static const u32 c_max_name_len       = 255;
+        static const u32 c_invalid_handle     = 0xFFFFFFFF;
+
+        // An open directory, shared by the sub folders that still have to be opened relative to it
+        struct handle_t
+        {
+            s32 m_fd;
+            u32 m_refs; // the folder itself + its queued sub folders
+        };
+
+        struct task_t
+        {
+            u32    m_parent; // handle of the parent directory, c_invalid_handle for the scan root
+            node_t m_node;   // registered folder
+            u32    m_depth;  // levels below the scan root
+            u32    m_len;    // length of m_name
+            char   m_name[c_max_name_len + 1];
+        };
+
+        struct worker_stats_t
+        {
+            scan_stats_t m_stats;
+            u8           m_padding[64 - (sizeof(scan_stats_t) & 63)];
+        };
+
+        struct scan_t
+        {
+            paths_t*          m_paths;
+            device_t*         m_device;
+            const char*       m_ospath;
+            u32               m_max_depth;
+            mutex_t           m_lock; // registry, handles
+            vpool_t<handle_t> m_handles;
+            u32               m_num_handles;
+            u32               m_free_handle; // free list, linked through m_fd
+            u8*               m_buffers;     // per worker dirent buffer
+            worker_stats_t*   m_stats;       // per worker
+        };
+
+        // --------------------------------------------------------------------------------------------------------------
+        // handles, all calls are made while holding the scan lock
+
+        static u32 s_alloc_handle(scan_t* scan, s32 fd)
+        {
+            u32 index = scan->m_free_handle;
+            if (index != c_invalid_handle)
+            {
+                scan->m_free_handle = (u32)scan->m_handles.ptr_of(index)->m_fd;
+            }
+            else
+            {
+                index = scan->m_num_handles++;
+                scan->m_handles.ensure_capacity(index);
+            }
+            handle_t* handle = scan->m_handles.ptr_of(index);
+            handle->m_fd     = fd;
+            handle->m_refs   = 1;
+            return index;
+        }
+
+        static void s_release_handle(scan_t* scan, u32 index)
+        {
+            handle_t* handle = scan->m_handles.ptr_of(index);
+            if (--handle->m_refs == 0)
+            {
+                ::close(handle->m_fd);
+                handle->m_fd        = (s32)scan->m_free_handle;
+                scan->m_free_handle = index;
+            }
+        }
+
+        // --------------------------------------------------------------------------------------------------------------
+        // reading a directory
+
+#    if defined(TARGET_LINUX)
+        struct reader_t
+        {
+            s32 m_fd;
+        };
+
+        static void s_reader_open(reader_t& reader, s32 fd) { reader.m_fd = fd; }
+        static void s_reader_close(reader_t&) {}
+        static s32  s_reader_read(reader_t& reader, u8* buffer, u32 size) { return (s32)::syscall(SYS_getdents64, reader.m_fd, buffer, size); }
+#    else
+        struct reader_t
+        {
+            DIR* m_dir;
+        };
+
+        // readdir consumes the descriptor, so it works on a duplicate, the original stays usable for openat
+        static void s_reader_open(reader_t& reader, s32 fd)
+        {
+            s32 const dup_fd = ::dup(fd);
+            reader.m_dir     = dup_fd >= 0 ? ::fdopendir(dup_fd) : nullptr;
+            if (reader.m_dir == nullptr && dup_fd >= 0)
+                ::close(dup_fd);
+        }
+
+        static void s_reader_close(reader_t& reader)
+        {
+            if (reader.m_dir != nullptr)
+                ::closedir(reader.m_dir);
+        }
+
+        static s32 s_reader_read(reader_t& reader, u8* buffer, u32 size)
+        {
+            if (reader.m_dir == nullptr)
+                return -1;
+            u32 used = 0;
+            while (true)
+            {
+                long const     pos   = ::telldir(reader.m_dir);
+                struct dirent* entry = ::readdir(reader.m_dir);
+                if (entry == nullptr)
+                    break;
+                u32 const len    = (u32)strlen(entry->d_name);
+                u32 const reclen = (u32)((offsetof(dirent_t, m_name) + len + 1 + 7) & ~7);
+                if ((used + reclen) > size)
+                {
+                    ::seekdir(reader.m_dir, pos); // doesn't fit, next batch
+                    break;
+                }
+                dirent_t* out = (dirent_t*)(buffer + used);
+                out->m_ino    = (u64)entry->d_ino;
+                out->m_off    = 0;
+                out->m_reclen = (u16)reclen;
+                out->m_type   = entry->d_type;
+                memcpy(out->m_name, entry->d_name, len + 1);
+                used += reclen;
+            }
+            return (s32)used;
+        }
+#    endif
+
+        static inline bool s_is_dot(const char* name) { return name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0)); }
+
+        // --------------------------------------------------------------------------------------------------------------
+        // work
+
+        // Open the folder of a task relative to its parent, returns the descriptor and its handle
+        static s32 s_open_folder(scan_t* scan, task_t const* task, u32& out_handle)
+        {
+            s32 fd;
+            if (task->m_parent == c_invalid_handle)
+            {
+                fd = ::open(scan->m_ospath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            }
+            else
+            {
+                s32 const parent_fd = scan->m_handles.ptr_of(task->m_parent)->m_fd;
+                fd                  = ::openat(parent_fd, task->m_name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+                lock_t lock(scan->m_lock);
+                s_release_handle(scan, task->m_parent);
+            }
+
+            if (fd >= 0)
+            {
+                lock_t lock(scan->m_lock);
+                out_handle = s_alloc_handle(scan, fd);
+            }
+            return fd;
+        }
+
+        static void s_scan_folder(workpool_t* pool, u32 worker, void* item, void* user)
+        {
+            scan_t* const       scan  = (scan_t*)user;
+            task_t const* const task  = (task_t const*)item;
+            scan_stats_t&       stats = scan->m_stats[worker].m_stats;
+
+            u32       handle;
+            s32 const fd = s_open_folder(scan, task, handle);
+            if (fd < 0)
+            {
+                stats.m_errors += 1;
+                return;
+            }
+            stats.m_folders += 1;
+
+            bool const descend = scan->m_max_depth == 0 || task->m_depth < scan->m_max_depth;
+            u8* const  buffer  = scan->m_buffers + worker * c_dirent_buffer_size;
+            reader_t   reader;
+            s_reader_open(reader, fd);
+            while (true)
+            {
+                s32 const size = s_reader_read(reader, buffer, c_dirent_buffer_size);
+                if (size <= 0)
+                {
+                    if (size < 0)
+                        stats.m_errors += 1;
+                    break;
+                }
+
+                // Resolve missing types outside of the lock
+                for (s32 offset = 0; offset < size;)
+                {
+                    dirent_t* entry = (dirent_t*)(buffer + offset);
+                    offset += entry->m_reclen;
+                    if (entry->m_type == DT_UNKNOWN && !s_is_dot(entry->m_name))
+                    {
+                        struct stat st;
+                        stats.m_stats += 1;
+                        if (::fstatat(fd, entry->m_name, &st, AT_SYMLINK_NOFOLLOW) == 0)
+                            entry->m_type = S_ISDIR(st.st_mode) ? DT_DIR : (S_ISREG(st.st_mode) ? DT_REG : (S_ISLNK(st.st_mode) ? DT_LNK : DT_FIFO));
+                    }
+                }
+
+                CPATH_SCOPE("scanner_t::register");
+                lock_t lock(scan->m_lock);
+                for (s32 offset = 0; offset < size;)
+                {
+                    dirent_t const* entry = (dirent_t const*)(buffer + offset);
+                    offset += entry->m_reclen;
+                    if (s_is_dot(entry->m_name))
+                        continue;
+
+                    u32 const      len  = (u32)strlen(entry->m_name);
+                    crunes_t const name = utf8::make_crunes((utf8::pcrune)entry->m_name, 0, len, len);
+                    if (entry->m_type == DT_DIR)
+                    {
+                        string_t const folder_name = scan->m_paths->find_or_insert_string(name);
+                        node_t const   folder_node = scan->m_device->add_dir(task->m_node, folder_name);
+                        scan->m_paths->m_folders->m_array.ptr_of(folder_node)->m_flags &= ~nfolder::FlagDeleted; // it is on disk
+                        if (descend && len <= c_max_name_len)
+                        {
+                            task_t sub;
+                            sub.m_parent = handle;
+                            sub.m_node   = folder_node;
+                            sub.m_depth  = task->m_depth + 1;
+                            sub.m_len    = len;
+                            memcpy(sub.m_name, entry->m_name, len + 1);
+                            scan->m_handles.ptr_of(handle)->m_refs += 1;
+                            g_push_work(pool, worker, &sub);
+                        }
+                    }
+                    else
+                    {
+                        u8 type = nfile::TypeOther;
+                        if (entry->m_type == DT_REG)
+                        {
+                            type = nfile::TypeRegular;
+                            stats.m_files += 1;
+                        }
+                        else if (entry->m_type == DT_LNK)
+                        {
+                            type = nfile::TypeSymlink;
+                            stats.m_symlinks += 1;
+                        }
+                        else
+                        {
+                            stats.m_others += 1;
+                        }
+
+                        string_t filename, extension;
+                        scan->m_paths->register_filename(name, filename, extension);
+                        ifile_t const file = scan->m_device->add_file(task->m_node, filename, extension, type);
+                        g_set_file_deleted(scan->m_paths, file, false);
+                    }
+                }
+            }
+            s_reader_close(reader);
+
+            lock_t lock(scan->m_lock);
+            s_release_handle(scan, handle);
+        }
+
+        static inline s64 s_mtime_ns(struct stat const& st)
+        {
+#    if defined(TARGET_MAC)
+            return (s64)st.st_mtimespec.tv_sec * 1000000000 + (s64)st.st_mtimespec.tv_nsec;
+#    else
+            return (s64)st.st_mtim.tv_sec * 1000000000 + (s64)st.st_mtim.tv_nsec;
+#    endif
+        }
+
+        static inline void s_to_filestat(struct stat const& st, filestat_t& out)
+        {
+            out.m_size     = (u64)st.st_size;
+            out.m_mtime_ns = s_mtime_ns(st);
+            out.m_inode    = (u64)st.st_ino;
+            out.m_device   = (u64)st.st_dev;
+            out.m_mode     = (u32)st.st_mode;
+            out.m_flags    = 0;
+        }
+
+        // The on-disk name of a registered file, false when it is too long
+        static bool s_file_name(paths_t const* paths, file_t const* f, char* name)
+        {
+            crunes_t filename, extension;
+            paths->m_strings->view_string(f->m_filename, filename);
+            paths->m_strings->view_string(f->m_extension, extension);
+            u32 const name_len = filename.m_end - filename.m_str;
+            u32 const ext_len  = f->m_extension != c_empty_string ? extension.m_end - extension.m_str : 0;
+            if ((name_len + ext_len) > c_max_name_len)
+                return false;
+            memcpy(name, filename.m_ascii + filename.m_str, name_len);
+            memcpy(name + name_len, extension.m_ascii + extension.m_str, ext_len);
+            name[name_len + ext_len] = 0;
+            return true;
+        }
+
+        // Queue the registered sub folders of a task (stat and hash passes walk the registry, not the disk)
+        static void s_push_registered_children(workpool_t* pool, u32 worker, scan_t* scan, task_t const* task, u32 handle)
+        {
+            if (scan->m_max_depth != 0 && task->m_depth >= scan->m_max_depth)
+                return;
+
+            paths_t* const  paths  = scan->m_paths;
+            folder_t const* folder = paths->m_folders->m_array.ptr_of(task->m_node);
+            for (node_t child = folder->m_child; child != c_invalid_folder;)
+            {
+                folder_t const* c = paths->m_folders->m_array.ptr_of(child);
+                crunes_t        child_name;
+                paths->m_strings->view_string(c->m_name, child_name);
+                u32 const len = child_name.m_end - child_name.m_str;
+                if (len <= c_max_name_len)
+                {
+                    task_t sub;
+                    sub.m_parent = handle;
+                    sub.m_node   = child;
+                    sub.m_depth  = task->m_depth + 1;
+                    sub.m_len    = len;
+                    memcpy(sub.m_name, child_name.m_ascii + child_name.m_str, len);
+                    sub.m_name[len] = 0;
+                    {
+                        lock_t lock(scan->m_lock);
+                        scan->m_handles.ptr_of(handle)->m_refs += 1;
+                    }
+                    g_push_work(pool, worker, &sub);
+                }
+                child = c->m_sibling;
+            }
+        }
+
+        // Stat pass over the registered sub tree, the registry is only read (no lock), every node is
+        // written by exactly one worker and the metadata columns are sized before the pass starts.
+        static void s_stat_folder(workpool_t* pool, u32 worker, void* item, void* user)
+        {
+            scan_t* const       scan     = (scan_t*)user;
+            task_t const* const task     = (task_t const*)item;
+            scan_stats_t&       stats    = scan->m_stats[worker].m_stats;
+            paths_t* const      paths    = scan->m_paths;
+            metadata_t* const   metadata = paths->m_metadata;
+
+            u32       handle;
+            s32 const fd = s_open_folder(scan, task, handle);
+            if (fd < 0)
+            {
+                stats.m_errors += 1;
+                g_set_metadata_missing(metadata->m_folders, task->m_node);
+                return;
+            }
+            stats.m_folders += 1;
+
+            struct stat st;
+            filestat_t  fs;
+            if (::fstat(fd, &st) == 0)
+            {
+                s_to_filestat(st, fs);
+                g_set_metadata(metadata->m_folders, task->m_node, fs);
+            }
+
+            folder_t const* folder = paths->m_folders->m_array.ptr_of(task->m_node);
+            char            name[c_max_name_len + 1];
+            for (ifile_t file = folder->m_file; file != c_invalid_file;)
+            {
+                file_t const* f = paths->m_files->m_array.ptr_of(file);
+                if (s_file_name(paths, f, name))
+                {
+                    stats.m_stats += 1;
+                    if (::fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0)
+                    {
+                        s_to_filestat(st, fs);
+                        g_set_metadata(metadata->m_files, file, fs);
+                        if (S_ISREG(st.st_mode))
+                            stats.m_files += 1;
+                        else if (S_ISLNK(st.st_mode))
+                            stats.m_symlinks += 1;
+                        else
+                            stats.m_others += 1;
+                        if ((*metadata->m_files.m_flags.ptr_of(file) & nmeta::FlagChanged) != 0)
+                            stats.m_changed += 1;
+                    }
+                    else
+                    {
+                        g_set_metadata_missing(metadata->m_files, file);
+                        stats.m_missing += 1;
+                    }
+                }
+                file = f->m_sibling;
+            }
+
+            s_push_registered_children(pool, worker, scan, task, handle);
+
+            lock_t lock(scan->m_lock);
+            s_release_handle(scan, handle);
+        }
+
+        static const u64 c_map_threshold = 64 * 1024; // larger files are mapped, smaller ones are read into the worker buffer
+
+        // Hash pass over the registered sub tree, like the stat pass every file node is written by one worker and
+        // the hash columns are sized before the pass starts. Only files without a valid hash for their current
+        // size and mtime are read.
+        static void s_hash_folder(workpool_t* pool, u32 worker, void* item, void* user)
+        {
+            scan_t* const       scan   = (scan_t*)user;
+            task_t const* const task   = (task_t const*)item;
+            scan_stats_t&       stats  = scan->m_stats[worker].m_stats;
+            paths_t* const      paths  = scan->m_paths;
+            hashes_t* const     hashes = paths->m_hashes;
+            u8* const           buffer = scan->m_buffers + (u64)worker * c_dirent_buffer_size;
+
+            u32       handle;
+            s32 const fd = s_open_folder(scan, task, handle);
+            if (fd < 0)
+            {
+                stats.m_errors += 1;
+                return;
+            }
+            stats.m_folders += 1;
+
+            folder_t const* folder = paths->m_folders->m_array.ptr_of(task->m_node);
+            char            name[c_max_name_len + 1];
+            for (ifile_t file = folder->m_file; file != c_invalid_file;)
+            {
+                file_t const* f = paths->m_files->m_array.ptr_of(file);
+                file            = f->m_sibling;
+                if (!s_file_name(paths, f, name))
+                    continue;
+
+                // A file that is unchanged since it was hashed costs one fstatat
+                struct stat st;
+                stats.m_stats += 1;
+                if (::fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+                {
+                    stats.m_missing += 1;
+                    continue;
+                }
+                if (!S_ISREG(st.st_mode))
+                {
+                    stats.m_others += 1;
+                    continue;
+                }
+                stats.m_files += 1;
+
+                ifile_t const index = paths->m_files->m_array.idx_of(f);
+                u8* const     flags = hashes->m_flags.ptr_of(index);
+                if ((*flags & nmeta::FlagValid) != 0 && *hashes->m_size.ptr_of(index) == (u64)st.st_size && *hashes->m_mtime.ptr_of(index) == s_mtime_ns(st))
+                    continue;
+
+                // The size and mtime recorded with the hash are the ones of the opened file
+                s32 const ffd = ::openat(fd, name, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+                if (ffd < 0 || ::fstat(ffd, &st) != 0)
+                {
+                    if (ffd >= 0)
+                        ::close(ffd);
+                    stats.m_errors += 1;
+                    continue;
+                }
+                u64 const size  = (u64)st.st_size;
+                s64 const mtime = s_mtime_ns(st);
+
+                contenthash_t hash;
+                bool          hashed = false;
+                if (size <= c_map_threshold)
+                {
+                    u64 done = 0;
+                    while (done < size)
+                    {
+                        ssize_t const n = ::pread(ffd, buffer + done, (size_t)(size - done), (off_t)done);
+                        if (n <= 0)
+                            break;
+                        done += (u64)n;
+                    }
+                    if (done == size)
+                    {
+                        g_hash128(buffer, size, hash);
+                        hashed = true;
+                    }
+                }
+                else
+                {
+                    void* data = ::mmap(nullptr, (size_t)size, PROT_READ, MAP_PRIVATE, ffd, 0);
+                    if (data != MAP_FAILED)
+                    {
+                        ::madvise(data, (size_t)size, MADV_SEQUENTIAL);
+                        g_hash128(data, size, hash);
+                        ::munmap(data, (size_t)size);
+                        hashed = true;
+                    }
+                }
+                ::close(ffd);
+
+                if (!hashed)
+                {
+                    stats.m_errors += 1;
+                    continue;
+                }
+                g_set_hash(hashes, index, size, mtime, hash);
+                stats.m_hashed += 1;
+                if ((*flags & nmeta::FlagChanged) != 0)
+                    stats.m_changed += 1;
+            }
+
+            s_push_registered_children(pool, worker, scan, task, handle);
+
+            lock_t lock(scan->m_lock);
+            s_release_handle(scan, handle);
+        }
+
+        static bool s_run(device_t* device, node_t node, const char* ospath, scan_config_t const& config, scan_stats_t& out_stats, work_fn fn)
+        {
+            memset(&out_stats, 0, sizeof(out_stats));
+            if (device == nullptr)
+                return false;
+
+            // The scan root must exist, this also gives a proper answer for the caller
+            s32 const root_fd = ::open(ospath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (root_fd < 0)
+                return false;
+            ::close(root_fd);
+
+            paths_t* const paths = device->m_owner;
+            alloc_t* const alloc = paths->m_allocator;
+
+            u32 const workers = config.m_num_threads != 0 ? config.m_num_threads : g_hardware_threads();
+
+            scan_t scan;
+            scan.m_paths       = paths;
+            scan.m_device      = device;
+            scan.m_ospath      = ospath;
+            scan.m_max_depth   = config.m_max_depth;
+            scan.m_num_handles = 0;
+            scan.m_free_handle = c_invalid_handle;
+            scan.m_buffers     = fn != s_stat_folder ? g_allocate_array<u8>(alloc, workers * c_dirent_buffer_size) : nullptr;
+            scan.m_stats       = g_allocate_array<worker_stats_t>(alloc, workers);
+            memset(scan.m_stats, 0, workers * sizeof(worker_stats_t));
+            scan.m_lock.init();
+            g_setup_vpool(scan.m_handles, 0, 1024 * 1024);
+
+            workpool_t* pool = g_construct_workpool(alloc, workers, sizeof(task_t), 16 * 1024 * 1024, fn, &scan);
+
+            task_t task;
+            task.m_parent  = c_invalid_handle;
+            task.m_node    = (node == c_empty_node || node == c_invalid_node) ? device->m_path : node;
+            task.m_depth   = 0;
+            task.m_len     = 0;
+            task.m_name[0] = 0;
+            g_push_work(pool, 0, &task);
+            g_run_workpool(pool);
+
+            for (u32 i = 0; i < g_num_workers(pool); ++i)
+            {
+                scan_stats_t const& s = scan.m_stats[i].m_stats;
+                out_stats.m_folders += s.m_folders;
+                out_stats.m_files += s.m_files;
+                out_stats.m_symlinks += s.m_symlinks;
+                out_stats.m_others += s.m_others;
+                out_stats.m_stats += s.m_stats;
+                out_stats.m_errors += s.m_errors;
+                out_stats.m_changed += s.m_changed;
+                out_stats.m_missing += s.m_missing;
+                out_stats.m_hashed += s.m_hashed;
+            }
+
+            // The workers changed folders, metadata or hashes all over the sub tree
+            if (paths->m_fingerprints != nullptr)
+                g_fingerprint_invalidate(paths);
+            if (paths->m_unions != nullptr)
+                g_unions_invalidate(paths);
+
+            g_destruct_workpool(alloc, pool);
+            if (scan.m_buffers != nullptr)
+                g_deallocate_array(alloc, scan.m_buffers);
+            g_deallocate_array(alloc, scan.m_stats);
+            g_teardown_vpool(scan.m_handles);
+            scan.m_lock.exit();
+            return true;
+        }
+
+        bool scanner_t::scan(dirpath_t const& root, const char* ospath, scan_config_t const& config, scan_stats_t& out_stats) { return s_run(root.m_device, root.m_path, ospath, config, out_stats, s_scan_folder); }
+
+        bool scanner_t::stat(dirpath_t const& root, const char* ospath, scan_config_t const& config, scan_stats_t& out_stats)
+        {
+            memset(&out_stats, 0, sizeof(out_stats));
+            if (root.m_device == nullptr)
+                return false;
+
+            paths_t* const paths = root.m_device->m_owner;
+            paths->enable_metadata();
+            g_ensure_metadata_capacity(paths->m_metadata->m_folders, paths->m_folders->m_count);
+            g_ensure_metadata_capacity(paths->m_metadata->m_files, paths->m_files->m_count);
+
+            // Clear the changed flags of the previous pass, the sweep afterwards only reports this pass
+            u8* const folder_flags = paths->m_metadata->m_folders.m_flags.ptr_of(0);
+            for (u32 i = 0; i < paths->m_metadata->m_folders.m_capacity; ++i)
+                folder_flags[i] &= ~nmeta::FlagChanged;
+            u8* const file_flags = paths->m_metadata->m_files.m_flags.ptr_of(0);
+            for (u32 i = 0; i < paths->m_metadata->m_files.m_capacity; ++i)
+                file_flags[i] &= ~nmeta::FlagChanged;
+
+            // The workers write the metadata columns in parallel, the rollups are recomputed once afterwards
+            bool const ok = s_run(root.m_device, root.m_path, ospath, config, out_stats, s_stat_folder);
+            if (paths->m_rollups != nullptr)
+                g_rollup_recompute(paths);
+            return ok;
+        }
+
+        bool scanner_t::hash(dirpath_t const& root, const char* ospath, scan_config_t const& config, scan_stats_t& out_stats)
+        {
+            memset(&out_stats, 0, sizeof(out_stats));
+            if (root.m_device == nullptr)
+                return false;
+
+            paths_t* const paths = root.m_device->m_owner;
+            paths->enable_hashes();
+            g_ensure_hashes_capacity(paths->m_hashes, paths->m_files->m_count);
+
+            u8* const flags = paths->m_hashes->m_flags.ptr_of(0);
+            for (u32 i = 0; i < paths->m_hashes->m_capacity; ++i)
+                flags[i] &= ~nmeta::FlagChanged;
+
+            return s_run(root.m_device, root.m_path, ospath, config, out_stats, s_hash_folder);
+        }
+
+#else
+
+        bool scanner_t::scan(dirpath_t const& root, const char* ospath, scan_config_t const& config, scan_stats_t& out_stats)
+        {
+            memset(&out_stats, 0, sizeof(out_stats));
+            return false;
+        }
+
+        bool scanner_t::stat(dirpath_t const& root, const char* ospath, scan_config_t const& config, scan_stats_t& out_stats)
+        {
+            memset(&out_stats, 0, sizeof(out_stats));
+            return false;
+        }
+
+        bool scanner_t::hash(dirpath_t const& root, const char* ospath, scan_config_t const& config, scan_stats_t& out_stats)
+        {
+            memset(&out_stats, 0, sizeof(out_stats));
+            return false;
+        }
+
+#endif
+
+    } // namespace npath
+} // namespace ncore
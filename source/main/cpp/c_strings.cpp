@@ -9,6 +9,7 @@
 #include "cpath/private/c_strings.h"
 #include "cpath/private/c_memory.h"
 #include "cpath/c_path.h"
+#include "cpath/c_instrument.h"
 
 namespace ncore
 {
@@ -31,7 +32,9 @@ namespace ncore
         {
             g_init_arena(m->m_data_buffer);
             g_init_arena(m->m_str_buffer);
+            g_init_arena(m->m_node_array);
             m->m_data_ptr = nullptr;
+            m->m_size     = 0;
             m->m_str_root = c_invalid_node;
             ntree32::g_init(m->m_str_tree);
         }
@@ -41,17 +44,17 @@ namespace ncore
 
         strings_t::strings_t() : m_data() {}
 
-        strings_t* g_construct_strings(alloc_t* allocator, u64 max_items)
+        strings_t* g_construct_strings(alloc_t* allocator, u64 max_items, varena_config_t const& config)
         {
             strings_t* strings = g_construct<strings_t>(allocator);
             strings->m_data    = g_construct<strings_t::members_t>(allocator);
             s_init_members(strings->m_data);
 
-            g_init_arena(strings->m_data->m_data_buffer, 8192, max_items, sizeof(u8));
-            g_init_arena(strings->m_data->m_str_buffer, 8192, max_items, sizeof(strings_t::str_t));
+            g_init_arena(strings->m_data->m_data_buffer, 8192, max_items, sizeof(u8), config);
+            g_init_arena(strings->m_data->m_str_buffer, 8192, max_items, sizeof(strings_t::str_t), config);
 
             const s32 c_extra_size = 2;
-            g_init_arena(strings->m_data->m_node_array, 8192, max_items + c_extra_size, sizeof(ntree32::nnode_t));
+            g_init_arena(strings->m_data->m_node_array, 8192, max_items + c_extra_size, sizeof(ntree32::nnode_t), config);
             ntree32::setup_tree(strings->m_data->m_str_tree, (ntree32::nnode_t*)strings->m_data->m_node_array.m_ptr);
 
             strings->m_data->m_data_ptr = strings->m_data->m_data_buffer.m_ptr;
@@ -76,6 +79,7 @@ namespace ncore
 
         static s8 s_compare_str_to_node(u32 const _str, u32 const _node, void const* user_data)
         {
+            CPATH_COUNT(StringCompare);
             strings_t const*        strings  = (strings_t const*)user_data;
             strings_t::str_t const* str      = strings->index_to_object(_str);
             strings_t::str_t const* node_str = strings->index_to_object(_node);
@@ -84,6 +88,8 @@ namespace ncore
 
         string_t strings_t::find(crunes_t const& _str)
         {
+            CPATH_COUNT(StringFind);
+            CPATH_SCOPE("strings_t::find");
             ASSERT(_str.m_type == utf8::TYPE || _str.m_type == ascii::TYPE);
             const char* str8 = _str.m_ascii + _str.m_str;
             const char* src8 = str8;
@@ -92,8 +98,9 @@ namespace ncore
             char*       dst8 = dst;
             while (src8 < end8)
                 *dst8++ = *src8++;
-            *dst = 0;
+            *dst8 = 0;
 
+            m_data->m_str_buffer.ensure_capacity(s_find_slot(m_data), sizeof(str_t));
             str_t* const str = (str_t*)m_data->m_str_buffer.ptr_of(s_find_slot(m_data), sizeof(str_t));
             str->m_str       = dst;
             str->m_hash      = nhash::strhash32((const char*)str8, (const char*)end8);
@@ -107,6 +114,8 @@ namespace ncore
 
         string_t strings_t::insert(crunes_t const& _str)
         {
+            CPATH_COUNT(StringInsert);
+            CPATH_SCOPE("strings_t::insert");
             ASSERT(_str.m_type == utf8::TYPE || _str.m_type == ascii::TYPE);
             const char* str8 = _str.m_ascii + _str.m_str;
             const char* src8 = str8;
@@ -115,7 +124,11 @@ namespace ncore
             char*       dst8 = dst;
             while (src8 < end8)
                 *dst8++ = *src8++;
-            *dst = 0;
+            *dst8 = 0;
+
+            // The tree writes into the temp slot during the insert, so both arrays need to hold it
+            m_data->m_str_buffer.ensure_capacity(s_temp_slot(m_data), sizeof(str_t));
+            m_data->m_node_array.ensure_capacity(s_temp_slot(m_data), sizeof(ntree32::nnode_t));
 
             str_t* const str = (str_t*)m_data->m_str_buffer.ptr_of(s_find_slot(m_data), sizeof(str_t));
             str->m_str       = dst;
@@ -123,14 +136,16 @@ namespace ncore
             str->m_len       = (end8 - str8);
             u32 const istr   = m_data->m_str_buffer.idx_of((u8 const*)str, sizeof(str_t));
 
-            // TODO, check if we need to grow m_str_buffer
-
             node_t inserted_or_found;
             if (ntree32::insert(m_data->m_str_tree, m_data->m_str_root, s_temp_slot(m_data), istr, s_compare_str_to_node, this, inserted_or_found))
             {
-                m_data->m_str_buffer.ensure_capacity(inserted_or_found);
+                m_data->m_str_buffer.ensure_capacity(inserted_or_found, sizeof(str_t));
                 str_t* dstr = index_to_object(inserted_or_found);
                 *dstr       = *str;
+
+                // The probe bytes become the string data, move the cursor past them and the terminator
+                m_data->m_data_ptr = (u8*)dst8 + 1;
+                m_data->m_size += 1;
             }
 
             return inserted_or_found;
@@ -163,6 +178,7 @@ namespace ncore
 
         s8 strings_t::compare_str(u32 const find_item, u32 const node_item, void const* user_data)
         {
+            CPATH_COUNT(StringCompare);
             strings_t const*        strings  = (strings_t const*)user_data;
             strings_t::str_t const* find_str = strings->index_to_object(find_item);
             strings_t::str_t const* node_str = strings->index_to_object(node_item);
@@ -171,6 +187,22 @@ namespace ncore
 
         u32 strings_t::get_len(string_t index) const { return index_to_object(index)->m_len; }
 
+        void strings_t::get_stats(paths_stats_t& stats) const
+        {
+            stats.m_string_data.m_reserved   = m_data->m_data_buffer.reserved_bytes();
+            stats.m_string_data.m_committed  = m_data->m_data_buffer.committed_bytes();
+            stats.m_string_array.m_reserved  = m_data->m_str_buffer.reserved_bytes();
+            stats.m_string_array.m_committed = m_data->m_str_buffer.committed_bytes();
+            stats.m_string_nodes.m_reserved  = m_data->m_node_array.reserved_bytes();
+            stats.m_string_nodes.m_committed = m_data->m_node_array.committed_bytes();
+
+            stats.m_string_count = m_data->m_size;
+            stats.m_string_bytes = (u64)(m_data->m_data_ptr - m_data->m_data_buffer.m_ptr);
+
+            // The find (probe) and temp slots at the end of the string and node arrays
+            stats.m_wasted_bytes += 2 * (sizeof(str_t) + sizeof(ntree32::nnode_t));
+        }
+
         void strings_t::view_string(string_t _str, crunes_t& out_str) const
         {
             str_t* str = index_to_object(_str);
@@ -184,5 +216,109 @@ namespace ncore
             return compare_str(left_str, right_str);
         }
 
+        s8 strings_t::collate(string_t left, string_t right) const
+        {
+            if (left == right)
+                return 0;
+            str_t const* left_str  = index_to_object(left);
+            str_t const* right_str = index_to_object(right);
+            u32 const    len       = left_str->m_len < right_str->m_len ? left_str->m_len : right_str->m_len;
+            for (u32 i = 0; i < len; ++i)
+            {
+                u8 const l = (u8)left_str->m_str[i];
+                u8 const r = (u8)right_str->m_str[i];
+                if (l != r)
+                    return l < r ? -1 : 1;
+            }
+            if (left_str->m_len != right_str->m_len)
+                return left_str->m_len < right_str->m_len ? -1 : 1;
+            return 0;
+        }
+
+        // A rendered name in two parts, the string and "/" or the extension
+        struct collate_key_t
+        {
+            const char* m_str[2];
+            u32         m_len[2];
+        };
+
+        static void s_set_part(strings_t const* strings, collate_key_t& key, u32 part, string_t str)
+        {
+            if (str == c_empty_string)
+            {
+                key.m_str[part] = "";
+                key.m_len[part] = 0;
+                return;
+            }
+            strings_t::str_t const* s = strings->index_to_object(str);
+            key.m_str[part]           = s->m_str;
+            key.m_len[part]           = s->m_len;
+        }
+
+        static s8 s_collate_keys(collate_key_t const& a, collate_key_t const& b)
+        {
+            u32 pa = 0, ia = 0, pb = 0, ib = 0;
+            while (true)
+            {
+                while (pa < 2 && ia == a.m_len[pa])
+                {
+                    pa += 1;
+                    ia = 0;
+                }
+                while (pb < 2 && ib == b.m_len[pb])
+                {
+                    pb += 1;
+                    ib = 0;
+                }
+                if (pa == 2 || pb == 2)
+                    return pa == pb ? 0 : (pa == 2 ? -1 : 1);
+                u8 const ca = (u8)a.m_str[pa][ia++];
+                u8 const cb = (u8)b.m_str[pb][ib++];
+                if (ca != cb)
+                    return ca < cb ? -1 : 1;
+            }
+        }
+
+        static void s_folder_key(strings_t const* strings, collate_key_t& key, string_t name)
+        {
+            s_set_part(strings, key, 0, name);
+            key.m_str[1] = "/";
+            key.m_len[1] = 1;
+        }
+
+        static void s_file_key(strings_t const* strings, collate_key_t& key, string_t name, string_t ext)
+        {
+            s_set_part(strings, key, 0, name);
+            s_set_part(strings, key, 1, ext);
+        }
+
+        s8 strings_t::collate_folders(string_t left, string_t right) const
+        {
+            if (left == right)
+                return 0;
+            collate_key_t a, b;
+            s_folder_key(this, a, left);
+            s_folder_key(this, b, right);
+            return s_collate_keys(a, b);
+        }
+
+        s8 strings_t::collate_files(string_t left_name, string_t left_ext, string_t right_name, string_t right_ext) const
+        {
+            if (left_name == right_name && left_ext == right_ext)
+                return 0;
+            collate_key_t a, b;
+            s_file_key(this, a, left_name, left_ext);
+            s_file_key(this, b, right_name, right_ext);
+            return s_collate_keys(a, b);
+        }
+
+        s8 strings_t::collate_file_folder(string_t name, string_t ext, string_t folder) const
+        {
+            collate_key_t a, b;
+            s_file_key(this, a, name, ext);
+            s_folder_key(this, b, folder);
+            return s_collate_keys(a, b);
+        }
+
     } // namespace npath
 } // namespace ncore
@@ -0,0 +1,174 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_device.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_subtree.h"
+#include "cpath/c_instrument.h"
+#include "cpath/private/c_folders.h"
+#include "cpath/private/c_lazy.h"
+#include "cpath/private/c_threads.h"
+
+#include <string.h>
+
+namespace ncore
+{
+    namespace npath
+    {
+        static const u32 c_local_stack = 1024; // folders per worker before half of them go to the pool
+
+        struct subtree_worker_t
+        {
+            node_t* m_stack;
+            u8*     m_acc;
+            u32     m_visited;
+            u8      m_padding[44];
+        };
+
+        struct subtree_walk_t
+        {
+            paths_t*          m_paths;
+            reducer_t const*  m_reducer;
+            workpool_t*       m_pool;
+            subtree_worker_t* m_workers;
+        };
+
+        struct subtree_item_t
+        {
+            node_t m_node;
+            u32    m_padding;
+        };
+
+        static void s_subtree_work(workpool_t* pool, u32 worker, void* item, void* user)
+        {
+            subtree_walk_t* const   walk    = (subtree_walk_t*)user;
+            subtree_worker_t* const w       = &walk->m_workers[worker];
+            paths_t* const          paths   = walk->m_paths;
+            reducer_t const&        reducer = *walk->m_reducer;
+            node_t* const           stack   = w->m_stack;
+
+            u32 top      = 0;
+            stack[top++] = ((subtree_item_t const*)item)->m_node;
+            while (top > 0)
+            {
+                node_t const    node   = stack[--top];
+                folder_t const* folder = paths->m_folders->m_array.ptr_of(node);
+                if (paths->m_lazy != nullptr && (g_load_acquire(folder->m_flags) & (nfolder::FlagLazy | nfolder::FlagExpanded)) == nfolder::FlagLazy)
+                    g_expand_folder(paths, node);
+
+                w->m_visited += 1;
+                if (reducer.m_folder != nullptr)
+                    reducer.m_folder(paths, node, w->m_acc, reducer.m_user);
+                if (reducer.m_file != nullptr)
+                {
+                    for (ifile_t file = folder->m_file; file != c_invalid_file;)
+                    {
+                        file_t const* f = paths->m_files->m_array.ptr_of(file);
+                        if ((f->m_flags & nfile::FlagDeleted) == 0)
+                            reducer.m_file(paths, file, w->m_acc, reducer.m_user);
+                        file = f->m_sibling;
+                    }
+                }
+
+                for (node_t child = folder->m_child; child != c_invalid_folder;)
+                {
+                    folder_t const* c = paths->m_folders->m_array.ptr_of(child);
+                    if ((c->m_flags & nfolder::FlagDeleted) == 0)
+                    {
+                        if (top == c_local_stack)
+                        {
+                            // The bottom half are the folders closest to the root of this task, the largest sub trees
+                            u32 const half = c_local_stack / 2;
+                            for (u32 i = 0; i < half; ++i)
+                            {
+                                subtree_item_t task = {stack[i], 0};
+                                g_push_work(pool, worker, &task);
+                            }
+                            memmove(stack, stack + half, (top - half) * sizeof(node_t));
+                            top -= half;
+                        }
+                        stack[top++] = child;
+                    }
+                    child = c->m_sibling;
+                }
+            }
+        }
+
+        u32 subtree_t::parallel_reduce(dirpath_t const& root, reducer_t const& reducer, void* out_acc, u32 num_threads)
+        {
+            CPATH_SCOPE("subtree_t::parallel_reduce");
+            if (reducer.m_acc_size > 0)
+                reducer.m_init(out_acc, reducer.m_user);
+            if (root.m_device == nullptr)
+                return 0;
+
+            paths_t* const paths = root.m_device->m_owner;
+            alloc_t* const alloc = paths->m_allocator;
+
+            subtree_walk_t walk;
+            walk.m_paths   = paths;
+            walk.m_reducer = &reducer;
+
+            u32 const workers = num_threads != 0 ? num_threads : g_hardware_threads();
+            walk.m_pool       = g_construct_workpool(alloc, workers, sizeof(subtree_item_t), paths->m_max_items, s_subtree_work, &walk);
+            u32 const count   = g_num_workers(walk.m_pool);
+
+            // One block for the stacks and the accumulators, every accumulator on its own cache lines
+            u32 const acc_size = (reducer.m_acc_size + 63) & ~(u32)63;
+            u32 const stride   = c_local_stack * sizeof(node_t) + acc_size;
+            u8* const block    = (u8*)alloc->allocate(count * stride, 64);
+            walk.m_workers     = g_allocate_array<subtree_worker_t>(alloc, count);
+            for (u32 i = 0; i < count; ++i)
+            {
+                subtree_worker_t& w = walk.m_workers[i];
+                w.m_acc             = block + i * stride;
+                w.m_stack           = (node_t*)(w.m_acc + acc_size);
+                w.m_visited         = 0;
+                if (reducer.m_acc_size > 0)
+                    reducer.m_init(w.m_acc, reducer.m_user);
+            }
+
+            subtree_item_t item = {(root.m_path == c_empty_node || root.m_path == c_invalid_node) ? root.m_device->m_path : root.m_path, 0};
+            g_push_work(walk.m_pool, 0, &item);
+            g_run_workpool(walk.m_pool);
+
+            u32 visited = 0;
+            for (u32 i = 0; i < count; ++i)
+            {
+                visited += walk.m_workers[i].m_visited;
+                if (reducer.m_acc_size > 0)
+                    reducer.m_merge(out_acc, walk.m_workers[i].m_acc, reducer.m_user);
+            }
+
+            alloc->deallocate(block);
+            g_deallocate_array(alloc, walk.m_workers);
+            g_destruct_workpool(alloc, walk.m_pool);
+            return visited;
+        }
+
+        struct subtree_for_t
+        {
+            subtree_fn m_fn;
+            void*      m_user;
+        };
+
+        static void s_for_folder(paths_t* paths, node_t folder, void*, void* user)
+        {
+            subtree_for_t const* f = (subtree_for_t const*)user;
+            f->m_fn(paths, folder, f->m_user);
+        }
+
+        u32 subtree_t::parallel_for(dirpath_t const& root, subtree_fn fn, void* user, u32 num_threads)
+        {
+            subtree_for_t f = {fn, user};
+            reducer_t     reducer;
+            memset(&reducer, 0, sizeof(reducer));
+            reducer.m_folder = s_for_folder;
+            reducer.m_user   = &f;
+            return parallel_reduce(root, reducer, nullptr, num_threads);
+        }
+
+    } // namespace npath
+} // namespace ncore
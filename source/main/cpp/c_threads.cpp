@@ -0,0 +1,244 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+
+#include "cpath/private/c_threads.h"
+
+#include <string.h>
+
+#if defined(TARGET_LINUX) || defined(TARGET_MAC)
+#    define CPATH_THREADS_POSIX
+#    include <pthread.h>
+#    include <sched.h>
+#    include <unistd.h>
+#endif
+
+namespace ncore
+{
+    namespace npath
+    {
+        // --------------------------------------------------------------------------------------------------------------
+        // Platform layer
+        // --------------------------------------------------------------------------------------------------------------
+
+#if defined(CPATH_THREADS_POSIX)
+        static_assert(sizeof(pthread_mutex_t) <= sizeof(mutex_t::m_storage), "mutex_t storage is too small");
+
+        u32 g_hardware_threads()
+        {
+            long const n = sysconf(_SC_NPROCESSORS_ONLN);
+            return n > 0 ? (u32)n : 1;
+        }
+
+        void mutex_t::init() { pthread_mutex_init((pthread_mutex_t*)m_storage, nullptr); }
+        void mutex_t::exit() { pthread_mutex_destroy((pthread_mutex_t*)m_storage); }
+        void mutex_t::lock() { pthread_mutex_lock((pthread_mutex_t*)m_storage); }
+        void mutex_t::unlock() { pthread_mutex_unlock((pthread_mutex_t*)m_storage); }
+
+        static inline void s_atomic_add(u64& value, u64 n) { __atomic_fetch_add(&value, n, __ATOMIC_ACQ_REL); }
+        static inline void s_atomic_sub(u64& value, u64 n) { __atomic_fetch_sub(&value, n, __ATOMIC_ACQ_REL); }
+        static inline u64  s_atomic_load(u64 const& value) { return __atomic_load_n(&value, __ATOMIC_ACQUIRE); }
+        static inline void s_yield() { sched_yield(); }
+#else
+        u32 g_hardware_threads() { return 1; }
+
+        void mutex_t::init() {}
+        void mutex_t::exit() {}
+        void mutex_t::lock() {}
+        void mutex_t::unlock() {}
+
+        static inline void s_atomic_add(u64& value, u64 n) { value += n; }
+        static inline void s_atomic_sub(u64& value, u64 n) { value -= n; }
+        static inline u64  s_atomic_load(u64 const& value) { return value; }
+        static inline void s_yield() {}
+#endif
+
+        // --------------------------------------------------------------------------------------------------------------
+        // Work-stealing pool
+        // --------------------------------------------------------------------------------------------------------------
+
+        struct deque_t
+        {
+            mutex_t  m_lock;
+            varena_t m_items;  // reserved for the maximum number of items, committed on demand
+            u32      m_top;    // thieves take from here (oldest)
+            u32      m_bottom; // the owner pushes and pops here (newest)
+            u8       m_padding[64 - ((sizeof(mutex_t) + sizeof(varena_t) + 8) & 63)];
+        };
+
+        struct workpool_t
+        {
+            alloc_t*  m_allocator;
+            work_fn   m_fn;
+            void*     m_user;
+            u32       m_num_workers;
+            u32       m_item_size;
+            u32       m_max_items; // per deque
+            u64       m_pending;   // pushed but not yet finished work items
+            deque_t*  m_deques;
+            u8*       m_scratch; // per worker, the item that is being worked on
+            DCORE_CLASS_PLACEMENT_NEW_DELETE
+        };
+
+        workpool_t* g_construct_workpool(alloc_t* allocator, u32 num_workers, u32 item_size, u32 max_items, work_fn fn, void* user)
+        {
+#if !defined(CPATH_THREADS_POSIX)
+            num_workers = 1;
+#endif
+            if (num_workers == 0)
+                num_workers = g_hardware_threads();
+
+            workpool_t* pool    = g_construct<workpool_t>(allocator);
+            pool->m_allocator   = allocator;
+            pool->m_fn          = fn;
+            pool->m_user        = user;
+            pool->m_num_workers = num_workers;
+            pool->m_item_size   = (item_size + 7) & ~7;
+            pool->m_max_items   = max_items;
+            pool->m_pending     = 0;
+            pool->m_deques      = g_allocate_array<deque_t>(allocator, num_workers);
+            pool->m_scratch     = g_allocate_array<u8>(allocator, num_workers * pool->m_item_size);
+            for (u32 i = 0; i < num_workers; ++i)
+            {
+                deque_t& d = pool->m_deques[i];
+                d.m_lock.init();
+                g_init_arena(d.m_items, 0, max_items, pool->m_item_size);
+                d.m_top    = 0;
+                d.m_bottom = 0;
+            }
+            return pool;
+        }
+
+        void g_destruct_workpool(alloc_t* allocator, workpool_t*& pool)
+        {
+            for (u32 i = 0; i < pool->m_num_workers; ++i)
+            {
+                pool->m_deques[i].m_lock.exit();
+                g_teardown_arena(pool->m_deques[i].m_items);
+            }
+            g_deallocate_array(allocator, pool->m_deques);
+            g_deallocate_array(allocator, pool->m_scratch);
+            g_destruct(allocator, pool);
+            pool = nullptr;
+        }
+
+        u32 g_num_workers(workpool_t const* pool) { return pool->m_num_workers; }
+
+        void g_push_work(workpool_t* pool, u32 worker, void const* item)
+        {
+            deque_t& d = pool->m_deques[worker];
+            {
+                lock_t lock(d.m_lock);
+                if (d.m_bottom == pool->m_max_items && d.m_top > 0)
+                {
+                    // Move the live items to the front, thieves have consumed the first part
+                    memmove(d.m_items.ptr_of(0, pool->m_item_size), d.m_items.ptr_of(d.m_top, pool->m_item_size), (d.m_bottom - d.m_top) * pool->m_item_size);
+                    d.m_bottom -= d.m_top;
+                    d.m_top = 0;
+                }
+                if (d.m_bottom < pool->m_max_items)
+                {
+                    s_atomic_add(pool->m_pending, 1);
+                    d.m_items.ensure_capacity(d.m_bottom, pool->m_item_size);
+                    memcpy(d.m_items.ptr_of(d.m_bottom, pool->m_item_size), item, pool->m_item_size);
+                    d.m_bottom += 1;
+                    return;
+                }
+            }
+
+            // The deque is full, do the work right here
+            pool->m_fn(pool, worker, (void*)item, pool->m_user);
+        }
+
+        static bool s_pop(workpool_t* pool, u32 worker, u8* out_item)
+        {
+            deque_t& d = pool->m_deques[worker];
+            lock_t   lock(d.m_lock);
+            if (d.m_bottom == d.m_top)
+                return false;
+            d.m_bottom -= 1;
+            memcpy(out_item, d.m_items.ptr_of(d.m_bottom, pool->m_item_size), pool->m_item_size);
+            if (d.m_bottom == d.m_top)
+                d.m_bottom = d.m_top = 0;
+            return true;
+        }
+
+        static bool s_steal(workpool_t* pool, u32 worker, u8* out_item)
+        {
+            for (u32 i = 1; i < pool->m_num_workers; ++i)
+            {
+                deque_t& d = pool->m_deques[(worker + i) % pool->m_num_workers];
+                lock_t   lock(d.m_lock);
+                if (d.m_bottom == d.m_top)
+                    continue;
+                memcpy(out_item, d.m_items.ptr_of(d.m_top, pool->m_item_size), pool->m_item_size);
+                d.m_top += 1;
+                if (d.m_bottom == d.m_top)
+                    d.m_bottom = d.m_top = 0;
+                return true;
+            }
+            return false;
+        }
+
+        static void s_worker_loop(workpool_t* pool, u32 worker)
+        {
+            u8* item = pool->m_scratch + worker * pool->m_item_size;
+            while (true)
+            {
+                if (s_pop(pool, worker, item) || s_steal(pool, worker, item))
+                {
+                    pool->m_fn(pool, worker, item, pool->m_user);
+                    s_atomic_sub(pool->m_pending, 1);
+                    continue;
+                }
+                if (s_atomic_load(pool->m_pending) == 0)
+                    break;
+                s_yield();
+            }
+        }
+
+#if defined(CPATH_THREADS_POSIX)
+        struct worker_start_t
+        {
+            workpool_t* m_pool;
+            u32         m_worker;
+        };
+
+        static void* s_worker_main(void* arg)
+        {
+            worker_start_t const* start = (worker_start_t const*)arg;
+            s_worker_loop(start->m_pool, start->m_worker);
+            return nullptr;
+        }
+
+        void g_run_workpool(workpool_t* pool)
+        {
+            u32 const       num_threads = pool->m_num_workers - 1;
+            pthread_t*      threads     = num_threads > 0 ? g_allocate_array<pthread_t>(pool->m_allocator, num_threads) : nullptr;
+            worker_start_t* starts      = num_threads > 0 ? g_allocate_array<worker_start_t>(pool->m_allocator, num_threads) : nullptr;
+
+            u32 started = 0;
+            for (u32 i = 0; i < num_threads; ++i)
+            {
+                starts[i].m_pool   = pool;
+                starts[i].m_worker = i + 1;
+                if (pthread_create(&threads[started], nullptr, s_worker_main, &starts[i]) == 0)
+                    started += 1;
+            }
+
+            s_worker_loop(pool, 0);
+
+            for (u32 i = 0; i < started; ++i)
+                pthread_join(threads[i], nullptr);
+            if (num_threads > 0)
+            {
+                g_deallocate_array(pool->m_allocator, threads);
+                g_deallocate_array(pool->m_allocator, starts);
+            }
+        }
+#else
+        void g_run_workpool(workpool_t* pool) { s_worker_loop(pool, 0); }
+#endif
+
+    } // namespace npath
+} // namespace ncore
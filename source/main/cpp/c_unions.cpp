@@ -0,0 +1,256 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_device.h"
+#include "cpath/private/c_unions.h"
+#include "cpath/private/c_folders.h"
+#include "cpath/private/c_lazy.h"
+#include "cpath/private/c_threads.h"
+
+#include <string.h>
+
+namespace ncore
+{
+    namespace npath
+    {
+        unions_t* g_construct_unions(alloc_t* allocator, u32 max_items, varena_config_t const& config)
+        {
+            unions_t* unions = g_construct<unions_t>(allocator);
+            g_setup_vpool(unions->m_unions, 0, 64 * 1024, config);
+            g_setup_vpool(unions->m_folders, 0, max_items, config);
+            g_setup_vpool(unions->m_layer_folders, 0, (u64)max_items * c_max_layers, config);
+            g_setup_vpool(unions->m_files, 0, max_items, config);
+            g_setup_vpool(unions->m_chain, 0, max_items, config);
+            unions->m_num_unions      = 0;
+            unions->m_folder_capacity = 0;
+            unions->m_file_capacity   = 0;
+            return unions;
+        }
+
+        void g_destruct_unions(alloc_t* allocator, unions_t*& unions)
+        {
+            g_teardown_vpool(unions->m_unions);
+            g_teardown_vpool(unions->m_folders);
+            g_teardown_vpool(unions->m_layer_folders);
+            g_teardown_vpool(unions->m_files);
+            g_teardown_vpool(unions->m_chain);
+            g_destruct(allocator, unions);
+            unions = nullptr;
+        }
+
+        static inline void s_bump(union_t* u)
+        {
+            u->m_version += 1;
+            if (u->m_version == 0)
+                u->m_version = 1;
+        }
+
+        static node_t s_top(folders_t const* folders, node_t folder)
+        {
+            node_t parent = folders->m_array.ptr_of(folder)->m_parent;
+            while (parent != c_invalid_folder)
+            {
+                folder = parent;
+                parent = folders->m_array.ptr_of(folder)->m_parent;
+            }
+            return folder;
+        }
+
+        static void s_refresh_tops(paths_t* paths, union_t* u)
+        {
+            for (u32 l = 0; l < u->m_num_layers; ++l)
+            {
+                node_t const path = paths->m_devices->get_device(u->m_layers[l])->m_path;
+                u->m_tops[l]      = (path == c_invalid_node || path == c_empty_node) ? c_invalid_node : s_top(paths->m_folders, path);
+            }
+        }
+
+        s32 g_unions_set(paths_t* paths, s32 index, idevice_t device, idevice_t const* layers, u32 num_layers)
+        {
+            ASSERT(num_layers > 0 && num_layers <= c_max_layers);
+            unions_t* const unions = paths->m_unions;
+            if (index < 0)
+            {
+                index = (s32)unions->m_num_unions++;
+                unions->m_unions.ensure_capacity(unions->m_num_unions);
+                unions->m_unions.ptr_of(index)->m_version = 0;
+            }
+            union_t* u      = unions->m_unions.ptr_of(index);
+            u->m_device     = device;
+            u->m_num_layers = num_layers;
+            for (u32 i = 0; i < num_layers; ++i)
+                u->m_layers[i] = layers[i];
+            s_refresh_tops(paths, u);
+            s_bump(u); // the hits of the previous layers are stale
+            return index;
+        }
+
+        // A layer only moves to another tree through an alias, which goes through g_unions_invalidate
+        void g_unions_changed(paths_t* paths, node_t folder)
+        {
+            unions_t* const unions = paths->m_unions;
+            if (unions->m_num_unions == 0)
+                return;
+            node_t const top = s_top(paths->m_folders, folder);
+            for (u32 i = 0; i < unions->m_num_unions; ++i)
+            {
+                union_t* const u = unions->m_unions.ptr_of(i);
+                for (u32 l = 0; l < u->m_num_layers; ++l)
+                {
+                    if (u->m_tops[l] == top)
+                    {
+                        s_bump(u);
+                        break;
+                    }
+                }
+            }
+        }
+
+        void g_unions_invalidate(paths_t* paths)
+        {
+            unions_t* const unions = paths->m_unions;
+            for (u32 i = 0; i < unions->m_num_unions; ++i)
+            {
+                union_t* const u = unions->m_unions.ptr_of(i);
+                s_refresh_tops(paths, u);
+                s_bump(u);
+            }
+        }
+
+        static inline void s_expand(paths_t* paths, node_t folder)
+        {
+            if (paths->m_lazy != nullptr && (g_load_acquire(paths->m_folders->m_array.ptr_of(folder)->m_flags) & (nfolder::FlagLazy | nfolder::FlagExpanded)) == nfolder::FlagLazy)
+                g_expand_folder(paths, folder);
+        }
+
+        // The live sub folder 'name' of a folder of a layer, c_invalid_node when there is none
+        static node_t s_descend(paths_t* paths, device_t const* layer, node_t folder, string_t name)
+        {
+            if (folder == c_invalid_node)
+                return c_invalid_node;
+            s_expand(paths, folder);
+            node_t const node = layer->find_dir(folder, name);
+            if (node == c_invalid_node || (paths->m_folders->m_array.ptr_of(node)->m_flags & nfolder::FlagDeleted) != 0)
+                return c_invalid_node;
+            return node;
+        }
+
+        static unionhit_t* s_hit(vpool_t<unionhit_t>& hits, u32& capacity, u32 count, u32 node)
+        {
+            if (node >= capacity)
+            {
+                u32 const grow = count > node + 1 ? count : node + 1;
+                hits.ensure_capacity(grow);
+                memset(hits.ptr_of(capacity), 0, (grow - capacity) * sizeof(unionhit_t));
+                capacity = grow;
+            }
+            return hits.ptr_of(node);
+        }
+
+        // From the folders of the parent in the layers, the root of the union is the root of every layer
+        static void s_resolve(paths_t* paths, union_t const* u, node_t folder)
+        {
+            unions_t* const unions = paths->m_unions;
+            unionhit_t*     hit    = unions->m_folders.ptr_of(folder);
+            node_t* const   mine   = unions->m_layer_folders.ptr_of(folder * c_max_layers);
+            folder_t const* f      = paths->m_folders->m_array.ptr_of(folder);
+            node_t const    root   = paths->m_devices->get_device(u->m_device)->m_path;
+            node_t const    parent = f->m_parent;
+            if (folder == root)
+            {
+                for (u32 l = 0; l < u->m_num_layers; ++l)
+                {
+                    node_t const path = paths->m_devices->get_device(u->m_layers[l])->m_path;
+                    mine[l]           = (path == c_empty_node) ? c_invalid_node : path;
+                }
+            }
+            else if (parent == c_invalid_folder)
+            {
+                for (u32 l = 0; l < u->m_num_layers; ++l)
+                    mine[l] = c_invalid_node; // not in the tree of the union
+            }
+            else
+            {
+                node_t const* const theirs = unions->m_layer_folders.ptr_of(parent * c_max_layers);
+                for (u32 l = 0; l < u->m_num_layers; ++l)
+                    mine[l] = s_descend(paths, paths->m_devices->get_device(u->m_layers[l]), theirs[l], f->m_name);
+            }
+
+            hit->m_version = u->m_version;
+            hit->m_layer   = -1;
+            hit->m_node    = c_invalid_node;
+            for (u32 l = 0; l < u->m_num_layers; ++l)
+            {
+                if (mine[l] != c_invalid_node)
+                {
+                    hit->m_layer = (s32)l;
+                    hit->m_node  = mine[l];
+                    break;
+                }
+            }
+        }
+
+        // The stale folders up to a resolved one (or the root of the union, or the top of the tree) are resolved
+        // top down, there is no limit on the depth
+        unionhit_t const* g_unions_resolve_folder(paths_t* paths, union_t const* u, node_t folder)
+        {
+            unions_t* const unions = paths->m_unions;
+            u32 const       count  = paths->m_folders->m_count + 1;
+            unionhit_t*     hit    = s_hit(unions->m_folders, unions->m_folder_capacity, count, folder);
+            if (hit->m_version == u->m_version)
+                return hit;
+
+            node_t const root = paths->m_devices->get_device(u->m_device)->m_path;
+            u32          num  = 0;
+            for (node_t node = folder;;)
+            {
+                unions->m_chain.ensure_capacity(num + 1);
+                *unions->m_chain.ptr_of(num++) = node;
+                node_t const parent            = paths->m_folders->m_array.ptr_of(node)->m_parent;
+                if (node == root || parent == c_invalid_folder || s_hit(unions->m_folders, unions->m_folder_capacity, count, parent)->m_version == u->m_version)
+                    break;
+                node = parent;
+            }
+
+            unions->m_layer_folders.ensure_capacity(unions->m_folder_capacity * c_max_layers);
+            while (num > 0)
+                s_resolve(paths, u, *unions->m_chain.ptr_of(--num));
+            return hit;
+        }
+
+        unionhit_t const* g_unions_resolve_file(paths_t* paths, union_t const* u, ifile_t file)
+        {
+            unions_t* const unions = paths->m_unions;
+            unionhit_t*     hit    = s_hit(unions->m_files, unions->m_file_capacity, paths->m_files->m_count + 1, file);
+            if (hit->m_version == u->m_version)
+                return hit;
+
+            file_t const* const f         = paths->m_files->m_array.ptr_of(file);
+            string_t const      filename  = f->m_filename;
+            string_t const      extension = f->m_extension;
+            g_unions_resolve_folder(paths, u, f->m_folder);
+            node_t const* const folders = unions->m_layer_folders.ptr_of(f->m_folder * c_max_layers);
+
+            hit->m_version = u->m_version;
+            hit->m_layer   = -1;
+            hit->m_node    = c_invalid_file;
+            for (u32 l = 0; l < u->m_num_layers; ++l)
+            {
+                if (folders[l] == c_invalid_node)
+                    continue;
+                s_expand(paths, folders[l]);
+                ifile_t const found = paths->m_devices->get_device(u->m_layers[l])->find_file(folders[l], filename, extension);
+                if (found != c_invalid_file && (paths->m_files->m_array.ptr_of(found)->m_flags & nfile::FlagDeleted) == 0)
+                {
+                    hit->m_layer = (s32)l;
+                    hit->m_node  = found;
+                    break;
+                }
+            }
+            return hit;
+        }
+
+    } // namespace npath
+} // namespace ncore
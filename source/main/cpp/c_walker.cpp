@@ -0,0 +1,223 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_device.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_walker.h"
+#include "cpath/c_instrument.h"
+#include "cpath/private/c_folders.h"
+#include "cpath/private/c_lazy.h"
+#include "cpath/private/c_strings.h"
+#include "cpath/private/c_threads.h"
+
+#if defined(_MSC_VER)
+#    include <xmmintrin.h>
+#endif
+
+namespace ncore
+{
+    namespace npath
+    {
+        static inline void s_prefetch(void const* ptr)
+        {
+#if defined(_MSC_VER)
+            _mm_prefetch((char const*)ptr, _MM_HINT_T0);
+#else
+            __builtin_prefetch(ptr);
+#endif
+        }
+
+        walker_t* g_construct_walker(alloc_t* allocator, dirpath_t const& root, u32 flags)
+        {
+            walker_t* walker = g_construct<walker_t>(allocator);
+            walker->m_paths  = nullptr;
+            walker->m_flags  = flags;
+            walker->m_top    = 0;
+            walker->m_stack.m_arena.m_ptr = nullptr;
+            walker->reset(root, flags);
+            return walker;
+        }
+
+        void g_destruct_walker(alloc_t* allocator, walker_t*& walker)
+        {
+            if (walker->m_stack.m_arena.m_ptr != nullptr)
+                g_teardown_vpool(walker->m_stack);
+            g_destruct(allocator, walker);
+            walker = nullptr;
+        }
+
+        void walker_t::reset(dirpath_t const& root, u32 flags)
+        {
+            m_flags = flags;
+            m_top   = 0;
+            if (root.m_device == nullptr)
+                return;
+            if (m_stack.m_arena.m_ptr == nullptr)
+            {
+                // a node is on the stack at most once, post-order keeps a folder below its children
+                m_paths = root.m_device->m_owner;
+                g_setup_vpool(m_stack, 0, (u64)m_paths->m_max_items * 2, m_paths->m_config);
+            }
+            ASSERT(m_paths == root.m_device->m_owner);
+
+            m_stack.ensure_capacity(1);
+            entry_t* entry   = m_stack.ptr_of(m_top++);
+            entry->m_node    = (root.m_path == c_empty_node || root.m_path == c_invalid_node) ? root.m_device->m_path : root.m_path;
+            entry->m_depth   = 0;
+            entry->m_type    = nwalk::TypeFolder;
+            entry->m_visited = 0;
+        }
+
+        // Lexicographic, files by name and then by extension (c_empty_string, no extension, first)
+        static s8 s_compare_entries(paths_t const* paths, walker_t::entry_t const& a, walker_t::entry_t const& b)
+        {
+            if (a.m_type == nwalk::TypeFolder)
+                return paths->m_strings->collate(paths->m_folders->m_array.ptr_of(a.m_node)->m_name, paths->m_folders->m_array.ptr_of(b.m_node)->m_name);
+
+            file_t const* fa = paths->m_files->m_array.ptr_of(a.m_node);
+            file_t const* fb = paths->m_files->m_array.ptr_of(b.m_node);
+            s8 const      c  = paths->m_strings->collate(fa->m_filename, fb->m_filename);
+            if (c != 0 || fa->m_extension == fb->m_extension)
+                return c;
+            if (fa->m_extension == c_empty_string || fb->m_extension == c_empty_string)
+                return fa->m_extension == c_empty_string ? -1 : 1;
+            return paths->m_strings->collate(fa->m_extension, fb->m_extension);
+        }
+
+        static void s_sift_down(paths_t const* paths, walker_t::entry_t* entries, u32 root, u32 count)
+        {
+            while (true)
+            {
+                u32 child = root * 2 + 1;
+                if (child >= count)
+                    return;
+                // descending, the stack pops the smallest name first
+                if (child + 1 < count && s_compare_entries(paths, entries[child], entries[child + 1]) > 0)
+                    child += 1;
+                if (s_compare_entries(paths, entries[root], entries[child]) <= 0)
+                    return;
+                walker_t::entry_t const t = entries[root];
+                entries[root]             = entries[child];
+                entries[child]            = t;
+                root                      = child;
+            }
+        }
+
+        static void s_sort_entries(paths_t const* paths, walker_t::entry_t* entries, u32 count)
+        {
+            for (u32 i = count / 2; i > 0; --i)
+                s_sift_down(paths, entries, i - 1, count);
+            for (u32 end = count; end > 1; --end)
+            {
+                walker_t::entry_t const t = entries[0];
+                entries[0]                = entries[end - 1];
+                entries[end - 1]          = t;
+                s_sift_down(paths, entries, 0, end - 1);
+            }
+        }
+
+        // The node that is popped next, and its name, are fetched while the caller handles the current one
+        static inline void s_prefetch_top(walker_t const* walker)
+        {
+            if (walker->m_top == 0)
+                return;
+            walker_t::entry_t const* top   = walker->m_stack.ptr_of(walker->m_top - 1);
+            paths_t const* const     paths = walker->m_paths;
+            if (top->m_type == nwalk::TypeFolder)
+            {
+                folder_t const* folder = paths->m_folders->m_array.ptr_of(top->m_node);
+                s_prefetch(folder);
+                s_prefetch(paths->m_strings->index_to_object(folder->m_name));
+            }
+            else
+            {
+                s_prefetch(paths->m_files->m_array.ptr_of(top->m_node));
+            }
+        }
+
+        bool walker_t::next(walknode_t& out_node)
+        {
+            while (m_top > 0)
+            {
+                entry_t const e = *m_stack.ptr_of(--m_top);
+                if (e.m_type == nwalk::TypeFile || e.m_visited)
+                {
+                    out_node.m_node    = e.m_node;
+                    out_node.m_depth   = e.m_depth;
+                    out_node.m_type    = e.m_type;
+                    out_node.m_padding = 0;
+                    s_prefetch_top(this);
+                    return true;
+                }
+
+                folder_t const* folder = m_paths->m_folders->m_array.ptr_of(e.m_node);
+                if (m_paths->m_lazy != nullptr && (g_load_acquire(folder->m_flags) & (nfolder::FlagLazy | nfolder::FlagExpanded)) == nfolder::FlagLazy)
+                    g_expand_folder(m_paths, e.m_node);
+
+                m_stack.ensure_capacity(m_top + 1 + folder->m_num_folders + ((m_flags & nwalk::WithFiles) ? folder->m_num_files : 0));
+                if (m_flags & nwalk::PostOrder)
+                {
+                    entry_t* self   = m_stack.ptr_of(m_top++);
+                    *self           = e;
+                    self->m_visited = 1;
+                }
+
+                // Sub folders first, then the files on top of them, the lists are linked most recent first, so
+                // popping from the stack gives the registration order
+                u16 const depth = e.m_depth + 1;
+                u32       first = m_top;
+                for (node_t child = folder->m_child; child != c_invalid_folder;)
+                {
+                    folder_t const* c = m_paths->m_folders->m_array.ptr_of(child);
+                    if (c->m_sibling != c_invalid_folder)
+                        s_prefetch(m_paths->m_folders->m_array.ptr_of(c->m_sibling));
+                    if ((c->m_flags & nfolder::FlagDeleted) == 0)
+                    {
+                        entry_t* entry   = m_stack.ptr_of(m_top++);
+                        entry->m_node    = child;
+                        entry->m_depth   = depth;
+                        entry->m_type    = nwalk::TypeFolder;
+                        entry->m_visited = 0;
+                    }
+                    child = c->m_sibling;
+                }
+                if ((m_flags & nwalk::SortedByName) && (m_top - first) > 1)
+                    s_sort_entries(m_paths, m_stack.ptr_of(first), m_top - first);
+
+                if (m_flags & nwalk::WithFiles)
+                {
+                    first = m_top;
+                    for (ifile_t file = folder->m_file; file != c_invalid_file;)
+                    {
+                        file_t const* f = m_paths->m_files->m_array.ptr_of(file);
+                        if ((f->m_flags & nfile::FlagDeleted) == 0)
+                        {
+                            entry_t* entry   = m_stack.ptr_of(m_top++);
+                            entry->m_node    = file;
+                            entry->m_depth   = depth;
+                            entry->m_type    = nwalk::TypeFile;
+                            entry->m_visited = 0;
+                        }
+                        file = f->m_sibling;
+                    }
+                    if ((m_flags & nwalk::SortedByName) && (m_top - first) > 1)
+                        s_sort_entries(m_paths, m_stack.ptr_of(first), m_top - first);
+                }
+
+                if ((m_flags & nwalk::PostOrder) == 0)
+                {
+                    out_node.m_node    = e.m_node;
+                    out_node.m_depth   = e.m_depth;
+                    out_node.m_type    = nwalk::TypeFolder;
+                    out_node.m_padding = 0;
+                    s_prefetch_top(this);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    } // namespace npath
+} // namespace ncore
@@ -0,0 +1,541 @@
+#include "ccore/c_target.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_allocator.h"
+#include "cbase/c_runes.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_device.h"
+#include "cpath/c_watcher.h"
+#include "cpath/c_instrument.h"
+#include "cpath/private/c_extindex.h"
+#include "cpath/private/c_fingerprints.h"
+#include "cpath/private/c_unions.h"
+#include "cpath/private/c_folders.h"
+#include "cpath/private/c_strings.h"
+
+#include <string.h>
+
+#if defined(TARGET_LINUX)
+#    define CPATH_WATCHER_INOTIFY
+#    include <dirent.h>
+#    include <fcntl.h>
+#    include <poll.h>
+#    include <sys/inotify.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+namespace ncore
+{
+    namespace npath
+    {
+        const watch_config_t g_default_watch_config = {10, 1024 * 1024};
+
+        static const u32 c_event_buffer_size = 64 * 1024;
+        static const u32 c_max_reads_per_poll = 1024; // bounds a poll() under a continuous stream of events
+        static const s32 c_max_ospath        = 4096;
+
+        // Grow a column so that 'index' is valid, new entries get 'value'
+        template <typename T> static void s_ensure_column(vpool_t<T>& column, u32& capacity, u32 index, T value)
+        {
+            if (index < capacity)
+                return;
+            column.ensure_capacity(index);
+            for (u32 i = capacity; i <= index; ++i)
+                *column.ptr_of(i) = value;
+            capacity = index + 1;
+        }
+
+        watcher_t* g_construct_watcher(alloc_t* allocator, paths_t* paths, watch_config_t const& config)
+        {
+            watcher_t* w         = g_construct<watcher_t>(allocator);
+            w->m_paths           = paths;
+            w->m_config          = config;
+            w->m_fd              = -1;
+            w->m_generation      = 0;
+            w->m_overflows       = 0;
+            w->m_num_roots       = 0;
+            w->m_wd_table_size   = 16;
+            w->m_num_watches     = 0;
+            w->m_node_capacity   = 0;
+            w->m_folder_capacity = 0;
+            w->m_file_capacity   = 0;
+            w->m_log_count       = 0;
+            w->m_buffer          = g_allocate_array<u8>(allocator, c_event_buffer_size);
+            u32 max_table_size = 16;
+            while (max_table_size < config.m_max_watches * 2)
+                max_table_size *= 2;
+            g_setup_vpool(w->m_wd_table, 0, max_table_size);
+            w->m_wd_table.ensure_capacity(w->m_wd_table_size - 1);
+            memset(w->m_wd_table.ptr(), 0, w->m_wd_table_size * sizeof(u32));
+            g_setup_vpool(w->m_node_to_wd, 0, paths->m_max_items);
+            g_setup_vpool(w->m_folder_last, 0, paths->m_max_items);
+            g_setup_vpool(w->m_file_last, 0, paths->m_max_items);
+            g_setup_vpool(w->m_log, 0, 64 * 1024 * 1024);
+#if defined(CPATH_WATCHER_INOTIFY)
+            w->m_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+            return w;
+        }
+
+        void g_destruct_watcher(alloc_t* allocator, watcher_t*& watcher)
+        {
+#if defined(CPATH_WATCHER_INOTIFY)
+            if (watcher->m_fd >= 0)
+                ::close(watcher->m_fd); // removes all watches
+#endif
+            g_deallocate_array(allocator, watcher->m_buffer);
+            g_teardown_vpool(watcher->m_wd_table);
+            g_teardown_vpool(watcher->m_node_to_wd);
+            g_teardown_vpool(watcher->m_folder_last);
+            g_teardown_vpool(watcher->m_file_last);
+            g_teardown_vpool(watcher->m_log);
+            g_destruct(allocator, watcher);
+            watcher = nullptr;
+        }
+
+        // --------------------------------------------------------------------------------------------------------------
+        // change log
+
+        // Entries of the same node within one generation are merged, the log holds one entry per node per generation
+        static u32 s_record(watcher_t* w, u32 generation, bool is_file, u32 index, u8 kind)
+        {
+            vpool_t<u32>& last     = is_file ? w->m_file_last : w->m_folder_last;
+            u32&          capacity = is_file ? w->m_file_capacity : w->m_folder_capacity;
+            s_ensure_column(last, capacity, index, (u32)0);
+
+            u32* const entry = last.ptr_of(index);
+            if (*entry != 0)
+            {
+                change_t* c = w->m_log.ptr_of(*entry - 1);
+                if (c->m_generation == generation)
+                {
+                    if (kind == nchange::KindCreated && c->m_kind == nchange::KindDeleted)
+                        c->m_kind = nchange::KindModified; // replaced, e.g. an editor saving through a rename
+                    else if (!(kind == nchange::KindModified && c->m_kind == nchange::KindCreated))
+                        c->m_kind = kind;
+                    return 0;
+                }
+            }
+
+            w->m_log.ensure_capacity(w->m_log_count);
+            change_t* c     = w->m_log.ptr_of(w->m_log_count);
+            c->m_generation = generation;
+            c->m_index      = index;
+            c->m_kind       = kind;
+            c->m_is_file    = is_file ? 1 : 0;
+            c->m_padding[0] = c->m_padding[1] = 0;
+            w->m_log_count += 1;
+            *entry = w->m_log_count;
+            return 1;
+        }
+
+        u32 watcher_t::changes_since(u32 generation, u32& cursor, change_t* out_changes, u32 max_changes) const
+        {
+            // First entry after 'generation', the log is ordered by generation
+            u32 lo = 0, hi = m_log_count;
+            while (lo < hi)
+            {
+                u32 const mid = (lo + hi) >> 1;
+                if (m_log.ptr_of(mid)->m_generation <= generation)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+
+            u32 i     = cursor > lo ? cursor : lo;
+            u32 count = 0;
+            for (; i < m_log_count && count < max_changes; ++i)
+            {
+                // Only the newest entry of a node describes its state
+                change_t const* c    = m_log.ptr_of(i);
+                u32 const       last = c->m_is_file ? *m_file_last.ptr_of(c->m_index) : *m_folder_last.ptr_of(c->m_index);
+                if (last == i + 1)
+                    out_changes[count++] = *c;
+            }
+            cursor = i;
+            return count;
+        }
+
+#if defined(CPATH_WATCHER_INOTIFY)
+
+        static const u32 c_watch_mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+
+        static inline bool s_is_dot(const char* name) { return name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0)); }
+
+        static bool s_is_root(watcher_t const* w, node_t node)
+        {
+            for (s32 i = 0; i < w->m_num_roots; ++i)
+            {
+                if (w->m_roots[i] == node)
+                    return true;
+            }
+            return false;
+        }
+
+        // The descriptor table is open addressing like devices_t::m_name_table, the key of an entry is the watch
+        // descriptor of its folder (m_node_to_wd). Linux hands out descriptors cyclically and does not reuse them
+        // soon, so the table is sized by the number of live watches and not by the value of a descriptor.
+        static inline u32 s_wd_hash(s32 wd, u32 mask) { return ((u32)wd * 0x9E3779B1u) & mask; }
+
+        // The slot that holds 'wd', or the empty slot where it would go
+        static u32 s_wd_slot(watcher_t const* w, s32 wd)
+        {
+            u32 const mask = w->m_wd_table_size - 1;
+            for (u32 i = s_wd_hash(wd, mask);; i = (i + 1) & mask)
+            {
+                u32 const entry = *w->m_wd_table.ptr_of(i);
+                if (entry == 0 || *w->m_node_to_wd.ptr_of(entry - 1) == wd)
+                    return i;
+            }
+        }
+
+        static node_t s_wd_find(watcher_t const* w, s32 wd)
+        {
+            u32 const entry = *w->m_wd_table.ptr_of(s_wd_slot(w, wd));
+            return entry != 0 ? (node_t)(entry - 1) : c_invalid_node;
+        }
+
+        // Keep the table at most half full, the watched folders are re-inserted
+        static void s_wd_grow(watcher_t* w)
+        {
+            w->m_wd_table_size *= 2;
+            w->m_wd_table.ensure_capacity(w->m_wd_table_size - 1);
+            memset(w->m_wd_table.ptr(), 0, w->m_wd_table_size * sizeof(u32));
+            for (u32 node = 0; node < w->m_node_capacity; ++node)
+            {
+                s32 const wd = *w->m_node_to_wd.ptr_of(node);
+                if (wd >= 0)
+                    *w->m_wd_table.ptr_of(s_wd_slot(w, wd)) = node + 1;
+            }
+        }
+
+        // Backward shift deletion, the entries after the hole that may live in it are moved up, no tombstones
+        static void s_wd_erase(watcher_t* w, s32 wd)
+        {
+            u32 const mask = w->m_wd_table_size - 1;
+            u32       hole = s_wd_slot(w, wd);
+            if (*w->m_wd_table.ptr_of(hole) == 0)
+                return;
+            for (u32 i = (hole + 1) & mask;; i = (i + 1) & mask)
+            {
+                u32 const entry = *w->m_wd_table.ptr_of(i);
+                if (entry == 0)
+                    break;
+                u32 const home = s_wd_hash(*w->m_node_to_wd.ptr_of(entry - 1), mask);
+                if (((i - home) & mask) >= ((i - hole) & mask))
+                {
+                    *w->m_wd_table.ptr_of(hole) = entry;
+                    hole                        = i;
+                }
+            }
+            *w->m_wd_table.ptr_of(hole) = 0;
+            w->m_num_watches -= 1;
+        }
+
+        static void s_add_watch(watcher_t* w, node_t node)
+        {
+            s_ensure_column(w->m_node_to_wd, w->m_node_capacity, node, (s32)-1);
+            if (*w->m_node_to_wd.ptr_of(node) >= 0)
+                return;
+
+            char      path[c_max_ospath];
+            if (w->m_paths->folder_to_ospath(node, path, c_max_ospath) < 0)
+                return;
+            s32 const wd = ::inotify_add_watch(w->m_fd, path, c_watch_mask);
+            if (wd < 0)
+                return;
+            if (s_wd_find(w, wd) != c_invalid_node)
+                return; // the same directory under another node (e.g. mounted twice), inotify hands out its descriptor again
+            if (w->m_num_watches >= w->m_config.m_max_watches)
+            {
+                ::inotify_rm_watch(w->m_fd, wd);
+                w->m_overflows += 1;
+                return;
+            }
+            if ((w->m_num_watches + 1) * 2 > w->m_wd_table_size)
+                s_wd_grow(w);
+            *w->m_wd_table.ptr_of(s_wd_slot(w, wd)) = node + 1;
+            *w->m_node_to_wd.ptr_of(node)            = wd;
+            w->m_num_watches += 1;
+        }
+
+        static void s_remove_watch(watcher_t* w, node_t node)
+        {
+            if (node >= w->m_node_capacity)
+                return;
+            s32* const wd = w->m_node_to_wd.ptr_of(node);
+            if (*wd < 0)
+                return;
+            ::inotify_rm_watch(w->m_fd, *wd);
+            s_wd_erase(w, *wd);
+            *wd = -1;
+        }
+
+        static void s_watch_tree(watcher_t* w, node_t node)
+        {
+            folder_t const* folder = w->m_paths->m_folders->m_array.ptr_of(node);
+            if (folder->m_flags & nfolder::FlagDeleted)
+                return;
+            s_add_watch(w, node);
+            for (node_t child = folder->m_child; child != c_invalid_folder; child = w->m_paths->m_folders->m_array.ptr_of(child)->m_sibling)
+                s_watch_tree(w, child);
+        }
+
+        // --------------------------------------------------------------------------------------------------------------
+        // applying events
+
+        static void s_delete_tree(watcher_t* w, u32 generation, node_t node)
+        {
+            paths_t* const paths  = w->m_paths;
+            folder_t*      folder = paths->m_folders->m_array.ptr_of(node);
+            s_remove_watch(w, node);
+            if ((folder->m_flags & nfolder::FlagDeleted) == 0)
+            {
+                folder->m_flags |= nfolder::FlagDeleted;
+                s_record(w, generation, false, node, nchange::KindDeleted);
+                if (paths->m_fingerprints != nullptr)
+                    g_fingerprint_dirty(paths, node); // leaves the sum of its parent
+                if (paths->m_unions != nullptr)
+                    g_unions_changed(paths, node);
+            }
+            for (ifile_t file = folder->m_file; file != c_invalid_file;)
+            {
+                file_t* f = paths->m_files->m_array.ptr_of(file);
+                if ((f->m_flags & nfile::FlagDeleted) == 0)
+                {
+                    g_set_file_deleted(paths, file, true);
+                    s_record(w, generation, true, file, nchange::KindDeleted);
+                }
+                file = f->m_sibling;
+            }
+            for (node_t child = folder->m_child; child != c_invalid_folder; child = paths->m_folders->m_array.ptr_of(child)->m_sibling)
+                s_delete_tree(w, generation, child);
+        }
+
+        static u8 s_file_type(watcher_t const* w, node_t folder, const char* name)
+        {
+            char      path[c_max_ospath];
+            s32 const len      = w->m_paths->folder_to_ospath(folder, path, c_max_ospath);
+            s32 const name_len = (s32)strlen(name);
+            if (len < 0 || (len + 1 + name_len + 1) > c_max_ospath)
+                return nfile::TypeUnknown;
+            path[len] = '/';
+            memcpy(path + len + 1, name, name_len + 1);
+
+            struct stat st;
+            if (::lstat(path, &st) != 0)
+                return nfile::TypeUnknown;
+            return S_ISREG(st.st_mode) ? nfile::TypeRegular : (S_ISLNK(st.st_mode) ? nfile::TypeSymlink : nfile::TypeOther);
+        }
+
+        static void s_file_appeared(watcher_t* w, u32 generation, device_t* device, node_t folder, const char* name, u8 type, bool modified)
+        {
+            paths_t* const paths = w->m_paths;
+            u32 const      len   = (u32)strlen(name);
+            string_t       filename, extension;
+            paths->register_filename(utf8::make_crunes((utf8::pcrune)name, 0, len, len), filename, extension);
+
+            u32 const     count = paths->m_files->m_count;
+            ifile_t const file  = device->add_file(folder, filename, extension, type);
+            file_t*       f     = paths->m_files->m_array.ptr_of(file);
+            if (file >= count || (f->m_flags & nfile::FlagDeleted) != 0)
+            {
+                g_set_file_deleted(paths, file, false);
+                s_record(w, generation, true, file, nchange::KindCreated);
+            }
+            else
+            {
+                s_record(w, generation, true, file, modified ? nchange::KindModified : nchange::KindCreated);
+            }
+        }
+
+        static void s_file_removed(watcher_t* w, u32 generation, device_t* device, node_t folder, const char* name)
+        {
+            paths_t* const paths = w->m_paths;
+            u32 const      len   = (u32)strlen(name);
+            string_t       filename, extension;
+            paths->register_filename(utf8::make_crunes((utf8::pcrune)name, 0, len, len), filename, extension);
+
+            ifile_t const file = device->find_file(folder, filename, extension);
+            if (file == c_invalid_file)
+                return;
+            file_t* f = paths->m_files->m_array.ptr_of(file);
+            if ((f->m_flags & nfile::FlagDeleted) == 0)
+            {
+                g_set_file_deleted(paths, file, true);
+                s_record(w, generation, true, file, nchange::KindDeleted);
+            }
+        }
+
+        // A folder appeared (created or moved in), watch it first and then register what is already in it, so
+        // nothing created in between is missed. Everything found is recorded as created.
+        static void s_folder_appeared(watcher_t* w, u32 generation, device_t* device, node_t parent, const char* name)
+        {
+            paths_t* const paths = w->m_paths;
+            u32 const      len   = (u32)strlen(name);
+            u32 const      count = paths->m_folders->m_count;
+            string_t const str   = paths->find_or_insert_string(utf8::make_crunes((utf8::pcrune)name, 0, len, len));
+            node_t const   node  = device->add_dir(parent, str);
+            folder_t*      f     = paths->m_folders->m_array.ptr_of(node);
+            if (node >= count || (f->m_flags & nfolder::FlagDeleted) != 0)
+            {
+                f->m_flags &= ~nfolder::FlagDeleted;
+                s_record(w, generation, false, node, nchange::KindCreated);
+                if (paths->m_fingerprints != nullptr)
+                    g_fingerprint_dirty(paths, node);
+                if (paths->m_unions != nullptr)
+                    g_unions_changed(paths, node);
+            }
+            s_add_watch(w, node);
+
+            char      path[c_max_ospath];
+            if (w->m_paths->folder_to_ospath(node, path, c_max_ospath) < 0)
+                return;
+            DIR* dir = ::opendir(path);
+            if (dir == nullptr)
+                return;
+            while (struct dirent* entry = ::readdir(dir))
+            {
+                if (s_is_dot(entry->d_name))
+                    continue;
+                u8 type = entry->d_type;
+                if (type == DT_UNKNOWN)
+                {
+                    struct stat st;
+                    if (::fstatat(::dirfd(dir), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+                        continue;
+                    type = S_ISDIR(st.st_mode) ? DT_DIR : (S_ISREG(st.st_mode) ? DT_REG : (S_ISLNK(st.st_mode) ? DT_LNK : DT_FIFO));
+                }
+                if (type == DT_DIR)
+                    s_folder_appeared(w, generation, device, node, entry->d_name);
+                else
+                    s_file_appeared(w, generation, device, node, entry->d_name, type == DT_REG ? nfile::TypeRegular : (type == DT_LNK ? nfile::TypeSymlink : nfile::TypeOther), false);
+            }
+            ::closedir(dir);
+        }
+
+        static void s_apply(watcher_t* w, u32 generation, struct inotify_event const* event)
+        {
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                w->m_overflows += 1;
+                return;
+            }
+            if (event->wd < 0)
+                return;
+            node_t const node = s_wd_find(w, event->wd);
+            if (node == c_invalid_node)
+                return; // removed by us, this is the IN_IGNORED (or a late event) of that watch
+
+            if (event->mask & IN_IGNORED)
+            {
+                s_wd_erase(w, event->wd);
+                *w->m_node_to_wd.ptr_of(node) = -1;
+                return;
+            }
+
+            if (event->len == 0)
+            {
+                // An event on the watched folder itself, only the removal of a watch root isn't also reported by its parent
+                if ((event->mask & IN_DELETE_SELF) && s_is_root(w, node))
+                    s_delete_tree(w, generation, node);
+                return;
+            }
+
+            device_t* const device = w->m_paths->device_of(node);
+            if (device == nullptr)
+                return;
+
+            const char* name = event->name;
+            if (event->mask & IN_ISDIR)
+            {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                {
+                    s_folder_appeared(w, generation, device, node, name);
+                }
+                else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                {
+                    u32 const      len   = (u32)strlen(name);
+                    string_t const str   = w->m_paths->find_string(utf8::make_crunes((utf8::pcrune)name, 0, len, len));
+                    node_t const   child = str != c_invalid_string ? device->find_dir(node, str) : c_invalid_node;
+                    if (child != c_invalid_node)
+                        s_delete_tree(w, generation, child);
+                }
+                return;
+            }
+
+            if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                s_file_appeared(w, generation, device, node, name, s_file_type(w, node, name), false);
+            else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                s_file_removed(w, generation, device, node, name);
+            else if (event->mask & (IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE))
+                s_file_appeared(w, generation, device, node, name, s_file_type(w, node, name), true);
+        }
+
+        bool watcher_t::watch(dirpath_t const& root, const char* ospath)
+        {
+            if (m_fd < 0 || root.m_device == nullptr || m_num_roots == c_max_roots)
+                return false;
+            if (!m_paths->mount(root, ospath))
+                return false;
+
+            node_t const node = (root.m_path == c_empty_node || root.m_path == c_invalid_node) ? root.m_device->m_path : root.m_path;
+            m_roots[m_num_roots++] = node;
+            s_watch_tree(this, node);
+            if (node >= m_node_capacity || *m_node_to_wd.ptr_of(node) < 0)
+            {
+                m_num_roots -= 1;
+                return false;
+            }
+            return true;
+        }
+
+        u32 watcher_t::poll(u32 timeout_ms)
+        {
+            if (m_fd < 0)
+                return 0;
+
+            struct pollfd pfd;
+            pfd.fd     = m_fd;
+            pfd.events = POLLIN;
+            if (::poll(&pfd, 1, (int)timeout_ms) <= 0)
+                return 0;
+
+            CPATH_SCOPE("watcher_t::poll");
+            u32 const generation = m_generation + 1;
+            u32 const log_count  = m_log_count;
+            u32 const overflows  = m_overflows;
+            for (u32 reads = 0; reads < c_max_reads_per_poll; ++reads)
+            {
+                ssize_t const size = ::read(m_fd, m_buffer, c_event_buffer_size);
+                if (size <= 0)
+                {
+                    // Queue drained, coalesce a burst by waiting a little for more
+                    if (m_config.m_coalesce_ms == 0 || ::poll(&pfd, 1, (int)m_config.m_coalesce_ms) <= 0)
+                        break;
+                    continue;
+                }
+                for (ssize_t offset = 0; offset < size;)
+                {
+                    struct inotify_event const* event = (struct inotify_event const*)(m_buffer + offset);
+                    s_apply(this, generation, event);
+                    offset += sizeof(struct inotify_event) + event->len;
+                }
+            }
+
+            if (m_log_count != log_count || m_overflows != overflows)
+                m_generation = generation;
+            return m_log_count - log_count;
+        }
+
+#else
+
+        bool watcher_t::watch(dirpath_t const& root, const char* ospath) { return false; }
+        u32  watcher_t::poll(u32 timeout_ms) { return 0; }
+
+#endif
+
+    } // namespace npath
+} // namespace ncore
@@ -0,0 +1,95 @@
+#ifndef __C_PATH_BATCHREAD_H__
+#define __C_PATH_BATCHREAD_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "ccore/c_allocator.h"
+#include "ccore/c_debug.h"
+
+#include "cpath/c_types.h"
+#include "cpath/private/c_memory.h"
+
+namespace ncore
+{
+    namespace npath
+    {
+        namespace nbatch
+        {
+            enum ebackend
+            {
+                BackendAuto    = 0, // io_uring when the kernel allows it, the thread pool otherwise
+                BackendUring   = 1, // Linux io_uring
+                BackendThreads = 2, // blocking reads on the work-stealing pool
+            };
+        } // namespace nbatch
+
+        struct batch_config_t
+        {
+            u32 m_queue_depth; // reads in flight (io_uring), rounded up to a power of two
+            u32 m_num_threads; // thread pool backend, 0 = one per hardware thread
+            u8  m_backend;     // nbatch::ebackend
+            u8  m_padding[3];
+        };
+
+        extern const batch_config_t g_default_batch_config;
+
+        // The result of one read, 'm_request' is the index of the request in submission order (over all submit calls)
+        struct read_result_t
+        {
+            u32 m_request;
+            s32 m_error; // 0 or an errno value (e.g. ENOENT)
+            u64 m_bytes; // bytes written to the buffer, less than its size when the file is smaller
+        };
+
+        typedef void (*read_done_fn)(read_result_t const& result, void* user);
+
+        // Reads whole files named by filepath_t into caller-owned buffers, many at once. With io_uring the files
+        // are opened on the submitting thread (the OS path is rendered from the registry into a stack buffer) and
+        // the reads are queued in the kernel, up to m_queue_depth at a time. Without io_uring (other platforms,
+        // older kernels or a seccomp policy) the requests are read on the work-stealing pool. Buffers must stay
+        // valid until their result has been returned. The files must be below a mounted folder (paths_t::mount).
+        // A batchreader_t is used by one thread, results are returned on that thread.
+        struct batchreader_t
+        {
+            // Queue 'count' reads of filepaths[i] into buffers[i] (at most sizes[i] bytes), returns the index of the first
+            u32 submit(filepath_t const* filepaths, void* const* buffers, u64 const* sizes, u32 count);
+
+            // Return up to 'max_results' finished reads, with 'wait' at least one when reads are pending. The
+            // thread pool backend finishes all pending reads before it returns.
+            u32 poll(read_result_t* out_results, u32 max_results, bool wait);
+
+            // Poll until every submitted read has finished, 'fn' is called once per read, returns the number of reads
+            u32 drain(read_done_fn fn, void* user);
+
+            u32 pending() const { return m_num_requests - m_num_returned; }
+            u8  backend() const { return m_backend; }
+
+            DCORE_CLASS_PLACEMENT_NEW_DELETE
+
+            struct request_t;
+            struct uring_t;
+
+            alloc_t*           m_allocator;
+            paths_t*           m_paths;
+            batch_config_t     m_config;
+            u8                 m_backend; // the one in use, nbatch::ebackend
+            u8                 m_padding[3];
+            u32                m_num_requests; // submitted
+            u32                m_num_issued;   // opened and queued in the kernel / handed to the pool
+            u32                m_num_returned; // returned by poll
+            u32                m_in_flight;    // io_uring
+            u32                m_done_head;    // finished but not yet returned, in completion order
+            u32                m_done_tail;    //
+            vpool_t<request_t> m_requests;     //
+            uring_t*           m_uring;        // nullptr when the thread pool is used
+        };
+
+        batchreader_t* g_construct_batchreader(alloc_t* allocator, paths_t* paths, batch_config_t const& config = g_default_batch_config);
+        void           g_destruct_batchreader(alloc_t* allocator, batchreader_t*& reader);
+
+    } // namespace npath
+} // namespace ncore
+
+#endif // __C_PATH_BATCHREAD_H__
@@ -11,58 +11,77 @@
 #include "cbase/c_tree32.h"
 
 #include "cpath/c_types.h"
+#include "cpath/private/c_memory.h"
 
 namespace ncore
 {
     namespace npath
     {
+        // A physical device owns a folder tree, its root folder carries the device name ("e:"). An alias device
+        // ("appdir:") is a folder on another device, possibly an alias itself ("appdir:" -> "data:/app/" ->
+        // "e:/data/app/"). Folders are only ever registered in the physical trees, so the redirection is resolved
+        // once, when the alias is registered: m_path is the resolved folder and finalize() renders it into a prefix
+        // ("e:/data/app/"), rendering a path of an alias costs the same as one of a physical device. When an alias
+        // is pointed somewhere else the aliases that redirect to it are moved along and finalized again.
         struct device_t
         {
             inline string_t name() const { return m_name; }
 
-            void finalize(devices_t* devices);
+            void finalize(devices_t* devices); // renders the prefix of the (resolved) root
 
-            void register_dirpath(crunes_t const& dirpath, dirpath_t& out_dirpath);
+            void register_dirpath(crunes_t const& dirpath, dirpath_t& out_dirpath); // the path below the device, normalized in the same pass
             void register_filepath(crunes_t const& filepath, filepath_t& out_filepath);
 
             node_t get_parent_path(node_t path) const;
             node_t get_first_child_dir(node_t path) const;
             node_t add_dir(node_t current_dir, string_t dir);
-            node_t add_file(node_t current_dir, string_t file);
+            ifile_t add_file(node_t current_dir, string_t filename, string_t extension, u8 type);
+            node_t  find_dir(node_t current_dir, string_t dir) const;
+            ifile_t find_file(node_t current_dir, string_t filename, string_t extension) const;
 
-            void to_string(runes_t& str) const;
-            s32  to_strlen() const;
+            void to_string(runes_t& str) const;             // the prefix, e.g. "e:/data/app/"
+            s32  to_strlen() const;                         // O(1)
+            void to_string(node_t path, runes_t& str) const; // the prefix and the folders from the root down to 'path'
             s32  to_strlen(node_t path) const;
 
             DCORE_CLASS_PLACEMENT_NEW_DELETE
 
             paths_t*  m_owner;
             string_t  m_name;       // name (e.g. "appdir")
-            node_t    m_path;       // [folder_t] path (e.g. "data\bin.pc" or "e:\")
-            idevice_t m_index;      // index into m_pathreg->m_arr_devices
-            idevice_t m_redirector; // -> device("e:\")
+            node_t    m_path;       // [folder_t] root, resolved for an alias (e.g. "e:\" or "e:\data\bin.pc\")
+            idevice_t m_index;      // index into devices_t::m_array
+            idevice_t m_redirector; // the device of the folder an alias points at, c_invalid_device for a physical device
+            u32       m_prefix;     // the rendered root in devices_t::m_prefixes
+            s32       m_prefix_len; // bytes
+            s32       m_union;      // index into unions_t::m_unions, -1 when the device is not a union
             s32       m_userdata1;  //
             s32       m_userdata2;  //
         };
 
-        device_t* g_construct_device(alloc_t* allocator, paths_t* owner, idevice_t index);
-        void      g_destruct_device(alloc_t* allocator, device_t*& device);
-
+        // The devices live in a virtual memory array, a device is constructed when its name is registered and its
+        // address never changes. Two open addressing tables find a device by its name and by its root folder in
+        // O(1), they are rebuilt with twice the size when they get half full. Slot 0 is the default device.
         struct devices_t
         {
             idevice_t find_device(string_t device_name) const;
             idevice_t register_device(string_t device_name);
+            idevice_t register_alias(string_t device_name, idevice_t redirector, node_t target); // c_invalid_device for a physical device name or a cycle
+            idevice_t register_union(string_t device_name, idevice_t const* layers, u32 num_layers); // c_invalid_device for a physical or alias device name
             device_t* get_device(idevice_t index) const;
             device_t* get_default_device() const;
+            device_t* device_of_root(node_t root) const; // the device whose path is the folder 'root', nullptr if none
+            void      get_stats(paths_stats_t& stats) const;
 
             paths_t*          m_owner;
             strings_t*        m_strings;
-            device_t**        m_arr_devices;
-            ntree32::nnode_t* m_device_nodes;
-            ntree32::tree_t   m_device_tree;
-            ntree32::node_t   m_device_tree_root;
-            s32               m_num_devices;
-            s32               m_max_devices;
+            vpool_t<device_t> m_array;       // [0, m_num_devices) are constructed
+            vpool_t<u32>      m_name_table;  // device name -> index + 1 (0 = free)
+            vpool_t<u32>      m_root_table;  // root folder of the device -> index + 1 (0 = free)
+            vpool_t<char>     m_prefixes;    // rendered roots, a new one is appended when a device is finalized again
+            u32               m_prefix_used; //
+            s32               m_num_devices; //
+            s32               m_max_devices; // reserved address space, not memory
+            u32               m_table_size;  // power of two, both tables
             DCORE_CLASS_PLACEMENT_NEW_DELETE
         };
 
@@ -0,0 +1,64 @@
+#ifndef __C_PATH_DIFF_H__
+#define __C_PATH_DIFF_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "cpath/c_types.h"
+
+namespace ncore
+{
+    namespace npath
+    {
+        namespace ndiff
+        {
+            enum ekind
+            {
+                KindAdded    = 0, // only in b
+                KindRemoved  = 1, // only in a
+                KindModified = 2, // in both, but different (type, metadata or content hash)
+            };
+
+            enum eflags
+            {
+                CompareNames    = 0, // files in both trees are equal unless their type differs
+                CompareMetadata = 1, // size and mtime, when both files have valid metadata
+                CompareHash     = 2, // content hash, when both files have a valid hash (otherwise the metadata, when requested)
+            };
+        } // namespace ndiff
+
+        // 'a' is nullptr for KindAdded, 'b' is nullptr for KindRemoved
+        typedef void (*diff_fn)(u32 kind, filepath_t const* a, filepath_t const* b, void* user);
+
+        struct diff_stats_t
+        {
+            u64 m_folders;  // folder pairs compared
+            u64 m_files;    // file pairs compared
+            u64 m_added;    //
+            u64 m_removed;  //
+            u64 m_modified; //
+            u64 m_pruned;   // folder pairs skipped, equal fingerprints
+        };
+
+        // Difference between two folder trees, usually in two registries (e.g. two manifests or snapshots). Both
+        // trees are walked in lockstep, at every folder the files and sub folders of both sides are sorted by
+        // name and merged, so names are compared as strings (the registries have their own string pools) but
+        // only between siblings. A sub tree that is only on one side is reported file by file. Folders are not
+        // reported themselves, an empty folder that appears or disappears is not a difference. Tombstones are
+        // skipped and lazy folders are expanded. Neither registry may be modified during the diff.
+        // When both registries have fingerprints (paths_t::enable_fingerprints) and neither is lazy, a folder pair
+        // with equal fingerprints is skipped without walking it, unless only the metadata is compared (the
+        // fingerprint of a file with a content hash does not include its size and mtime).
+        struct diff_t
+        {
+            static void run(dirpath_t const& a, dirpath_t const& b, u32 flags, diff_fn fn, void* user, diff_stats_t& out_stats);
+
+            // Every device of both registries, paired by device name
+            static void run(paths_t* a, paths_t* b, u32 flags, diff_fn fn, void* user, diff_stats_t& out_stats);
+        };
+
+    } // namespace npath
+} // namespace ncore
+
+#endif // __C_PATH_DIFF_H__
@@ -31,6 +31,14 @@ namespace ncore
         friend class filepath_t;
         friend class filedevice_t;
         friend struct npath::paths_t;
+        friend struct npath::scanner_t;
+        friend struct npath::watcher_t;
+        friend struct npath::glob_t;
+        friend struct npath::walker_t;
+        friend struct npath::subtree_t;
+        friend struct npath::diff_t;
+        friend struct npath::lister_t;
+        friend filestream_t open_filestream(filepath_t const& filepath, u8 mode);
 
     public:
         dirpath_t(dirpath_t const& other);
@@ -59,13 +67,14 @@ namespace ncore
 
         s32        depth() const;                        // "E:\documents\old\inventory\books\sci-fi\", -> 5
         dirpath_t  up() const;                           // "E:\documents\old\inventory\books\sci-fi\", -> "E:\documents\old\inventory\books\"
-        dirpath_t  down() const;                         // return the first child folder of this dirpath
+        dirpath_t  down() const;                         // return the first child folder of this dirpath, empty when there is none
         dirpath_t  down(crunes_t const& folder) const;   // return the child folder of this dirpath that matches the folder name
         filepath_t filename(crunes_t const& filename) const; // "E:\documents\old\inventory\books\sci-fi\" + "perry-rhodan.pdf", -> "E:\documents\old\inventory\books\sci-fi\perry-rhodan.pdf"
 
         dirpath_t& operator=(dirpath_t const& other);
 
-        s32        compare(const dirpath_t& other) const;
+        s32        compare(const dirpath_t& other) const; // O(1), identity order
+        s32        collate(const dirpath_t& other) const; // lexicographic order of the full path, see paths_t::update_collation
 
         // (device = "E", base = "documents\old\inventory\", path = "books\sci-fi\") -> "books\sci-fi\"
         void relative_path_to_string(runes_t& str) const;
@@ -34,6 +34,7 @@ namespace ncore
         friend class fileinfo_t;
         friend class filedevice_t;
         friend struct npath::paths_t;
+        friend filestream_t open_filestream(filepath_t const& filepath, u8 mode);
 
     public:
         filepath_t(npath::device_t* d);
@@ -52,10 +53,13 @@ namespace ncore
 
         dirpath_t dirpath() const;
 
+        filepath_t& operator=(filepath_t const& other);
+
         void down(crunes_t const& folder);
         void up();
 
-        s8 compare(const filepath_t& right) const;
+        s8 compare(const filepath_t& right) const; // O(1), identity order
+        s8 collate(const filepath_t& right) const; // lexicographic order of the full path
 
         // void to_string(runes_t& str) const;
         // s32  to_strlen() const;
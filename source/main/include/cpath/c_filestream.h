@@ -0,0 +1,56 @@
+#ifndef __C_PATH_FILESTREAM_H__
+#define __C_PATH_FILESTREAM_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "cpath/c_types.h"
+
+namespace ncore
+{
+    namespace npath
+    {
+        namespace nstream
+        {
+            enum emode
+            {
+                ModeMapped     = 0, // zero-copy view of the whole file (mmap), shared by all streams of the same file
+                ModeSequential = 1, // buffered reads through the pooled descriptor, with kernel readahead hints
+            };
+        } // namespace nstream
+    } // namespace npath
+
+    // A read-only stream of a registered file. Open files are pooled per file node: opening the same filepath
+    // again, while it is open or shortly after, reuses the descriptor and the mapping. A filestream_t is a
+    // handle, copies refer to the same stream, close it once. When the file doesn't exist (or the filepath
+    // isn't below a mounted folder, see paths_t::mount) the stream is not open and contains no data.
+    // Reading one stream is not thread-safe, different streams (also of the same file) can be used in parallel.
+    class filestream_t
+    {
+    public:
+        filestream_t();
+
+        bool is_open() const;
+        u64  size() const;
+        u64  position() const;
+        bool seek(u64 position);
+
+        u64       read(void* out, u64 size);          // copies up to 'size' bytes, returns the number of bytes read
+        u64       view(u8 const*& out_data, u64 size); // zero-copy read (ModeMapped), 'out_data' points into the mapping
+        u8 const* data() const;                       // the whole file (ModeMapped), nullptr otherwise
+
+        void close();
+
+    protected:
+        npath::streams_t* m_streams;
+        u32               m_stream;
+
+        friend filestream_t open_filestream(filepath_t const& filepath, u8 mode);
+    };
+
+    filestream_t open_filestream(filepath_t const& filepath, u8 mode = npath::nstream::ModeMapped);
+
+} // namespace ncore
+
+#endif // __C_PATH_FILESTREAM_H__
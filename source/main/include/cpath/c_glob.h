@@ -0,0 +1,80 @@
+#ifndef __C_PATH_GLOB_H__
+#define __C_PATH_GLOB_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "ccore/c_allocator.h"
+#include "ccore/c_debug.h"
+#include "cbase/c_runes.h"
+
+#include "cpath/c_types.h"
+
+namespace ncore
+{
+    namespace npath
+    {
+        namespace nglob
+        {
+            enum ekind
+            {
+                KindLiteral  = 0, // no wildcards, resolved to a string_t and looked up directly (find_dir, find_file)
+                KindWildcard = 1, // '*', '?' and '[...]' ('[!...]' negates), matched against the name
+                KindAny      = 2, // a single '*', every name
+                KindAnyDepth = 3, // '**', zero or more folders
+            };
+        } // namespace nglob
+
+        // One '/' separated component of a pattern. The last component matches files, it is split at the first
+        // '.' like paths_t::register_filename, so the extension is matched on its own: "*.cpp" matches the files
+        // with extension ".cpp" (compared by string_t) and "*" or "Make*" (no '.') match the whole file name.
+        struct globpart_t
+        {
+            u8  m_kind;     // nglob::ekind of the name (a folder name or the file name)
+            u8  m_ext_kind; // nglob::ekind of the extension (file component with a '.')
+            u8  m_has_ext;  //
+            u8  m_padding;
+            u16 m_name;     // offset in glob_t::m_text
+            u16 m_name_len; //
+            u16 m_ext;      // offset in glob_t::m_text, includes the '.'
+            u16 m_ext_len;  //
+        };
+
+        // Called for every matching file, from the worker threads in the parallel mode
+        typedef void (*glob_fn)(ifile_t file, void* user);
+
+        // A compiled glob pattern, e.g. "src/**/*.cpp", matched against the folder tree below a dirpath. The walk
+        // carries the set of pattern components that can match at every folder (an NFA over the components), so
+        // every folder is visited at most once, sub trees that no component can match are not entered and when
+        // only literal components are left the next folder is looked up instead of scanned. Literal names are
+        // resolved to string_t once per match() call, a literal that is not in the registry matches nothing.
+        // Tombstones (FlagDeleted) are skipped, lazy folders are expanded when the walk enters them.
+        struct glob_t
+        {
+            // Calls 'fn' for every matching file below 'root', returns the number of matches. With 'num_threads'
+            // other than 1 the sub trees are distributed over the work-stealing pool (0 = all hardware threads).
+            u32 match(dirpath_t const& root, glob_fn fn, void* user, u32 num_threads = 1) const;
+
+            // The first 'max_files' matches below 'root' (walk order), returns the number written
+            u32 collect(dirpath_t const& root, ifile_t* out_files, u32 max_files) const;
+
+            DCORE_CLASS_PLACEMENT_NEW_DELETE
+
+            static const u32 c_max_parts = 32;
+            static const u32 c_max_text  = 1024;
+
+            paths_t*   m_paths;
+            u32        m_num_parts; // 0 when the pattern could not be compiled
+            globpart_t m_parts[c_max_parts];
+            char       m_text[c_max_text];
+        };
+
+        // Returns nullptr when the pattern has too many components or is too long
+        glob_t* g_compile_glob(alloc_t* allocator, paths_t* paths, crunes_t const& pattern);
+        void    g_destruct_glob(alloc_t* allocator, glob_t*& glob);
+
+    } // namespace npath
+} // namespace ncore
+
+#endif // __C_PATH_GLOB_H__
@@ -0,0 +1,95 @@
+#ifndef __C_PATH_INSTRUMENT_H__
+#define __C_PATH_INSTRUMENT_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+// Hot-path instrumentation, only compiled in when CPATH_INSTRUMENT is defined.
+// Counters are per thread, scoped timing events are recorded when tracing is enabled
+// and can be exported as Chrome trace JSON (chrome://tracing, Perfetto).
+
+namespace ncore
+{
+    namespace npath
+    {
+        namespace ninstrument
+        {
+            enum ecounter
+            {
+                StringFind = 0,       // strings_t::find calls
+                StringInsert,         // strings_t::insert calls
+                StringCompare,        // string pool tree comparisons
+                FolderAdd,            // device_t::add_dir calls
+                FolderCompare,        // sub folder tree comparisons
+                ParentWalk,           // steps taken walking up the m_parent chain
+                ChildLookup,          // dirpath_t::down calls
+                ArenaCommit,          // arena growth steps
+                ArenaCommitBytes,     // bytes committed by arena growth
+                CounterCount
+            };
+
+            struct snapshot_t
+            {
+                u64 m_counters[CounterCount];
+                u32 m_threads; // number of per-thread blocks that contributed, blocks are reused once their thread exits
+            };
+
+            // writer for the trace export, called with consecutive chunks of JSON
+            typedef void (*write_fn)(const char* str, u32 len, void* user);
+
+#ifdef CPATH_INSTRUMENT
+            void count(ecounter counter, u64 n);
+
+            void snapshot_thread(snapshot_t& out); // counters of the calling thread
+            void snapshot_all(snapshot_t& out);    // sum of the counters of all threads
+            void reset_all();
+
+            extern bool g_trace_enabled;
+
+            void enable_trace(bool enable);
+            void trace_event(const char* name, u64 start_ns, u64 end_ns);
+            void write_chrome_trace(write_fn writer, void* user);
+            u64  now_ns();
+
+            // Only reads the clock when tracing is enabled
+            struct scope_t
+            {
+                inline scope_t(const char* name) : m_name(name), m_start(g_trace_enabled ? now_ns() : 0) {}
+                inline ~scope_t()
+                {
+                    if (m_start != 0)
+                        trace_event(m_name, m_start, now_ns());
+                }
+                const char* m_name;
+                u64         m_start;
+            };
+#else
+            inline void snapshot_thread(snapshot_t& out)
+            {
+                for (s32 i = 0; i < CounterCount; ++i)
+                    out.m_counters[i] = 0;
+                out.m_threads = 0;
+            }
+            inline void snapshot_all(snapshot_t& out) { snapshot_thread(out); }
+            inline void reset_all() {}
+            inline void enable_trace(bool) {}
+            inline void write_chrome_trace(write_fn writer, void* user) { writer("{\"traceEvents\":[]}", 18, user); }
+#endif
+        } // namespace ninstrument
+    } // namespace npath
+} // namespace ncore
+
+#ifdef CPATH_INSTRUMENT
+#    define CPATH_COUNT(counter)         ::ncore::npath::ninstrument::count(::ncore::npath::ninstrument::counter, 1)
+#    define CPATH_COUNT_N(counter, n)    ::ncore::npath::ninstrument::count(::ncore::npath::ninstrument::counter, (n))
+#    define CPATH_SCOPE_CONCAT2(a, b)    a##b
+#    define CPATH_SCOPE_CONCAT(a, b)     CPATH_SCOPE_CONCAT2(a, b)
+#    define CPATH_SCOPE(name)            ::ncore::npath::ninstrument::scope_t CPATH_SCOPE_CONCAT(s_cpath_scope_, __LINE__)(name)
+#else
+#    define CPATH_COUNT(counter)
+#    define CPATH_COUNT_N(counter, n)
+#    define CPATH_SCOPE(name)
+#endif
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef __C_PATH_LISTING_H__
+#define __C_PATH_LISTING_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "ccore/c_allocator.h"
+#include "ccore/c_debug.h"
+
+#include "cpath/c_types.h"
+#include "cpath/c_walker.h"
+#include "cpath/private/c_memory.h"
+
+namespace ncore
+{
+    namespace npath
+    {
+        namespace nlist
+        {
+            enum eflags
+            {
+                Children  = 0, // the files and sub folders of the folder
+                Recursive = 1, // everything below the folder, a folder is followed by its sub tree
+            };
+        } // namespace nlist
+
+        // Ordered listing of the files and sub folders below a dirpath, in byte order of their names relative to
+        // it (a folder sorts as its name followed by a '/', so a recursive listing is in order of the full paths).
+        // The order comes from the name index (paths_t::enable_nameindex, enabled by the lister), a folder is
+        // sorted on its first listing, after that a seek to a prefix is a binary search and a page costs only its
+        // entries. A block is a sorted run plus a small sorted side run, a page merges the two. Entries registered
+        // after a listing are sorted on the next one and merged into the side run, which costs the new entries plus
+        // the side run, and the side run joins the first run once it outgrows the square root of it, so a folder
+        // that keeps growing between listings pays about the square root of its size per new entry. The prefix only applies to the names directly below the dirpath. The last walknode_t of a page
+        // is the resume token, resume() with it continues after that entry, also with a new lister or after files
+        // were registered. Entries registered while listing show up when they sort after the position of the
+        // lister. Tombstones are skipped, lazy folders are read on their first listing.
+        struct lister_t
+        {
+            void seek(dirpath_t const& dir, const char* prefix = nullptr, u32 flags = nlist::Children);
+            void resume(dirpath_t const& dir, const char* prefix, u32 flags, walknode_t const& last);
+            u32  next(walknode_t* out_nodes, u32 max_nodes); // the number of entries written, 0 when done
+
+            DCORE_CLASS_PLACEMENT_NEW_DELETE
+
+            static const u32 c_max_prefix = 256;
+
+            struct level_t
+            {
+                node_t m_folder;
+                u32    m_pos;      // next position in the first run of the block of the folder
+                u32    m_end;      // end of the first run, or of the prefix in it
+                u32    m_side_pos; // next position in the side run
+                u32    m_side_end; // end of the side run, or of the prefix in it
+                u32    m_version;  // of the block when the positions were computed
+                u32    m_last;    // entry that was listed last on this level, c_invalid_node = none
+            };
+
+            paths_t*         m_paths;
+            u32              m_flags; // nlist::eflags
+            u32              m_top;   // number of levels on the stack
+            u32              m_prefix_len;
+            vpool_t<level_t> m_stack;
+            char             m_prefix[c_max_prefix];
+        };
+
+        lister_t* g_construct_lister(alloc_t* allocator, dirpath_t const& dir, const char* prefix = nullptr, u32 flags = nlist::Children);
+        void      g_destruct_lister(alloc_t* allocator, lister_t*& lister);
+
+    } // namespace npath
+} // namespace ncore
+
+#endif // __C_PATH_LISTING_H__
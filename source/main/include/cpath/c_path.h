@@ -11,22 +11,104 @@
 #include "cbase/c_tree32.h"
 
 #include "cpath/c_types.h"
+#include "cpath/private/c_memory.h"
 
 namespace ncore
 {
     namespace npath
     {
+        struct arena_usage_t
+        {
+            u64 m_reserved;  // bytes of address space reserved
+            u64 m_committed; // bytes of memory committed
+        };
+
+        // Memory and shape of a registry, all counters are maintained incrementally so this is O(1)
+        struct paths_stats_t
+        {
+            arena_usage_t m_string_data;  // utf-8 string bytes
+            arena_usage_t m_string_array; // strings_t::str_t[]
+            arena_usage_t m_string_nodes; // red-black tree nodes of the string pool
+            arena_usage_t m_folder_array; // folder_t[]
+            arena_usage_t m_folder_nodes; // red-black tree nodes of all sub folder trees
+            arena_usage_t m_file_array;   // file_t[]
+            arena_usage_t m_file_nodes;   // red-black tree nodes of all file trees
+            arena_usage_t m_device_array; // device_t[] and the name and root tables
+            u64           m_string_count; // number of unique strings
+            u64           m_string_bytes; // bytes used by unique strings, including terminators
+            u32           m_folder_count; // number of folders, including the device roots
+            u32           m_file_count;   // number of files, including the default file
+            u32           m_device_count; // number of registered devices
+            f32           m_avg_children; // average number of sub folders of folders that have sub folders
+            u32           m_max_children; // largest number of sub folders of any folder
+            u32           m_max_depth;    // height of the deepest folder tree
+            u64           m_wasted_bytes; // probe (find) and temp slots that hold no data
+        };
+
+        namespace nmeta
+        {
+            enum eflags
+            {
+                FlagValid   = 1, // the fields hold the result of the last stat pass
+                FlagChanged = 2, // the last stat pass found different values than the one before (or none before)
+                FlagMissing = 4, // the last stat pass could not find it on disk
+            };
+        } // namespace nmeta
+
+        // File system metadata of a folder or file, see paths_t::enable_metadata
+        struct filestat_t
+        {
+            u64 m_size;     // bytes
+            s64 m_mtime_ns; // modification time, nanoseconds since the epoch
+            u64 m_inode;    //
+            u64 m_device;   // file system device (st_dev)
+            u32 m_mode;     // st_mode
+            u32 m_flags;    // nmeta::eflags
+        };
+
+        // Aggregates of a folder over its whole sub tree, see paths_t::enable_rollups
+        struct rollup_t
+        {
+            u64 m_bytes;    // sum of the file sizes
+            s64 m_mtime_ns; // newest file modification time, 0 = none
+            u32 m_files;    // files that are not tombstones
+            u32 m_padding;
+        };
+
+        // 128-bit fingerprint of a folder over its sub tree, see paths_t::enable_fingerprints (m_lo alone is a 64-bit one)
+        struct fingerprint_t
+        {
+            u64 m_lo;
+            u64 m_hi;
+        };
+
+        // 128-bit content hash of a file, see paths_t::enable_hashes
+        struct contenthash_t
+        {
+            u64 m_lo;
+            u64 m_hi;
+        };
+
         struct paths_t
         {
             // -----------------------------------------------------------
             // device registration
             device_t* register_device(crunes_t const& devicename);
+            device_t* register_alias(crunes_t const& devicename, dirpath_t const& target); // (re)points "appdir:" at a folder, nullptr for a physical device or a cycle
+            bool      register_prefix(crunes_t const& prefix, device_t* device); // POSIX paths below "/mnt/data/" are on 'device', false for a prefix with ".."
+            device_t* root_device();                                           // "/"
+            device_t* home_device();                                           // "~", an alias of $HOME when it is absolute, otherwise a device of its own
             node_t    allocate_folder(string_t name);
 
             // -----------------------------------------------------------
             void   register_filename(crunes_t const& filename, string_t& out_name, string_t& out_ext);
 
             // -----------------------------------------------------------
+            // A full path starts with a device ("e:/...", "appdir:/..."), or it is a POSIX path: "/home/x/" is on the
+            // root device (named "", it renders as "/"), "~/" on the home device and a path below a mount prefix on the
+            // device of the longest prefix that matches ("/mnt/data/" -> "data:"). The prefixes are a trie over their
+            // components, finding the device is O(path depth) however many prefixes there are. ".." does not leave
+            // the device a path was found on.
             dirpath_t  register_fulldirpath(crunes_t const& fulldirpath);
             filepath_t register_fullfilepath(crunes_t const& fullfilepath);
 
@@ -40,20 +122,136 @@ namespace ncore
             s8 compare_str(string_t left, string_t right) const;
             s8 compare_str(folder_t* left, folder_t* right) const;
 
+            // Lexicographic order of the full paths of two folders ("c:/foo.d/" before "c:/foo/"), uses the collation
+            // keys when they are up-to-date (O(1)), otherwise walks up to the common ancestor and compares the names
+            // below it as "name/". The keys are current while the folder count is the one they were built for,
+            // folders are never removed or renamed, so adding one is the only change that makes them stale.
+            s8   collate_folder(node_t left, node_t right) const;
+            void update_collation(); // (re)build the collation keys, O(n log n)
+            s8   collate_file(node_t left_folder, string_t left_name, string_t left_ext, node_t right_folder, string_t right_name, string_t right_ext) const; // "c:/a/b/x.txt" before "c:/a/z.txt"
+
             crunes_t get_crunes(string_t str) const;
             void     to_string(string_t str, runes_t& out_str) const;
             s32      to_strlen(string_t str) const;
 
+            // Render the folders below 'from' up to and including 'to', e.g. "inventory/books/", when 'from' is
+            // c_invalid_node (or not an ancestor of 'to') the full path including the device is rendered, "E:/documents/.../books/"
+            void folder_to_string(node_t to, node_t from, runes_t& out_str) const;
+            s32  folder_to_strlen(node_t to, node_t from) const;
+
+            // The same, with the prefix of 'device' in front when the walk ends at 'from' (see device_t::to_string)
+            void folder_to_string(node_t to, node_t from, device_t const* device, runes_t& out_str) const;
+
+            // -----------------------------------------------------------
+            // Optional metadata columns (size, mtime, inode, device, mode) per folder and file node, filled
+            // by scanner_t::stat. Change detection is a sweep over the flags, no path strings are involved.
+            void       enable_metadata();
+            bool       get_folder_stat(node_t folder, filestat_t& out_stat) const;
+            bool       get_file_stat(ifile_t file, filestat_t& out_stat) const;
+            u32        changed_files(ifile_t from, ifile_t* out_files, u32 max_files) const; // files with FlagChanged, starting at 'from'
+            void       set_file_stat(ifile_t file, filestat_t const& stat); // enables the metadata, the rollups follow
+            device_t*  device_of(node_t folder) const;
+            filepath_t get_filepath(ifile_t file) const;
+            ifile_t    file_of(filepath_t const& filepath); // the file node of a filepath, registered when it has none yet
+
+            // -----------------------------------------------------------
+            // Optional content hash per file node, filled by scanner_t::hash, which only hashes files whose size or
+            // mtime differ from the ones recorded with their hash. The hashes can be saved to and loaded from a
+            // file (keyed by the path relative to 'root'), so unchanged files are not hashed again in the next run.
+            void enable_hashes();
+            bool get_file_hash(ifile_t file, contenthash_t& out_hash) const; // false when the file has no valid hash
+            u32  changed_hashes(ifile_t from, ifile_t* out_files, u32 max_files) const; // files whose hash changed in the last pass
+            bool save_hashes(dirpath_t const& root, const char* ospath) const;
+            bool load_hashes(dirpath_t const& root, const char* ospath);
+
+            // -----------------------------------------------------------
+            // Optional extension index: the files of every extension in a compact list, kept current when files are
+            // added, deleted or reappear (tombstones). The list is kept in a few runs sorted by the pre-order of the
+            // folders, so below a folder the query is two binary searches per run plus the result and doesn't modify
+            // the index. Both return the number of matching files, at most 'max_files' of them are written.
+            void enable_extindex();
+            u32  files_with_extension(string_t extension, ifile_t* out_files, u32 max_files) const;
+            u32  files_with_extension(dirpath_t const& dir, string_t extension, ifile_t* out_files, u32 max_files) const;
+
+            // -----------------------------------------------------------
+            // Optional rollups per folder over its sub tree: bytes, files and the newest mtime (from the metadata
+            // columns). Files that are added, become tombstones or come back and set_file_stat update every folder
+            // on the parent chain, so a query is O(1); scanner_t::stat recomputes them in bulk after its pass.
+            // Losing the newest file marks the folders that had it, their mtime is rebuilt on the next query.
+            void enable_rollups(); // computes them for the registry as it is
+            void update_rollups(); // bulk recompute, O(n), after changing the metadata columns directly
+            bool get_rollup(dirpath_t const& dir, rollup_t& out_rollup); // false when the rollups are not enabled
+
+            // -----------------------------------------------------------
+            // Optional Merkle fingerprint per folder over its sub tree: the names and types of everything below it
+            // and the content of the files (their content hash, otherwise size and mtime). It does not depend on the
+            // registration order, so equal fingerprints, also from two registries, mean equal sub trees that need no
+            // walk. Changes mark the folder and its parents dirty, a query of a dirty folder or update_fingerprints
+            // recompute the dirty folders, a level at a time on 'num_threads' workers (0 = hardware threads).
+            // Lazy folders that were not read yet count as empty.
+            void enable_fingerprints(u32 num_threads = 0); // computes them for the registry as it is
+            void update_fingerprints(u32 num_threads = 0);
+            bool get_fingerprint(dirpath_t const& dir, fingerprint_t& out_fingerprint); // false when not enabled
+
+            // -----------------------------------------------------------
+            // Optional name index: per folder its files and sub folders in byte order of their names, built on the
+            // first ordered listing of the folder (see lister_t in c_listing.h, which enables it), entries that are
+            // registered later are appended and merged in on the next listing.
+            void enable_nameindex();
+
+            // -----------------------------------------------------------
+            // Union devices: "assets:" over an ordered list of layers ("patch:", "dlc:", "base:"), a folder or file of
+            // the union is the one of the first layer that has it. The union has a folder tree of its own for the paths
+            // asked for, every folder and file node of it caches its resolution, so asking again is one probe. A folder
+            // or file added, deleted or back in the tree of a layer, or a layer alias pointed elsewhere, invalidates
+            // the cached resolutions of the unions over it. Registering the union again replaces its layers.
+            device_t* register_union(crunes_t const& devicename, device_t* const* layers, u32 num_layers); // nullptr for a physical or alias device name
+            bool      resolve(dirpath_t const& dir, dirpath_t& out_dir);       // false when no layer has it, a path that is not in a union is itself
+            bool      resolve(filepath_t const& file, filepath_t& out_file); // registers the file in the union tree
+
+            // -----------------------------------------------------------
+            // OS folders behind registered folders, used by lazy materialization, the watcher and the file streams.
+            // The OS path of a folder or file is the OS path of the nearest mounted ancestor followed by the names
+            // below it, the return value is its length or -1 when there is no mount or it doesn't fit.
+            bool mount(dirpath_t const& root, const char* ospath);
+            s32  folder_to_ospath(node_t folder, char* out_path, s32 max_len) const;
+            s32  file_to_ospath(ifile_t file, char* out_path, s32 max_len) const;
+
+            // -----------------------------------------------------------
+            // Lazy materialization (opt-in): the folders below 'root' are read from 'ospath' on disk the first time
+            // they are enumerated (dirpath_t::down), exactly once per folder. Enumerating readers may run concurrently
+            // with an expansion, they only take a lock when they hit a folder that has not been read yet.
+            bool enable_lazy(dirpath_t const& root, const char* ospath);
+            bool expand(node_t folder); // read a lazy folder now (no-op when done before), false when it isn't lazy or unreadable
+
+            // -----------------------------------------------------------
+            void stats(paths_stats_t& out_stats) const;
+
             DCORE_CLASS_PLACEMENT_NEW_DELETE
 
             // -----------------------------------------------------------
             //
-            alloc_t*   m_allocator;
-            strings_t* m_strings;
-            devices_t* m_devices;
-            folders_t* m_folders;
+            alloc_t*        m_allocator;
+            strings_t*      m_strings;
+            devices_t*      m_devices;
+            folders_t*      m_folders;
+            files_t*        m_files;
+            metadata_t*     m_metadata;     // nullptr until enable_metadata()
+            lazy_t*         m_lazy;         // nullptr until enable_lazy()
+            mounts_t*       m_mounts;       // nullptr until mount()
+            streams_t*      m_streams;      // nullptr until the first mount()
+            hashes_t*       m_hashes;       // nullptr until enable_hashes()
+            extindex_t*     m_extindex;     // nullptr until enable_extindex()
+            rollups_t*      m_rollups;      // nullptr until enable_rollups()
+            fingerprints_t* m_fingerprints; // nullptr until enable_fingerprints()
+            nameindex_t*    m_nameindex;    // nullptr until enable_nameindex()
+            unions_t*       m_unions;       // nullptr until register_union()
+            prefixtrie_t*   m_prefixtrie;   // nullptr until register_prefix()
+            u32             m_max_items;
+            varena_config_t m_config;
         };
 
+        paths_t* g_construct_paths(alloc_t* allocator, u32 max_items, varena_config_t const& config);
         paths_t* g_construct_paths(alloc_t* allocator, u32 max_items);
         paths_t* g_construct_paths(alloc_t* allocator);
         void     g_destruct_paths(alloc_t* allocator, paths_t*& paths);
@@ -0,0 +1,60 @@
+#ifndef __C_PATH_SCANNER_H__
+#define __C_PATH_SCANNER_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "cpath/c_types.h"
+
+namespace ncore
+{
+    namespace npath
+    {
+        struct scan_config_t
+        {
+            u32 m_num_threads; // 0 = one per hardware thread
+            u32 m_max_depth;   // number of folder levels below the scan root to visit, 0 = unlimited
+        };
+
+        extern const scan_config_t g_default_scan_config;
+
+        struct scan_stats_t
+        {
+            u64 m_folders;  // folders visited (including the scan root)
+            u64 m_files;    // regular files registered
+            u64 m_symlinks; // symbolic links registered as files, they are not followed
+            u64 m_others;   // fifo, socket and device entries registered as files
+            u64 m_stats;    // fstatat calls, scan: entries without a type from the file system, stat: every file
+            u64 m_errors;   // folders that could not be opened or read
+            u64 m_changed;  // stat: files whose metadata differs from the previous pass (or that had none)
+            u64 m_missing;  // stat: registered files that are not on disk (anymore)
+            u64 m_hashed;   // hash: files whose content was read and hashed, the others still had a valid hash
+        };
+
+        // Populates the registry from disk.
+        // The folder 'ospath' is enumerated (openat/getdents64 on Linux) and everything below it is registered
+        // below 'root', directly by node, there is no full path string per entry. Sub folders are distributed
+        // over a work-stealing pool, the registry itself is updated under a lock once per batch of entries.
+        // Files carry their file system type (nfile::etype), symbolic links are registered but not followed.
+        // Returns false when 'ospath' could not be opened or when the platform is not supported.
+        //
+        // stat() walks the folders and files that are registered below 'root' (it doesn't enumerate the disk)
+        // and fills the metadata columns (see paths_t::enable_metadata) with fstat/fstatat, distributed over
+        // the same work-stealing pool. Afterwards FlagChanged marks exactly the files that changed since the
+        // previous stat pass, see paths_t::changed_files. The registry must not be modified during a stat pass.
+        //
+        // hash() walks the registered files below 'root' like stat() and computes the content hash (see
+        // paths_t::enable_hashes) of every regular file whose size or mtime differs from the ones stored with
+        // its hash, large files are mapped, small ones read. m_changed counts the files whose hash changed.
+        struct scanner_t
+        {
+            static bool scan(dirpath_t const& root, const char* ospath, scan_config_t const& config, scan_stats_t& out_stats);
+            static bool stat(dirpath_t const& root, const char* ospath, scan_config_t const& config, scan_stats_t& out_stats);
+            static bool hash(dirpath_t const& root, const char* ospath, scan_config_t const& config, scan_stats_t& out_stats);
+        };
+
+    } // namespace npath
+} // namespace ncore
+
+#endif // __C_PATH_SCANNER_H__
@@ -0,0 +1,44 @@
+#ifndef __C_PATH_SUBTREE_H__
+#define __C_PATH_SUBTREE_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "cpath/c_types.h"
+
+namespace ncore
+{
+    namespace npath
+    {
+        typedef void (*subtree_fn)(paths_t* paths, node_t folder, void* user);
+
+        // Map/reduce over a sub tree, every worker has its own accumulator of m_acc_size bytes (cleared by
+        // m_init), the visit functions fold folders and files into the accumulator of the worker that runs
+        // them, at the end the accumulators are merged into the result in worker order.
+        struct reducer_t
+        {
+            u32   m_acc_size;                                                      // bytes per accumulator
+            void  (*m_init)(void* acc, void* user);                                //
+            void  (*m_folder)(paths_t* paths, node_t folder, void* acc, void* user); // nullptr = not called
+            void  (*m_file)(paths_t* paths, ifile_t file, void* acc, void* user);    // nullptr = not called, tombstones are skipped
+            void  (*m_merge)(void* acc, void const* other, void* user);            // 'other' into 'acc'
+            void* m_user;
+        };
+
+        // Parallel traversal of the folders below (and including) 'root' on a work-stealing pool. A worker walks
+        // its part depth-first on a small local stack, when that stack fills up the bottom half (the folders
+        // closest to the root, the largest remaining sub trees) is handed to the pool where idle workers steal
+        // it, so the tasks follow the actual sizes of the sub trees, whatever the shape of the tree.
+        // The visit functions run concurrently and must not modify the registry; lazy folders are expanded
+        // when they are entered. Both return the number of folders visited.
+        struct subtree_t
+        {
+            static u32 parallel_for(dirpath_t const& root, subtree_fn fn, void* user, u32 num_threads = 0);                  // 0 = one per hardware thread
+            static u32 parallel_reduce(dirpath_t const& root, reducer_t const& reducer, void* out_acc, u32 num_threads = 0); // out_acc is initialized by m_init
+        };
+
+    } // namespace npath
+} // namespace ncore
+
+#endif // __C_PATH_SUBTREE_H__
@@ -11,6 +11,7 @@ namespace ncore
 
     class filepath_t;
     class dirpath_t;
+    class filestream_t;
 
     namespace ntree32
     {
@@ -26,13 +27,33 @@ namespace ncore
         struct folder_t;
         struct files_t;
         struct paths_t;
+        struct paths_stats_t;
+        struct scanner_t;
+        struct metadata_t;
+        struct watcher_t;
+        struct lazy_t;
+        struct mounts_t;
+        struct streams_t;
+        struct hashes_t;
+        struct extindex_t;
+        struct rollups_t;
+        struct fingerprints_t;
+        struct nameindex_t;
+        struct unions_t;
+        struct prefixtrie_t;
+        struct glob_t;
+        struct walker_t;
+        struct subtree_t;
+        struct diff_t;
+        struct lister_t;
 
         struct devices_t;
 
         typedef u32             ifolder_t;
+        typedef u32             ifile_t;
         typedef u32             string_t;
         typedef ntree32::node_t node_t;
-        typedef s16             idevice_t;
+        typedef s32             idevice_t;
 
         const u32       c_invalid_file   = 0xFFFFFFFF;
         const u32       c_invalid_folder = 0xFFFFFFFF;
@@ -0,0 +1,77 @@
+#ifndef __C_PATH_WALKER_H__
+#define __C_PATH_WALKER_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "ccore/c_allocator.h"
+#include "ccore/c_debug.h"
+
+#include "cpath/c_types.h"
+#include "cpath/private/c_memory.h"
+
+namespace ncore
+{
+    namespace npath
+    {
+        namespace nwalk
+        {
+            enum eflags
+            {
+                PreOrder       = 0, // a folder before its files and sub folders
+                PostOrder      = 1, // a folder after its files and sub folders
+                InsertionOrder = 0, // siblings in the order they were registered
+                SortedByName   = 2, // siblings in lexicographic order of their name (files by name, then extension)
+                FoldersOnly    = 0, //
+                WithFiles      = 4, // the files of a folder come before its sub folders
+            };
+
+            enum etype
+            {
+                TypeFolder = 0, // m_node is a folder node
+                TypeFile   = 1, // m_node is an ifile_t
+            };
+        } // namespace nwalk
+
+        struct walknode_t
+        {
+            u32 m_node;  // folder node or file, see m_type
+            u16 m_depth; // 0 = the root of the walk, its files and sub folders are 1
+            u8  m_type;  // nwalk::etype
+            u8  m_padding;
+        };
+
+        // Depth-first walk over the folders (and files) below a dirpath, including the dirpath itself. There is
+        // no recursion, the pending nodes are on an explicit stack, and the node that comes next is prefetched
+        // (its folder_t or file_t and its name) while the caller handles the current one. Tombstones are skipped,
+        // lazy folders are expanded when the walk enters them. Registering below a folder that is on the stack
+        // while walking is not supported.
+        struct walker_t
+        {
+            bool next(walknode_t& out_node); // false when the walk is done
+            void reset(dirpath_t const& root, u32 flags);
+
+            DCORE_CLASS_PLACEMENT_NEW_DELETE
+
+            struct entry_t
+            {
+                u32 m_node;
+                u16 m_depth;
+                u8  m_type;
+                u8  m_visited; // post-order, the children of the folder are on the stack
+            };
+
+            paths_t*         m_paths;
+            u32              m_flags; // nwalk::eflags
+            u32              m_top;   // number of entries on the stack
+            vpool_t<entry_t> m_stack;
+        };
+
+        walker_t* g_construct_walker(alloc_t* allocator, dirpath_t const& root, u32 flags = nwalk::PreOrder | nwalk::InsertionOrder);
+        void      g_destruct_walker(alloc_t* allocator, walker_t*& walker);
+
+    } // namespace npath
+} // namespace ncore
+
+#endif // __C_PATH_WALKER_H__
@@ -0,0 +1,100 @@
+#ifndef __C_PATH_WATCHER_H__
+#define __C_PATH_WATCHER_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "ccore/c_allocator.h"
+#include "ccore/c_debug.h"
+
+#include "cpath/c_types.h"
+#include "cpath/private/c_memory.h"
+
+namespace ncore
+{
+    namespace npath
+    {
+        namespace nchange
+        {
+            enum ekind
+            {
+                KindCreated  = 1, // registered (or re-created after a delete)
+                KindDeleted  = 2, // removed on disk, the node stays registered as a tombstone (FlagDeleted)
+                KindModified = 3, // content or attributes changed, or removed and re-created within one generation
+            };
+        } // namespace nchange
+
+        // One entry of the change log, 'm_index' is a node_t (folder) or an ifile_t (file)
+        struct change_t
+        {
+            u32 m_generation;
+            u32 m_index;
+            u8  m_kind;    // nchange::ekind
+            u8  m_is_file; //
+            u8  m_padding[2];
+        };
+
+        struct watch_config_t
+        {
+            u32 m_coalesce_ms; // after the first event, keep reading until the queue has been quiet this long
+            u32 m_max_watches; // upper bound of live watches (address space of the descriptor table)
+        };
+
+        extern const watch_config_t g_default_watch_config;
+
+        // Keeps a registry live: every registered folder below a watched dirpath (mounted on 'ospath', see
+        // paths_t::mount) gets an inotify watch, events are mapped from their watch descriptor to the folder
+        // node and applied to the folder and file stores by node, new folders are scanned and watched. Removed
+        // folders and files are not taken out of the trees, they are marked with FlagDeleted (a tombstone) and
+        // cleared again when they re-appear. A rename is a delete of the old name and a create of the new one.
+        //
+        // Every poll() that applies events is one generation, all events on the same node within a generation
+        // coalesce into one change, changes_since() answers "what changed after generation N" (newest state of
+        // every node only). The watcher updates the registry on the calling thread, the registry must not be
+        // modified by anyone else during poll(). Linux only, elsewhere watch() returns false.
+        struct watcher_t
+        {
+            bool watch(dirpath_t const& root, const char* ospath);
+
+            // Wait up to 'timeout_ms' for events and apply them, returns the number of change log entries written
+            u32 poll(u32 timeout_ms);
+
+            u32  generation() const { return m_generation; }
+            bool overflowed() const { return m_overflows != 0; } // events were lost, a rescan is needed
+
+            // Changes made after 'generation', start with 'cursor' = 0 and repeat until it returns 0
+            u32 changes_since(u32 generation, u32& cursor, change_t* out_changes, u32 max_changes) const;
+
+            DCORE_CLASS_PLACEMENT_NEW_DELETE
+
+            static const s32 c_max_roots = 16;
+
+            paths_t*          m_paths;
+            watch_config_t    m_config;
+            s32               m_fd; // inotify instance
+            u32               m_generation;
+            u32               m_overflows;
+            s32               m_num_roots;
+            node_t            m_roots[c_max_roots];
+            vpool_t<u32>      m_wd_table;      // watch descriptor -> 1 + folder, open addressing, 0 = empty slot
+            u32               m_wd_table_size; // power of two, kept at most half full
+            u32               m_num_watches;   //
+            vpool_t<s32>      m_node_to_wd;  // folder -> watch descriptor, -1 = not watched
+            u32               m_node_capacity;
+            vpool_t<u32>      m_folder_last; // folder -> 1 + index of its latest change log entry, 0 = none
+            u32               m_folder_capacity;
+            vpool_t<u32>      m_file_last; // file -> 1 + index of its latest change log entry, 0 = none
+            u32               m_file_capacity;
+            vpool_t<change_t> m_log; // ordered by generation
+            u32               m_log_count;
+            u8*               m_buffer; // event buffer
+        };
+
+        watcher_t* g_construct_watcher(alloc_t* allocator, paths_t* paths, watch_config_t const& config = g_default_watch_config);
+        void       g_destruct_watcher(alloc_t* allocator, watcher_t*& watcher);
+
+    } // namespace npath
+} // namespace ncore
+
+#endif // __C_PATH_WATCHER_H__
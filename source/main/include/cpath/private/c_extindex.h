@@ -0,0 +1,74 @@
+#ifndef __C_PATH_EXTINDEX_H__
+#define __C_PATH_EXTINDEX_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "cpath/c_types.h"
+#include "cpath/private/c_memory.h"
+
+namespace ncore
+{
+    class alloc_t;
+
+    namespace npath
+    {
+        // The files of one extension, a block of m_capacity entries in extindex_t::m_files of which the first
+        // m_entries are in use. A block that is full moves to the end of the storage with twice the capacity.
+        // The entries are sorted runs whose sizes are the bits of m_entries (largest first), adding a file merges the
+        // runs of the trailing zero bits. A file that becomes a tombstone keeps its entry (c_extentry_removed) until
+        // half of the entries are tombstones, then the block is merged into one run without them.
+        struct extbucket_t
+        {
+            string_t m_ext;      // extension
+            u32      m_offset;   // first entry in extindex_t::m_files
+            u32      m_count;    // files, the entries that are not tombstones
+            u32      m_entries;  // entries
+            u32      m_capacity; // entries
+        };
+
+        static const u32 c_extentry_removed = 0x80000000;
+
+        // Secondary index, extension -> files that are not tombstones. Every file knows its position in the
+        // list of its extension, so removing and adding back is O(1) and adding is amortized O(log files).
+        // The folders get nested pre-order intervals [enter, leave) with gaps, a folder contains every folder whose
+        // enter is in its interval, so the runs sorted by the enter of the file folders answer a sub tree with two
+        // binary searches per run. A new folder takes a part of the gap in front of the first child of its parent,
+        // when there is none the smallest ancestor that is sparse enough is renumbered. The renumbering keeps the
+        // order, the runs stay sorted and a query doesn't modify the index.
+        struct extindex_t
+        {
+            vpool_t<u32>         m_files;       // bucket storage, file ids
+            vpool_t<u32>         m_slot;        // per file, its position in the bucket of its extension
+            vpool_t<extbucket_t> m_buckets;     // in order of first use
+            vpool_t<u32>         m_table;       // open addressing on the extension, bucket index + 1 (0 = free)
+            vpool_t<u64>         m_enter;       // per folder, pre-order number
+            vpool_t<u64>         m_leave;       // per folder, above the numbers of its descendants
+            vpool_t<u32>         m_size;        // per folder, number of folders in its sub tree
+            vpool_t<u32>         m_scratch;     // merging two runs
+            u32                  m_used;        // entries of m_files handed out to buckets
+            u32                  m_num_buckets; //
+            u32                  m_table_size;  // power of two
+            u32                  m_slots;       // number of files m_slot can hold
+            u32                  m_roots;       // folder trees (device roots and the default folder) that have an interval
+            DCORE_CLASS_PLACEMENT_NEW_DELETE
+        };
+
+        extindex_t*  g_construct_extindex(alloc_t* allocator, u32 max_items, varena_config_t const& config = g_default_arena_config);
+        void         g_destruct_extindex(alloc_t* allocator, extindex_t*& index);
+        void         g_extindex_add(extindex_t* index, files_t const* files, ifile_t file, string_t extension);
+        void         g_extindex_remove(extindex_t* index, files_t const* files, ifile_t file, string_t extension);
+        void         g_extindex_build_intervals(extindex_t* index, folders_t const* folders); // every folder, when the index is enabled
+        void         g_extindex_add_folder(extindex_t* index, folders_t const* folders, node_t folder); // O(depth), a new folder or folder tree
+        extbucket_t* g_extindex_find(extindex_t const* index, string_t extension); // nullptr when no file has it
+        u32          g_extindex_files(extindex_t const* index, extbucket_t const* bucket, ifile_t* out_files, u32 max_files);
+        u32          g_extindex_files_below(extindex_t const* index, extbucket_t const* bucket, files_t const* files, node_t folder, ifile_t* out_files, u32 max_files);
+
+        // Set or clear the tombstone of a file, the extension index and the rollups (when enabled) follow
+        void g_set_file_deleted(paths_t* paths, ifile_t file, bool deleted);
+
+    } // namespace npath
+} // namespace ncore
+
+#endif
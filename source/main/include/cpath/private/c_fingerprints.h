@@ -0,0 +1,69 @@
+#ifndef __C_PATH_FINGERPRINTS_H__
+#define __C_PATH_FINGERPRINTS_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "cpath/c_types.h"
+#include "cpath/private/c_memory.h"
+
+namespace ncore
+{
+    class alloc_t;
+
+    namespace npath
+    {
+        namespace nfingerprint
+        {
+            enum eflags
+            {
+                FlagDirty      = 1, // the fingerprint is out of date, so are the ones of all parents
+                FlagFilesDirty = 2, // the files of the folder changed, their sum is recomputed
+                FlagQueued     = 4, // in m_pending
+            };
+        } // namespace nfingerprint
+
+        // 128-bit sum of entry hashes and the number of entries, the order of the entries does not matter
+        struct fpsum_t
+        {
+            u64 m_lo;
+            u64 m_hi;
+            u64 m_count;
+        };
+
+        // Merkle fingerprint per folder node over its sub tree. Every live file and sub folder is an entry, the hash
+        // of its name, type and content (a file: its content hash, otherwise its size and mtime, otherwise nothing;
+        // a sub folder: its fingerprint). The fingerprint is the hash of the sum of the entries, so it does not
+        // depend on the order in which things were registered and two registries with the same sub tree agree.
+        // A change marks the folder and its parents dirty (up to the first one that already is). Dirty folders are
+        // recomputed from the deepest level up: the files are only hashed again when they changed, the entry of a
+        // sub folder replaces its previous one in the sum of the parent, so a folder with many sub folders costs
+        // the same as one with a few. Folders that become dirty are queued, so an update after a few changes does
+        // not look at the others; after a bulk change (invalidate) all folders are swept instead.
+        struct fingerprints_t
+        {
+            vpool_t<u64>     m_lo;       // 128-bit fingerprint, low half (a 64-bit fingerprint on its own)
+            vpool_t<u64>     m_hi;       // 128-bit fingerprint, high half
+            vpool_t<fpsum_t> m_files;    // sum of the file entries
+            vpool_t<fpsum_t> m_children; // sum of the sub folder entries
+            vpool_t<fpsum_t> m_entry;    // the entry of the folder in the sum of its parent, 0 when not in it
+            vpool_t<u8>      m_dirty;    // nfingerprint::eflags
+            vpool_t<node_t>  m_pending;  // the dirty folders, unless m_sweep
+            u32              m_num_pending;
+            bool             m_sweep;    // every folder may be dirty, m_pending is not used
+            u32              m_capacity; // number of folder nodes the columns can hold
+            DCORE_CLASS_PLACEMENT_NEW_DELETE
+        };
+
+        fingerprints_t* g_construct_fingerprints(alloc_t* allocator, u32 max_items, varena_config_t const& config = g_default_arena_config);
+        void            g_destruct_fingerprints(alloc_t* allocator, fingerprints_t*& fingerprints);
+        void            g_fingerprint_dirty(paths_t* paths, node_t folder); // a file in the folder or the folder itself (new, deleted) changed
+        void            g_fingerprint_invalidate(paths_t* paths);           // all folders, after passes that bypass the above
+        void            g_fingerprint_update(paths_t* paths, u32 num_threads); // the dirty folders, a level at a time on the work pool
+        void            g_fingerprint_get(paths_t* paths, node_t folder, u64& out_lo, u64& out_hi); // updates first when the folder is dirty
+
+    } // namespace npath
+} // namespace ncore
+
+#endif
@@ -16,16 +16,43 @@ namespace ncore
 {
     namespace npath
     {
+        namespace nfolder
+        {
+            enum eflags
+            {
+                FlagDeleted  = 1, // tombstone, the folder was removed on disk (see watcher_t)
+                FlagLazy     = 2, // children are read from disk on first enumeration (see paths_t::enable_lazy)
+                FlagExpanded = 4, // a lazy folder whose children have been read
+                FlagMount    = 8, // an OS folder is mounted here (see paths_t::mount)
+            };
+        } // namespace nfolder
+
         struct folder_t
         {
-            ifolder_t m_parent;  // folder parent (index into m_folder_array)
-            string_t  m_name;    // folder name
-            node_t    m_folders; // sub folders (tree root node)
+            ifolder_t m_parent;      // folder parent (index into m_folder_array)
+            string_t  m_name;        // folder name
+            node_t    m_folders;     // sub folders (tree root node)
+            u32       m_num_folders; // number of sub folders
+            u32       m_depth;       // number of folders between this folder and the device root
+            node_t    m_files;       // files (tree root node, index into files_t)
+            u32       m_num_files;   // number of files
+            ifolder_t m_child;       // first sub folder, sub folders are linked most recently added first
+            ifolder_t m_sibling;     // next sub folder of m_parent
+            ifile_t   m_file;        // first file, files are linked most recently added first
+            u32       m_flags;       // nfolder::eflags
             void      reset()
             {
-                m_parent  = c_invalid_folder;
-                m_name    = c_empty_string;
-                m_folders = c_invalid_node;
+                m_parent      = c_invalid_folder;
+                m_name        = c_empty_string;
+                m_folders     = c_invalid_node;
+                m_num_folders = 0;
+                m_depth       = 0;
+                m_files       = c_invalid_node;
+                m_num_files   = 0;
+                m_child       = c_invalid_folder;
+                m_sibling     = c_invalid_folder;
+                m_file        = c_invalid_file;
+                m_flags       = 0;
             }
         };
 
@@ -33,34 +60,83 @@ namespace ncore
         {
             ntree32::tree_t           m_tree;
             u32                       m_count;
+            u32                       m_num_parents;  // number of folders that have at least one sub folder
+            u32                       m_num_children; // number of folders that are a sub folder of another folder
+            u32                       m_max_children; // largest m_num_folders of any folder
+            u32                       m_max_depth;    // largest m_depth of any folder
+            u32                       m_collate_count; // m_count at the time the collation keys were built
             vpool_t<ntree32::nnode_t> m_nodes;
             vpool_t<folder_t>         m_array;
+            vpool_t<u32>              m_collate; // per folder, rank of its full path in lexicographic order
             DCORE_CLASS_PLACEMENT_NEW_DELETE
         };
 
-        folders_t* g_construct_folders(alloc_t* allocator, u32 max_items);
+        folders_t* g_construct_folders(alloc_t* allocator, u32 max_items, varena_config_t const& config = g_default_arena_config);
         void       g_destruct_folders(alloc_t* allocator, folders_t*& folders);
         node_t     g_allocate_folder(folders_t* folders, string_t name);
+        void       g_ensure_folder_capacity(folders_t* folders, u32 index);
+        void       g_add_child_folder(folders_t* folders, folder_t* parent, folder_t* child);
+        void       g_get_stats(folders_t const* folders, paths_stats_t& stats);
 
-        // typedef u32 ifile_t;
-        // struct file_t
-        // {
-        //     string_t m_filename;  // file name
-        //     string_t m_extension; // file extension
-        // };
+        // True when walking up from 'folder' reaches 'ancestor' (or 'folder' is 'ancestor')
+        bool g_folder_is_below(folders_t const* folders, node_t folder, node_t ancestor);
 
-        // struct files_t
-        // {
-        //     ntree32::tree_t             m_tree; // And extensions
-        //     u32                         m_count;
-        //     vpool_t<ntree32::nnode_t> m_nodes;
-        //     vpool_t<file_t>           m_array; // A file consists of a filename and an extension
-        //     DCORE_CLASS_PLACEMENT_NEW_DELETE
-        // };
+        // Calls 'fn' for the folders from 'to' up to 'from' (exclusive) top-down, when 'from' is not an ancestor of
+        // 'to' the walk ends at the top of the tree, which is included. There is no limit on the depth.
+        typedef void (*folder_fn)(node_t folder, void* user);
+        void g_for_each_folder_down(folders_t const* folders, node_t to, node_t from, folder_fn fn, void* user);
+
+        namespace nfile
+        {
+            enum etype
+            {
+                TypeUnknown = 0, // the file system didn't tell
+                TypeRegular = 1, // regular file
+                TypeSymlink = 2, // symbolic link, never followed
+                TypeOther   = 3, // fifo, socket, device
+            };
+
+            enum eflags
+            {
+                FlagDeleted = 1, // tombstone, the file was removed on disk (see watcher_t)
+            };
+        } // namespace nfile
+
+        struct file_t
+        {
+            string_t  m_filename;  // file name
+            string_t  m_extension; // file extension
+            ifolder_t m_folder;    // the folder this file lives in
+            ifile_t   m_sibling;   // next file in m_folder
+            u8        m_type;      // nfile::etype
+            u8        m_flags;     // nfile::eflags
+            u8        m_padding[2];
+            void      reset()
+            {
+                m_filename   = c_empty_string;
+                m_extension  = c_empty_string;
+                m_folder     = c_invalid_folder;
+                m_sibling    = c_invalid_file;
+                m_type       = nfile::TypeUnknown;
+                m_flags      = 0;
+                m_padding[0] = m_padding[1] = 0;
+            }
+        };
+
+        // Every folder has a tree of its files ordered by (filename, extension), all trees share the node pool
+        struct files_t
+        {
+            ntree32::tree_t           m_tree;
+            u32                       m_count;
+            vpool_t<ntree32::nnode_t> m_nodes;
+            vpool_t<file_t>           m_array; // A file consists of a filename and an extension
+            DCORE_CLASS_PLACEMENT_NEW_DELETE
+        };
 
-        // files_t* g_construct_files(alloc_t* allocator, u32 max_items);
-        // void     g_destruct_files(alloc_t* allocator, files_t*& files);
-        // node_t   g_allocate_file(files_t* folders, string_t filename, string_t extension);
+        files_t* g_construct_files(alloc_t* allocator, u32 max_items, varena_config_t const& config = g_default_arena_config);
+        void     g_destruct_files(alloc_t* allocator, files_t*& files);
+        void     g_ensure_file_capacity(files_t* files, u32 index);
+        void     g_get_stats(files_t const* files, paths_stats_t& stats);
 
     } // namespace npath
 } // namespace ncore
@@ -0,0 +1,44 @@
+#ifndef __C_PATH_HASHES_H__
+#define __C_PATH_HASHES_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "cpath/c_types.h"
+#include "cpath/private/c_memory.h"
+
+namespace ncore
+{
+    class alloc_t;
+
+    namespace npath
+    {
+        struct contenthash_t;
+
+        // Content hash per file node, with the size and mtime of the file at the time it was hashed. A hash is
+        // valid (nmeta::FlagValid) until the file on disk has a different size or mtime. Laid out as columns,
+        // like the metadata, so the validation sweep only touches size and mtime.
+        struct hashes_t
+        {
+            vpool_t<u64> m_lo;       // 128-bit hash, low half
+            vpool_t<u64> m_hi;       // 128-bit hash, high half
+            vpool_t<u64> m_size;     // bytes, when hashed
+            vpool_t<s64> m_mtime;    // nanoseconds since the epoch, when hashed
+            vpool_t<u8>  m_flags;    // nmeta::FlagValid, nmeta::FlagChanged (the last pass computed a different hash)
+            u32          m_capacity; // number of file nodes the columns can hold
+            DCORE_CLASS_PLACEMENT_NEW_DELETE
+        };
+
+        hashes_t* g_construct_hashes(alloc_t* allocator, u32 max_items, varena_config_t const& config = g_default_arena_config);
+        void      g_destruct_hashes(alloc_t* allocator, hashes_t*& hashes);
+        void      g_ensure_hashes_capacity(hashes_t* hashes, u32 count); // new entries are cleared (no flags)
+        void      g_set_hash(hashes_t* hashes, ifile_t file, u64 size, s64 mtime_ns, contenthash_t const& hash); // FlagChanged when different
+
+        // MurmurHash3 x64 128-bit, seed 0
+        void g_hash128(void const* data, u64 size, contenthash_t& out_hash);
+
+    } // namespace npath
+} // namespace ncore
+
+#endif
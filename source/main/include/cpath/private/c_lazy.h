@@ -0,0 +1,36 @@
+#ifndef __C_PATH_LAZY_H__
+#define __C_PATH_LAZY_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "ccore/c_allocator.h"
+#include "ccore/c_debug.h"
+
+#include "cpath/c_types.h"
+#include "cpath/private/c_threads.h"
+
+namespace ncore
+{
+    namespace npath
+    {
+        // Folders below a lazy root (a mount, see paths_t::mount) carry nfolder::FlagLazy (inherited by add_dir), the first enumeration of such
+        // a folder reads it from disk once and sets nfolder::FlagExpanded. Expansion is serialized by m_lock,
+        // readers test the flags with acquire semantics and only take the lock for an unexpanded folder.
+        struct lazy_t
+        {
+            mutex_t m_lock;
+            u64     m_expanded; // folders read from disk
+            DCORE_CLASS_PLACEMENT_NEW_DELETE
+        };
+
+        lazy_t* g_construct_lazy(alloc_t* allocator);
+        void    g_destruct_lazy(alloc_t* allocator, lazy_t*& lazy);
+        void    g_mark_lazy(paths_t* paths, node_t folder);
+        bool    g_expand_folder(paths_t* paths, node_t folder); // true when the folder is lazy and its children are registered
+
+    } // namespace npath
+} // namespace ncore
+
+#endif // __C_PATH_LAZY_H__
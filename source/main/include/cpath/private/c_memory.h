@@ -9,11 +9,44 @@ namespace ncore
 {
     namespace npath
     {
+        namespace narena
+        {
+            enum epages
+            {
+                PagesDefault         = 0, // regular OS pages
+                PagesTransparentHuge = 1, // regular pages advised as 2 MB transparent huge pages (madvise)
+                PagesHugeTLB         = 2, // explicit hugetlb pages for the initial capacity, PagesTransparentHuge for the rest and when unavailable
+            };
+
+            enum egrowth
+            {
+                GrowMinimal   = 0, // commit only what is needed (+ c_capacity_bias items)
+                GrowGeometric = 1, // at least double the committed size on every growth step
+            };
+
+            const u32 c_huge_page_size = 2 * 1024 * 1024;
+        } // namespace narena
+
+        struct varena_config_t
+        {
+            u8  m_pages;       // narena::epages
+            u8  m_growth;      // narena::egrowth
+            u8  m_prefault;    // fault-in every committed range in bulk at commit time
+            u8  m_padding;     //
+            u32 m_commit_step; // minimum number of bytes per commit (rounded up to the arena page size)
+        };
+
+        extern const varena_config_t g_default_arena_config;
+
         struct varena_t
         {
-            u8* m_ptr;       // Virtual memory
-            u64 m_reserved;  // Maximum reserved item count (unit=item size), memory size = m_reserved * item size
-            u64 m_committed; // Current committed item count (unit=item size), memory size = m_committed * item size
+            u8*             m_ptr;       // Virtual memory
+            u64             m_reserved;  // Maximum reserved item count (unit=item size), memory size = m_reserved * item size
+            u64             m_committed; // Current committed item count (unit=item size), memory size = m_committed * item size
+            u32             m_item_size; // Item size given at init time
+            u32             m_page_size; // Commit granularity, the OS page size or the huge page size
+            u64             m_hugetlb;   // Bytes at the start of the reservation on hugetlb pages
+            varena_config_t m_config;    // Page and growth behaviour
 
             // Note: You need to stick to a particular item size when using this interface
             void reset(u64 initial_capacity, u32 item_size = 1);
@@ -31,10 +64,14 @@ namespace ncore
             // Index to pointer and pointer to index
             inline u32 idx_of(u8 const* item, u32 item_size = 1) const { return (u32)(item - m_ptr) / item_size; }
             inline u8* ptr_of(u32 index, u32 item_size = 1) const { return m_ptr + index * item_size; }
+
+            inline u64 reserved_bytes() const { return m_reserved * m_item_size; }
+            u64        committed_bytes() const;
         };
 
         void g_init_arena(varena_t& m);
         void g_init_arena(varena_t& m, u64 initial_capacity, u64 max_capacity, u32 item_size = 1);
+        void g_init_arena(varena_t& m, u64 initial_capacity, u64 max_capacity, u32 item_size, varena_config_t const& config);
         void g_teardown_arena(varena_t& m);
 
         template <typename T> struct vpool_t
@@ -45,7 +82,7 @@ namespace ncore
             void add_capacity(u64 add_capacity) { m_arena.add_capacity(add_capacity, sizeof(T)); }
 
             inline T* ptr() const { return (T*)m_arena.m_ptr; }
-            void      ensure_capacity(u64 capacity, u32 add_capacity_when_needed = 64 * 1024) { m_arena.ensure_capacity(capacity, add_capacity_when_needed); }
+            void      ensure_capacity(u64 capacity, u32 add_capacity_when_needed = 64 * 1024) { m_arena.ensure_capacity((u32)capacity, sizeof(T), add_capacity_when_needed); }
 
             T* allocate(u32 items) { return (T*)m_arena.allocate((u8*&)m_arena.m_ptr, items, sizeof(T)); }
             T* reserve(u32 items) { return (T*)m_arena.reserve(m_arena.m_ptr, items, sizeof(T)); }
@@ -56,11 +93,14 @@ namespace ncore
         };
 
         template<typename T>
-        inline void g_setup_vpool(vpool_t<T>& o) { g_init_arena(o.m); }
+        inline void g_setup_vpool(vpool_t<T>& o) { g_init_arena(o.m_arena); }
 
         template<typename T>
         inline void g_setup_vpool(vpool_t<T>& o, u64 initial_capacity, u64 max_capacity) { g_init_arena(o.m_arena, initial_capacity, max_capacity, sizeof(T)); }
 
+        template<typename T>
+        inline void g_setup_vpool(vpool_t<T>& o, u64 initial_capacity, u64 max_capacity, varena_config_t const& config) { g_init_arena(o.m_arena, initial_capacity, max_capacity, sizeof(T), config); }
+
         template<typename T>
         inline void g_teardown_vpool(vpool_t<T>& o) { g_teardown_arena(o.m_arena); }
 
@@ -0,0 +1,49 @@
+#ifndef __C_PATH_METADATA_H__
+#define __C_PATH_METADATA_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "cpath/c_types.h"
+#include "cpath/private/c_memory.h"
+
+namespace ncore
+{
+    class alloc_t;
+
+    namespace npath
+    {
+        struct filestat_t;
+
+        // One array per field, indexed by folder or file node, so a sweep over one field (e.g. mtime for change
+        // detection) touches only that field. Memory is reserved up-front and committed as the registry grows.
+        struct columns_t
+        {
+            vpool_t<u64> m_size;     // bytes
+            vpool_t<s64> m_mtime;    // nanoseconds since the epoch
+            vpool_t<u64> m_inode;    //
+            vpool_t<u64> m_device;   // st_dev
+            vpool_t<u32> m_mode;     // st_mode
+            vpool_t<u8>  m_flags;    // nmeta::eflags
+            u32          m_capacity; // number of nodes the columns can hold
+        };
+
+        struct metadata_t
+        {
+            columns_t m_folders;
+            columns_t m_files;
+            DCORE_CLASS_PLACEMENT_NEW_DELETE
+        };
+
+        metadata_t* g_construct_metadata(alloc_t* allocator, u32 max_items, varena_config_t const& config = g_default_arena_config);
+        void        g_destruct_metadata(alloc_t* allocator, metadata_t*& metadata);
+        void        g_ensure_metadata_capacity(columns_t& columns, u32 count); // new entries are cleared (no flags)
+        void        g_get_metadata(columns_t const& columns, u32 index, filestat_t& out_stat);
+        void        g_set_metadata(columns_t& columns, u32 index, filestat_t const& stat); // sets FlagValid, FlagChanged when different
+        void        g_set_metadata_missing(columns_t& columns, u32 index);                 // sets FlagMissing, FlagChanged when it was valid
+
+    } // namespace npath
+} // namespace ncore
+
+#endif
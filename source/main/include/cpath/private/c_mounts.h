@@ -0,0 +1,41 @@
+#ifndef __C_PATH_MOUNTS_H__
+#define __C_PATH_MOUNTS_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "ccore/c_allocator.h"
+#include "ccore/c_debug.h"
+
+#include "cpath/c_types.h"
+
+namespace ncore
+{
+    namespace npath
+    {
+        struct mount_t
+        {
+            node_t m_node;       // registered folder
+            s32    m_ospath_len; //
+            char*  m_ospath;     // OS folder behind it, without a trailing '/'
+        };
+
+        // The OS folders behind registered folders (see paths_t::mount), mount roots carry nfolder::FlagMount so
+        // resolving a path only searches this table for folders that actually are a mount root.
+        struct mounts_t
+        {
+            static const s32 c_max_mounts = 16;
+
+            s32     m_count;
+            mount_t m_mounts[c_max_mounts];
+            DCORE_CLASS_PLACEMENT_NEW_DELETE
+        };
+
+        mounts_t* g_construct_mounts(alloc_t* allocator);
+        void      g_destruct_mounts(alloc_t* allocator, mounts_t*& mounts);
+
+    } // namespace npath
+} // namespace ncore
+
+#endif // __C_PATH_MOUNTS_H__
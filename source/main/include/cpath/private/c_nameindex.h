@@ -0,0 +1,71 @@
+#ifndef __C_PATH_NAMEINDEX_H__
+#define __C_PATH_NAMEINDEX_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "cpath/c_types.h"
+#include "cpath/private/c_memory.h"
+
+namespace ncore
+{
+    class alloc_t;
+
+    namespace npath
+    {
+        static const u32 c_nameentry_file = 0x80000000; // an entry with this bit is a file, otherwise a folder node
+
+        // The files and sub folders of one folder in byte order of their names, a block of m_capacity entries in
+        // nameindex_t::m_entries of which the first m_count are in use. The block is two sorted runs, the first
+        // m_sorted entries and the m_side entries after them. Entries registered after that are appended, the next
+        // query sorts only those and merges them into the side run, and the side run is merged into the first one
+        // when it grows past the square root of it (from the first position that changes). A block that is full
+        // moves to the end of the storage with twice the capacity.
+        struct nameblock_t
+        {
+            u32 m_offset;   // first entry in nameindex_t::m_entries
+            u32 m_count;    // entries
+            u32 m_capacity; // 0 = the folder has no block yet
+            u32 m_sorted;   // entries of the first run
+            u32 m_side;     // entries of the side run
+            u32 m_version;  // incremented when the order changes, positions from before are stale
+        };
+
+        // An entry with the first 8 bytes of its name (big-endian, zero padded), most comparisons while sorting
+        // only need the key
+        struct namesort_t
+        {
+            u64 m_key;
+            u32 m_entry;
+            u32 m_padding;
+        };
+
+        // Secondary index, folder -> its entries ordered by name. The name of a file is its name followed by its
+        // extension, the name of a folder is followed by a '/', so the order of the entries of nested folders is
+        // the byte order of the full paths. Tombstones stay in the blocks (they may come back), readers skip them.
+        struct nameindex_t
+        {
+            vpool_t<u32>         m_entries;  // block storage
+            vpool_t<nameblock_t> m_blocks;   // per folder node
+            vpool_t<namesort_t>  m_scratch;  // sorting and merging
+            u32                  m_used;     // entries of m_entries handed out to blocks
+            u32                  m_capacity; // folder nodes m_blocks can hold
+            DCORE_CLASS_PLACEMENT_NEW_DELETE
+        };
+
+        nameindex_t* g_construct_nameindex(alloc_t* allocator, u32 max_items, varena_config_t const& config = g_default_arena_config);
+        void         g_destruct_nameindex(alloc_t* allocator, nameindex_t*& index);
+        void         g_nameindex_add(paths_t* paths, node_t folder, u32 entry); // a new file or sub folder of a folder that has a block
+        nameblock_t* g_nameindex_block(paths_t* paths, node_t folder);         // built (lazy folders are read first) and sorted
+
+        // Binary searches in the sorted run [begin, end) of a block, the first entry whose name cut to the length of
+        // 'prefix' is not below 'prefix' (upper: above), so [lower, upper) are the entries that start with it
+        u32 g_nameindex_seek(paths_t const* paths, nameblock_t const* block, u32 begin, u32 end, const char* prefix, u32 len, bool upper);
+        u32 g_nameindex_after(paths_t const* paths, nameblock_t const* block, u32 begin, u32 end, u32 entry); // the first entry with a name above the one of 'entry'
+        s8  g_nameindex_compare(paths_t const* paths, u32 a, u32 b);                                          // the order of two entries
+
+    } // namespace npath
+} // namespace ncore
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef __C_PATH_PREFIXTRIE_H__
+#define __C_PATH_PREFIXTRIE_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "cpath/c_types.h"
+#include "cpath/private/c_memory.h"
+
+namespace ncore
+{
+    class alloc_t;
+
+    namespace npath
+    {
+        static const u32 c_invalid_prefix = 0xFFFFFFFF;
+
+        // A component of a mount prefix, "/mnt/data/" is the root -> "mnt" -> "data"
+        struct prefixnode_t
+        {
+            string_t  m_name;         // interned component
+            u32       m_parent;       // c_invalid_prefix for the root
+            idevice_t m_device;       // the device of the paths below the prefix, c_invalid_device when it is not one
+            u32       m_num_children; //
+        };
+
+        // The mount prefixes of POSIX paths as a trie over their components. The children of all nodes are in one
+        // open addressing table keyed by (parent, interned name), kept at most half full and rebuilt with twice the
+        // size, so a step down is O(1) however many prefixes share a parent. Node 0 is the root ("/").
+        struct prefixtrie_t
+        {
+            vpool_t<prefixnode_t> m_nodes;      //
+            vpool_t<u32>          m_table;      // (parent, name) -> node + 1 (0 = free)
+            u32                   m_num_nodes;  //
+            u32                   m_table_size; // power of two
+            DCORE_CLASS_PLACEMENT_NEW_DELETE
+        };
+
+        prefixtrie_t* g_construct_prefixtrie(alloc_t* allocator, varena_config_t const& config = g_default_arena_config);
+        void          g_destruct_prefixtrie(alloc_t* allocator, prefixtrie_t*& trie);
+        u32           g_prefixtrie_child(prefixtrie_t const* trie, u32 parent, string_t name); // c_invalid_prefix when there is none
+        u32           g_prefixtrie_insert(prefixtrie_t* trie, u32 parent, string_t name);      // the child, added when there is none
+
+    } // namespace npath
+} // namespace ncore
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef __C_PATH_ROLLUPS_H__
+#define __C_PATH_ROLLUPS_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "cpath/c_types.h"
+#include "cpath/private/c_memory.h"
+
+namespace ncore
+{
+    class alloc_t;
+
+    namespace npath
+    {
+        struct filestat_t;
+
+        // Aggregates per folder node over its whole sub tree: bytes, files (that are not tombstones) and the newest
+        // mtime, the size and mtime of a file come from the metadata columns (0 without valid metadata). A change
+        // to a file is applied to every folder on its m_parent chain. The newest mtime cannot be taken back, when
+        // the file that had it goes away (or gets older) the folders that had it are marked stale and rebuilt from
+        // their files and sub folders on the next query. That query is not O(1), it visits the files and sub folders
+        // of every stale folder below the one asked for.
+        struct rollups_t
+        {
+            vpool_t<u64> m_bytes;    //
+            vpool_t<s64> m_mtime;    // newest, nanoseconds since the epoch, 0 = none
+            vpool_t<u32> m_files;    //
+            vpool_t<u8>  m_stale;    // m_mtime may be newer than what is left in the sub tree
+            vpool_t<u32> m_order;    // the stale folders being rebuilt, parents before their sub folders
+            u32          m_capacity; // number of folder nodes the columns can hold
+            DCORE_CLASS_PLACEMENT_NEW_DELETE
+        };
+
+        rollups_t* g_construct_rollups(alloc_t* allocator, u32 max_items, varena_config_t const& config = g_default_arena_config);
+        void       g_destruct_rollups(alloc_t* allocator, rollups_t*& rollups);
+        void       g_rollup_add(paths_t* paths, ifile_t file);    // the file was added or is no longer a tombstone
+        void       g_rollup_remove(paths_t* paths, ifile_t file); // the file became a tombstone, before its metadata changes
+        void       g_rollup_change(paths_t* paths, ifile_t file, u64 old_size, s64 old_mtime); // the metadata of a live file changed
+        void       g_rollup_recompute(paths_t* paths);            // all folders, O(n), after passes that bypass the above
+        void       g_rollup_get(paths_t* paths, node_t folder, u64& out_bytes, u32& out_files, s64& out_mtime);
+
+        // The size and mtime a file contributes, 0 when it has no valid metadata
+        void g_rollup_contribution(paths_t const* paths, ifile_t file, u64& out_size, s64& out_mtime);
+
+    } // namespace npath
+} // namespace ncore
+
+#endif
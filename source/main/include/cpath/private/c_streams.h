@@ -0,0 +1,85 @@
+#ifndef __C_PATH_STREAMS_H__
+#define __C_PATH_STREAMS_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "ccore/c_allocator.h"
+#include "ccore/c_debug.h"
+
+#include "cpath/c_types.h"
+#include "cpath/private/c_memory.h"
+#include "cpath/private/c_threads.h"
+
+namespace ncore
+{
+    namespace npath
+    {
+        const u32 c_invalid_mapping = 0xFFFFFFFF;
+        const u32 c_invalid_stream  = 0xFFFFFFFF;
+
+        // An open file, one per file node. It holds the pooled descriptor and, once a mapped stream asked for it,
+        // the read-only mapping of the whole file (a copy for files up to c_copy_threshold, mapping those costs
+        // more than reading them). Without streams it stays open on the idle list (LRU) until more than m_max_idle
+        // files are idle.
+        struct mapping_t
+        {
+            ifile_t m_file;     // file node
+            s32     m_fd;       //
+            u8*     m_data;     // nullptr until mapped
+            u64     m_size;     // bytes, at open time
+            s64     m_mtime_ns; // at open time, an idle mapping of a file that changed is not reused
+            u64     m_dev;      // at open time, with m_ino the identity of the file, a file replaced by a rename
+            u64     m_ino;      // keeps the size and mtime of the old one on the descriptor
+            u32     m_refs;     // open streams
+            u32     m_prev;     // idle list, c_invalid_mapping terminated
+            u32     m_next;     // idle list, also the free list
+            u8      m_copied;   // m_data is an allocated copy instead of a mapping
+            u8      m_padding[3];
+        };
+
+        // One open stream, a filestream_t is a handle to one of these
+        struct stream_t
+        {
+            u32 m_mapping;     // the file
+            u8  m_mode;        // nstream::emode
+            u8  m_padding[3];  //
+            u64 m_position;    // read position
+            u8* m_buffer;      // ModeSequential, c_buffer_size bytes
+            u64 m_buffer_base; // file offset of m_buffer[0]
+            u32 m_buffer_len;  // valid bytes in m_buffer
+            u32 m_next;        // free list
+        };
+
+        struct streams_t
+        {
+            static const u32 c_buffer_size    = 64 * 1024;
+            static const u32 c_copy_threshold = 16 * 1024;
+
+            paths_t*           m_paths;
+            mutex_t            m_lock;           // open and close, reading a stream doesn't lock
+            vpool_t<u32>       m_file_mapping;   // file node -> mapping, c_invalid_mapping = not open
+            u32                m_file_capacity;  //
+            vpool_t<mapping_t> m_mappings;       //
+            u32                m_num_mappings;   //
+            u32                m_free_mapping;   //
+            u32                m_idle_head;      // most recently released
+            u32                m_idle_tail;      // evicted first
+            u32                m_num_idle;       //
+            u32                m_max_idle;       //
+            vpool_t<stream_t>  m_streams;        //
+            u32                m_num_streams;    //
+            u32                m_free_stream;    //
+            u64                m_opens;          // open calls that found the file
+            u64                m_reuses;         // of those, the ones that reused an open descriptor or mapping
+            DCORE_CLASS_PLACEMENT_NEW_DELETE
+        };
+
+        streams_t* g_construct_streams(alloc_t* allocator, paths_t* paths, u32 max_idle = 64);
+        void       g_destruct_streams(alloc_t* allocator, streams_t*& streams);
+
+    } // namespace npath
+} // namespace ncore
+
+#endif // __C_PATH_STREAMS_H__
@@ -6,6 +6,7 @@
 #endif
 
 #include "cpath/c_types.h"
+#include "cpath/private/c_memory.h"
 
 namespace ncore
 {
@@ -33,7 +34,14 @@ namespace ncore
             string_t insert(crunes_t const& str);
 
             u32  get_len(string_t index) const;
-            s8   compare(string_t left, string_t right) const;
+            void get_stats(paths_stats_t& stats) const;
+            s8   compare(string_t left, string_t right) const; // hash order, fast but not lexicographic
+            s8   collate(string_t left, string_t right) const; // lexicographic (byte) order
+
+            // Lexicographic order of names the way a path renders them, a folder as "name/" and a file as "name.ext"
+            s8 collate_folders(string_t left, string_t right) const;
+            s8 collate_files(string_t left_name, string_t left_ext, string_t right_name, string_t right_ext) const;
+            s8 collate_file_folder(string_t name, string_t ext, string_t folder) const;
             void view_string(string_t str, crunes_t& out_str) const;
 
             string_t object_to_index(str_t const* item) const; // { return m_data.m_str_buffer.idx_of((u8 const*)item, sizeof(str_t)); }
@@ -47,7 +55,7 @@ namespace ncore
             members_t* m_data;
         };
 
-        strings_t* g_construct_strings(alloc_t* allocator, u64 max_items = 16 * 1024 * 1024);
+        strings_t* g_construct_strings(alloc_t* allocator, u64 max_items = 16 * 1024 * 1024, varena_config_t const& config = g_default_arena_config);
         void       g_destruct_strings(alloc_t* allocator, strings_t*& strings);
 
     } // namespace npath
@@ -0,0 +1,64 @@
+#ifndef __C_PATH_THREADS_H__
+#define __C_PATH_THREADS_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "cpath/private/c_memory.h"
+
+namespace ncore
+{
+    class alloc_t;
+
+    namespace npath
+    {
+        // Number of hardware threads, 1 on platforms without thread support
+        u32 g_hardware_threads();
+
+        struct mutex_t
+        {
+            void init();
+            void exit();
+            void lock();
+            void unlock();
+
+            u64 m_storage[8]; // pthread_mutex_t
+        };
+
+        // Acquire/release access to a word that readers check without taking a lock
+#if defined(__GNUC__) || defined(__clang__)
+        inline u32  g_load_acquire(u32 const& value) { return __atomic_load_n(&value, __ATOMIC_ACQUIRE); }
+        inline void g_store_release(u32& value, u32 v) { __atomic_store_n(&value, v, __ATOMIC_RELEASE); }
+#else
+        inline u32  g_load_acquire(u32 const& value) { return *(u32 const volatile*)&value; }
+        inline void g_store_release(u32& value, u32 v) { *(u32 volatile*)&value = v; }
+#endif
+
+        struct lock_t
+        {
+            inline lock_t(mutex_t& m) : m_mutex(m) { m_mutex.lock(); }
+            inline ~lock_t() { m_mutex.unlock(); }
+            mutex_t& m_mutex;
+        };
+
+        // Work-stealing pool for recursive work (directory trees, sub trees).
+        // Every worker owns a deque, it pushes and pops at the bottom (depth-first, cache friendly),
+        // idle workers steal from the top of other deques (the largest pieces of work).
+        // The deques are lock based, work items are expected to be coarse (a directory, a sub tree).
+        // On platforms without thread support everything runs on the calling thread.
+        struct workpool_t;
+
+        // 'worker' is the index of the worker running the item, use it to push follow-up work
+        typedef void (*work_fn)(workpool_t* pool, u32 worker, void* item, void* user);
+
+        workpool_t* g_construct_workpool(alloc_t* allocator, u32 num_workers, u32 item_size, u32 max_items, work_fn fn, void* user);
+        void        g_destruct_workpool(alloc_t* allocator, workpool_t*& pool);
+        u32         g_num_workers(workpool_t const* pool);
+        void        g_push_work(workpool_t* pool, u32 worker, void const* item);
+        void        g_run_workpool(workpool_t* pool); // the calling thread becomes worker 0, returns when all work is done
+
+    } // namespace npath
+} // namespace ncore
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef __C_PATH_UNIONS_H__
+#define __C_PATH_UNIONS_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "cpath/c_types.h"
+#include "cpath/private/c_memory.h"
+
+namespace ncore
+{
+    class alloc_t;
+
+    namespace npath
+    {
+        static const u32 c_max_layers = 8;
+
+        // A union device over an ordered list of layers, the first one that has a folder or file wins. A layer is
+        // any device that is not a union, an alias is resolved through its root.
+        struct union_t
+        {
+            idevice_t m_device;               // the union device, it holds the paths asked for
+            u32       m_num_layers;           //
+            idevice_t m_layers[c_max_layers]; // highest priority first
+            node_t    m_tops[c_max_layers];   // the top folder of the tree every layer is in, c_invalid_node when it has none
+            u32       m_version;              // incremented when the tree of a layer changes, starts at 1
+        };
+
+        // The resolution of a folder or file node of a union tree, valid while m_version is the one of the union
+        struct unionhit_t
+        {
+            u32 m_version; // 0 = never resolved
+            s32 m_layer;   // index into union_t::m_layers, -1 when no layer has it
+            u32 m_node;    // node_t or ifile_t in the tree of the layer
+        };
+
+        // Resolution cache per folder and file node (only the nodes of union trees are ever written). A folder also
+        // keeps the folder at its place in every layer, so resolving one of its files or sub folders is a single
+        // step per layer. A folder or file added, deleted or back in the tree of a layer increments the version of
+        // the unions over it, which invalidates all their hits at once.
+        struct unions_t
+        {
+            vpool_t<union_t>    m_unions;
+            vpool_t<unionhit_t> m_folders;         // per folder node
+            vpool_t<node_t>     m_layer_folders;   // per folder node c_max_layers folders, c_invalid_node when a layer has none
+            vpool_t<unionhit_t> m_files;           // per file node
+            vpool_t<node_t>     m_chain;           // the folders that g_unions_resolve_folder resolves, deepest first
+            u32                 m_num_unions;      //
+            u32                 m_folder_capacity; // folder nodes m_folders can hold
+            u32                 m_file_capacity;   // file nodes m_files can hold
+            DCORE_CLASS_PLACEMENT_NEW_DELETE
+        };
+
+        unions_t* g_construct_unions(alloc_t* allocator, u32 max_items, varena_config_t const& config = g_default_arena_config);
+        void      g_destruct_unions(alloc_t* allocator, unions_t*& unions);
+        s32       g_unions_set(paths_t* paths, s32 index, idevice_t device, idevice_t const* layers, u32 num_layers); // index -1 adds a union, returns its index
+        void      g_unions_changed(paths_t* paths, node_t folder); // a folder or file below 'folder' was added, deleted or came back
+        void      g_unions_invalidate(paths_t* paths);            // bulk change or a layer alias moved, also refreshes m_tops
+
+        unionhit_t const* g_unions_resolve_folder(paths_t* paths, union_t const* u, node_t folder); // 'folder' is in the tree of the union
+        unionhit_t const* g_unions_resolve_file(paths_t* paths, union_t const* u, ifile_t file);
+
+    } // namespace npath
+} // namespace ncore
+
+#endif
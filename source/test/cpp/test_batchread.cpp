@@ -0,0 +1,151 @@
+#include "ccore/c_target.h"
+#include "cbase/c_allocator.h"
+#include "cbase/c_runes.h"
+#include "cvmem/c_virtual_memory.h"
+
+#include "cunittest/cunittest.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_filepath.h"
+#include "cpath/c_batchread.h"
+
+#if defined(TARGET_LINUX) || defined(TARGET_MAC)
+#    include <fcntl.h>
+#    include <stdio.h>
+#    include <stdlib.h>
+#    include <string.h>
+#    include <unistd.h>
+#endif
+
+using namespace ncore;
+
+UNITTEST_SUITE_BEGIN(batchread)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_ALLOCATOR;
+
+        UNITTEST_FIXTURE_SETUP() { nvmem::initialize(); }
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+#if defined(TARGET_LINUX) || defined(TARGET_MAC)
+        static const u32 c_num_files = 200;
+
+        struct seen_t
+        {
+            u32 m_count;
+            u32 m_errors;
+            u64 m_bytes;
+        };
+
+        static void s_on_read(npath::read_result_t const& result, void* user)
+        {
+            seen_t* seen = (seen_t*)user;
+            seen->m_count += 1;
+            seen->m_errors += result.m_error != 0 ? 1 : 0;
+            seen->m_bytes += result.m_bytes;
+        }
+
+        static void s_read_all(alloc_t* allocator, u8 backend)
+        {
+            char root[] = "/tmp/cpath_batch_XXXXXX";
+            CHECK_NOT_NULL(mkdtemp(root));
+
+            npath::paths_t* paths = npath::g_construct_paths(allocator);
+            dirpath_t       dir   = paths->register_fulldirpath(ascii::make_crunes("data:/"));
+            CHECK_TRUE(paths->mount(dir, root));
+
+            // every file holds its own name, the last one doesn't exist
+            filepath_t* files    = g_allocate_array<filepath_t>(allocator, c_num_files);
+            char*       storage  = g_allocate_array<char>(allocator, c_num_files * 32);
+            void**      buffers  = g_allocate_array<void*>(allocator, c_num_files);
+            u64*        sizes    = g_allocate_array<u64>(allocator, c_num_files);
+            char        path[512];
+            for (u32 i = 0; i < c_num_files; ++i)
+            {
+                char name[32];
+                snprintf(name, sizeof(name), "f%u.txt", i);
+                if (i + 1 < c_num_files)
+                {
+                    snprintf(path, sizeof(path), "%s/%s", root, name);
+                    s32 const fd = open(path, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+                    write(fd, name, strlen(name));
+                    close(fd);
+                }
+                new (&files[i]) filepath_t(dir.filename(ascii::make_crunes(name)));
+                buffers[i] = storage + i * 32;
+                sizes[i]   = 32;
+                memset(buffers[i], 0, 32);
+            }
+
+            npath::batch_config_t config = npath::g_default_batch_config;
+            config.m_backend             = backend;
+            config.m_queue_depth         = 16;
+            npath::batchreader_t* reader = npath::g_construct_batchreader(allocator, paths, config);
+            if (backend == npath::nbatch::BackendThreads)
+                CHECK_EQUAL(npath::nbatch::BackendThreads, reader->backend());
+
+            CHECK_EQUAL(0, reader->submit(files, buffers, sizes, c_num_files / 2));
+            CHECK_EQUAL(c_num_files / 2, reader->submit(files + c_num_files / 2, buffers + c_num_files / 2, sizes + c_num_files / 2, c_num_files / 2));
+            CHECK_EQUAL(c_num_files, reader->pending());
+
+            seen_t seen = {0, 0, 0};
+            CHECK_EQUAL(c_num_files, reader->drain(s_on_read, &seen));
+            CHECK_EQUAL(0, reader->pending());
+            CHECK_EQUAL(c_num_files, seen.m_count);
+            CHECK_EQUAL(1, seen.m_errors);
+
+            u64 expected = 0;
+            for (u32 i = 0; i + 1 < c_num_files; ++i)
+            {
+                char name[32];
+                snprintf(name, sizeof(name), "f%u.txt", i);
+                expected += strlen(name);
+                CHECK_EQUAL(0, strcmp((char const*)buffers[i], name));
+                snprintf(path, sizeof(path), "%s/%s", root, name);
+                unlink(path);
+            }
+            CHECK_EQUAL(expected, seen.m_bytes);
+
+            npath::g_destruct_batchreader(allocator, reader);
+            for (u32 i = 0; i < c_num_files; ++i)
+                files[i].~filepath_t();
+            g_deallocate_array(allocator, files);
+            g_deallocate_array(allocator, storage);
+            g_deallocate_array(allocator, buffers);
+            g_deallocate_array(allocator, sizes);
+            npath::g_destruct_paths(allocator, paths);
+            rmdir(root);
+        }
+
+        UNITTEST_TEST(auto_backend) { s_read_all(Allocator, npath::nbatch::BackendAuto); }
+        UNITTEST_TEST(thread_pool) { s_read_all(Allocator, npath::nbatch::BackendThreads); }
+
+        UNITTEST_TEST(poll)
+        {
+            npath::paths_t*       paths  = npath::g_construct_paths(Allocator);
+            npath::batchreader_t* reader = npath::g_construct_batchreader(Allocator, paths);
+
+            // nothing submitted, nothing to wait for
+            npath::read_result_t results[4];
+            CHECK_EQUAL(0, reader->poll(results, 4, true));
+
+            // not mounted
+            dirpath_t  dir  = paths->register_fulldirpath(ascii::make_crunes("other:/"));
+            filepath_t file = dir.filename(ascii::make_crunes("a.txt"));
+            u8         buffer[8];
+            void*      buffers[1] = {buffer};
+            u64        sizes[1]   = {sizeof(buffer)};
+            reader->submit(&file, buffers, sizes, 1);
+            CHECK_EQUAL(1, reader->poll(results, 4, true));
+            CHECK_EQUAL(0, results[0].m_request);
+            CHECK_TRUE(results[0].m_error != 0);
+
+            npath::g_destruct_batchreader(Allocator, reader);
+            npath::g_destruct_paths(Allocator, paths);
+        }
+#endif
+    }
+}
+UNITTEST_SUITE_END
@@ -0,0 +1,189 @@
+#include "ccore/c_target.h"
+#include "cbase/c_allocator.h"
+#include "cbase/c_runes.h"
+#include "cvmem/c_virtual_memory.h"
+
+#include "cunittest/cunittest.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_filepath.h"
+#include "cpath/c_diff.h"
+
+#include "test_helpers.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace ncore;
+
+UNITTEST_SUITE_BEGIN(diff)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_ALLOCATOR;
+
+        UNITTEST_FIXTURE_SETUP() { nvmem::initialize(); }
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        static npath::ifile_t s_add(npath::paths_t* paths, const char* dir, const char* file, u64 size = 0)
+        {
+            npath::ifile_t const node = ntest::g_add_file(paths, dir, file);
+            npath::filestat_t    stat;
+            memset(&stat, 0, sizeof(stat));
+            stat.m_size = size;
+            paths->set_file_stat(node, stat);
+            return node;
+        }
+
+        struct record_t
+        {
+            npath::paths_t* m_a;
+            npath::paths_t* m_b;
+            npath::ifile_t  m_files[3][8]; // per kind, a side for removed and modified, b side for added
+            u32             m_count[3];
+        };
+
+        static void s_record(u32 kind, filepath_t const* a, filepath_t const* b, void* user)
+        {
+            record_t* r = (record_t*)user;
+            if (r->m_count[kind] < 8)
+                r->m_files[kind][r->m_count[kind]++] = kind == npath::ndiff::KindAdded ? r->m_b->file_of(*b) : r->m_a->file_of(*a);
+        }
+
+        static bool s_has(record_t const& r, u32 kind, npath::ifile_t file)
+        {
+            for (u32 i = 0; i < r.m_count[kind]; ++i)
+                if (r.m_files[kind][i] == file)
+                    return true;
+            return false;
+        }
+
+        UNITTEST_TEST(lockstep)
+        {
+            npath::paths_t* a = npath::g_construct_paths(Allocator);
+            npath::paths_t* b = npath::g_construct_paths(Allocator);
+
+            // registered in different orders, the string pools differ
+            npath::ifile_t const a_cpp = s_add(a, "c:/src/", "a.cpp", 10);
+            s_add(a, "c:/src/", "b.h", 5);
+            npath::ifile_t const x = s_add(a, "c:/src/old/", "x.txt");
+            npath::ifile_t const y = s_add(a, "c:/src/old/deep/", "y.txt");
+            s_add(a, "c:/docs/", "readme");
+
+            npath::ifile_t const z = s_add(b, "c:/src/new/", "z.txt");
+            s_add(b, "c:/docs/", "readme");
+            s_add(b, "c:/src/", "b.h", 5);
+            s_add(b, "c:/src/", "a.cpp", 12);
+            npath::ifile_t const f = s_add(b, "d:/", "f.txt");
+
+            record_t            r;
+            npath::diff_stats_t stats;
+            memset(&r, 0, sizeof(r));
+            r.m_a = a;
+            r.m_b = b;
+
+            // names only
+            npath::diff_t::run(a->register_fulldirpath(ascii::make_crunes("c:/")), b->register_fulldirpath(ascii::make_crunes("c:/")), npath::ndiff::CompareNames, s_record, &r, stats);
+            CHECK_EQUAL(1, stats.m_added);
+            CHECK_EQUAL(2, stats.m_removed);
+            CHECK_EQUAL(0, stats.m_modified);
+            CHECK_EQUAL(3, stats.m_files);
+            CHECK_EQUAL(3, stats.m_folders); // c:, docs and src
+            CHECK_TRUE(s_has(r, npath::ndiff::KindAdded, z));
+            CHECK_TRUE(s_has(r, npath::ndiff::KindRemoved, x) && s_has(r, npath::ndiff::KindRemoved, y));
+
+            // whole registries, with the metadata, the device "d:" is only in b
+            memset(r.m_count, 0, sizeof(r.m_count));
+            npath::diff_t::run(a, b, npath::ndiff::CompareMetadata, s_record, &r, stats);
+            CHECK_EQUAL(2, stats.m_added);
+            CHECK_EQUAL(2, stats.m_removed);
+            CHECK_EQUAL(1, stats.m_modified);
+            CHECK_TRUE(s_has(r, npath::ndiff::KindAdded, f));
+            CHECK_TRUE(s_has(r, npath::ndiff::KindModified, a_cpp));
+
+            // a registry has no difference with itself
+            npath::diff_t::run(a, a, npath::ndiff::CompareMetadata, s_record, &r, stats);
+            CHECK_EQUAL(0, stats.m_added + stats.m_removed + stats.m_modified);
+
+            npath::g_destruct_paths(Allocator, a);
+            npath::g_destruct_paths(Allocator, b);
+        }
+
+        UNITTEST_TEST(pruned)
+        {
+            npath::paths_t* a = npath::g_construct_paths(Allocator);
+            npath::paths_t* b = npath::g_construct_paths(Allocator);
+            npath::ifile_t const a_cpp = s_add(a, "c:/src/core/", "a.cpp", 10);
+            s_add(a, "c:/src/ui/", "b.cpp", 20);
+            s_add(a, "c:/docs/", "readme", 1);
+            s_add(b, "c:/docs/", "readme", 1);
+            s_add(b, "c:/src/ui/", "b.cpp", 20);
+            s_add(b, "c:/src/core/", "a.cpp", 11);
+            a->enable_fingerprints();
+            b->enable_fingerprints();
+
+            record_t            r;
+            npath::diff_stats_t stats;
+            memset(&r, 0, sizeof(r));
+            r.m_a = a;
+            r.m_b = b;
+
+            // only the path to the change is walked, docs and ui are skipped
+            npath::diff_t::run(a, b, npath::ndiff::CompareHash | npath::ndiff::CompareMetadata, s_record, &r, stats);
+            CHECK_EQUAL(1, stats.m_modified);
+            CHECK_EQUAL(0, stats.m_added + stats.m_removed);
+            CHECK_EQUAL(3, stats.m_folders); // c:, src and core
+            CHECK_EQUAL(2, stats.m_pruned);
+            CHECK_TRUE(s_has(r, npath::ndiff::KindModified, a_cpp));
+
+            // equal registries are a single comparison
+            s_add(b, "c:/src/core/", "a.cpp", 10);
+            npath::diff_t::run(a, b, npath::ndiff::CompareNames, s_record, &r, stats);
+            CHECK_EQUAL(0, stats.m_added + stats.m_removed + stats.m_modified);
+            CHECK_EQUAL(0, stats.m_folders);
+            CHECK_EQUAL(1, stats.m_pruned);
+
+            // only the metadata, files with a hash could differ in mtime, nothing is skipped
+            npath::diff_t::run(a, b, npath::ndiff::CompareMetadata, s_record, &r, stats);
+            CHECK_EQUAL(0, stats.m_pruned);
+            CHECK_EQUAL(5, stats.m_folders);
+
+            npath::g_destruct_paths(Allocator, a);
+            npath::g_destruct_paths(Allocator, b);
+        }
+
+        // Two wide folders without a name in common, the sub folders of both sides are stacked together
+        UNITTEST_TEST(disjoint)
+        {
+            u32 const       max_items = 1000;
+            npath::paths_t* a         = npath::g_construct_paths(Allocator, max_items);
+            npath::paths_t* b         = npath::g_construct_paths(Allocator, max_items);
+
+            u32 const count = 600;
+            for (u32 i = 0; i < count; ++i)
+            {
+                char dir[32];
+                snprintf(dir, sizeof(dir), "c:/a%03u/", i);
+                s_add(a, dir, "f");
+                snprintf(dir, sizeof(dir), "c:/b%03u/", i);
+                s_add(b, dir, "f");
+            }
+
+            record_t            r;
+            npath::diff_stats_t stats;
+            memset(&r, 0, sizeof(r));
+            r.m_a = a;
+            r.m_b = b;
+
+            npath::diff_t::run(a, b, npath::ndiff::CompareNames, s_record, &r, stats);
+            CHECK_EQUAL(count, stats.m_added);
+            CHECK_EQUAL(count, stats.m_removed);
+            CHECK_EQUAL(0, stats.m_modified);
+
+            npath::g_destruct_paths(Allocator, a);
+            npath::g_destruct_paths(Allocator, b);
+        }
+    }
+}
+UNITTEST_SUITE_END
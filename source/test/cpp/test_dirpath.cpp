@@ -55,7 +55,7 @@ UNITTEST_SUITE_BEGIN(dirpath)
 
 #ifdef TARGET_PC
             crunes_t fullpath = ascii::make_crunes("c:\\the\\name\\is\\johhnywalker\\");
-#elif defined(TARGET_MAC)
+#else
             crunes_t fullpath = ascii::make_crunes("/volume/the/name/is/johhnywalker/");
 #endif
 
@@ -69,20 +69,86 @@ UNITTEST_SUITE_BEGIN(dirpath)
         {
             npath::paths_t* paths = npath::g_construct_paths(Allocator);
 
-            // const char* asciidirstr = "c:\\the\\name\\is\\johhnywalker\\";
+            const char* asciidirstr = "c:/the/name/is/johhnywalker/";
+            dirpath_t   dirpath     = paths->register_fulldirpath(ascii::make_crunes(asciidirstr));
+            CHECK_EQUAL(4, dirpath.depth());
+            CHECK_EQUAL(28, dirpath.full_path_to_strlen());
 
-            // npath::string_t outdevicename;
-            // npath::node_t   outnode;
-            // paths->register_fulldirpath(asciidirstr, outdevicename, outnode);
-            // dirpath_t dirpath(paths->get_device(outdevicename), outnode);
+            utf32::rune dst_runes[256];
+            dst_runes[0] = 0;
+            dst_runes[1] = 0;
+            runes_t dst(dst_runes, 0, 0, 256);
 
-            // utf32::rune dst_runes[256];
-            // dst_runes[0] = 0;
-            // dst_runes[1] = 0;
-            // runes_t dst(dst_runes, 0, 0, 256);
+            dirpath.full_path_to_string(dst);
+            CHECK_EQUAL(28, (s32)(dst.m_end - dst.m_str));
 
-            // dirpath.to_string(dst);
-            // CHECK_EQUAL(0, nrunes::compare(dst, asciidirstr));
+            dirpath_t parent = dirpath.up();
+            CHECK_EQUAL(3, parent.depth());
+            CHECK_EQUAL(15, parent.full_path_to_strlen()); // "c:/the/name/is/"
+
+            npath::g_destruct_paths(Allocator, paths);
+        }
+
+        // Rendering has no depth limit, the rendered length agrees with full_path_to_strlen
+        UNITTEST_TEST(deep)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+
+            s32 const depth = 300;
+            char      str[3 + depth * 2 + 1];
+            str[0] = 'c';
+            str[1] = ':';
+            str[2] = '/';
+            for (s32 i = 0; i < depth; ++i)
+            {
+                str[3 + i * 2]     = (char)('a' + (i % 26));
+                str[3 + i * 2 + 1] = '/';
+            }
+            str[3 + depth * 2] = 0;
+
+            dirpath_t const dirpath = paths->register_fulldirpath(ascii::make_crunes(str));
+            CHECK_EQUAL(depth, dirpath.depth());
+            CHECK_EQUAL(3 + depth * 2, dirpath.full_path_to_strlen());
+
+            utf32::rune dst_runes[1024];
+            runes_t     dst(dst_runes, 0, 0, 1024);
+            dirpath.full_path_to_string(dst);
+            CHECK_EQUAL(3 + depth * 2, (s32)(dst.m_end - dst.m_str));
+            bool same = true;
+            for (s32 i = 0; i < 3 + depth * 2; ++i)
+                same = same && dst_runes[dst.m_str + i] == (utf32::rune)str[i];
+            CHECK_TRUE(same);
+
+            npath::g_destruct_paths(Allocator, paths);
+        }
+
+        UNITTEST_TEST(normalize)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+
+            dirpath_t const clean = paths->register_fulldirpath(ascii::make_crunes("c:/the/name/is/"));
+            npath::paths_stats_t before;
+            paths->stats(before);
+
+            CHECK_TRUE(clean == paths->register_fulldirpath(ascii::make_crunes("c:\\the\\name\\is\\")));
+            CHECK_TRUE(clean == paths->register_fulldirpath(ascii::make_crunes("c://the///name/./is//")));
+            CHECK_TRUE(clean == paths->register_fulldirpath(ascii::make_crunes("c:/the/name/is")));
+            CHECK_TRUE(clean == paths->register_fulldirpath(ascii::make_crunes("c:/the/other/../name/./is/")));
+            CHECK_TRUE(clean == paths->register_fulldirpath(ascii::make_crunes("c:/the/name/is/was/..")));
+            CHECK_TRUE(clean == paths->register_fulldirpath(ascii::make_crunes("c:/../../the/name\\is/")));
+            CHECK_TRUE(clean == paths->register_fulldirpath(ascii::make_crunes("c:/a/b/../../the/name/is/")));
+            CHECK_TRUE(clean == paths->register_fulldirpath(ascii::make_crunes("c:/the/name/is/a/b/./c/../../..")));
+            CHECK_TRUE(clean == paths->register_fulldirpath(ascii::make_crunes("c:/the/x/../name/y/z/../w/../../is/")));
+
+            // The folders that are popped again are never registered, however deep the popped chain is
+            npath::paths_stats_t after;
+            paths->stats(after);
+            CHECK_EQUAL(before.m_folder_count, after.m_folder_count);
+
+            // ".." does not go above the root of the device
+            dirpath_t const root = paths->register_fulldirpath(ascii::make_crunes("c:/the/../../"));
+            CHECK_TRUE(root.isRoot());
+            CHECK_EQUAL(3, root.full_path_to_strlen()); // "c:/"
 
             npath::g_destruct_paths(Allocator, paths);
         }
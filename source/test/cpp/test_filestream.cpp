@@ -0,0 +1,147 @@
+#include "ccore/c_target.h"
+#include "cbase/c_allocator.h"
+#include "cbase/c_runes.h"
+#include "cvmem/c_virtual_memory.h"
+
+#include "cunittest/cunittest.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_filepath.h"
+#include "cpath/c_filestream.h"
+#include "cpath/private/c_streams.h"
+
+#if defined(TARGET_LINUX) || defined(TARGET_MAC)
+#    include <fcntl.h>
+#    include <stdio.h>
+#    include <stdlib.h>
+#    include <string.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+using namespace ncore;
+
+UNITTEST_SUITE_BEGIN(filestream)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_ALLOCATOR;
+
+        UNITTEST_FIXTURE_SETUP() { nvmem::initialize(); }
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+#if defined(TARGET_LINUX) || defined(TARGET_MAC)
+        static void s_write(const char* root, const char* name, const char* text)
+        {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/%s", root, name);
+            s32 const fd = open(path, O_CREAT | O_WRONLY | O_TRUNC, 0644);
+            write(fd, text, strlen(text));
+            close(fd);
+        }
+
+        static void s_remove(const char* root, const char* name)
+        {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/%s", root, name);
+            unlink(path);
+        }
+
+        UNITTEST_TEST(mapped_and_sequential)
+        {
+            char root[] = "/tmp/cpath_stream_XXXXXX";
+            CHECK_NOT_NULL(mkdtemp(root));
+            s_write(root, "data.txt", "hello stream");
+
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+            dirpath_t       dir   = paths->register_fulldirpath(ascii::make_crunes("assets:/"));
+            CHECK_TRUE(paths->mount(dir, root));
+
+            filepath_t const datafile = dir.filename(ascii::make_crunes("data.txt"));
+            filestream_t     mapped   = open_filestream(datafile);
+            CHECK_TRUE(mapped.is_open());
+            CHECK_EQUAL(12, mapped.size());
+            CHECK_NOT_NULL(mapped.data());
+
+            // zero-copy views advance the position
+            u8 const* view = nullptr;
+            CHECK_EQUAL(5, mapped.view(view, 5));
+            CHECK_EQUAL(0, memcmp(view, "hello", 5));
+            CHECK_EQUAL(5, mapped.position());
+
+            // the same file again shares the mapping
+            filestream_t again = open_filestream(datafile);
+            CHECK_TRUE(again.data() == mapped.data());
+            CHECK_EQUAL(1, paths->m_streams->m_reuses);
+
+            // sequential, buffered
+            filestream_t seq = open_filestream(datafile, npath::nstream::ModeSequential);
+            CHECK_NULL(seq.data());
+            char text[32];
+            CHECK_TRUE(seq.seek(6));
+            CHECK_EQUAL(6, seq.read(text, sizeof(text)));
+            CHECK_EQUAL(0, memcmp(text, "stream", 6));
+            CHECK_EQUAL(0, seq.read(text, sizeof(text)));
+
+            mapped.close();
+            again.close();
+            seq.close();
+            CHECK_FALSE(mapped.is_open());
+
+            // a file that changed while its descriptor was idle is opened again
+            s_write(root, "data.txt", "changed");
+            filestream_t changed = open_filestream(datafile);
+            CHECK_EQUAL(7, changed.size());
+            changed.close();
+
+#    if defined(TARGET_LINUX)
+            // an atomic replace with the same size and mtime is another file, the idle descriptor still has the old one
+            char path[512], next[512];
+            snprintf(path, sizeof(path), "%s/data.txt", root);
+            snprintf(next, sizeof(next), "%s/next.txt", root);
+            s_write(root, "next.txt", "CHANGED");
+            struct stat st;
+            stat(path, &st);
+            struct timespec const times[2] = {st.st_atim, st.st_mtim};
+            utimensat(AT_FDCWD, next, times, 0);
+            rename(next, path);
+            filestream_t replaced = open_filestream(datafile);
+            CHECK_EQUAL(7, replaced.size());
+            CHECK_EQUAL(0, memcmp(replaced.data(), "CHANGED", 7));
+            replaced.close();
+#    endif
+
+            npath::g_destruct_paths(Allocator, paths);
+            s_remove(root, "data.txt");
+            rmdir(root);
+        }
+
+        UNITTEST_TEST(missing_file)
+        {
+            char root[] = "/tmp/cpath_stream_XXXXXX";
+            CHECK_NOT_NULL(mkdtemp(root));
+
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+            dirpath_t       dir   = paths->register_fulldirpath(ascii::make_crunes("assets:/"));
+            CHECK_TRUE(paths->mount(dir, root));
+
+            // the stream contains no data to read from
+            filestream_t stream = open_filestream(dir.filename(ascii::make_crunes("nothere.bin")));
+            CHECK_FALSE(stream.is_open());
+            CHECK_EQUAL(0, stream.size());
+            char buffer[4];
+            CHECK_EQUAL(0, stream.read(buffer, 4));
+            stream.close();
+
+            // not mounted
+            dirpath_t other = paths->register_fulldirpath(ascii::make_crunes("other:/"));
+            CHECK_FALSE(open_filestream(other.filename(ascii::make_crunes("data.txt"))).is_open());
+
+            npath::g_destruct_paths(Allocator, paths);
+            rmdir(root);
+        }
+#endif
+    }
+}
+UNITTEST_SUITE_END
@@ -0,0 +1,116 @@
+#include "ccore/c_target.h"
+#include "cbase/c_allocator.h"
+#include "cbase/c_runes.h"
+#include "cvmem/c_virtual_memory.h"
+
+#include "cunittest/cunittest.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_filepath.h"
+#include "cpath/c_glob.h"
+
+#include "test_helpers.h"
+
+#include <stdio.h>
+
+using namespace ncore;
+
+UNITTEST_SUITE_BEGIN(glob)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_ALLOCATOR;
+
+        UNITTEST_FIXTURE_SETUP() { nvmem::initialize(); }
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        static void s_ignore(npath::ifile_t, void*) {}
+
+        static u32 s_count(alloc_t* allocator, npath::paths_t* paths, dirpath_t const& root, const char* pattern, u32 num_threads = 1)
+        {
+            npath::glob_t* glob = npath::g_compile_glob(allocator, paths, ascii::make_crunes(pattern));
+            u32 const      n    = glob->match(root, s_ignore, nullptr, num_threads);
+            npath::g_destruct_glob(allocator, glob);
+            return n;
+        }
+
+        UNITTEST_TEST(patterns)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+
+            npath::ifile_t const main_cpp = ntest::g_add_file(paths, "c:/src/a/", "main.cpp");
+            ntest::g_add_file(paths, "c:/src/a/", "util.h");
+            npath::ifile_t const x_cpp = ntest::g_add_file(paths, "c:/src/b/c/", "x.cpp");
+            ntest::g_add_file(paths, "c:/src/", "Makefile");
+            ntest::g_add_file(paths, "c:/src/", "notes.tar.gz");
+            ntest::g_add_file(paths, "c:/docs/", "readme.md");
+            dirpath_t root = paths->register_fulldirpath(ascii::make_crunes("c:/"));
+
+            CHECK_EQUAL(2, s_count(Allocator, paths, root, "src/**/*.cpp"));
+            CHECK_EQUAL(2, s_count(Allocator, paths, root, "**/*.cpp"));
+            CHECK_EQUAL(1, s_count(Allocator, paths, root, "src/a/main.cpp"));
+            CHECK_EQUAL(1, s_count(Allocator, paths, root, "src/*/*.h"));
+            CHECK_EQUAL(1, s_count(Allocator, paths, root, "src/Makefile"));
+            CHECK_EQUAL(1, s_count(Allocator, paths, root, "src/Make*"));
+            CHECK_EQUAL(1, s_count(Allocator, paths, root, "src/*.tar.gz"));  // the extension starts at the first '.'
+            CHECK_EQUAL(0, s_count(Allocator, paths, root, "src/*.gz"));      //
+            CHECK_EQUAL(2, s_count(Allocator, paths, root, "**/[mx]*.cpp"));  //
+            CHECK_EQUAL(1, s_count(Allocator, paths, root, "**/[!m]*.c?p"));  //
+            CHECK_EQUAL(1, s_count(Allocator, paths, root, "src/**/c/*"));    // "**" matches one or more folders
+            CHECK_EQUAL(1, s_count(Allocator, paths, root, "src/**/b/**/*")); // and zero folders
+            CHECK_EQUAL(5, s_count(Allocator, paths, root, "src/**"));        //
+            CHECK_EQUAL(6, s_count(Allocator, paths, root, "**"));            //
+            CHECK_EQUAL(0, s_count(Allocator, paths, root, "**/*.txt"));      // not registered
+            CHECK_EQUAL(0, s_count(Allocator, paths, root, "lib/**"));        //
+
+            // relative to a sub folder
+            dirpath_t src = root.down(ascii::make_crunes("src"));
+            CHECK_EQUAL(1, s_count(Allocator, paths, src, "a/*.cpp"));
+
+            // collect
+            npath::glob_t* glob = npath::g_compile_glob(Allocator, paths, ascii::make_crunes("**/*.cpp"));
+            npath::ifile_t files[4];
+            CHECK_EQUAL(2, glob->collect(root, files, 4));
+            CHECK_TRUE((files[0] == main_cpp && files[1] == x_cpp) || (files[0] == x_cpp && files[1] == main_cpp));
+            CHECK_EQUAL(1, glob->collect(root, files, 1));
+            npath::g_destruct_glob(Allocator, glob);
+
+            npath::g_destruct_paths(Allocator, paths);
+        }
+
+        UNITTEST_TEST(parallel)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+
+            char dir[64];
+            char file[32];
+            for (u32 i = 0; i < 20; ++i)
+            {
+                for (u32 j = 0; j < 10; ++j)
+                {
+                    snprintf(dir, sizeof(dir), "c:/d%u/e%u/", i, j);
+                    snprintf(file, sizeof(file), "f%u.%s", j, (j & 1) ? "cpp" : "h");
+                    ntest::g_add_file(paths, dir, file);
+                }
+            }
+            for (u32 j = 0; j < 40; ++j) // enough files to be looked up instead of scanned
+            {
+                snprintf(file, sizeof(file), "f%u.%s", j, (j & 1) ? "cpp" : "h");
+                ntest::g_add_file(paths, "c:/many/", file);
+            }
+            dirpath_t root = paths->register_fulldirpath(ascii::make_crunes("c:/"));
+
+            CHECK_EQUAL(1, s_count(Allocator, paths, root, "many/f7.cpp"));
+            CHECK_EQUAL(0, s_count(Allocator, paths, root, "many/f8.cpp"));
+            CHECK_EQUAL(1, s_count(Allocator, paths, root, "many/f7.cpp", 4));
+            CHECK_EQUAL(100, s_count(Allocator, paths, root, "d*/**/*.cpp"));
+            CHECK_EQUAL(100, s_count(Allocator, paths, root, "d*/**/*.cpp", 4));
+            CHECK_EQUAL(200, s_count(Allocator, paths, root, "d*/*/*", 0));
+            CHECK_EQUAL(20, s_count(Allocator, paths, root, "d*/e3/f3.cpp", 4));
+
+            npath::g_destruct_paths(Allocator, paths);
+        }
+    }
+}
+UNITTEST_SUITE_END
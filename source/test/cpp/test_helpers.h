@@ -0,0 +1,29 @@
+#ifndef __C_PATH_TEST_HELPERS_H__
+#define __C_PATH_TEST_HELPERS_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "cbase/c_runes.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_filepath.h"
+
+// Helpers shared by the unit tests that fill a registry by hand
+
+namespace ncore
+{
+    namespace ntest
+    {
+        // Registers 'dir' (a full path ending in a slash) and the file 'file' in it
+        inline npath::ifile_t g_add_file(npath::paths_t* paths, const char* dir, const char* file)
+        {
+            dirpath_t d = paths->register_fulldirpath(ascii::make_crunes(dir));
+            return paths->file_of(d.filename(ascii::make_crunes(file)));
+        }
+    } // namespace ntest
+} // namespace ncore
+
+#endif
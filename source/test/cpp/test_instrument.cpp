@@ -0,0 +1,157 @@
+#include "ccore/c_target.h"
+#include "cbase/c_allocator.h"
+#include "cvmem/c_virtual_memory.h"
+
+#include "cunittest/cunittest.h"
+
+#include "cpath/c_instrument.h"
+#include "cpath/private/c_threads.h"
+
+#include <string.h>
+#if defined(TARGET_LINUX) || defined(TARGET_MAC)
+#    include <time.h>
+#endif
+
+using namespace ncore;
+
+UNITTEST_SUITE_BEGIN(instrument)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_ALLOCATOR;
+
+        UNITTEST_FIXTURE_SETUP() { nvmem::initialize(); }
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        struct trace_buffer_t
+        {
+            char m_text[4096];
+            u32  m_len;
+        };
+
+        static void s_write(const char* str, u32 len, void* user)
+        {
+            trace_buffer_t* buffer = (trace_buffer_t*)user;
+            if (buffer->m_len + len < sizeof(buffer->m_text))
+            {
+                memcpy(buffer->m_text + buffer->m_len, str, len);
+                buffer->m_len += len;
+            }
+            buffer->m_text[buffer->m_len] = 0;
+        }
+
+#ifdef CPATH_INSTRUMENT
+        static bool s_ends_with(trace_buffer_t const& buffer, const char* suffix)
+        {
+            u32 const len = (u32)strlen(suffix);
+            return buffer.m_len >= len && memcmp(buffer.m_text + buffer.m_len - len, suffix, len) == 0;
+        }
+
+        static const u32 c_counts_per_item = 1000;
+
+        static void s_count_work(npath::workpool_t* pool, u32 worker, void* item, void* user)
+        {
+            for (u32 i = 0; i < c_counts_per_item; ++i)
+                CPATH_COUNT(FolderAdd);
+#    if defined(TARGET_LINUX) || defined(TARGET_MAC)
+            // give the other workers of the pool a chance to steal, so that every thread counts something
+            struct timespec const pause = {0, 1000 * 1000};
+            nanosleep(&pause, nullptr);
+#    endif
+        }
+
+        UNITTEST_TEST(counters)
+        {
+            npath::ninstrument::snapshot_t before, after, mine;
+            npath::ninstrument::snapshot_all(before);
+
+            CPATH_COUNT(ParentWalk);
+            CPATH_COUNT_N(ParentWalk, 4);
+            npath::ninstrument::snapshot_thread(mine);
+            CHECK_EQUAL(1, mine.m_threads);
+            CHECK_TRUE(mine.m_counters[npath::ninstrument::ParentWalk] >= 5);
+
+            npath::ninstrument::snapshot_all(after);
+            CHECK_EQUAL(5, after.m_counters[npath::ninstrument::ParentWalk] - before.m_counters[npath::ninstrument::ParentWalk]);
+
+            npath::ninstrument::reset_all();
+            npath::ninstrument::snapshot_all(after);
+            for (s32 i = 0; i < npath::ninstrument::CounterCount; ++i)
+                CHECK_EQUAL(0, after.m_counters[i]);
+        }
+
+        // Every workpool starts fresh threads, far more of them than there are per-thread blocks
+        UNITTEST_TEST(many_threads)
+        {
+            npath::ninstrument::reset_all();
+
+            u32 const num_pools = 40;
+            u32 const num_items = 16;
+            for (u32 p = 0; p < num_pools; ++p)
+            {
+                npath::workpool_t* pool = npath::g_construct_workpool(Allocator, 4, sizeof(u64), num_items, s_count_work, nullptr);
+                for (u64 i = 0; i < num_items; ++i)
+                    npath::g_push_work(pool, 0, &i);
+                npath::g_run_workpool(pool);
+                npath::g_destruct_workpool(Allocator, pool);
+                CHECK_NULL(pool);
+            }
+
+            npath::ninstrument::snapshot_t all;
+            npath::ninstrument::snapshot_all(all);
+            CHECK_EQUAL((u64)num_pools * num_items * c_counts_per_item, all.m_counters[npath::ninstrument::FolderAdd]);
+
+            // exited threads hand their block back, so the blocks are not used up
+            CHECK_TRUE(all.m_threads < 64);
+        }
+
+        UNITTEST_TEST(chrome_trace)
+        {
+            npath::ninstrument::reset_all();
+            npath::ninstrument::enable_trace(true);
+            {
+                CPATH_SCOPE("test_scope");
+            }
+            npath::ninstrument::enable_trace(false);
+            {
+                CPATH_SCOPE("not_recorded");
+            }
+
+            trace_buffer_t buffer;
+            buffer.m_len = 0;
+            npath::ninstrument::write_chrome_trace(s_write, &buffer);
+            CHECK_EQUAL(0, strncmp(buffer.m_text, "{\"traceEvents\":[{", 17));
+            CHECK_NOT_NULL(strstr(buffer.m_text, "\"name\":\"test_scope\",\"ph\":\"X\""));
+            CHECK_NULL(strstr(buffer.m_text, "not_recorded"));
+            CHECK_TRUE(s_ends_with(buffer, "],\"displayTimeUnit\":\"ns\"}"));
+
+            npath::ninstrument::reset_all();
+            buffer.m_len = 0;
+            npath::ninstrument::write_chrome_trace(s_write, &buffer);
+            CHECK_EQUAL(0, strcmp(buffer.m_text, "{\"traceEvents\":[],\"displayTimeUnit\":\"ns\"}"));
+        }
+#else
+        // Without CPATH_INSTRUMENT the macros are empty and the queries report nothing
+        UNITTEST_TEST(disabled)
+        {
+            CPATH_COUNT(ParentWalk);
+            CPATH_COUNT_N(ParentWalk, 4);
+            CPATH_SCOPE("test_scope");
+
+            npath::ninstrument::snapshot_t all;
+            npath::ninstrument::snapshot_all(all);
+            CHECK_EQUAL(0, all.m_threads);
+            for (s32 i = 0; i < npath::ninstrument::CounterCount; ++i)
+                CHECK_EQUAL(0, all.m_counters[i]);
+
+            npath::ninstrument::enable_trace(true);
+            trace_buffer_t buffer;
+            buffer.m_len = 0;
+            npath::ninstrument::write_chrome_trace(s_write, &buffer);
+            npath::ninstrument::enable_trace(false);
+            CHECK_EQUAL(0, strcmp(buffer.m_text, "{\"traceEvents\":[]}"));
+        }
+#endif
+    }
+}
+UNITTEST_SUITE_END
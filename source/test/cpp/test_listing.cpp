@@ -0,0 +1,204 @@
+#include "ccore/c_target.h"
+#include "cbase/c_allocator.h"
+#include "cbase/c_runes.h"
+#include "cvmem/c_virtual_memory.h"
+
+#include "cunittest/cunittest.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_filepath.h"
+#include "cpath/c_listing.h"
+#include "cpath/private/c_extindex.h"
+#include "cpath/private/c_folders.h"
+#include "cpath/private/c_nameindex.h"
+
+#include "test_helpers.h"
+
+#include <string.h>
+
+using namespace ncore;
+
+UNITTEST_SUITE_BEGIN(listing)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_ALLOCATOR;
+
+        UNITTEST_FIXTURE_SETUP() { nvmem::initialize(); }
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        static void s_append(npath::paths_t* paths, npath::string_t str, char* out, u32& len)
+        {
+            if (str == npath::c_empty_string)
+                return;
+            utf32::rune runes[64];
+            runes_t     r(runes, 0, 0, 64);
+            paths->to_string(str, r);
+            for (u32 i = r.m_str; i < r.m_end; ++i)
+                out[len++] = (char)runes[i];
+        }
+
+        // The names of the listed entries separated by '|', a folder is followed by a '/'
+        static void s_render(npath::paths_t* paths, npath::walknode_t const* nodes, u32 count, char* out)
+        {
+            u32 len = 0;
+            for (u32 i = 0; i < count; ++i)
+            {
+                if (i > 0)
+                    out[len++] = '|';
+                if (nodes[i].m_type == npath::nwalk::TypeFolder)
+                {
+                    s_append(paths, paths->m_folders->m_array.ptr_of(nodes[i].m_node)->m_name, out, len);
+                    out[len++] = '/';
+                }
+                else
+                {
+                    npath::file_t const* f = paths->m_files->m_array.ptr_of(nodes[i].m_node);
+                    s_append(paths, f->m_filename, out, len);
+                    s_append(paths, f->m_extension, out, len);
+                }
+            }
+            out[len] = 0;
+        }
+
+        UNITTEST_TEST(children)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+            ntest::g_add_file(paths, "c:/dir/", "b.txt");
+            ntest::g_add_file(paths, "c:/dir/", "a.cpp");
+            ntest::g_add_file(paths, "c:/dir/", "c");
+            npath::ifile_t const ab = ntest::g_add_file(paths, "c:/dir/", "ab");
+            ntest::g_add_file(paths, "c:/dir/a/", "x");
+            ntest::g_add_file(paths, "c:/dir/", "a.h");
+            ntest::g_add_file(paths, "c:/dir/b/", "y");
+            dirpath_t const dir = paths->register_fulldirpath(ascii::make_crunes("c:/dir/"));
+
+            npath::walknode_t nodes[16];
+            char              names[256];
+            npath::lister_t*  lister = npath::g_construct_lister(Allocator, dir);
+            u32               n      = lister->next(nodes, 16);
+            s_render(paths, nodes, n, names);
+            CHECK_EQUAL(0, strcmp(names, "a.cpp|a.h|a/|ab|b.txt|b/|c"));
+            CHECK_EQUAL(1, nodes[0].m_depth);
+            CHECK_EQUAL(0, lister->next(nodes, 16));
+
+            // prefixes
+            lister->seek(dir, "a");
+            n = lister->next(nodes, 16);
+            s_render(paths, nodes, n, names);
+            CHECK_EQUAL(0, strcmp(names, "a.cpp|a.h|a/|ab"));
+            lister->seek(dir, "b.");
+            n = lister->next(nodes, 16);
+            s_render(paths, nodes, n, names);
+            CHECK_EQUAL(0, strcmp(names, "b.txt"));
+            lister->seek(dir, "d");
+            CHECK_EQUAL(0, lister->next(nodes, 16));
+
+            // pages, registering while listing, a new lister resumes from the token
+            lister->seek(dir);
+            CHECK_EQUAL(2, lister->next(nodes, 2));
+            ntest::g_add_file(paths, "c:/dir/", "aa");
+            ntest::g_add_file(paths, "c:/dir/", "0"); // before the cursor
+            npath::g_set_file_deleted(paths, ab, true);
+            npath::lister_t* other = npath::g_construct_lister(Allocator, dir);
+            other->resume(dir, nullptr, npath::nlist::Children, nodes[1]);
+            n = lister->next(nodes, 16);
+            s_render(paths, nodes, n, names);
+            CHECK_EQUAL(0, strcmp(names, "a/|aa|b.txt|b/|c"));
+            n = other->next(nodes, 16);
+            s_render(paths, nodes, n, names);
+            CHECK_EQUAL(0, strcmp(names, "a/|aa|b.txt|b/|c"));
+
+            npath::g_destruct_lister(Allocator, other);
+            npath::g_destruct_lister(Allocator, lister);
+            npath::g_destruct_paths(Allocator, paths);
+        }
+
+        UNITTEST_TEST(recursive)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+            ntest::g_add_file(paths, "c:/src/", "main.cpp");
+            ntest::g_add_file(paths, "c:/src/lib/", "util.h");
+            ntest::g_add_file(paths, "c:/src/lib/net/", "tcp.cpp");
+            ntest::g_add_file(paths, "c:/src/lib/", "io.h");
+            ntest::g_add_file(paths, "c:/src/", "lib.h");
+            ntest::g_add_file(paths, "c:/src/app/", "app.cpp");
+            dirpath_t const src = paths->register_fulldirpath(ascii::make_crunes("c:/src/"));
+
+            // the order of the full paths, "lib.h" < "lib/" < "main.cpp"
+            npath::walknode_t nodes[16];
+            char              names[256];
+            npath::lister_t*  lister = npath::g_construct_lister(Allocator, src, nullptr, npath::nlist::Recursive);
+            u32               n      = lister->next(nodes, 16);
+            s_render(paths, nodes, n, names);
+            CHECK_EQUAL(0, strcmp(names, "app/|app.cpp|lib.h|lib/|io.h|net/|tcp.cpp|util.h|main.cpp"));
+            CHECK_EQUAL(3, nodes[6].m_depth);
+
+            // resume after a folder continues in it, after a file in the folder of the file
+            lister->resume(src, nullptr, npath::nlist::Recursive, nodes[3]);
+            n = lister->next(nodes + 9, 3);
+            s_render(paths, nodes + 9, n, names);
+            CHECK_EQUAL(0, strcmp(names, "io.h|net/|tcp.cpp"));
+            lister->resume(src, nullptr, npath::nlist::Recursive, nodes[11]);
+            n = lister->next(nodes, 16);
+            s_render(paths, nodes, n, names);
+            CHECK_EQUAL(0, strcmp(names, "util.h|main.cpp"));
+
+            // the prefix selects the names directly below the dirpath, with their sub trees
+            lister->seek(src, "lib/", npath::nlist::Recursive);
+            n = lister->next(nodes, 16);
+            s_render(paths, nodes, n, names);
+            CHECK_EQUAL(0, strcmp(names, "lib/|io.h|net/|tcp.cpp|util.h"));
+
+            npath::g_destruct_lister(Allocator, lister);
+            npath::g_destruct_paths(Allocator, paths);
+        }
+
+        UNITTEST_TEST(incremental)
+        {
+            // Files registered in a scrambled order between listings, a listing reads the first run and the side run
+            // of the block and a page stops half way while a file is added
+            npath::paths_t*     paths  = npath::g_construct_paths(Allocator);
+            npath::node_t const folder = paths->m_files->m_array.ptr_of(ntest::g_add_file(paths, "c:/inc/", "f000"))->m_folder;
+            dirpath_t const     dir    = paths->register_fulldirpath(ascii::make_crunes("c:/inc/"));
+            npath::lister_t*    lister = npath::g_construct_lister(Allocator, dir);
+            npath::walknode_t   nodes[512];
+            char                name[8];
+            u32                 below = 0; // names that start with "f1"
+            bool                sides = false;
+            for (u32 round = 0; round < 40; ++round)
+            {
+                for (u32 i = 0; i < 10; ++i)
+                {
+                    u32 const k = 1 + ((round * 10 + i) * 157) % 400;
+                    name[0]     = 'f';
+                    name[1]     = (char)('0' + k / 100);
+                    name[2]     = (char)('0' + (k / 10) % 10);
+                    name[3]     = (char)('0' + k % 10);
+                    name[4]     = 0;
+                    ntest::g_add_file(paths, "c:/inc/", name);
+                    below += k / 100 == 1 ? 1 : 0;
+                }
+
+                lister->seek(dir);
+                u32 n = lister->next(nodes, 3);
+                ntest::g_add_file(paths, "c:/inc/", (round & 1) ? "f999" : "f0000"); // after and before the cursor
+                n += lister->next(nodes + n, 512 - n);
+                CHECK_EQUAL((round + 1) * 10 + 1 + (round > 0 ? 2 : 0), n);
+                for (u32 i = 1; i < n; ++i)
+                    CHECK_TRUE(npath::g_nameindex_compare(paths, nodes[i - 1].m_node | npath::c_nameentry_file, nodes[i].m_node | npath::c_nameentry_file) < 0);
+
+                lister->seek(dir, "f1");
+                CHECK_EQUAL(below, lister->next(nodes, 512));
+
+                sides |= npath::g_nameindex_block(paths, folder)->m_side > 0;
+            }
+            CHECK_TRUE(sides);
+
+            npath::g_destruct_lister(Allocator, lister);
+            npath::g_destruct_paths(Allocator, paths);
+        }
+    }
+}
+UNITTEST_SUITE_END
@@ -0,0 +1,158 @@
+#include "ccore/c_target.h"
+#include "cbase/c_allocator.h"
+#include "cvmem/c_virtual_memory.h"
+
+#include "cunittest/cunittest.h"
+
+#include "cpath/private/c_memory.h"
+
+#if defined(TARGET_LINUX)
+#    include <signal.h>
+#    include <sys/mman.h>
+#    include <sys/wait.h>
+#    include <unistd.h>
+#endif
+
+using namespace ncore;
+
+UNITTEST_SUITE_BEGIN(memory)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_ALLOCATOR;
+
+        UNITTEST_FIXTURE_SETUP() { nvmem::initialize(); }
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+#if defined(TARGET_LINUX)
+        // Pages of the range that are in memory
+        static u32 s_resident(u8 const* ptr, u64 size)
+        {
+            u32 const     page  = (u32)::sysconf(_SC_PAGESIZE);
+            u32 const     pages = (u32)((size + page - 1) / page);
+            unsigned char vec[1024];
+            if (pages > sizeof(vec) || ::mincore((void*)ptr, size, vec) != 0)
+                return 0;
+            u32 n = 0;
+            for (u32 i = 0; i < pages; ++i)
+                n += vec[i] & 1;
+            return n;
+        }
+#endif
+
+        UNITTEST_TEST(growth)
+        {
+            npath::varena_config_t config = {npath::narena::PagesDefault, npath::narena::GrowMinimal, 0, 0, 0};
+            npath::varena_t        arena;
+            npath::g_init_arena(arena, 0, 1024 * 1024, sizeof(u64), config);
+            CHECK_NOT_NULL(arena.m_ptr);
+            CHECK_EQUAL(0, arena.m_committed);
+
+            // Minimal growth commits the pages an index needs, every item up to there can be written
+            u32 const page = arena.m_page_size;
+            for (u32 i = 0; i < 10000; ++i)
+            {
+                arena.ensure_capacity(i, sizeof(u64));
+                CHECK_TRUE(arena.m_committed > i);
+                *(u64*)arena.ptr_of(i, sizeof(u64)) = i;
+            }
+            CHECK_EQUAL(0, arena.committed_bytes() % page);
+            CHECK_TRUE(arena.committed_bytes() <= (u64)(10000 + 4) * sizeof(u64) + page);
+
+            // reset gives the pages back down to the initial capacity
+            arena.reset(page / sizeof(u64), sizeof(u64));
+            CHECK_EQUAL((u64)page, arena.committed_bytes());
+            CHECK_EQUAL(1, *(u64*)arena.ptr_of(1, sizeof(u64)));
+            npath::g_teardown_arena(arena);
+            CHECK_NULL(arena.m_ptr);
+
+            // Geometric growth at least doubles, the commit step is the smallest step
+            config.m_growth      = npath::narena::GrowGeometric;
+            config.m_commit_step = 16 * page;
+            npath::g_init_arena(arena, 1, 1024 * 1024, sizeof(u64), config);
+            CHECK_EQUAL((u64)16 * page, arena.committed_bytes());
+            u64 last = arena.committed_bytes();
+            for (u32 i = 0; i < 200000; ++i)
+            {
+                arena.ensure_capacity(i, sizeof(u64));
+                if (arena.committed_bytes() != last)
+                {
+                    CHECK_TRUE(arena.committed_bytes() >= last * 2);
+                    last = arena.committed_bytes();
+                }
+            }
+            CHECK_TRUE(arena.m_committed > 200000);
+            npath::g_teardown_arena(arena);
+        }
+
+#if defined(TARGET_LINUX)
+        UNITTEST_TEST(prefault)
+        {
+            // Committed pages are in memory right away with m_prefault, otherwise on their first write
+            u32 const              page   = (u32)::sysconf(_SC_PAGESIZE);
+            npath::varena_config_t config = {npath::narena::PagesDefault, npath::narena::GrowMinimal, 1, 0, 0};
+            npath::varena_t        arena;
+            npath::g_init_arena(arena, 64 * page, 1024 * page, 1, config);
+            CHECK_EQUAL((u64)64 * page, arena.committed_bytes());
+            CHECK_EQUAL(64, s_resident(arena.m_ptr, 64 * page));
+            arena.add_capacity(32 * page);
+            CHECK_EQUAL(96, s_resident(arena.m_ptr, 96 * page));
+            npath::g_teardown_arena(arena);
+
+            config.m_prefault = 0;
+            npath::g_init_arena(arena, 64 * page, 1024 * page, 1, config);
+            CHECK_EQUAL(0, s_resident(arena.m_ptr, 64 * page));
+            npath::g_teardown_arena(arena);
+        }
+
+        UNITTEST_TEST(hugetlb)
+        {
+            // The hugetlb pool only backs the initial capacity, with the default 1 GB maximum the reservation
+            // still succeeds and the arena grows past it on transparent huge pages
+            u32 const              huge   = npath::narena::c_huge_page_size;
+            npath::varena_config_t config = {npath::narena::PagesHugeTLB, npath::narena::GrowMinimal, 0, 0, 0};
+            npath::varena_t        arena;
+            npath::g_init_arena(arena, huge, (u64)1 << 30, 1, config);
+            CHECK_NOT_NULL(arena.m_ptr);
+            CHECK_EQUAL((u64)huge, arena.m_page_size);
+            CHECK_EQUAL(0, (u64)arena.m_ptr % huge);
+            if (arena.m_config.m_pages == npath::narena::PagesHugeTLB)
+                CHECK_EQUAL((u64)huge, arena.m_hugetlb);
+            else
+                CHECK_EQUAL(0, arena.m_hugetlb); // no pool, transparent huge pages (or regular pages without THP)
+            arena.ensure_capacity(3 * huge);
+            CHECK_EQUAL((u64)4 * huge, arena.committed_bytes());
+            for (u32 i = 0; i < 4 * huge; i += 4096)
+                arena.m_ptr[i] = (u8)i;
+            npath::g_teardown_arena(arena);
+
+            // Without an initial capacity nothing goes to the pool
+            npath::g_init_arena(arena, 0, (u64)1 << 30, 1, config);
+            CHECK_NOT_NULL(arena.m_ptr);
+            CHECK_EQUAL(0, arena.m_hugetlb);
+            CHECK_TRUE(arena.m_config.m_pages != npath::narena::PagesHugeTLB);
+            npath::g_teardown_arena(arena);
+        }
+
+        UNITTEST_TEST(reservation_abort)
+        {
+            // Growing past the reservation aborts instead of handing out memory behind it
+            pid_t const pid = ::fork();
+            if (pid == 0)
+            {
+                ::signal(SIGABRT, SIG_DFL);
+                npath::varena_t arena;
+                npath::g_init_arena(arena, 0, 100, sizeof(u64));
+                arena.ensure_capacity(100000, sizeof(u64));
+                ::_exit(0);
+            }
+            CHECK_TRUE(pid > 0);
+            int status = 0;
+            ::waitpid(pid, &status, 0);
+            CHECK_TRUE(WIFSIGNALED(status));
+            CHECK_EQUAL(SIGABRT, WTERMSIG(status));
+        }
+#endif
+    }
+}
+UNITTEST_SUITE_END
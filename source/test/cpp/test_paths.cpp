@@ -0,0 +1,619 @@
+#include "ccore/c_target.h"
+#include "cbase/c_allocator.h"
+#include "cbase/c_runes.h"
+#include "cvmem/c_virtual_memory.h"
+
+#include "cunittest/cunittest.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_device.h"
+#include "cpath/c_filepath.h"
+#include "cpath/private/c_extindex.h"
+#include "cpath/private/c_fingerprints.h"
+#include "cpath/private/c_folders.h"
+
+#include "test_helpers.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace ncore;
+
+UNITTEST_SUITE_BEGIN(paths)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_ALLOCATOR;
+
+        UNITTEST_FIXTURE_SETUP() { nvmem::initialize(); }
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(stats)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+
+            paths->register_fulldirpath(ascii::make_crunes("c:/a/b/"));
+            paths->register_fulldirpath(ascii::make_crunes("c:/a/c/"));
+            paths->register_fulldirpath(ascii::make_crunes("c:/a/b/d/"));
+
+            npath::paths_stats_t stats;
+            paths->stats(stats);
+
+            CHECK_EQUAL(6, stats.m_folder_count); // default folder, "c:", "a", "b", "c" and "d"
+            CHECK_EQUAL(6, stats.m_string_count); // "nil", "c:", "a", "b", "c" and "d"
+            CHECK_EQUAL(2, stats.m_max_children);
+            CHECK_EQUAL(3, stats.m_max_depth);
+            CHECK_TRUE(stats.m_avg_children > 1.3f && stats.m_avg_children < 1.4f);
+            CHECK_TRUE(stats.m_folder_array.m_committed > 0);
+            CHECK_TRUE(stats.m_folder_array.m_committed <= stats.m_folder_array.m_reserved);
+            CHECK_TRUE(stats.m_string_bytes > 0);
+
+            npath::g_destruct_paths(Allocator, paths);
+        }
+
+        UNITTEST_TEST(many_devices)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+
+            // far more than the 62 devices of the old fixed table, the tables grow on the way
+            npath::ifile_t files[300];
+            for (u32 i = 0; i < 300; ++i)
+            {
+                char name[32];
+                snprintf(name, sizeof(name), "tenant%u:/data/", i);
+                dirpath_t d = paths->register_fulldirpath(ascii::make_crunes(name));
+                files[i]    = paths->file_of(d.filename(ascii::make_crunes("a.txt")));
+            }
+
+            npath::paths_stats_t stats;
+            paths->stats(stats);
+            CHECK_EQUAL(301, stats.m_device_count); // and the default device
+
+            for (u32 i = 0; i < 300; ++i)
+            {
+                char name[32];
+                snprintf(name, sizeof(name), "tenant%u:", i);
+                npath::idevice_t const index  = paths->m_devices->find_device(paths->find_string(ascii::make_crunes(name)));
+                npath::device_t*       device = paths->m_devices->get_device(index);
+                CHECK_TRUE(device != nullptr);
+                CHECK_TRUE(device == paths->device_of(paths->m_files->m_array.ptr_of(files[i])->m_folder));
+                CHECK_TRUE(device == paths->register_device(ascii::make_crunes(name))); // registered once
+            }
+            CHECK_EQUAL(npath::c_invalid_device, paths->m_devices->find_device(paths->find_or_insert_string(ascii::make_crunes("none:"))));
+
+            npath::g_destruct_paths(Allocator, paths);
+        }
+
+        static bool s_full_path_is(dirpath_t const& dir, const char* expected)
+        {
+            utf32::rune runes[256];
+            runes_t     r(runes, 0, 0, 256);
+            dir.full_path_to_string(r);
+            u32 const len = (u32)strlen(expected);
+            if ((u32)(r.m_end - r.m_str) != len || (u32)dir.full_path_to_strlen() != len)
+                return false;
+            for (u32 i = 0; i < len; ++i)
+                if (runes[r.m_str + i] != (utf32::rune)expected[i])
+                    return false;
+            return true;
+        }
+
+        UNITTEST_TEST(aliases)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+
+            // appdir: -> data: -> e:/data/
+            dirpath_t        e_data = paths->register_fulldirpath(ascii::make_crunes("e:/data/"));
+            npath::device_t* data   = paths->register_alias(ascii::make_crunes("data:"), e_data);
+            CHECK_TRUE(data != nullptr);
+            dirpath_t        data_app = paths->register_fulldirpath(ascii::make_crunes("data:/app/"));
+            npath::device_t* appdir   = paths->register_alias(ascii::make_crunes("appdir:"), data_app);
+            CHECK_TRUE(appdir != nullptr);
+            CHECK_TRUE(appdir == paths->register_alias(ascii::make_crunes("appdir:"), data_app)); // registered once
+
+            // Folders of an alias live in the physical tree and render as such
+            dirpath_t bin = paths->register_fulldirpath(ascii::make_crunes("appdir:/bin/"));
+            CHECK_TRUE(s_full_path_is(bin, "e:/data/app/bin/"));
+            CHECK_TRUE(bin == paths->register_fulldirpath(ascii::make_crunes("e:/data/app/bin/")));
+            npath::ifile_t const a = paths->file_of(bin.filename(ascii::make_crunes("a.txt")));
+            CHECK_TRUE(paths->device_of(paths->m_files->m_array.ptr_of(a)->m_folder) == paths->register_device(ascii::make_crunes("e:")));
+            CHECK_EQUAL(12, appdir->to_strlen()); // "e:/data/app/"
+
+            // A physical device cannot become an alias, an alias cannot redirect to itself
+            CHECK_TRUE(paths->register_alias(ascii::make_crunes("e:"), e_data) == nullptr);
+            CHECK_TRUE(paths->register_alias(ascii::make_crunes("data:"), bin) == nullptr);
+
+            // Pointing data: somewhere else moves appdir: along, the folders registered before stay where they are
+            dirpath_t f_store = paths->register_fulldirpath(ascii::make_crunes("f:/store/"));
+            CHECK_TRUE(data == paths->register_alias(ascii::make_crunes("data:"), f_store));
+            dirpath_t bin2 = paths->register_fulldirpath(ascii::make_crunes("appdir:/bin/"));
+            CHECK_TRUE(s_full_path_is(bin2, "f:/store/app/bin/"));
+            CHECK_TRUE(s_full_path_is(bin, "e:/data/app/bin/"));
+            npath::ifile_t const b = paths->file_of(bin2.filename(ascii::make_crunes("b.txt")));
+            CHECK_TRUE(paths->device_of(paths->m_files->m_array.ptr_of(b)->m_folder) == paths->register_device(ascii::make_crunes("f:")));
+
+            // An alias far below the root of the alias it redirects to moves along as well
+            char deep[6 + 300 * 2 + 1] = "data:/";
+            for (s32 i = 0; i < 300; ++i)
+            {
+                deep[6 + i * 2]     = 'd';
+                deep[6 + i * 2 + 1] = '/';
+            }
+            deep[6 + 300 * 2]       = 0;
+            npath::device_t* nested = paths->register_alias(ascii::make_crunes("nested:"), paths->register_fulldirpath(ascii::make_crunes(deep)));
+            CHECK_EQUAL(9 + 300 * 2, nested->to_strlen()); // "f:/store/d/d/.../d/"
+            CHECK_TRUE(data == paths->register_alias(ascii::make_crunes("data:"), e_data));
+            CHECK_EQUAL(8 + 300 * 2, nested->to_strlen()); // "e:/data/d/d/.../d/"
+
+            npath::g_destruct_paths(Allocator, paths);
+        }
+
+        UNITTEST_TEST(unions)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+
+            npath::ifile_t const base_a  = ntest::g_add_file(paths, "e:/base/textures/", "a.png");
+            npath::ifile_t const base_b  = ntest::g_add_file(paths, "e:/base/textures/", "b.png");
+            npath::ifile_t const patch_a = ntest::g_add_file(paths, "f:/patch/textures/", "a.png");
+            paths->register_fulldirpath(ascii::make_crunes("e:/dlc/"));
+
+            npath::device_t* layers[3];
+            layers[1] = paths->register_alias(ascii::make_crunes("dlc:"), paths->register_fulldirpath(ascii::make_crunes("e:/dlc/")));
+            layers[2] = paths->register_alias(ascii::make_crunes("base:"), paths->register_fulldirpath(ascii::make_crunes("e:/base/")));
+            layers[0] = paths->register_alias(ascii::make_crunes("patch:"), paths->register_fulldirpath(ascii::make_crunes("f:/patch/")));
+            npath::device_t* assets = paths->register_union(ascii::make_crunes("assets:"), layers, 3);
+            CHECK_TRUE(assets != nullptr);
+            CHECK_TRUE(paths->register_union(ascii::make_crunes("e:"), layers, 3) == nullptr); // a physical device
+            CHECK_TRUE(paths->register_union(ascii::make_crunes("all:"), &assets, 1) == nullptr); // a union is not a layer
+
+            dirpath_t  textures = paths->register_fulldirpath(ascii::make_crunes("assets:/textures/"));
+            filepath_t a        = textures.filename(ascii::make_crunes("a.png"));
+            filepath_t b        = textures.filename(ascii::make_crunes("b.png"));
+            filepath_t c        = textures.filename(ascii::make_crunes("c.png"));
+
+            // The first layer that has it, asking again hits the cache
+            filepath_t out(paths->m_devices->get_default_device());
+            CHECK_TRUE(paths->resolve(a, out));
+            CHECK_EQUAL(patch_a, paths->file_of(out));
+            CHECK_TRUE(paths->resolve(a, out));
+            CHECK_EQUAL(patch_a, paths->file_of(out));
+            CHECK_TRUE(paths->resolve(b, out));
+            CHECK_EQUAL(base_b, paths->file_of(out));
+            CHECK_FALSE(paths->resolve(c, out));
+
+            dirpath_t dir(paths->m_devices->get_default_device());
+            CHECK_TRUE(paths->resolve(textures, dir));
+            CHECK_TRUE(s_full_path_is(dir, "f:/patch/textures/"));
+            CHECK_FALSE(paths->resolve(paths->register_fulldirpath(ascii::make_crunes("assets:/sounds/")), dir));
+
+            // A change in the tree of a layer invalidates the cached resolutions
+            npath::ifile_t const dlc_b = ntest::g_add_file(paths, "dlc:/textures/", "b.png");
+            CHECK_TRUE(paths->resolve(b, out));
+            CHECK_EQUAL(dlc_b, paths->file_of(out));
+            npath::g_set_file_deleted(paths, patch_a, true);
+            CHECK_TRUE(paths->resolve(a, out));
+            CHECK_EQUAL(base_a, paths->file_of(out));
+            npath::g_set_file_deleted(paths, patch_a, false);
+            CHECK_TRUE(paths->resolve(a, out));
+            CHECK_EQUAL(patch_a, paths->file_of(out));
+
+            // A path that is not in a union is itself
+            filepath_t e = paths->register_fulldirpath(ascii::make_crunes("e:/base/textures/")).filename(ascii::make_crunes("a.png"));
+            CHECK_TRUE(paths->resolve(e, out));
+            CHECK_EQUAL(base_a, paths->file_of(out));
+
+            // Deep folders resolve without recursing once per level
+            dirpath_t deep_base  = paths->register_fulldirpath(ascii::make_crunes("base:/"));
+            dirpath_t deep_union = paths->register_fulldirpath(ascii::make_crunes("assets:/"));
+            for (s32 i = 0; i < 5000; ++i)
+            {
+                deep_base  = deep_base.down(ascii::make_crunes("d"));
+                deep_union = deep_union.down(ascii::make_crunes("d"));
+            }
+            CHECK_TRUE(paths->resolve(deep_union, dir));
+            CHECK_TRUE(dir == deep_base);
+
+            npath::g_destruct_paths(Allocator, paths);
+        }
+
+        UNITTEST_TEST(posix_paths)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+
+            dirpath_t const y = paths->register_fulldirpath(ascii::make_crunes("/home/me/y/"));
+            CHECK_FALSE(y.isEmpty());
+            CHECK_TRUE(s_full_path_is(y, "/home/me/y/"));
+            CHECK_TRUE(y == paths->register_fulldirpath(ascii::make_crunes("//home/me/./y")));
+            CHECK_EQUAL(1, paths->root_device()->to_strlen()); // "/"
+
+            // The home device, here pointed at a folder of the root device before its first use
+            CHECK_TRUE(paths->register_alias(ascii::make_crunes("~"), paths->register_fulldirpath(ascii::make_crunes("/home/me/"))) != nullptr);
+            CHECK_TRUE(y == paths->register_fulldirpath(ascii::make_crunes("~/y/")));
+            CHECK_TRUE(paths->home_device() == paths->register_alias(ascii::make_crunes("~"), paths->register_fulldirpath(ascii::make_crunes("/home/me/"))));
+
+            // The longest mount prefix wins, unless a ".." goes above it
+            dirpath_t const x = paths->register_fulldirpath(ascii::make_crunes("/mnt/data/../x/"));
+            CHECK_TRUE(s_full_path_is(x, "/mnt/x/"));
+            npath::device_t* mnt  = paths->register_device(ascii::make_crunes("mnt:"));
+            npath::device_t* data = paths->register_device(ascii::make_crunes("data:"));
+            CHECK_TRUE(paths->register_prefix(ascii::make_crunes("/mnt/"), mnt));
+            CHECK_TRUE(paths->register_prefix(ascii::make_crunes("/mnt/data/"), data));
+            CHECK_FALSE(paths->register_prefix(ascii::make_crunes("/mnt/../etc/"), data));
+            CHECK_TRUE(paths->register_fulldirpath(ascii::make_crunes("/mnt/data/a/")) == paths->register_fulldirpath(ascii::make_crunes("data:/a/")));
+            CHECK_TRUE(paths->register_fulldirpath(ascii::make_crunes("/mnt/other/b/")) == paths->register_fulldirpath(ascii::make_crunes("mnt:/other/b/")));
+            CHECK_TRUE(paths->register_fulldirpath(ascii::make_crunes("/mnt/data/a/../c/")) == paths->register_fulldirpath(ascii::make_crunes("data:/c/")));
+            CHECK_TRUE(paths->register_fulldirpath(ascii::make_crunes("/mnt/data/a/../../c/")) == paths->register_fulldirpath(ascii::make_crunes("mnt:/c/")));
+            CHECK_TRUE(paths->register_fulldirpath(ascii::make_crunes("/mnt/data/../x/")) == paths->register_fulldirpath(ascii::make_crunes("mnt:/x/")));
+            CHECK_TRUE(paths->register_fulldirpath(ascii::make_crunes("/mnt/data/../../etc/")) == paths->register_fulldirpath(ascii::make_crunes("/etc/")));
+            CHECK_TRUE(s_full_path_is(paths->register_fulldirpath(ascii::make_crunes("/mnt/data/../../etc/")), "/etc/"));
+            CHECK_TRUE(paths->register_fulldirpath(ascii::make_crunes("/mnt")) == paths->register_fulldirpath(ascii::make_crunes("mnt:/")));
+            CHECK_TRUE(paths->register_fulldirpath(ascii::make_crunes("/mn/t/")) == paths->register_fulldirpath(ascii::make_crunes("/mn/./t")));
+
+            // Hundreds of prefixes below one parent
+            for (u32 i = 0; i < 300; ++i)
+            {
+                char name[32];
+                snprintf(name, sizeof(name), "vol%u:", i);
+                npath::device_t* vol = paths->register_device(ascii::make_crunes(name));
+                snprintf(name, sizeof(name), "/vol/%u/", i);
+                CHECK_TRUE(paths->register_prefix(ascii::make_crunes(name), vol));
+            }
+            CHECK_TRUE(paths->register_fulldirpath(ascii::make_crunes("/vol/123/x/")) == paths->register_fulldirpath(ascii::make_crunes("vol123:/x/")));
+            CHECK_TRUE(paths->register_fulldirpath(ascii::make_crunes("/vol/1234/x/")) == paths->register_fulldirpath(ascii::make_crunes("/vol/1234/x/")));
+            CHECK_TRUE(s_full_path_is(paths->register_fulldirpath(ascii::make_crunes("/vol/1234/x/")), "/vol/1234/x/"));
+
+            npath::g_destruct_paths(Allocator, paths);
+        }
+
+        UNITTEST_TEST(compare_and_collate)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+
+            // registered out of lexicographic order on purpose
+            dirpath_t zeta   = paths->register_fulldirpath(ascii::make_crunes("c:/zeta/"));
+            dirpath_t alpha  = paths->register_fulldirpath(ascii::make_crunes("c:/alpha/beta/"));
+            dirpath_t alpha2 = paths->register_fulldirpath(ascii::make_crunes("c:/alpha/beta/"));
+            dirpath_t parent = alpha.up();
+
+            CHECK_EQUAL(0, alpha.compare(alpha2));
+            CHECK_TRUE(alpha == alpha2);
+            CHECK_TRUE(alpha != zeta);
+
+            // walk based collation
+            CHECK_TRUE(alpha.collate(zeta) < 0);
+            CHECK_TRUE(zeta.collate(alpha) > 0);
+            CHECK_TRUE(parent.collate(alpha) < 0);
+            CHECK_EQUAL(0, alpha.collate(alpha2));
+
+            // key based collation must agree
+            paths->update_collation();
+            CHECK_TRUE(alpha.collate(zeta) < 0);
+            CHECK_TRUE(zeta.collate(alpha) > 0);
+            CHECK_TRUE(parent.collate(alpha) < 0);
+            CHECK_EQUAL(0, alpha.collate(alpha2));
+
+            npath::g_destruct_paths(Allocator, paths);
+        }
+
+        // The order of the rendered full paths, a folder is "name/" and a file in a folder above another file
+        // compares with the sub folder on the way down
+        UNITTEST_TEST(collate_full_path)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+
+            dirpath_t const foo  = paths->register_fulldirpath(ascii::make_crunes("c:/foo/"));
+            dirpath_t const food = paths->register_fulldirpath(ascii::make_crunes("c:/foo.d/"));
+            dirpath_t const a    = paths->register_fulldirpath(ascii::make_crunes("c:/a/"));
+            dirpath_t const ab   = paths->register_fulldirpath(ascii::make_crunes("c:/a/b/"));
+            for (s32 pass = 0; pass < 2; ++pass)
+            {
+                CHECK_TRUE(food.collate(foo) < 0); // '.' < '/'
+                CHECK_TRUE(foo.collate(food) > 0);
+                CHECK_TRUE(a.collate(ab) < 0);
+                paths->update_collation(); // the keys must agree with the walk
+            }
+
+            filepath_t const z   = a.filename(ascii::make_crunes("z.txt"));
+            filepath_t const x   = ab.filename(ascii::make_crunes("x.txt"));
+            filepath_t const b0  = a.filename(ascii::make_crunes("b.txt")); // "b.txt" < "b/"
+            filepath_t const ax  = a.filename(ascii::make_crunes("a.x"));
+            filepath_t const ad  = a.filename(ascii::make_crunes("a-"));
+            filepath_t const top = paths->register_fulldirpath(ascii::make_crunes("c:/")).filename(ascii::make_crunes("b.txt"));
+            CHECK_TRUE(x.collate(z) < 0);
+            CHECK_TRUE(z.collate(x) > 0);
+            CHECK_TRUE(b0.collate(x) < 0);
+            CHECK_TRUE(x.collate(b0) > 0);
+            CHECK_TRUE(ad.collate(ax) < 0); // "a-" < "a.x"
+            CHECK_TRUE(top.collate(x) > 0); // "c:/b.txt" > "c:/a/b/x.txt"
+            CHECK_TRUE(x.collate(top) < 0);
+            CHECK_EQUAL(0, z.collate(a.filename(ascii::make_crunes("z.txt"))));
+
+            npath::g_destruct_paths(Allocator, paths);
+        }
+
+        static bool s_contains(npath::ifile_t const* files, u32 count, npath::ifile_t file)
+        {
+            for (u32 i = 0; i < count; ++i)
+                if (files[i] == file)
+                    return true;
+            return false;
+        }
+
+        UNITTEST_TEST(extension_index)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+
+            // files registered before and after the index is enabled
+            npath::ifile_t const a = ntest::g_add_file(paths, "c:/src/core/", "a.cpp");
+            ntest::g_add_file(paths, "c:/src/core/", "a.h");
+            paths->enable_extindex();
+            npath::ifile_t const b = ntest::g_add_file(paths, "c:/src/ui/", "b.cpp");
+            npath::ifile_t const c = ntest::g_add_file(paths, "c:/src/core/sub/", "c.cpp");
+            npath::ifile_t const d = ntest::g_add_file(paths, "c:/test/", "d.cpp");
+            for (u32 i = 0; i < 20; ++i) // grows the bucket
+            {
+                char name[16] = {'x', (char)('a' + i), '.', 'c', 'p', 'p', 0};
+                ntest::g_add_file(paths, "c:/other/", name);
+            }
+
+            npath::string_t const cpp = paths->find_string(ascii::make_crunes(".cpp"));
+            npath::ifile_t        files[32];
+            CHECK_EQUAL(24, paths->files_with_extension(cpp, files, 32));
+            CHECK_EQUAL(1, paths->files_with_extension(paths->find_string(ascii::make_crunes(".h")), files, 32));
+            CHECK_EQUAL(0, paths->files_with_extension(paths->find_or_insert_string(ascii::make_crunes(".txt")), files, 32));
+
+            // below a folder
+            dirpath_t const core = paths->register_fulldirpath(ascii::make_crunes("c:/src/core/"));
+            dirpath_t const src  = paths->register_fulldirpath(ascii::make_crunes("c:/src/"));
+            CHECK_EQUAL(2, paths->files_with_extension(core, cpp, files, 32));
+            CHECK_TRUE(s_contains(files, 2, a) && s_contains(files, 2, c));
+            CHECK_EQUAL(3, paths->files_with_extension(src, cpp, files, 32));
+            CHECK_TRUE(s_contains(files, 3, b));
+            CHECK_EQUAL(3, paths->files_with_extension(src, cpp, files, 1)); // the count, one written
+
+            // tombstones leave the index and come back, new folders get an interval of their own
+            npath::g_set_file_deleted(paths, c, true);
+            CHECK_EQUAL(1, paths->files_with_extension(core, cpp, files, 32));
+            CHECK_EQUAL(a, files[0]);
+            npath::g_set_file_deleted(paths, c, false);
+            npath::ifile_t const e = ntest::g_add_file(paths, "c:/src/core/new/", "e.cpp");
+            CHECK_EQUAL(3, paths->files_with_extension(core, cpp, files, 32));
+            CHECK_TRUE(s_contains(files, 3, c) && s_contains(files, 3, e));
+            CHECK_EQUAL(1, paths->files_with_extension(paths->register_fulldirpath(ascii::make_crunes("c:/test/")), cpp, files, 32));
+            CHECK_EQUAL(d, files[0]);
+
+            npath::g_destruct_paths(Allocator, paths);
+        }
+
+        // Folders added in random places after the index was enabled use up the gaps and renumber sub trees, the
+        // queries are checked against the paths
+        UNITTEST_TEST(extindex_incremental)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+            paths->enable_extindex();
+            npath::string_t const cpp = paths->find_or_insert_string(ascii::make_crunes(".cpp"));
+
+            s32 const      count   = 3000;
+            s32 const      max_len = 256;
+            char*          dirs    = (char*)Allocator->allocate(count * max_len);
+            npath::ifile_t files[count];
+            npath::ifile_t found[count];
+            u32            seed = 12345;
+            for (s32 i = 0; i < count; ++i)
+            {
+                // below the last folder (deep chains) or a random one (wide folders)
+                seed               = seed * 1103515245 + 12345;
+                s32 const   parent = (seed >> 16) % 4 == 0 ? i - 1 : (s32)((seed >> 8) % (u32)(i + 1)) - 1;
+                char*       dir    = dirs + i * max_len;
+                char const* p      = parent < 0 ? "c:/" : dirs + parent * max_len;
+                if (strlen(p) + 8 >= (size_t)max_len)
+                    p = "c:/";
+                snprintf(dir, max_len, "%sf%d/", p, i);
+                files[i] = ntest::g_add_file(paths, dir, "x.cpp");
+            }
+
+            bool alive[count];
+            for (s32 i = 0; i < count; ++i)
+                alive[i] = true;
+            for (s32 pass = 0; pass < 3; ++pass)
+            {
+                // two thirds become tombstones, which merges the list without them, then half of those come back
+                for (s32 i = 0; i < count && pass > 0; ++i)
+                {
+                    if ((i % 3) == 0 || (pass == 2 && (i % 3) == 2))
+                        continue;
+                    npath::g_set_file_deleted(paths, files[i], pass == 1);
+                    alive[i] = pass != 1;
+                }
+
+                s32 mismatches = 0;
+                for (s32 i = 0; i < count; i += 7)
+                {
+                    char const*  dir      = dirs + i * max_len;
+                    size_t const len      = strlen(dir);
+                    u32          expected = 0;
+                    for (s32 j = 0; j < count; ++j)
+                    {
+                        if (alive[j] && strncmp(dirs + j * max_len, dir, len) == 0)
+                            expected += 1;
+                    }
+                    u32 const n = paths->files_with_extension(paths->register_fulldirpath(ascii::make_crunes(dir)), cpp, found, count);
+                    if (n != expected || s_contains(found, n, files[i]) != alive[i])
+                        mismatches += 1;
+                }
+                CHECK_EQUAL(0, mismatches);
+            }
+
+            Allocator->deallocate(dirs);
+            npath::g_destruct_paths(Allocator, paths);
+        }
+
+        // One extension with more than half of all the files, its block doubles past max_items
+        UNITTEST_TEST(extindex_one_bucket)
+        {
+            u32 const       max_items = 10000;
+            npath::paths_t* paths     = npath::g_construct_paths(Allocator, max_items);
+            paths->enable_extindex();
+
+            u32 const count = 9000;
+            for (u32 i = 0; i < count; ++i)
+            {
+                char name[16];
+                snprintf(name, sizeof(name), "f%05u.cpp", i);
+                ntest::g_add_file(paths, "c:/src/", name);
+            }
+
+            npath::ifile_t files[4];
+            CHECK_EQUAL(count, paths->files_with_extension(paths->find_string(ascii::make_crunes(".cpp")), files, 4));
+
+            npath::g_destruct_paths(Allocator, paths);
+        }
+
+        static void s_set_stat(npath::paths_t* paths, npath::ifile_t file, u64 size, s64 mtime)
+        {
+            npath::filestat_t stat;
+            memset(&stat, 0, sizeof(stat));
+            stat.m_size     = size;
+            stat.m_mtime_ns = mtime;
+            paths->set_file_stat(file, stat);
+        }
+
+        UNITTEST_TEST(rollups)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+
+            npath::ifile_t const a = ntest::g_add_file(paths, "c:/src/core/", "a.cpp");
+            npath::ifile_t const b = ntest::g_add_file(paths, "c:/src/ui/", "b.cpp");
+            s_set_stat(paths, a, 100, 10);
+            s_set_stat(paths, b, 50, 20);
+            paths->enable_rollups();
+
+            dirpath_t const root = paths->register_fulldirpath(ascii::make_crunes("c:/"));
+            dirpath_t const src  = paths->register_fulldirpath(ascii::make_crunes("c:/src/"));
+            dirpath_t const core = paths->register_fulldirpath(ascii::make_crunes("c:/src/core/"));
+
+            npath::rollup_t r;
+            CHECK_TRUE(paths->get_rollup(src, r));
+            CHECK_EQUAL(150, r.m_bytes);
+            CHECK_EQUAL(2, r.m_files);
+            CHECK_EQUAL(20, r.m_mtime_ns);
+
+            // incremental, new files (without metadata), changed metadata, new folders
+            npath::ifile_t const c = ntest::g_add_file(paths, "c:/src/core/sub/", "c.h");
+            s_set_stat(paths, c, 7, 30);
+            s_set_stat(paths, a, 40, 15);
+            paths->get_rollup(root, r);
+            CHECK_EQUAL(97, r.m_bytes);
+            CHECK_EQUAL(3, r.m_files);
+            CHECK_EQUAL(30, r.m_mtime_ns);
+            paths->get_rollup(core, r);
+            CHECK_EQUAL(47, r.m_bytes);
+            CHECK_EQUAL(2, r.m_files);
+
+            // losing the newest file rebuilds the mtime, tombstones come back
+            npath::g_set_file_deleted(paths, c, true);
+            paths->get_rollup(root, r);
+            CHECK_EQUAL(90, r.m_bytes);
+            CHECK_EQUAL(2, r.m_files);
+            CHECK_EQUAL(20, r.m_mtime_ns);
+            paths->get_rollup(core, r);
+            CHECK_EQUAL(15, r.m_mtime_ns);
+            s_set_stat(paths, b, 50, 5); // older than before
+            paths->get_rollup(src, r);
+            CHECK_EQUAL(15, r.m_mtime_ns);
+            npath::g_set_file_deleted(paths, c, false);
+            paths->get_rollup(src, r);
+            CHECK_EQUAL(97, r.m_bytes);
+            CHECK_EQUAL(30, r.m_mtime_ns);
+
+            // the bulk recompute agrees
+            npath::rollup_t before;
+            paths->get_rollup(root, before);
+            paths->update_rollups();
+            paths->get_rollup(root, r);
+            CHECK_EQUAL(before.m_bytes, r.m_bytes);
+            CHECK_EQUAL(before.m_files, r.m_files);
+            CHECK_EQUAL(before.m_mtime_ns, r.m_mtime_ns);
+
+            // the newest file at the bottom of a deep chain, every folder above it is rebuilt without recursion
+            dirpath_t deep = paths->register_fulldirpath(ascii::make_crunes("c:/deep/"));
+            for (s32 i = 0; i < 50000; ++i)
+                deep = deep.down(ascii::make_crunes("d"));
+            npath::ifile_t const d = paths->file_of(deep.filename(ascii::make_crunes("d.txt")));
+            s_set_stat(paths, d, 1, 40);
+            paths->get_rollup(root, r);
+            CHECK_EQUAL(40, r.m_mtime_ns);
+            npath::g_set_file_deleted(paths, d, true);
+            paths->get_rollup(root, r);
+            CHECK_EQUAL(30, r.m_mtime_ns);
+            CHECK_EQUAL(before.m_files, r.m_files);
+
+            npath::g_destruct_paths(Allocator, paths);
+        }
+
+        static bool s_same(npath::paths_t* a, const char* dir_a, npath::paths_t* b, const char* dir_b)
+        {
+            npath::fingerprint_t fa, fb;
+            a->get_fingerprint(a->register_fulldirpath(ascii::make_crunes(dir_a)), fa);
+            b->get_fingerprint(b->register_fulldirpath(ascii::make_crunes(dir_b)), fb);
+            return fa.m_lo == fb.m_lo && fa.m_hi == fb.m_hi;
+        }
+
+        UNITTEST_TEST(fingerprints)
+        {
+            npath::paths_t* a = npath::g_construct_paths(Allocator);
+            npath::paths_t* b = npath::g_construct_paths(Allocator);
+
+            // the same tree registered in a different order
+            npath::ifile_t const x = ntest::g_add_file(a, "c:/src/core/", "a.cpp");
+            ntest::g_add_file(a, "c:/src/ui/", "b.cpp");
+            ntest::g_add_file(a, "c:/docs/", "readme");
+            s_set_stat(a, x, 100, 10);
+            ntest::g_add_file(b, "d:/docs/", "readme");
+            ntest::g_add_file(b, "d:/src/ui/", "b.cpp");
+            npath::ifile_t const y = ntest::g_add_file(b, "d:/src/core/", "a.cpp");
+            s_set_stat(b, y, 100, 10);
+
+            npath::fingerprint_t fp;
+            CHECK_FALSE(a->get_fingerprint(a->register_fulldirpath(ascii::make_crunes("c:/")), fp));
+            a->enable_fingerprints();
+            b->enable_fingerprints(2);
+            CHECK_TRUE(s_same(a, "c:/", b, "d:/")); // the name of the root is not part of it
+            CHECK_TRUE(s_same(a, "c:/src/", b, "d:/src/"));
+            CHECK_FALSE(s_same(a, "c:/src/", b, "d:/docs/"));
+
+            // changes are seen by the folder and its parents only
+            s_set_stat(b, y, 100, 11);
+            CHECK_FALSE(s_same(a, "c:/", b, "d:/"));
+            CHECK_FALSE(s_same(a, "c:/src/core/", b, "d:/src/core/"));
+            CHECK_TRUE(s_same(a, "c:/src/ui/", b, "d:/src/ui/"));
+            s_set_stat(b, y, 100, 10);
+            CHECK_TRUE(s_same(a, "c:/", b, "d:/"));
+
+            // a new empty folder, a tombstone
+            b->register_fulldirpath(ascii::make_crunes("d:/src/empty/"));
+            CHECK_FALSE(s_same(a, "c:/src/", b, "d:/src/"));
+            a->register_fulldirpath(ascii::make_crunes("c:/src/empty/"));
+            CHECK_TRUE(s_same(a, "c:/src/", b, "d:/src/"));
+            npath::g_set_file_deleted(a, x, true);
+            CHECK_FALSE(s_same(a, "c:/", b, "d:/"));
+            npath::g_set_file_deleted(a, x, false);
+            CHECK_TRUE(s_same(a, "c:/", b, "d:/"));
+
+            // the bulk recompute agrees with the queries
+            npath::ifile_t const z = ntest::g_add_file(a, "c:/src/core/deep/er/", "z.txt");
+            s_set_stat(a, z, 1, 2);
+            npath::fingerprint_t bulk, query;
+            a->update_fingerprints(2);
+            a->get_fingerprint(a->register_fulldirpath(ascii::make_crunes("c:/")), bulk);
+            npath::g_fingerprint_invalidate(a);
+            a->get_fingerprint(a->register_fulldirpath(ascii::make_crunes("c:/")), query);
+            CHECK_TRUE(bulk.m_lo == query.m_lo && bulk.m_hi == query.m_hi);
+
+            npath::g_destruct_paths(Allocator, a);
+            npath::g_destruct_paths(Allocator, b);
+        }
+    }
+}
+UNITTEST_SUITE_END
@@ -0,0 +1,424 @@
+#include "ccore/c_target.h"
+#include "cbase/c_allocator.h"
+#include "cbase/c_runes.h"
+#include "cvmem/c_virtual_memory.h"
+
+#include "cunittest/cunittest.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_filepath.h"
+#include "cpath/c_device.h"
+#include "cpath/c_scanner.h"
+#include "cpath/private/c_lazy.h"
+
+#if defined(TARGET_LINUX) || defined(TARGET_MAC)
+#    include <fcntl.h>
+#    include <pthread.h>
+#    include <stdio.h>
+#    include <stdlib.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+using namespace ncore;
+
+UNITTEST_SUITE_BEGIN(scanner)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_ALLOCATOR;
+
+        UNITTEST_FIXTURE_SETUP() { nvmem::initialize(); }
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+#if defined(TARGET_LINUX) || defined(TARGET_MAC)
+        static const char* s_dirs[]  = {"a", "a/b", "c"};
+        static const char* s_files[] = {"a/x.txt", "a/y.cpp", "a/b/z.h", "top.md"};
+
+        static void s_path(char* out, s32 size, const char* root, const char* name) { snprintf(out, size, "%s/%s", root, name); }
+
+        static void s_create_tree(const char* root)
+        {
+            char path[512];
+            for (s32 i = 0; i < 3; ++i)
+            {
+                s_path(path, sizeof(path), root, s_dirs[i]);
+                mkdir(path, 0755);
+            }
+            for (s32 i = 0; i < 4; ++i)
+            {
+                s_path(path, sizeof(path), root, s_files[i]);
+                close(open(path, O_CREAT | O_WRONLY, 0644));
+            }
+            s_path(path, sizeof(path), root, "link");
+            symlink("a", path);
+        }
+
+        static void s_remove_tree(const char* root)
+        {
+            char path[512];
+            s_path(path, sizeof(path), root, "link");
+            unlink(path);
+            for (s32 i = 0; i < 4; ++i)
+            {
+                s_path(path, sizeof(path), root, s_files[i]);
+                unlink(path);
+            }
+            for (s32 i = 2; i >= 0; --i)
+            {
+                s_path(path, sizeof(path), root, s_dirs[i]);
+                rmdir(path);
+            }
+            rmdir(root);
+        }
+
+        UNITTEST_TEST(scan)
+        {
+            char root[] = "/tmp/cpath_scan_XXXXXX";
+            CHECK_NOT_NULL(mkdtemp(root));
+            s_create_tree(root);
+
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+            dirpath_t       scan  = paths->register_fulldirpath(ascii::make_crunes("scan:/"));
+
+            npath::scan_config_t config = npath::g_default_scan_config;
+            config.m_num_threads        = 4;
+            npath::scan_stats_t stats;
+            CHECK_TRUE(npath::scanner_t::scan(scan, root, config, stats));
+
+            CHECK_EQUAL(4, stats.m_folders); // root, "a", "a/b" and "c"
+            CHECK_EQUAL(4, stats.m_files);
+            CHECK_EQUAL(1, stats.m_symlinks); // "link" is registered as a file, it is not followed
+            CHECK_EQUAL(0, stats.m_errors);
+
+            npath::paths_stats_t before;
+            paths->stats(before);
+            CHECK_EQUAL(5, before.m_folder_count); // default folder, "scan:", "a", "b" and "c"
+            CHECK_EQUAL(6, before.m_file_count);   // default file + 5
+
+            // everything is there already, navigating down doesn't register anything new
+            dirpath_t b = scan.down(ascii::make_crunes("a")).down(ascii::make_crunes("b"));
+            CHECK_EQUAL(2, b.depth());
+            npath::paths_stats_t after;
+            paths->stats(after);
+            CHECK_EQUAL(before.m_folder_count, after.m_folder_count);
+
+            npath::g_destruct_paths(Allocator, paths);
+            s_remove_tree(root);
+        }
+
+        UNITTEST_TEST(stat)
+        {
+            char root[] = "/tmp/cpath_stat_XXXXXX";
+            CHECK_NOT_NULL(mkdtemp(root));
+            s_create_tree(root);
+
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+            dirpath_t       scan  = paths->register_fulldirpath(ascii::make_crunes("scan:/"));
+
+            npath::scan_config_t config = npath::g_default_scan_config;
+            config.m_num_threads        = 2;
+            npath::scan_stats_t stats;
+            CHECK_TRUE(npath::scanner_t::scan(scan, root, config, stats));
+
+            // first pass, everything is new
+            CHECK_TRUE(npath::scanner_t::stat(scan, root, config, stats));
+            CHECK_EQUAL(4, stats.m_folders);
+            CHECK_EQUAL(5, stats.m_changed);
+            CHECK_EQUAL(0, stats.m_missing);
+
+            // nothing changed on disk
+            CHECK_TRUE(npath::scanner_t::stat(scan, root, config, stats));
+            CHECK_EQUAL(0, stats.m_changed);
+
+            // grow one file, remove another
+            char path[512];
+            s_path(path, sizeof(path), root, "a/y.cpp");
+            s32 const fd = open(path, O_WRONLY | O_APPEND);
+            CHECK_EQUAL(5, (s32)write(fd, "hello", 5));
+            close(fd);
+            s_path(path, sizeof(path), root, "top.md");
+            unlink(path);
+
+            paths->enable_rollups();
+            CHECK_TRUE(npath::scanner_t::stat(scan, root, config, stats));
+            CHECK_EQUAL(1, stats.m_missing);
+
+            // recomputed after the pass, the symbolic link is 1 byte ("a"), a missing file has no size
+            npath::rollup_t rollup;
+            CHECK_TRUE(paths->get_rollup(scan, rollup));
+            CHECK_EQUAL(6, rollup.m_bytes);
+            CHECK_EQUAL(5, rollup.m_files);
+            CHECK_TRUE(paths->get_rollup(scan.down(ascii::make_crunes("a")), rollup));
+            CHECK_EQUAL(5, rollup.m_bytes);
+
+            npath::ifile_t changed[8];
+            u32 const      num_changed = paths->changed_files(0, changed, 8);
+            CHECK_EQUAL(2, num_changed); // the grown and the removed file
+
+            npath::filestat_t fs;
+            u32               grown = 0;
+            for (u32 i = 0; i < num_changed; ++i)
+            {
+                if (paths->get_file_stat(changed[i], fs))
+                {
+                    CHECK_EQUAL(5, fs.m_size);
+                    CHECK_TRUE((fs.m_flags & npath::nmeta::FlagChanged) != 0);
+                    filepath_t const fp = paths->get_filepath(changed[i]);
+                    CHECK_TRUE(fp.dirpath() == scan.down(ascii::make_crunes("a")));
+                    grown += 1;
+                }
+            }
+            CHECK_EQUAL(1, grown);
+
+            npath::g_destruct_paths(Allocator, paths);
+            s_remove_tree(root);
+        }
+
+        UNITTEST_TEST(hash)
+        {
+            char root[] = "/tmp/cpath_hash_XXXXXX";
+            CHECK_NOT_NULL(mkdtemp(root));
+            s_create_tree(root);
+
+            char path[512];
+            s_path(path, sizeof(path), root, "a/x.txt");
+            s32 fd = open(path, O_WRONLY | O_TRUNC);
+            CHECK_EQUAL(5, (s32)write(fd, "hello", 5));
+            close(fd);
+
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+            dirpath_t       scan  = paths->register_fulldirpath(ascii::make_crunes("scan:/"));
+
+            npath::scan_config_t config = npath::g_default_scan_config;
+            config.m_num_threads        = 2;
+            npath::scan_stats_t stats;
+            CHECK_TRUE(npath::scanner_t::scan(scan, root, config, stats));
+
+            // every regular file is hashed once
+            CHECK_TRUE(npath::scanner_t::hash(scan, root, config, stats));
+            CHECK_EQUAL(4, stats.m_files);
+            CHECK_EQUAL(4, stats.m_hashed);
+
+            npath::contenthash_t hash;
+            npath::ifile_t const x = paths->file_of(scan.down(ascii::make_crunes("a")).filename(ascii::make_crunes("x.txt")));
+            CHECK_TRUE(paths->get_file_hash(x, hash));
+            // MurmurHash3 x64-128 of "hello" with seed 0, the reference MurmurHash3_x64_128 (smhasher) returns the same two halves
+            CHECK_TRUE(hash.m_lo == 0xcbd8a7b341bd9b02ULL && hash.m_hi == 0x5b1e906a48ae1d19ULL);
+
+            // unchanged files are not read again
+            CHECK_TRUE(npath::scanner_t::hash(scan, root, config, stats));
+            CHECK_EQUAL(0, stats.m_hashed);
+
+            s_path(path, sizeof(path), root, "a/y.cpp");
+            fd = open(path, O_WRONLY | O_APPEND);
+            CHECK_EQUAL(5, (s32)write(fd, "hello", 5));
+            close(fd);
+            CHECK_TRUE(npath::scanner_t::hash(scan, root, config, stats));
+            CHECK_EQUAL(1, stats.m_hashed);
+            CHECK_EQUAL(1, stats.m_changed);
+            npath::ifile_t changed[4];
+            CHECK_EQUAL(1, paths->changed_hashes(0, changed, 4));
+
+            // the hashes survive into a new registry, nothing needs to be hashed
+            char saved[512];
+            snprintf(saved, sizeof(saved), "%s.hashes", root);
+            CHECK_TRUE(paths->save_hashes(scan, saved));
+            npath::g_destruct_paths(Allocator, paths);
+
+            paths = npath::g_construct_paths(Allocator);
+            scan  = paths->register_fulldirpath(ascii::make_crunes("scan:/"));
+            CHECK_TRUE(paths->load_hashes(scan, saved));
+            CHECK_TRUE(paths->get_file_hash(paths->file_of(scan.down(ascii::make_crunes("a")).filename(ascii::make_crunes("x.txt"))), hash));
+            CHECK_TRUE(hash.m_lo == 0xcbd8a7b341bd9b02ULL && hash.m_hi == 0x5b1e906a48ae1d19ULL);
+            CHECK_TRUE(npath::scanner_t::scan(scan, root, config, stats));
+            CHECK_TRUE(npath::scanner_t::hash(scan, root, config, stats));
+            CHECK_EQUAL(4, stats.m_files);
+            CHECK_EQUAL(0, stats.m_hashed);
+
+            unlink(saved);
+            npath::g_destruct_paths(Allocator, paths);
+            s_remove_tree(root);
+        }
+
+        UNITTEST_TEST(lazy)
+        {
+            char root[] = "/tmp/cpath_lazy_XXXXXX";
+            CHECK_NOT_NULL(mkdtemp(root));
+            s_create_tree(root);
+
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+            dirpath_t       lazy  = paths->register_fulldirpath(ascii::make_crunes("lazy:/"));
+            CHECK_TRUE(paths->enable_lazy(lazy, root));
+
+            npath::paths_stats_t stats;
+            paths->stats(stats);
+            CHECK_EQUAL(2, stats.m_folder_count); // default folder and "lazy:", nothing has been read yet
+
+            // the first enumeration reads the root, only the root
+            CHECK_FALSE(lazy.down().isEmpty());
+            paths->stats(stats);
+            CHECK_EQUAL(4, stats.m_folder_count); // + "a" and "c"
+            CHECK_EQUAL(3, stats.m_file_count);   // default file, "top.md" and "link"
+
+            dirpath_t const a = lazy.down(ascii::make_crunes("a"));
+            CHECK_EQUAL(1, a.depth());
+            paths->stats(stats);
+            CHECK_EQUAL(4, stats.m_folder_count);
+
+            dirpath_t const b = a.down();
+            CHECK_TRUE(b == a.down(ascii::make_crunes("b")));
+            paths->stats(stats);
+            CHECK_EQUAL(5, stats.m_folder_count);
+            CHECK_EQUAL(5, stats.m_file_count); // + "x.txt" and "y.cpp"
+
+            // read once, enumerating again doesn't touch the disk
+            lazy.down();
+            a.down();
+            paths->stats(stats);
+            CHECK_EQUAL(5, stats.m_folder_count);
+            CHECK_EQUAL(paths->m_lazy->m_expanded, 2);
+
+            npath::g_destruct_paths(Allocator, paths);
+            s_remove_tree(root);
+        }
+
+        struct reader_t
+        {
+            dirpath_t const* m_root;
+            s32              m_depth;
+        };
+
+        static void* s_lazy_reader(void* arg)
+        {
+            reader_t* reader = (reader_t*)arg;
+            dirpath_t dir    = *reader->m_root;
+            while (true)
+            {
+                dirpath_t const child = dir.down();
+                if (child.isEmpty())
+                    break;
+                dir = child;
+            }
+            reader->m_depth = dir.depth();
+            return nullptr;
+        }
+
+        UNITTEST_TEST(lazy_concurrent_readers)
+        {
+            char root[] = "/tmp/cpath_lazy_XXXXXX";
+            CHECK_NOT_NULL(mkdtemp(root));
+            s_create_tree(root);
+
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+            dirpath_t       lazy  = paths->register_fulldirpath(ascii::make_crunes("lazy:/"));
+            CHECK_TRUE(paths->enable_lazy(lazy, root));
+
+            // every reader walks down the first child chain, which expands folders on the way
+            pthread_t threads[4];
+            reader_t  readers[4];
+            for (s32 i = 0; i < 4; ++i)
+            {
+                readers[i].m_root  = &lazy;
+                readers[i].m_depth = -1;
+                pthread_create(&threads[i], nullptr, s_lazy_reader, &readers[i]);
+            }
+            for (s32 i = 0; i < 4; ++i)
+                pthread_join(threads[i], nullptr);
+            for (s32 i = 1; i < 4; ++i)
+                CHECK_EQUAL(readers[0].m_depth, readers[i].m_depth);
+            CHECK_TRUE(readers[0].m_depth >= 1);
+
+            npath::g_destruct_paths(Allocator, paths);
+            s_remove_tree(root);
+        }
+
+        static const s32 c_named_dirs    = 64;
+        static const s32 c_named_threads = 4;
+
+        struct named_t
+        {
+            dirpath_t const* m_root;
+            s32              m_thread;
+        };
+
+        static void* s_named_reader(void* arg)
+        {
+            named_t* named = (named_t*)arg;
+            char     name[32];
+            for (s32 j = 0; j < c_named_dirs; ++j)
+            {
+                // looking up a name inserts strings and folders while other threads expand their folders
+                snprintf(name, sizeof(name), "d%02d", j);
+                dirpath_t const dir = named->m_root->down(ascii::make_crunes(name));
+                snprintf(name, sizeof(name), "t%d", named->m_thread);
+                dir.down(ascii::make_crunes(name));
+                dir.down(ascii::make_crunes("shared"));
+            }
+            return nullptr;
+        }
+
+        UNITTEST_TEST(lazy_concurrent_named_lookups)
+        {
+            char root[] = "/tmp/cpath_lazy_XXXXXX";
+            CHECK_NOT_NULL(mkdtemp(root));
+            char path[512];
+            for (s32 j = 0; j < c_named_dirs; ++j)
+            {
+                snprintf(path, sizeof(path), "%s/d%02d", root, j);
+                mkdir(path, 0755);
+                snprintf(path, sizeof(path), "%s/d%02d/f%02d.txt", root, j, j);
+                close(open(path, O_CREAT | O_WRONLY, 0644));
+            }
+
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+            dirpath_t       lazy  = paths->register_fulldirpath(ascii::make_crunes("lazy:/"));
+            CHECK_TRUE(paths->enable_lazy(lazy, root));
+            lazy.down();
+            npath::paths_stats_t stats;
+            paths->stats(stats);
+            u32 const            folders = stats.m_folder_count;
+
+            pthread_t threads[c_named_threads];
+            named_t   named[c_named_threads];
+            for (s32 i = 0; i < c_named_threads; ++i)
+            {
+                named[i].m_root   = &lazy;
+                named[i].m_thread = i;
+                pthread_create(&threads[i], nullptr, s_named_reader, &named[i]);
+            }
+            for (s32 i = 0; i < c_named_threads; ++i)
+                pthread_join(threads[i], nullptr);
+
+            // "shared" and every "t<thread>" was added exactly once, every folder was read exactly once
+            paths->stats(stats);
+            CHECK_EQUAL(folders + c_named_dirs * (1 + c_named_threads), stats.m_folder_count);
+            CHECK_EQUAL(c_named_dirs + 1, stats.m_file_count); // + the default file
+            CHECK_EQUAL(c_named_dirs + 1, paths->m_lazy->m_expanded);
+
+            npath::g_destruct_paths(Allocator, paths);
+            for (s32 j = 0; j < c_named_dirs; ++j)
+            {
+                snprintf(path, sizeof(path), "%s/d%02d/f%02d.txt", root, j, j);
+                unlink(path);
+                snprintf(path, sizeof(path), "%s/d%02d", root, j);
+                rmdir(path);
+            }
+            rmdir(root);
+        }
+
+        UNITTEST_TEST(scan_missing_root)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+            dirpath_t       scan  = paths->register_fulldirpath(ascii::make_crunes("scan:/"));
+
+            npath::scan_stats_t stats;
+            CHECK_FALSE(npath::scanner_t::scan(scan, "/tmp/cpath_scan_does_not_exist", npath::g_default_scan_config, stats));
+
+            npath::g_destruct_paths(Allocator, paths);
+        }
+#endif
+    }
+}
+UNITTEST_SUITE_END
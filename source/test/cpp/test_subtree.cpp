@@ -0,0 +1,115 @@
+#include "ccore/c_target.h"
+#include "cbase/c_allocator.h"
+#include "cbase/c_runes.h"
+#include "cvmem/c_virtual_memory.h"
+
+#include "cunittest/cunittest.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_filepath.h"
+#include "cpath/c_subtree.h"
+#include "cpath/private/c_extindex.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace ncore;
+
+UNITTEST_SUITE_BEGIN(subtree)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_ALLOCATOR;
+
+        UNITTEST_FIXTURE_SETUP() { nvmem::initialize(); }
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        struct count_t
+        {
+            u32 m_folders;
+            u32 m_files;
+        };
+
+        static void s_init(void* acc, void*) { memset(acc, 0, sizeof(count_t)); }
+        static void s_folder(npath::paths_t*, npath::node_t, void* acc, void*) { ((count_t*)acc)->m_folders += 1; }
+        static void s_file(npath::paths_t*, npath::ifile_t, void* acc, void*) { ((count_t*)acc)->m_files += 1; }
+        static void s_merge(void* acc, void const* other, void*)
+        {
+            ((count_t*)acc)->m_folders += ((count_t const*)other)->m_folders;
+            ((count_t*)acc)->m_files += ((count_t const*)other)->m_files;
+        }
+
+        static void s_mark(npath::paths_t*, npath::node_t folder, void* user) { ((u8*)user)[folder] += 1; }
+
+        // c:/wide/ has 3000 sub folders (more than a local stack holds), c:/deep/ is a chain of 100, 2 files per folder
+        static dirpath_t s_build(npath::paths_t* paths, npath::ifile_t& out_first)
+        {
+            char path[1024];
+            for (u32 i = 0; i < 3000; ++i)
+            {
+                snprintf(path, sizeof(path), "c:/wide/w%u/", i);
+                dirpath_t d = paths->register_fulldirpath(ascii::make_crunes(path));
+                out_first   = paths->file_of(d.filename(ascii::make_crunes("a.txt")));
+                paths->file_of(d.filename(ascii::make_crunes("b.txt")));
+            }
+            u32 len = snprintf(path, sizeof(path), "c:/deep/");
+            for (u32 i = 0; i < 100; ++i)
+            {
+                len += snprintf(path + len, sizeof(path) - len, "d/");
+                dirpath_t d = paths->register_fulldirpath(ascii::make_crunes(path));
+                paths->file_of(d.filename(ascii::make_crunes("a.txt")));
+                paths->file_of(d.filename(ascii::make_crunes("b.txt")));
+            }
+            return paths->register_fulldirpath(ascii::make_crunes("c:/"));
+        }
+
+        UNITTEST_TEST(reduce)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+            npath::ifile_t  last;
+            dirpath_t const root = s_build(paths, last);
+
+            npath::reducer_t reducer = {sizeof(count_t), s_init, s_folder, s_file, s_merge, nullptr};
+            u32 const        threads[] = {1, 4, 0};
+            for (u32 t = 0; t < 3; ++t)
+            {
+                count_t count;
+                CHECK_EQUAL(3103, npath::subtree_t::parallel_reduce(root, reducer, &count, threads[t]));
+                CHECK_EQUAL(3103, count.m_folders); // root, wide, 3000, deep, 100
+                CHECK_EQUAL(6200, count.m_files);
+            }
+
+            // below a sub folder, without tombstones
+            npath::g_set_file_deleted(paths, last, true);
+            count_t count;
+            CHECK_EQUAL(3001, npath::subtree_t::parallel_reduce(root.down(ascii::make_crunes("wide")), reducer, &count, 4));
+            CHECK_EQUAL(5999, count.m_files);
+
+            npath::g_destruct_paths(Allocator, paths);
+        }
+
+        UNITTEST_TEST(for_each_folder_once)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+            npath::ifile_t  last;
+            dirpath_t const root = s_build(paths, last);
+
+            u8* visited = (u8*)Allocator->allocate(8192);
+            memset(visited, 0, 8192);
+            CHECK_EQUAL(3103, npath::subtree_t::parallel_for(root, s_mark, visited, 4));
+            u32 once = 0, more = 0;
+            for (u32 i = 0; i < 8192; ++i)
+            {
+                once += visited[i] == 1 ? 1 : 0;
+                more += visited[i] > 1 ? 1 : 0;
+            }
+            CHECK_EQUAL(3103, once);
+            CHECK_EQUAL(0, more);
+            Allocator->deallocate(visited);
+
+            npath::g_destruct_paths(Allocator, paths);
+        }
+    }
+}
+UNITTEST_SUITE_END
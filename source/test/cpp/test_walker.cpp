@@ -0,0 +1,134 @@
+#include "ccore/c_target.h"
+#include "cbase/c_allocator.h"
+#include "cbase/c_runes.h"
+#include "cvmem/c_virtual_memory.h"
+
+#include "cunittest/cunittest.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_filepath.h"
+#include "cpath/c_walker.h"
+#include "cpath/private/c_extindex.h"
+#include "cpath/private/c_folders.h"
+
+#include "test_helpers.h"
+
+#include <string.h>
+
+using namespace ncore;
+
+UNITTEST_SUITE_BEGIN(walker)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_ALLOCATOR;
+
+        UNITTEST_FIXTURE_SETUP() { nvmem::initialize(); }
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        static char s_letter(npath::paths_t* paths, npath::string_t str)
+        {
+            utf32::rune runes[32];
+            runes[0] = 0;
+            runes_t out(runes, 0, 0, 32);
+            paths->to_string(str, out);
+            return (char)runes[0];
+        }
+
+        // One letter per node (the first letter of its name, '.' for the root of the walk), the depths as digits
+        static void s_trace(npath::paths_t* paths, npath::walker_t* walker, char* names, char* depths)
+        {
+            npath::walknode_t node;
+            u32               n = 0;
+            while (walker->next(node) && n < 31)
+            {
+                if (node.m_depth == 0)
+                    names[n] = '.';
+                else if (node.m_type == npath::nwalk::TypeFolder)
+                    names[n] = s_letter(paths, paths->m_folders->m_array.ptr_of(node.m_node)->m_name);
+                else
+                    names[n] = s_letter(paths, paths->m_files->m_array.ptr_of(node.m_node)->m_filename);
+                depths[n] = (char)('0' + node.m_depth);
+                n += 1;
+            }
+            names[n]  = 0;
+            depths[n] = 0;
+        }
+
+        UNITTEST_TEST(orders)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+
+            paths->register_fulldirpath(ascii::make_crunes("c:/b/"));
+            ntest::g_add_file(paths, "c:/a/x/", "w.txt");
+            ntest::g_add_file(paths, "c:/a/", "z.txt");
+            ntest::g_add_file(paths, "c:/a/", "y.txt");
+            paths->register_fulldirpath(ascii::make_crunes("c:/c/"));
+            ntest::g_add_file(paths, "c:/", "m.txt");
+            dirpath_t const root = paths->register_fulldirpath(ascii::make_crunes("c:/"));
+
+            char names[32], depths[32];
+
+            npath::walker_t* walker = npath::g_construct_walker(Allocator, root);
+            s_trace(paths, walker, names, depths);
+            CHECK_EQUAL(0, strcmp(names, ".baxc"));
+            CHECK_EQUAL(0, strcmp(depths, "01121"));
+
+            walker->reset(root, npath::nwalk::PreOrder | npath::nwalk::SortedByName);
+            s_trace(paths, walker, names, depths);
+            CHECK_EQUAL(0, strcmp(names, ".axbc"));
+
+            walker->reset(root, npath::nwalk::PostOrder | npath::nwalk::InsertionOrder);
+            s_trace(paths, walker, names, depths);
+            CHECK_EQUAL(0, strcmp(names, "bxac."));
+            CHECK_EQUAL(0, strcmp(depths, "12110"));
+
+            walker->reset(root, npath::nwalk::PreOrder | npath::nwalk::WithFiles);
+            s_trace(paths, walker, names, depths);
+            CHECK_EQUAL(0, strcmp(names, ".mbazyxwc"));
+            CHECK_EQUAL(0, strcmp(depths, "011122231"));
+
+            walker->reset(root, npath::nwalk::PreOrder | npath::nwalk::SortedByName | npath::nwalk::WithFiles);
+            s_trace(paths, walker, names, depths);
+            CHECK_EQUAL(0, strcmp(names, ".mayzxwbc"));
+
+            walker->reset(root, npath::nwalk::PostOrder | npath::nwalk::SortedByName | npath::nwalk::WithFiles);
+            s_trace(paths, walker, names, depths);
+            CHECK_EQUAL(0, strcmp(names, "myzwxabc."));
+
+            npath::g_destruct_walker(Allocator, walker);
+            CHECK_NULL(walker);
+            npath::g_destruct_paths(Allocator, paths);
+        }
+
+        UNITTEST_TEST(sub_tree)
+        {
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+
+            ntest::g_add_file(paths, "c:/a/x/", "w.txt");
+            npath::ifile_t const z = ntest::g_add_file(paths, "c:/a/", "z.txt");
+            ntest::g_add_file(paths, "c:/a/", "y.txt");
+            ntest::g_add_file(paths, "c:/b/", "v.txt");
+            dirpath_t const a = paths->register_fulldirpath(ascii::make_crunes("c:/a/"));
+
+            char names[32], depths[32];
+
+            // the walk stays below its root, depths are relative to it
+            npath::walker_t* walker = npath::g_construct_walker(Allocator, a, npath::nwalk::PreOrder | npath::nwalk::WithFiles);
+            s_trace(paths, walker, names, depths);
+            CHECK_EQUAL(0, strcmp(names, ".zyxw"));
+            CHECK_EQUAL(0, strcmp(depths, "01112"));
+
+            // tombstones are skipped
+            npath::g_set_file_deleted(paths, z, true);
+            walker->reset(a, npath::nwalk::PreOrder | npath::nwalk::WithFiles);
+            s_trace(paths, walker, names, depths);
+            CHECK_EQUAL(0, strcmp(names, ".yxw"));
+
+            npath::g_destruct_walker(Allocator, walker);
+            npath::g_destruct_paths(Allocator, paths);
+        }
+    }
+}
+UNITTEST_SUITE_END
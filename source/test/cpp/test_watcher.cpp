@@ -0,0 +1,207 @@
+#include "ccore/c_target.h"
+#include "cbase/c_allocator.h"
+#include "cbase/c_runes.h"
+#include "cvmem/c_virtual_memory.h"
+
+#include "cunittest/cunittest.h"
+
+#include "cpath/c_path.h"
+#include "cpath/c_dirpath.h"
+#include "cpath/c_filepath.h"
+#include "cpath/c_device.h"
+#include "cpath/c_scanner.h"
+#include "cpath/c_watcher.h"
+#include "cpath/private/c_folders.h"
+
+#if defined(TARGET_LINUX)
+#    include <fcntl.h>
+#    include <stdio.h>
+#    include <stdlib.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+using namespace ncore;
+
+UNITTEST_SUITE_BEGIN(watcher)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_ALLOCATOR;
+
+        UNITTEST_FIXTURE_SETUP() { nvmem::initialize(); }
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+#if defined(TARGET_LINUX)
+        static void s_path(char* out, s32 size, const char* root, const char* name) { snprintf(out, size, "%s/%s", root, name); }
+
+        static void s_touch(const char* root, const char* name)
+        {
+            char path[512];
+            s_path(path, sizeof(path), root, name);
+            close(open(path, O_CREAT | O_WRONLY, 0644));
+        }
+
+        static s32 s_count(npath::change_t const* changes, u32 count, bool is_file, u8 kind)
+        {
+            s32 n = 0;
+            for (u32 i = 0; i < count; ++i)
+                n += (changes[i].m_is_file == (is_file ? 1 : 0) && changes[i].m_kind == kind) ? 1 : 0;
+            return n;
+        }
+
+        // Poll until the changes after generation 'since' hold at least 'expected' changes of a kind, the events of
+        // one burst can arrive over several polls. Gives up after about 5 seconds.
+        static void s_poll(npath::watcher_t* watcher, u32 since, bool is_file, u8 kind, s32 expected)
+        {
+            npath::change_t changes[64];
+            for (s32 i = 0; i < 50; ++i)
+            {
+                u32       cursor = 0;
+                u32 const count  = watcher->changes_since(since, cursor, changes, 64);
+                if (s_count(changes, count, is_file, kind) >= expected)
+                    return;
+                watcher->poll(100);
+            }
+        }
+
+        UNITTEST_TEST(create_delete_rename)
+        {
+            char root[] = "/tmp/cpath_watch_XXXXXX";
+            CHECK_NOT_NULL(mkdtemp(root));
+            char path[512], path2[512];
+            s_path(path, sizeof(path), root, "a");
+            mkdir(path, 0755);
+            s_touch(root, "a/x.txt");
+            s_touch(root, "top.md");
+
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+            dirpath_t       scan  = paths->register_fulldirpath(ascii::make_crunes("watch:/"));
+
+            npath::scan_stats_t stats;
+            CHECK_TRUE(npath::scanner_t::scan(scan, root, npath::g_default_scan_config, stats));
+
+            npath::watcher_t* watcher = npath::g_construct_watcher(Allocator, paths);
+            CHECK_TRUE(watcher->watch(scan, root));
+            CHECK_EQUAL(0, watcher->generation());
+
+            // a burst: new file, new folder with a file, a removed file and a renamed file
+            s_touch(root, "new.cpp");
+            s_path(path, sizeof(path), root, "d");
+            mkdir(path, 0755);
+            s_touch(root, "d/inner.h");
+            s_path(path, sizeof(path), root, "top.md");
+            unlink(path);
+            s_path(path, sizeof(path), root, "a/x.txt");
+            s_path(path2, sizeof(path2), root, "a/y.txt");
+            rename(path, path2);
+            s_poll(watcher, 0, false, npath::nchange::KindCreated, 1);
+            s_poll(watcher, 0, true, npath::nchange::KindDeleted, 2);
+            s_poll(watcher, 0, true, npath::nchange::KindCreated, 2);
+            CHECK_TRUE(watcher->generation() >= 1);
+            CHECK_FALSE(watcher->overflowed());
+
+            npath::change_t changes[32];
+            u32             cursor = 0;
+            u32 const       count  = watcher->changes_since(0, cursor, changes, 32);
+            CHECK_EQUAL(0, watcher->changes_since(0, cursor, changes, 32));
+            CHECK_EQUAL(1, s_count(changes, count, false, npath::nchange::KindCreated)); // "d"
+            CHECK_EQUAL(2, s_count(changes, count, true, npath::nchange::KindDeleted));  // "top.md", "x.txt"
+            CHECK_TRUE(s_count(changes, count, true, npath::nchange::KindCreated) >= 2); // "new.cpp", "y.txt" and (unless it raced the watch) "inner.h"
+
+            // the registry follows the disk
+            dirpath_t const d = scan.down(ascii::make_crunes("d"));
+            CHECK_EQUAL(1, d.depth());
+            for (u32 i = 0; i < count; ++i)
+            {
+                if (changes[i].m_is_file && changes[i].m_kind == npath::nchange::KindDeleted)
+                {
+                    CHECK_TRUE((paths->m_files->m_array.ptr_of(changes[i].m_index)->m_flags & npath::nfile::FlagDeleted) != 0);
+                }
+            }
+
+            // nothing since the last generation, then remove the new folder
+            u32 const generation = watcher->generation();
+            cursor               = 0;
+            CHECK_EQUAL(0, watcher->changes_since(generation, cursor, changes, 32));
+
+            s_path(path, sizeof(path), root, "d/inner.h");
+            unlink(path);
+            s_path(path, sizeof(path), root, "d");
+            rmdir(path);
+            s_poll(watcher, generation, false, npath::nchange::KindDeleted, 1);
+            s_poll(watcher, generation, true, npath::nchange::KindDeleted, 1);
+
+            cursor            = 0;
+            u32 const removed = watcher->changes_since(generation, cursor, changes, 32);
+            CHECK_EQUAL(1, s_count(changes, removed, false, npath::nchange::KindDeleted));
+            CHECK_EQUAL(1, s_count(changes, removed, true, npath::nchange::KindDeleted));
+
+            npath::g_destruct_watcher(Allocator, watcher);
+            npath::g_destruct_paths(Allocator, paths);
+
+            s_path(path, sizeof(path), root, "a/y.txt");
+            unlink(path);
+            s_path(path, sizeof(path), root, "new.cpp");
+            unlink(path);
+            s_path(path, sizeof(path), root, "a");
+            rmdir(path);
+            rmdir(root);
+        }
+
+        // inotify hands out watch descriptors cyclically, a long lived watcher keeps watching new folders after many
+        // more descriptors than m_max_watches have been used, the limit is on the number of live watches
+        UNITTEST_TEST(descriptor_churn)
+        {
+            char root[] = "/tmp/cpath_churn_XXXXXX";
+            CHECK_NOT_NULL(mkdtemp(root));
+
+            npath::paths_t* paths = npath::g_construct_paths(Allocator);
+            dirpath_t       scan  = paths->register_fulldirpath(ascii::make_crunes("churn:/"));
+
+            npath::scan_stats_t stats;
+            CHECK_TRUE(npath::scanner_t::scan(scan, root, npath::g_default_scan_config, stats));
+
+            npath::watch_config_t config = npath::g_default_watch_config;
+            config.m_max_watches         = 4;
+            npath::watcher_t* watcher    = npath::g_construct_watcher(Allocator, paths, config);
+            CHECK_TRUE(watcher->watch(scan, root));
+
+            char path[512];
+            s_path(path, sizeof(path), root, "d");
+            for (s32 i = 0; i < 24; ++i)
+            {
+                u32 const generation = watcher->generation();
+                mkdir(path, 0755);
+                s_poll(watcher, generation, false, npath::nchange::KindCreated, 1);
+                rmdir(path);
+                s_poll(watcher, generation, false, npath::nchange::KindDeleted, 1);
+            }
+            CHECK_FALSE(watcher->overflowed());
+
+            // a folder created now is still watched, the file created in it is seen
+            u32 const created = watcher->generation();
+            mkdir(path, 0755);
+            s_poll(watcher, created, false, npath::nchange::KindCreated, 1);
+            u32 const generation = watcher->generation();
+            s_touch(root, "d/late.txt");
+            s_poll(watcher, generation, true, npath::nchange::KindCreated, 1);
+            npath::change_t changes[8];
+            u32             cursor = 0;
+            u32 const       count  = watcher->changes_since(generation, cursor, changes, 8);
+            CHECK_EQUAL(1, s_count(changes, count, true, npath::nchange::KindCreated));
+            CHECK_FALSE(watcher->overflowed());
+
+            npath::g_destruct_watcher(Allocator, watcher);
+            npath::g_destruct_paths(Allocator, paths);
+
+            s_path(path, sizeof(path), root, "d/late.txt");
+            unlink(path);
+            s_path(path, sizeof(path), root, "d");
+            rmdir(path);
+            rmdir(root);
+        }
+#endif
+    }
+}
+UNITTEST_SUITE_END